@@ -2,6 +2,7 @@
 #include <cli.h>
 #include <iostream>
 #include <functional>
+#include <string_view>
 #include <progressbar_manager.h>
 using namespace cli;
 
@@ -101,12 +102,21 @@ static void login_page()
 	}
 }
 
-int main()
+int main(int argc, char* argv[])
 {
 	try
 	{
 		ftClient = std::make_unique<FileTransferClient>();
 
+		// --large-pages: bật trước khi có buffer nào được cấp phát
+		for (int i = 1; i < argc; i++)
+		{
+			if (std::string_view(argv[i]) == "--large-pages" && ftClient->EnableLargePages())
+			{
+				std::cout << "Large pages are enabled for direct I/O buffers." << std::endl;
+			}
+		}
+
 		login_page(); // Show login page
 	}
 	catch (const std::exception& e)
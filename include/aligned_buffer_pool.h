@@ -0,0 +1,103 @@
+#ifndef ALIGNED_BUFFER_POOL_H
+#define ALIGNED_BUFFER_POOL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace utils
+{
+	// Căn chỉnh cho I/O không qua cache (FILE_FLAG_NO_BUFFERING): bội số của sector size trên cả ổ 512e và 4Kn
+	constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+	inline uint64_t AlignDown(uint64_t value, uint64_t alignment)
+	{
+		return value - value % alignment;
+	}
+
+	inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return AlignDown(value + alignment - 1, alignment);
+	}
+
+	/*
+	 * @brief Pool các buffer cấp phát bằng VirtualAlloc (căn theo trang) dùng cho direct I/O và buffer gói tin
+	 * @brief Kích thước được làm tròn lên theo size class (4 class cho mỗi luỹ thừa 2, từ 64KB tới 64MB), mỗi class một danh sách buffer rảnh
+	 * @brief Buffer trả về pool được giữ lại để dùng lại cho tới khi tổng dung lượng rảnh vượt max_idle_bytes; buffer lớn hơn class cuối không được giữ lại
+	 */
+	class AlignedBufferPool
+	{
+	public:
+		// Buffer thuộc pool, tự trả về pool khi bị huỷ
+		class Buffer
+		{
+		private:
+			AlignedBufferPool* m_pool;
+			uint8_t* m_data;
+			size_t m_size;
+
+		public:
+			Buffer() : m_pool(nullptr), m_data(nullptr), m_size(0) {}
+			Buffer(AlignedBufferPool* pool, uint8_t* data, size_t size) : m_pool(pool), m_data(data), m_size(size) {}
+			~Buffer() { Release(); }
+
+			Buffer(const Buffer&) = delete;
+			Buffer& operator=(const Buffer&) = delete;
+
+			Buffer(Buffer&& other) noexcept;
+			Buffer& operator=(Buffer&& other) noexcept;
+
+			uint8_t* data() const { return m_data; }
+			size_t size() const { return m_size; }
+			explicit operator bool() const { return m_data != nullptr; }
+
+			void Release();
+		};
+
+		static constexpr size_t MIN_CLASS_SIZE = 64 * 1024;			// 64KB, bằng allocation granularity của VirtualAlloc
+		static constexpr size_t MAX_CLASS_SIZE = 64ULL * 1024 * 1024; // 64MB
+		static constexpr size_t CLASSES_PER_DOUBLING = 4;
+		static constexpr size_t SIZE_CLASS_COUNT = 10 * CLASSES_PER_DOUBLING + 1; // 64KB << 10 = 64MB
+
+	private:
+		std::mutex m_mutex;
+		std::array<std::vector<uint8_t*>, SIZE_CLASS_COUNT> m_idle; // size class -> buffer rảnh
+		size_t m_idle_bytes;
+		size_t m_max_idle_bytes;
+		size_t m_large_page_size; // 0: không dùng large page
+
+	public:
+		explicit AlignedBufferPool(size_t max_idle_bytes = 256ULL * 1024 * 1024);
+		~AlignedBufferPool();
+
+		AlignedBufferPool(const AlignedBufferPool&) = delete;
+		AlignedBufferPool& operator=(const AlignedBufferPool&) = delete;
+
+		// Pool dùng chung của tiến trình
+		static AlignedBufferPool& Shared();
+
+		// Buffer có ít nhất size byte, địa chỉ căn theo trang
+		Buffer Acquire(size_t size);
+
+		/*
+		 * @brief Cấp phát các buffer từ large page size trở lên bằng MEM_LARGE_PAGES (cần quyền SeLockMemoryPrivilege)
+		 * @brief Trả về false và giữ nguyên trang thường nếu hệ thống không cho phép; lần cấp phát large page thất bại sau đó cũng quay về trang thường
+		 */
+		bool EnableLargePages();
+
+		// Kích thước thực tế của buffer khi yêu cầu size byte
+		static size_t RoundToSizeClass(size_t size);
+
+	private:
+		void Return(uint8_t* data, size_t size);
+		uint8_t* Allocate(size_t size);
+
+		// Chỉ số size class nhỏ nhất chứa được size, SIZE_CLASS_COUNT nếu vượt MAX_CLASS_SIZE
+		static size_t SizeClassIndex(size_t size);
+		static size_t SizeClassSize(size_t index);
+	};
+}
+
+#endif // !ALIGNED_BUFFER_POOL_H
@@ -0,0 +1,113 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace utils
+{
+	/*
+	 * @brief Hàng đợi nhiều producer / nhiều consumer có giới hạn: Push() chờ khi đầy nên producer không chạy xa hơn consumer
+	 * @brief Sau Close(), Push() trả về false ngay còn consumer vẫn lấy nốt các phần tử còn lại
+	 */
+	template <typename T>
+	class BoundedQueue
+	{
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_not_empty;
+		std::condition_variable m_not_full;
+		std::deque<T> m_items;
+		size_t m_capacity;
+		bool m_closed;
+
+	public:
+		explicit BoundedQueue(size_t capacity)
+			: m_capacity(capacity > 0 ? capacity : 1),
+			m_closed(false)
+		{
+		}
+
+		BoundedQueue(const BoundedQueue&) = delete;
+		BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+		// Trả về false nếu hàng đợi đã đóng, phần tử không được thêm
+		bool Push(T item)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_not_full.wait(lock, [this]() { return m_closed || m_items.size() < m_capacity; });
+
+			if (m_closed)
+			{
+				return false;
+			}
+
+			m_items.push_back(std::move(item));
+			lock.unlock();
+
+			m_not_empty.notify_one();
+			return true;
+		}
+
+		// Trả về false khi hàng đợi đã đóng và không còn phần tử
+		bool Pop(T& item)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_not_empty.wait(lock, [this]() { return m_closed || !m_items.empty(); });
+
+			if (m_items.empty())
+			{
+				return false;
+			}
+
+			item = std::move(m_items.front());
+			m_items.pop_front();
+			lock.unlock();
+
+			m_not_full.notify_one();
+			return true;
+		}
+
+		// Chờ có ít nhất một phần tử rồi lấy tối đa max_items phần tử đang có vào out (out bị xoá trước), trả về số phần tử lấy được
+		size_t PopBatch(std::vector<T>& out, size_t max_items)
+		{
+			out.clear();
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_not_empty.wait(lock, [this]() { return m_closed || !m_items.empty(); });
+
+			while (!m_items.empty() && out.size() < max_items)
+			{
+				out.push_back(std::move(m_items.front()));
+				m_items.pop_front();
+			}
+			lock.unlock();
+
+			m_not_full.notify_all();
+			return out.size();
+		}
+
+		void Close()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_closed = true;
+			}
+
+			m_not_empty.notify_all();
+			m_not_full.notify_all();
+		}
+
+		bool IsClosed()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_closed;
+		}
+	};
+}
+
+#endif // !BOUNDED_QUEUE_H
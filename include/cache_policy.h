@@ -0,0 +1,34 @@
+#ifndef CACHE_POLICY_H
+#define CACHE_POLICY_H
+
+#include <Windows.h>
+
+#include <cstdint>
+
+namespace utils
+{
+	// Chính sách page cache cho file đang truyền (nhẹ hơn direct I/O): đọc trước phía trước con trỏ, bỏ các trang đã dùng phía sau
+	struct CachePolicy
+	{
+		uint64_t readahead_bytes = 32ULL * 1024 * 1024; // Đọc trước bao xa phía trước con trỏ đọc, 0: không đọc trước
+		bool drop_behind = true;						// Loại các trang đã đọc khỏi working set
+		bool low_memory_priority = true;				// Trang cache do phiên truyền tạo ra được thu hồi trước các dữ liệu khác
+	};
+
+	// Hạ memory priority của luồng hiện tại trong phạm vi, khôi phục khi huỷ
+	class ScopedMemoryPriority
+	{
+	private:
+		ULONG m_previous;
+		bool m_changed;
+
+	public:
+		explicit ScopedMemoryPriority(bool enabled, ULONG priority = MEMORY_PRIORITY_LOW);
+		~ScopedMemoryPriority();
+
+		ScopedMemoryPriority(const ScopedMemoryPriority&) = delete;
+		ScopedMemoryPriority& operator=(const ScopedMemoryPriority&) = delete;
+	};
+}
+
+#endif // !CACHE_POLICY_H
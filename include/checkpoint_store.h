@@ -0,0 +1,59 @@
+#ifndef CHECKPOINT_STORE_H
+#define CHECKPOINT_STORE_H
+
+#include <transfer_journal.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace utils
+{
+	/*
+	 * @brief Kho checkpoint duy nhất cho mọi phiên truyền dang dở, khoá chính là transfer ID
+	 * @brief Dữ liệu nằm trong TransferJournal, kho chỉ giữ thêm chỉ mục theo đường dẫn local để tra cứu nhanh
+	 */
+	class CheckpointStore
+	{
+	private:
+		TransferJournal& m_journal;
+
+		mutable std::mutex m_mutex;
+		std::unordered_map<std::string, uint64_t> m_upload_index;	// normalized local path -> transfer ID
+		std::unordered_map<std::string, uint64_t> m_download_index; // normalized local path -> transfer ID
+
+	public:
+		explicit CheckpointStore(TransferJournal& journal);
+
+		CheckpointStore(const CheckpointStore&) = delete;
+		CheckpointStore& operator=(const CheckpointStore&) = delete;
+
+		// Kho dùng chung, chỉ mục được dựng từ journal ở lần gọi đầu tiên
+		static CheckpointStore& Shared();
+
+		// Checkpoint cũ của cùng file local (nếu có) bị thay thế
+		uint64_t Begin(TransferDirection direction, const fs::path& local_path, const std::string& remote_path,
+			uint32_t file_id, uint64_t file_size, uint32_t chunk_size);
+
+		void Progress(uint64_t transfer_id, uint32_t chunk_index, uint64_t position);
+		void Complete(uint64_t transfer_id);
+		void Abort(uint64_t transfer_id);
+
+		bool Get(uint64_t transfer_id, TransferState& out_state) const;
+		bool Find(TransferDirection direction, const fs::path& local_path, TransferState& out_state) const;
+
+		// Danh sách checkpoint theo thứ tự transfer ID
+		std::vector<TransferState> List(TransferDirection direction) const;
+
+		static std::string NormalizePath(const fs::path& path);
+
+	private:
+		std::unordered_map<std::string, uint64_t>& IndexOf(TransferDirection direction);
+		const std::unordered_map<std::string, uint64_t>& IndexOf(TransferDirection direction) const;
+		void Unindex(uint64_t transfer_id);
+	};
+}
+
+#endif // !CHECKPOINT_STORE_H
@@ -0,0 +1,48 @@
+#ifndef CHUNK_BITMAP_H
+#define CHUNK_BITMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utils
+{
+	/*
+	 * @brief Bitmap đánh dấu các chunk đã hoàn tất của một phiên truyền, cho phép resume khi chunk hoàn tất không theo thứ tự
+	 * @brief Dạng nén: varint(chunk_count) rồi độ dài các đoạn xen kẽ thiếu/đã có (bắt đầu bằng đoạn thiếu), mỗi độ dài là một varint
+	 */
+	class ChunkBitmap
+	{
+	private:
+		std::vector<uint64_t> m_words;
+		uint32_t m_chunk_count;
+		uint32_t m_completed;
+
+	public:
+		ChunkBitmap();
+		explicit ChunkBitmap(uint32_t chunk_count);
+
+		uint32_t GetChunkCount() const { return m_chunk_count; }
+		uint32_t GetCompletedCount() const { return m_completed; }
+		uint32_t GetMissingCount() const { return m_chunk_count - m_completed; }
+		bool IsComplete() const { return m_completed == m_chunk_count; }
+
+		void Set(uint32_t chunk_index);
+		bool Test(uint32_t chunk_index) const;
+
+		// Số chunk liên tiếp đã hoàn tất tính từ chunk 0
+		uint32_t GetCompletedPrefix() const;
+
+		std::vector<uint32_t> GetMissingChunks() const;
+
+		std::vector<uint8_t> Encode() const;
+		// Số chunk trong dữ liệu phải bằng expected_chunk_count (kiểm tra trước khi cấp phát), throw std::runtime_error nếu không hợp lệ
+		static ChunkBitmap Decode(const uint8_t* data, size_t size, uint32_t expected_chunk_count);
+		static ChunkBitmap Decode(const std::vector<uint8_t>& data, uint32_t expected_chunk_count)
+		{
+			return Decode(data.data(), data.size(), expected_chunk_count);
+		}
+	};
+}
+
+#endif // !CHUNK_BITMAP_H
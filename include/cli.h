@@ -14,7 +14,10 @@
 #include <Windows.h>
 #include <filesystem>
 #include <fstream>
+#include <thread>
 #include <file_transfer_client.h>
+#include <checkpoint_store.h>
+#include <directory_scanner.h>
 using namespace std;
 namespace fs = std::filesystem;
 
@@ -24,6 +27,9 @@ namespace fs = std::filesystem;
 
 namespace cli
 {
+	constexpr uint16_t STRIPE_COUNT = 4; // Connections used by a striped transfer
+	constexpr uint64_t DIRECT_IO_SUGGEST_SIZE = 1ULL << 30; // Offer direct I/O for uploads from 1GB
+
 	enum class CLIState : int
 	{
 		MAIN_MENU,
@@ -65,6 +71,59 @@ namespace cli
 			return (choice == 'Y' || choice == 'y');
 		}
 
+		// Cú pháp giống HTTP Range: "a-b" (bao gồm b), "a-" (đến hết file), "-n" (n byte cuối)
+		vector<ByteRangeDTO> parseByteRanges(const string& spec)
+		{
+			vector<ByteRangeDTO> ranges;
+			stringstream ss(spec);
+			string item;
+
+			while (getline(ss, item, ','))
+			{
+				item.erase(0, item.find_first_not_of(" \t"));
+				item.erase(item.find_last_not_of(" \t") + 1);
+
+				size_t dash = item.find('-');
+				if (item.empty() || dash == string::npos)
+				{
+					throw std::invalid_argument("Invalid byte range: " + item);
+				}
+
+				string first = item.substr(0, dash);
+				string last = item.substr(dash + 1);
+
+				if (first.empty())
+				{
+					uint64_t suffix = stoull(last);
+					ranges.emplace_back(suffix, suffix, true);
+				}
+				else
+				{
+					uint64_t start = stoull(first);
+					uint64_t length = 0;
+
+					if (!last.empty())
+					{
+						uint64_t end = stoull(last);
+						if (end < start)
+						{
+							throw std::invalid_argument("Invalid byte range: " + item);
+						}
+						length = end - start + 1;
+					}
+
+					ranges.emplace_back(start, length, false);
+				}
+			}
+
+			if (ranges.empty())
+			{
+				throw std::invalid_argument("No byte range given.");
+			}
+
+			return ranges;
+		}
+
 		void showWelcomeMessage()
 		{
 			system("cls"); // Clear screen
@@ -356,13 +415,48 @@ namespace cli
 					return;
 				}
 
+				cout << "Which type of file upload do you want to use?\n";
+				cout << "1. Full upload\n";
+				cout << "2. Delta upload (only send changes of a file already on the server)\n";
+				cout << "3. Striped upload (split a large file over " << STRIPE_COUNT << " connections)\n";
+
+				int choice = 0;
+				cout << "Enter your choice: ";
+				cin >> choice;
+				cin.ignore((numeric_limits<streamsize>::max)(), '\n');
+
+				if (choice < 1 || choice > 3)
+				{
+					cout << "Invalid choice. Please try again.\n";
+					waitForEnter();
+					return showUploadFile(client);
+				}
+
+				// Delta upload đọc file theo cách riêng, chỉ hỏi với upload toàn bộ file
+				client->SetDirectIO(choice != 2 && fileSize >= DIRECT_IO_SUGGEST_SIZE &&
+					confirmAction("Bypass the system file cache (direct I/O)? Recommended for very large files on shared hosts."));
+
 				system("cls"); // Clear screen
 
 				cout << "\n===============================================\n";
 				cout << "> Uploading file...\n\n";
 
 				// Upload file
-				if (client->UploadFile(filePath, filePath.filename().string()))
+				bool uploaded = false;
+				switch (choice)
+				{
+				case 1:
+					uploaded = client->UploadFile(filePath, filePath.filename().string());
+					break;
+				case 2:
+					uploaded = client->DeltaUploadFile(filePath, filePath.filename().string());
+					break;
+				case 3:
+					uploaded = client->UploadFileStriped(filePath, filePath.filename().string(), STRIPE_COUNT);
+					break;
+				}
+
+				if (uploaded)
 				{
 					cout << "File uploaded successfully.\n";
 				}
@@ -408,8 +502,49 @@ namespace cli
 					showTransferMenu(); // Return to transfer menu
 				}
 
-				// 
-				if (client->DownloadFile(filename))
+				// Nếu đã có bản local thì cho phép chỉ tải các khối đã thay đổi
+				bool refresh = fs::exists(filename) &&
+					confirmAction("A local copy exists. Refresh it by downloading only the changed blocks?");
+
+				int choice = 1;
+				if (!refresh)
+				{
+					cout << "Which type of file download do you want to use?\n";
+					cout << "1. Full download\n";
+					cout << "2. Striped download (split the file over " << STRIPE_COUNT << " connections)\n";
+					cout << "3. Byte ranges only\n";
+
+					cout << "Enter your choice: ";
+					cin >> choice;
+					cin.ignore((numeric_limits<streamsize>::max)(), '\n');
+				}
+
+				client->SetDirectIO(!refresh && (choice == 1 || choice == 2) &&
+					confirmAction("Bypass the system file cache (direct I/O)? Recommended for very large files on shared hosts."));
+
+				bool downloaded = false;
+				if (refresh)
+				{
+					downloaded = client->DeltaDownloadFile(filename);
+				}
+				else if (choice == 2)
+				{
+					downloaded = client->DownloadFileStriped(filename, STRIPE_COUNT);
+				}
+				else if (choice == 3)
+				{
+					string rangeSpec;
+					cout << "Enter byte ranges (e.g. 0-1023,4096-,-512): ";
+					getline(cin, rangeSpec);
+
+					downloaded = client->DownloadRanges(filename, parseByteRanges(rangeSpec));
+				}
+				else
+				{
+					downloaded = client->DownloadFile(filename);
+				}
+
+				if (downloaded)
 				{
 					cout << endl << "File downloaded successfully." << endl;
 				}
@@ -426,8 +561,7 @@ namespace cli
 			waitForEnter();
 			showTransferMenu(); // Return to transfer menu
 		}
-		// {folderPath, totalItems, totalSize}
-		std::tuple<fs::path, size_t, size_t> OpenDirectoryDialog()
+		fs::path OpenDirectoryDialog()
 		{
 			// Initialize COM
 			HRESULT hr = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
@@ -509,31 +643,32 @@ namespace cli
 			pFileOpen->Release();
 			CoUninitialize();
 
-			// Calculate the total size of the folder, item counting
-			size_t totalItems = 0;
-			size_t totalSize = 0;
+			return folderPath;
+		}
+
+		// {totalItems, totalSize}: quét trước cả cây (bỏ các thư mục bị lọc) cho các chế độ cần tổng số để hiển thị tiến trình quét
+		std::pair<size_t, uint64_t> CountDirectory(FileTransferClient* client, const fs::path& folderPath)
+		{
+			std::atomic<uint64_t> totalSize = 0;
 
 			try
 			{
-				for (const auto& entry : fs::recursive_directory_iterator(folderPath))
+				const utils::PathFilter filter = client->LoadPathFilter(folderPath);
+
+				// Kích thước có sẵn trong kết quả liệt kê thư mục, không stat lại từng file
+				utils::DirectoryScanner scanner;
+				if (!filter.IsEmpty())
 				{
-					if (fs::is_regular_file(entry.status()))
-					{
-						totalItems++;
-						totalSize += fs::file_size(entry.path());
-					}
-					else if (fs::is_directory(entry.status()))
-					{
-						totalItems++;
-					}
+					scanner.SetFilter(&filter);
 				}
+
+				scanner.Scan(folderPath, [&totalSize](size_t, const utils::ScannedFile& file) { totalSize += file.size; });
+				return { scanner.GetVisitedCount(), totalSize.load() };
 			}
-			catch (const fs::filesystem_error& e)
+			catch (const std::exception& e)
 			{
 				throw std::runtime_error(std::string("Error accessing folder: ") + e.what());
 			}
-
-			return { folderPath, totalItems, totalSize };
 		}
 
 		void showUploadFolder(FileTransferClient* client)
@@ -553,15 +688,13 @@ namespace cli
 
 			fs::path folderPath;
 			size_t totalItems = 0;
-			size_t totalSize = 0;
+			uint64_t totalSize = 0;
 
 			try
 			{
-				tie(folderPath, totalItems, totalSize) = OpenDirectoryDialog();
+				folderPath = OpenDirectoryDialog();
 
 				wcout << L"Selected folder: " << folderPath.wstring() << L"\n";
-				wcout << L"Total items: " << totalItems << L"\n";
-				wcout << L"Total size: " << totalSize << L" bytes (" << (totalSize / 1024) << L" KB)\n";
 
 				if (!confirmAction("Do you want to upload this folder?"))
 				{
@@ -571,13 +704,16 @@ namespace cli
 				cout << "Which type of folder upload do you want to use?\n";
 				cout << "1. Sequential upload\n";
 				cout << "2. Parallel upload\n";
+				cout << "3. Incremental sync (only new or changed files)\n";
+				cout << "4. Mirror with server (transfer only files that differ)\n";
+				cout << "5. Watch folder (upload changes continuously)\n";
 
 				int choice = 0;
 				cout << "Enter your choice: ";
 				cin >> choice;
 				cin.ignore((numeric_limits<streamsize>::max)(), '\n');
 
-				if (choice < 1 || choice > 2)
+				if (choice < 1 || choice > 5)
 				{
 					cout << "Invalid choice. Please try again.\n";
 					waitForEnter();
@@ -589,6 +725,16 @@ namespace cli
 				cout << "\n===============================================\n";
 				cout << "> Uploading folder...\n\n";
 
+				// Upload tuần tự/song song quét và truyền cùng lúc (tổng số được ước lượng trong lúc quét), watch tự sync lần đầu:
+				// chỉ sync và mirror cần quét trước cả cây
+				if (choice == 3 || choice == 4)
+				{
+					tie(totalItems, totalSize) = CountDirectory(client, folderPath);
+
+					wcout << L"Total items: " << totalItems << L"\n";
+					wcout << L"Total size: " << totalSize << L" bytes (" << (totalSize / 1024) << L" KB)\n";
+				}
+
 				if (choice == 1)
 				{
 					// Upload folder
@@ -613,6 +759,49 @@ namespace cli
 						cerr << "Failed to upload folder.\n";
 					}
 				}
+				else if (choice == 3)
+				{
+					// Sync folder
+					if (client->SyncDirectory(folderPath, totalItems))
+					{
+						cout << "\nFolder synced successfully.\n";
+					}
+					else
+					{
+						cerr << "Failed to sync folder.\n";
+					}
+				}
+				else if (choice == 4)
+				{
+					// Mirror folder
+					if (client->MirrorDirectory(folderPath, totalItems))
+					{
+						cout << "\nFolder mirrored successfully.\n";
+					}
+					else
+					{
+						cerr << "Failed to mirror folder.\n";
+					}
+				}
+				else if (choice == 5)
+				{
+					// Watch folder, dừng khi người dùng nhấn Enter
+					std::jthread watcher([client, folderPath](std::stop_token stop)
+						{
+							if (!client->WatchDirectory(folderPath, stop))
+							{
+								cerr << "Failed to watch folder.\n";
+							}
+						});
+
+					cout << "Watching folder for changes. Press Enter to stop...\n";
+					cin.get();
+
+					watcher.request_stop();
+					watcher.join();
+
+					cout << "\nStopped watching folder.\n";
+				}
 			}
 			catch (const std::exception& e)
 			{
@@ -626,6 +815,45 @@ namespace cli
 			state = CLIState::SESSION;
 		}
 
+		// Liệt kê các checkpoint dang dở và cho người dùng chọn một, trả về false nếu không có lựa chọn hợp lệ
+		bool selectCheckpoint(utils::TransferDirection direction, utils::TransferState& selected)
+		{
+			std::vector<utils::TransferState> checkpoints = utils::CheckpointStore::Shared().List(direction);
+
+			if (checkpoints.empty())
+			{
+				cout << "List is empty.\n";
+				return false;
+			}
+
+			cout << (direction == utils::TransferDirection::UPLOAD ? "Interrupted uploads:\n" : "Interrupted downloads:\n");
+
+			for (size_t i = 0; i < checkpoints.size(); i++)
+			{
+				const auto& checkpoint = checkpoints[i];
+				double progress = (checkpoint.file_size > 0)
+					? (static_cast<double>(checkpoint.position) / checkpoint.file_size) * 100.0
+					: 0.0;
+
+				cout << setw(4) << (i + 1) << ". " << checkpoint.remote_path
+					<< " (" << fixed << setprecision(1) << progress << "%) <-> " << checkpoint.local_path << '\n';
+			}
+
+			size_t choice = 0;
+			cout << "Enter the number of the transfer you want to resume: ";
+			cin >> choice;
+			cin.ignore((numeric_limits<streamsize>::max)(), '\n');
+
+			if (choice < 1 || choice > checkpoints.size())
+			{
+				cerr << "Invalid option.\n";
+				return false;
+			}
+
+			selected = checkpoints[choice - 1];
+			return true;
+		}
+
 		void showResumeUpload(FileTransferClient* client)
 		{
 			if (!client || state != CLIState::RESUME)
@@ -639,36 +867,25 @@ namespace cli
 			cout << "||             RESUME UPLOAD FILE            ||\n";
 			cout << "||                                           ||\n";
 			cout << "===============================================\n";
-			cout << "> Select a file to resume upload...\n\n";
-
-			fs::path filePath;
-			wstring fileName, fileType;
-			size_t fileSize;
 
 			try {
-				tie(filePath, fileName, fileType, fileSize) = OpenFileDialog();
-
-				wcout << L"Selected file: " << fileName << L"\n";
-				wcout << L"File path: " << filePath << L"\n";
-				wcout << L"File type: " << fileType << L"\n";
-				wcout << L"File size: " << fileSize << L" bytes (" << (fileSize / 1024) << L" KB)\n";
+				utils::TransferState checkpoint;
 
-				if (!confirmAction("Do you want to resume upload this file?"))
+				if (selectCheckpoint(utils::TransferDirection::UPLOAD, checkpoint) &&
+					confirmAction("Do you want to resume upload this file?"))
 				{
-					return;
-				}
-
-				system("cls");
-				cout << "\n===============================================\n";
-				cout << "> Resuming upload file...\n\n";
+					system("cls");
+					cout << "\n===============================================\n";
+					cout << "> Resuming upload file...\n\n";
 
-				if (client->ResumeUpload(filePath.string()))
-				{
-					cout << "File uploaded successfully.\n";
-				}
-				else
-				{
-					cerr << "Failed to upload file.\n";
+					if (client->ResumeUpload(checkpoint.local_path))
+					{
+						cout << "File uploaded successfully.\n";
+					}
+					else
+					{
+						cerr << "Failed to upload file.\n";
+					}
 				}
 			}
 			catch (const std::exception& e) {
@@ -693,110 +910,27 @@ namespace cli
 			cout << "||           RESUME DONWLOAD FILE            ||\n";
 			cout << "||                                           ||\n";
 			cout << "===============================================\n";
-			cout << "> Select a file to resume download...\n\n";
-
-			std::string path = "./checkpoint/";
-			std::vector<fs::path> files;
 
 			try {
-				if (fs::exists(path) && fs::is_directory(path)) {
-					int i = 0;
-					std::cout << "list of files was downloading:\n";
-
-					for (const auto& entry : fs::directory_iterator(path)) {
-						if (fs::is_regular_file(entry.path())) {
-							files.push_back(entry.path());
-
-							std::string file_name;
-							uint32_t file_id_read;
-							uint64_t resume_position_read;
-							uint32_t last_chunk_index_read;
-							uint64_t file_size;
-							size_t len;
-
-							/*fs::path path(file_name);
-							std::string namePart = path.stem().string();
-							std::string check_point_path = utils::DEFAULT_CHECK_POINT_PATH + namePart + ".ckp";*/
-
-							std::ifstream resume_in(entry.path(), std::ios::binary);
-							// Repair info resuming transfer
-							if (resume_in.is_open())
-							{
-								resume_in.read(reinterpret_cast<char*>(&len), sizeof(len));
-								resume_in.read(reinterpret_cast<char*>(file_name.data()), sizeof(char) * len);
-								resume_in.read(reinterpret_cast<char*>(&file_id_read), sizeof(file_id_read));
-								resume_in.read(reinterpret_cast<char*>(&resume_position_read), sizeof(resume_position_read));
-								resume_in.read(reinterpret_cast<char*>(&last_chunk_index_read), sizeof(last_chunk_index_read));
-								resume_in.read(reinterpret_cast<char*>(&file_size), sizeof(file_size));
-							}
-							resume_in.close();
-
-							std::cout << ++i << ". " << file_name.data() << '\n';
-						}
-					}
-
-					if (files.empty()) {
-						std::cout << "List is empty.\n";
-						return;
-					}
-
-					int choice;
-					std::cout << "Enter the file number you want to resume download: ";
-					std::cin >> choice;
-					cin.ignore();
+				utils::TransferState checkpoint;
 
-					if (choice >= 0 && choice <= static_cast<int>(files.size()))
+				if (selectCheckpoint(utils::TransferDirection::DOWNLOAD, checkpoint) &&
+					confirmAction("Do you want to resume download this file?"))
+				{
+					if (client->ResumeDownload(checkpoint.transfer_id))
 					{
-						if (!confirmAction("Do you want to resume download this file?"))
-						{
-							return;
-						}
-
-						std::string resume_file_name;
-						uint32_t file_id_read{};
-						uint64_t resume_position_read{};
-						uint32_t last_chunk_index_read{};
-						uint64_t file_size{};
-						size_t len{};
-
-						std::ifstream resume_in("./checkpoint/" + files[choice - 1].filename().string(), std::ios::binary);
-						// Get the file name
-						if (resume_in.is_open())
-						{
-							resume_in.read(reinterpret_cast<char*>(&len), sizeof(len));
-							resume_in.read(reinterpret_cast<char*>(resume_file_name.data()), sizeof(char) * len);
-							resume_in.read(reinterpret_cast<char*>(&file_id_read), sizeof(file_id_read));
-							resume_in.read(reinterpret_cast<char*>(&resume_position_read), sizeof(resume_position_read));
-							resume_in.read(reinterpret_cast<char*>(&last_chunk_index_read), sizeof(last_chunk_index_read));
-							resume_in.read(reinterpret_cast<char*>(&file_size), sizeof(file_size));
-						}
-						resume_in.close();
-
-						if (client->ResumeDownload(resume_file_name))
-						{
-							cout << "File downloaded successfully.\n";
-						}
-						else
-						{
-							cerr << "Failed to download file.\n";
-						}
+						cout << "File downloaded successfully.\n";
 					}
 					else
 					{
-						std::cerr << "Invalid option.\n";
+						cerr << "Failed to download file.\n";
 					}
 				}
-				else
-				{
-					std::cerr << "Invalid directory.\n";
-				}
 			}
-			catch (const fs::filesystem_error& e) {
-				std::cerr << "Error: " << e.what() << '\n';
+			catch (const std::exception& e) {
+				cerr << "Error: " << e.what() << endl;
 			}
 
-
-
 			waitForEnter();
 
 			state = CLIState::SESSION;
@@ -0,0 +1,66 @@
+#ifndef CONCURRENCY_CONTROLLER_H
+#define CONCURRENCY_CONTROLLER_H
+
+#include <transfer_stats.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace utils
+{
+	/*
+	 * @brief Chọn số kết nối song song theo số liệu đo được thay vì một hằng số
+	 * @brief Mỗi chu kỳ lấy mẫu goodput (byte gửi + nhận của mọi kết nối), RTT trung bình của request và mức dùng CPU:
+	 * @brief - CPU bão hoà, hoặc RTT tăng vọt mà goodput không tăng (hàng đợi mạng đầy): bớt một worker
+	 * @brief - Lần thêm worker trước không tăng goodput ít nhất MIN_GAIN: quay lại mức cũ và giữ nguyên vài chu kỳ
+	 * @brief - Còn lại: thêm worker, gấp đôi khi mới bắt đầu (slow start) rồi tăng từng worker một
+	 */
+	class ConcurrencyController
+	{
+	private:
+		size_t m_min_workers;
+		size_t m_max_workers;
+		size_t m_target;
+		std::chrono::steady_clock::duration m_interval;
+
+		std::chrono::steady_clock::time_point m_last_sample;
+		TransferStats::Snapshot m_last_stats;
+		uint64_t m_last_cpu_idle;
+		uint64_t m_last_cpu_total;
+
+		double m_goodput;		 // byte/s của chu kỳ gần nhất
+		double m_last_goodput;
+		double m_round_trip_us;	 // RTT trung bình của chu kỳ gần nhất
+		double m_base_round_trip_us; // RTT nhỏ nhất từng đo được
+		double m_cpu_usage;		 // 0..1
+
+		long long m_last_step;	 // Thay đổi số worker ở chu kỳ trước
+		bool m_slow_start;
+		size_t m_hold;			 // Số chu kỳ còn phải giữ nguyên sau khi quay lại
+
+	public:
+		static constexpr double CPU_SATURATION = 0.90;
+		static constexpr double RTT_INFLATION = 2.0;
+		static constexpr double MIN_GAIN = 1.05;
+		static constexpr size_t HOLD_INTERVALS = 3;
+		static constexpr std::chrono::milliseconds DEFAULT_INTERVAL{ 2000 };
+
+		ConcurrencyController(size_t initial_workers, size_t max_workers,
+			std::chrono::steady_clock::duration interval = DEFAULT_INTERVAL, size_t min_workers = 1);
+
+		// Gọi định kỳ, chỉ đánh giá lại khi đã qua một chu kỳ; trả về số worker mong muốn
+		size_t Update();
+
+		size_t GetTarget() const { return m_target; }
+		double GetGoodput() const { return m_goodput; }
+		double GetRoundTripMs() const { return m_round_trip_us / 1000.0; }
+		double GetCpuUsage() const { return m_cpu_usage; }
+
+	private:
+		// Tỉ lệ CPU bận kể từ lần gọi trước, theo GetSystemTimes
+		double SampleCpuUsage();
+	};
+}
+
+#endif // !CONCURRENCY_CONTROLLER_H
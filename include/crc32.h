@@ -0,0 +1,13 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utils
+{
+	// CRC-32 (IEEE 802.3) của một bản ghi trên đĩa, crc là giá trị của phần trước khi tính nối tiếp
+	uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+}
+
+#endif // !CRC32_H
@@ -0,0 +1,120 @@
+#ifndef DELTA_SYNC_H
+#define DELTA_SYNC_H
+
+#include <packet_def.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+namespace fs = std::filesystem;
+
+namespace utils
+{
+	// rsync-style weak checksum that can slide one byte at a time over a window
+	class RollingChecksum
+	{
+	private:
+		uint32_t m_a;
+		uint32_t m_b;
+		size_t m_window;
+
+	public:
+		RollingChecksum();
+
+		void Reset(const uint8_t* data, size_t length);
+		void Roll(uint8_t out_byte, uint8_t in_byte);
+		uint32_t Digest() const;
+
+		static uint32_t Compute(const uint8_t* data, size_t length);
+	};
+
+	// Chọn kích thước khối ~ sqrt(file_size) sao cho danh sách chữ ký vẫn vừa một gói tin
+	uint32_t ChooseDeltaBlockSize(uint64_t file_size);
+
+	// Tính chữ ký (weak + MD5) cho từng khối của file, khối cuối có thể ngắn hơn block_size
+	std::vector<BlockSignatureDTO> ComputeBlockSignatures(const fs::path& file_path, uint32_t block_size,
+		const std::function<void(uint64_t bytes_processed)>& on_progress = nullptr);
+
+	/*
+	 * @brief Tạo luồng lệnh delta (COPY_BLOCKS / LITERAL) cho file mới dựa trên chữ ký khối của phiên bản cũ
+	 * @brief Lệnh được gom lại và đẩy ra qua callback khi đạt kích thước tối đa của một gói tin
+	 */
+	class DeltaEncoder
+	{
+	public:
+		// Nhận một đoạn lệnh delta, trả về false để dừng quá trình mã hoá
+		using FlushCallback = std::function<bool(const std::vector<uint8_t>& instructions, bool is_last)>;
+		using ProgressCallback = std::function<void(uint64_t bytes_processed)>;
+
+		DeltaEncoder(const std::vector<BlockSignatureDTO>& signatures, uint32_t block_size, size_t max_instruction_size);
+
+		bool Encode(const fs::path& file_path, const FlushCallback& on_flush, const ProgressCallback& on_progress = nullptr);
+
+		uint64_t GetMatchedBytes() const { return m_matched_bytes; }
+		uint64_t GetLiteralBytes() const { return m_literal_bytes; }
+
+	private:
+		bool FindMatch(const uint8_t* window, uint32_t weak, uint32_t& out_block_index) const;
+
+		bool EmitCopy(uint32_t block_index, const FlushCallback& on_flush);
+		bool EmitLiteral(const uint8_t* data, size_t length, const FlushCallback& on_flush);
+		bool FlushPendingCopy(const FlushCallback& on_flush);
+		bool FlushIfFull(const FlushCallback& on_flush);
+
+		const std::vector<BlockSignatureDTO>& m_signatures;
+		uint32_t m_block_size;
+		size_t m_max_instruction_size;
+
+		std::unordered_map<uint32_t, std::vector<uint32_t>> m_weak_index; // weak checksum -> block indexes
+		std::vector<bool> m_weak_filter;								  // 16-bit tag filter in front of m_weak_index
+
+		std::vector<uint8_t> m_pending;	 // Instructions not yet flushed
+		uint32_t m_copy_start;			 // First block of the current COPY run
+		uint32_t m_copy_count;			 // Length of the current COPY run (0: no run)
+
+		uint64_t m_matched_bytes;
+		uint64_t m_literal_bytes;
+	};
+
+	/*
+	 * @brief Dựng lại file từ bản cũ (basis) và luồng lệnh delta
+	 * @brief Kết quả được ghi ra file tạm, Commit() thay thế bản cũ khi toàn bộ luồng lệnh đã được áp dụng
+	 */
+	class DeltaPatcher
+	{
+	private:
+		fs::path m_basis_path;
+		fs::path m_temp_path;
+		std::ifstream m_basis;
+		std::ofstream m_output;
+		uint64_t m_basis_size;
+		uint32_t m_block_size;
+		uint64_t m_bytes_written;
+		uint64_t m_reused_bytes;
+		std::vector<uint8_t> m_copy_buffer;
+
+	public:
+		DeltaPatcher(const fs::path& basis_path, uint32_t block_size);
+		~DeltaPatcher();
+
+		// Áp dụng một đoạn lệnh delta, ném exception nếu lệnh không hợp lệ
+		void Apply(const std::vector<uint8_t>& instructions);
+
+		// Đóng file tạm để có thể kiểm tra checksum trước khi Commit()
+		void Close();
+
+		// Thay thế bản cũ bằng file tạm
+		void Commit();
+		void Abort();
+
+		const fs::path& GetTempPath() const { return m_temp_path; }
+		uint64_t GetBytesWritten() const { return m_bytes_written; }
+		uint64_t GetReusedBytes() const { return m_reused_bytes; }
+	};
+}
+
+#endif // !DELTA_SYNC_H
@@ -0,0 +1,40 @@
+#ifndef DIRECT_FILE_READER_H
+#define DIRECT_FILE_READER_H
+
+#include <Windows.h>
+
+#include <aligned_buffer_pool.h>
+#include <file_chunk_reader.h>
+
+namespace utils
+{
+	/*
+	 * @brief Đọc file với FILE_FLAG_NO_BUFFERING để truyền file rất lớn mà không đẩy dữ liệu khác ra khỏi page cache
+	 * @brief Mỗi lần đọc được mở rộng ra biên DIRECT_IO_ALIGNMENT vào buffer lấy từ AlignedBufferPool, chunk cuối đọc ngắn tại EOF
+	 */
+	class DirectFileReader : public FileChunkReader
+	{
+	private:
+		fs::path m_path;
+		HANDLE m_handle;
+		uint64_t m_file_size;
+		AlignedBufferPool::Buffer m_buffer;
+
+	public:
+		explicit DirectFileReader(const fs::path& path);
+		~DirectFileReader() override;
+
+		DirectFileReader(const DirectFileReader&) = delete;
+		DirectFileReader& operator=(const DirectFileReader&) = delete;
+
+		std::span<const uint8_t> Read(uint64_t offset, size_t length) override;
+
+		uint64_t GetFileSize() const override { return m_file_size; }
+		const fs::path& GetPath() const { return m_path; }
+
+	protected:
+		size_t GetHashBlockSize() const override { return 8ULL * 1024 * 1024; }
+	};
+}
+
+#endif // !DIRECT_FILE_READER_H
@@ -0,0 +1,92 @@
+#ifndef DIRECTORY_MANIFEST_H
+#define DIRECTORY_MANIFEST_H
+
+#include <Windows.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+namespace fs = std::filesystem;
+
+namespace utils
+{
+	constexpr auto DEFAULT_MANIFEST_DIR = "./checkpoint/directories";
+
+	enum class ManifestFileState : uint8_t
+	{
+		PENDING,   // Đã tìm thấy khi quét, chưa upload
+		IN_FLIGHT, // Đang upload theo chunk: các chunk đã xong nằm trong bitmap của checkpoint (CheckpointStore) của file
+		DONE
+	};
+
+	struct ManifestEntry
+	{
+		uint64_t size = 0;
+		uint64_t last_write_time = 0; // FILETIME
+		ManifestFileState state = ManifestFileState::PENDING;
+	};
+
+	/*
+	 * @brief Manifest của một lần upload thư mục, khoá là đường dẫn tương đối (như FileTable::GetRelativePath)
+	 * @brief File được tạo ngay khi bắt đầu và ghi nối tiếp: mỗi thay đổi trạng thái là một bản ghi đầy đủ, bản ghi sau thắng
+	 * @brief Bản ghi được gom lại, ghi và FlushFileBuffers mỗi FLUSH_INTERVAL hoặc khi đủ FLUSH_BYTES; mất vài bản ghi cuối khi crash
+	 * @brief chỉ làm vài file bị upload lại, còn bản ghi sai CRC (ghi dở khi mất điện) và mọi thứ sau nó bị bỏ qua khi đọc lại
+	 * @brief Lần chạy sau của cùng thư mục bỏ qua file DONE chưa thay đổi và tiếp tục file IN_FLIGHT từ checkpoint của nó
+	 */
+	class DirectoryManifest
+	{
+	private:
+		fs::path m_path;
+
+		mutable std::mutex m_mutex;
+		std::unordered_map<std::string, ManifestEntry> m_entries;
+		size_t m_resumed_count; // Số file có trong manifest lúc mở (0: lần upload mới)
+		HANDLE m_handle;
+		uint64_t m_end_offset;
+		std::vector<char> m_pending;
+		std::chrono::steady_clock::time_point m_last_flush;
+		bool m_failed;
+
+	public:
+		static constexpr size_t FLUSH_BYTES = 64 * 1024;
+		static constexpr std::chrono::seconds FLUSH_INTERVAL{ 1 };
+
+		// Đọc manifest dang dở tại path nếu có (compact lại nếu có nhiều bản ghi cũ) rồi mở để ghi tiếp
+		explicit DirectoryManifest(const fs::path& path);
+		~DirectoryManifest();
+
+		DirectoryManifest(const DirectoryManifest&) = delete;
+		DirectoryManifest& operator=(const DirectoryManifest&) = delete;
+
+		// File manifest của thư mục root trong DEFAULT_MANIFEST_DIR
+		static fs::path PathFor(const fs::path& root);
+
+		// Ghi nhận file tìm thấy khi quét, trả về trạng thái cần xử lý:
+		// file mới hoặc đã thay đổi kể từ lần chạy trước được đặt lại thành PENDING
+		ManifestFileState Add(const std::string& relative_path, uint64_t size, uint64_t last_write_time);
+		void SetState(const std::string& relative_path, ManifestFileState state);
+
+		size_t GetResumedCount() const;
+		size_t Count(ManifestFileState state) const;
+
+		// Ghi các bản ghi đang gom xuống file, trả về false nếu ghi thất bại
+		bool Flush();
+		// Cả thư mục đã upload xong: đóng và xoá file manifest
+		void Remove();
+
+	private:
+		// Trả về số bản ghi đọc được, out_clean = false nếu file hỏng hoặc bị cắt cụt (phải viết lại trước khi ghi tiếp)
+		size_t Load(bool& out_clean);
+		bool Compact();
+		bool Open();
+		void Append(const std::string& relative_path, const ManifestEntry& entry);
+		bool FlushLocked();
+	};
+}
+
+#endif // !DIRECTORY_MANIFEST_H
@@ -0,0 +1,109 @@
+#ifndef DIRECTORY_SCANNER_H
+#define DIRECTORY_SCANNER_H
+
+#include <path_filter.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+namespace fs = std::filesystem;
+
+namespace utils
+{
+	// Chỉ hợp lệ trong lời gọi FileSink, tên trỏ vào buffer liệt kê của worker
+	struct ScannedFile
+	{
+		uint32_t directory; // Id do DirectorySink trả về cho thư mục chứa file (thư mục gốc là 0)
+		std::wstring_view name;
+		uint64_t size;
+		uint64_t last_write_time; // FILETIME (đơn vị 100ns từ 1601)
+	};
+
+	/*
+	 * @brief Quét cây thư mục song song: mỗi thư mục là một task, worker lấy task từ cuối deque của mình
+	 * @brief và khi hết việc thì lấy trộm từ đầu deque của worker khác
+	 * @brief Thư mục được liệt kê bằng FindFirstFileExW (FindExInfoBasic, FIND_FIRST_EX_LARGE_FETCH):
+	 * @brief thuộc tính và kích thước có sẵn trong kết quả liệt kê nên không stat lại từng file
+	 * @brief Không đi vào reparse point (junction, symlink thư mục), giống fs::recursive_directory_iterator
+	 * @brief Với PathFilter, entry bị loại được bỏ ngay khi liệt kê: thư mục bị loại không bao giờ được mở
+	 */
+	class DirectoryScanner
+	{
+	public:
+		// Gọi đồng thời từ các worker, worker là chỉ số của worker gọi (0 .. thread_count - 1)
+		using FileSink = std::function<void(size_t worker, const ScannedFile& file)>;
+		// Gọi đồng thời từ các worker khi gặp một thư mục con, trả về id của thư mục đó cho các file bên trong
+		using DirectorySink = std::function<uint32_t(uint32_t parent, std::wstring_view name)>;
+		// Gọi định kỳ trên thread gọi Scan(), visited là tổng số file và thư mục đã gặp
+		using ProgressCallback = std::function<void(size_t visited)>;
+
+	private:
+		struct DirectoryTask
+		{
+			fs::path path;
+			uint32_t directory;
+			PathFilter::Context filter;
+		};
+
+		struct WorkerQueue
+		{
+			std::mutex mutex;
+			std::deque<DirectoryTask> tasks;
+		};
+
+		size_t m_thread_count;
+		const PathFilter* m_filter;
+		std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+		std::atomic<size_t> m_pending; // Thư mục đang chờ hoặc đang được liệt kê
+		std::atomic<size_t> m_queued;  // Thư mục đang nằm trong các deque, chưa worker nào nhận
+		std::atomic<size_t> m_idle;	   // Số worker đang ngủ trên m_idle_cv
+		std::atomic<size_t> m_visited;
+		std::atomic<bool> m_failed;
+		std::mutex m_done_mutex;
+		std::condition_variable m_done_cv; // Báo cho thread gọi Scan() khi đã hết thư mục hoặc có lỗi
+		std::mutex m_idle_mutex;
+		std::condition_variable m_idle_cv; // Đánh thức worker rảnh khi có thư mục mới hoặc khi đã quét xong
+		std::mutex m_error_mutex;
+		std::string m_error;
+
+	public:
+		static constexpr size_t MAX_THREADS = 32;
+
+		// thread_count = 0: gấp đôi số nhân (I/O-bound trên network file system), tối thiểu 4
+		explicit DirectoryScanner(size_t thread_count = 0);
+
+		DirectoryScanner(const DirectoryScanner&) = delete;
+		DirectoryScanner& operator=(const DirectoryScanner&) = delete;
+
+		// Quét toàn bộ cây dưới root, throw std::runtime_error nếu liệt kê một thư mục thất bại (trừ lỗi không có quyền)
+		void Scan(const fs::path& root, const FileSink& sink, const ProgressCallback& progress = nullptr,
+			const DirectorySink& on_directory = nullptr);
+
+		// Áp dụng cho các lần Scan() sau, filter phải tồn tại tới khi Scan() trả về; nullptr để bỏ lọc
+		void SetFilter(const PathFilter* filter) { m_filter = filter; }
+
+		size_t GetThreadCount() const { return m_thread_count; }
+		// Số file và thư mục đã gặp (không tính entry bị lọc) trong lần quét gần nhất
+		size_t GetVisitedCount() const { return m_visited.load(); }
+
+	private:
+		void WorkerLoop(size_t worker, const FileSink& sink, const DirectorySink& on_directory);
+		bool PopTask(size_t worker, DirectoryTask& task);
+		void PushTask(size_t worker, DirectoryTask&& task);
+		void ListDirectory(size_t worker, const DirectoryTask& task, const FileSink& sink, const DirectorySink& on_directory);
+		void Fail(const std::string& message);
+		void NotifyDone();
+		void WakeIdleWorkers(bool all);
+	};
+}
+
+#endif // !DIRECTORY_SCANNER_H
@@ -0,0 +1,77 @@
+#ifndef DIRECTORY_WATCHER_H
+#define DIRECTORY_WATCHER_H
+
+#include <Windows.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+namespace fs = std::filesystem;
+
+namespace utils
+{
+	/*
+	 * @brief Theo dõi thay đổi trong cả cây thư mục bằng một handle ReadDirectoryChangesW (overlapped) trên thread nền
+	 * @brief Các sự kiện của cùng một đường dẫn được gộp lại: đường dẫn chỉ được trả về khi đã yên lặng trong debounce
+	 * @brief (hoặc đã chờ quá MAX_DELAY_FACTOR lần debounce nếu file bị ghi liên tục)
+	 * @brief Khi buffer sự kiện của hệ thống bị tràn, danh sách thay đổi không còn đầy đủ và người gọi phải quét lại
+	 */
+	class DirectoryWatcher
+	{
+	private:
+		struct PendingChange
+		{
+			std::chrono::steady_clock::time_point first_event;
+			std::chrono::steady_clock::time_point last_event;
+		};
+
+		fs::path m_root;
+		std::chrono::steady_clock::duration m_debounce;
+
+		HANDLE m_directory;
+		HANDLE m_stop_event;
+		std::thread m_thread;
+
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::unordered_map<std::wstring, PendingChange> m_pending; // Đường dẫn tương đối so với root
+		bool m_overflowed;
+		bool m_stopped;
+		std::string m_error;
+
+	public:
+		static constexpr std::chrono::milliseconds DEFAULT_DEBOUNCE{ 500 };
+		static constexpr int MAX_DELAY_FACTOR = 10;
+		static constexpr DWORD BUFFER_SIZE = 64 * 1024; // Giới hạn của ReadDirectoryChangesW trên thư mục mạng
+
+		explicit DirectoryWatcher(const fs::path& root, std::chrono::steady_clock::duration debounce = DEFAULT_DEBOUNCE);
+		~DirectoryWatcher();
+
+		DirectoryWatcher(const DirectoryWatcher&) = delete;
+		DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+		// Mở thư mục và bắt đầu nhận sự kiện, throw std::runtime_error nếu không mở được
+		void Start();
+		// Dừng thread theo dõi, WaitForChanges() đang chờ sẽ trả về false
+		void Stop();
+
+		// Chờ tới khi có đường dẫn đã yên lặng đủ lâu, out_paths nhận đường dẫn tương đối so với root (có thể đã bị xoá)
+		// Trả về false khi đã Stop() hoặc việc theo dõi bị lỗi (xem GetError())
+		bool WaitForChanges(std::vector<fs::path>& out_paths, bool& out_overflowed);
+
+		std::string GetError();
+
+	private:
+		void WatchLoop();
+		void Record(const FILE_NOTIFY_INFORMATION* info);
+		void Overflow();
+		void Fail(const std::string& message);
+	};
+}
+
+#endif // !DIRECTORY_WATCHER_H
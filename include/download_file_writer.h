@@ -0,0 +1,92 @@
+#ifndef DOWNLOAD_FILE_WRITER_H
+#define DOWNLOAD_FILE_WRITER_H
+
+#include <Windows.h>
+
+#include <cache_policy.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+namespace fs = std::filesystem;
+
+namespace utils
+{
+	// Chính sách đẩy dữ liệu xuống đĩa: FlushFileBuffers khi đủ số byte hoặc quá thời gian, tuỳ điều kiện nào đến trước
+	struct FlushPolicy
+	{
+		uint64_t max_unflushed_bytes = 64ULL * 1024 * 1024;			// 0: không flush theo số byte
+		std::chrono::milliseconds max_interval = std::chrono::seconds(5); // 0: không flush theo thời gian
+	};
+
+	/*
+	 * @brief Ghi file tải về theo offset của từng chunk thay vì ghi nối tiếp
+	 * @brief File được cấp phát trước đủ file_size nên chunk có thể đến không theo thứ tự hoặc từ nhiều luồng
+	 * @brief direct_io: ghi không qua page cache (FILE_FLAG_NO_BUFFERING), dữ liệu được chép vào buffer căn chỉnh trước khi ghi
+	 * @brief sparse: file được đánh dấu sparse và không cấp phát trước, các đoạn trống được tạo lại bằng PunchHole
+	 */
+	class DownloadFileWriter
+	{
+	private:
+		fs::path m_path;
+		HANDLE m_handle;
+		uint64_t m_file_size;
+		uint32_t m_chunk_size;
+		bool m_direct_io;
+		bool m_sparse;
+		bool m_truncated;
+		FlushPolicy m_policy;
+		CachePolicy m_cache_policy;
+		std::function<void()> m_on_flush;
+
+		std::mutex m_flush_mutex;
+		uint64_t m_unflushed_bytes;
+		std::chrono::steady_clock::time_point m_last_flush;
+
+	public:
+		// truncate = false giữ lại nội dung đã tải (dùng khi resume)
+		// direct_io chỉ được bật khi chunk_size là bội số của DIRECT_IO_ALIGNMENT để các luồng không ghi chung một sector
+		// sparse bị bỏ qua nếu file system không hỗ trợ (FAT, exFAT)
+		DownloadFileWriter(const fs::path& path, uint64_t file_size, uint32_t chunk_size,
+			const FlushPolicy& policy = FlushPolicy(), bool truncate = true, bool direct_io = false, bool sparse = false);
+		~DownloadFileWriter();
+
+		DownloadFileWriter(const DownloadFileWriter&) = delete;
+		DownloadFileWriter& operator=(const DownloadFileWriter&) = delete;
+
+		// Ghi chunk tại chunk_index * chunk_size
+		void WriteChunk(uint32_t chunk_index, const uint8_t* data, size_t size);
+		void WriteAt(uint64_t offset, const uint8_t* data, size_t size);
+
+		// Đoạn [offset, offset + length) đọc ra toàn số 0: giải phóng vùng đĩa với file sparse, ngược lại ghi số 0 nếu file có nội dung cũ
+		void PunchHole(uint64_t offset, uint64_t length);
+
+		void Flush();
+		void Close();
+
+		// Được gọi sau mỗi lần dữ liệu đã ghi được đẩy xuống đĩa
+		void SetFlushCallback(const std::function<void()>& on_flush) { m_on_flush = on_flush; }
+
+		// Ghi qua cache: chỉ low_memory_priority có tác dụng, việc ghi xuống đĩa dần dần do FlushPolicy quyết định
+		void SetCachePolicy(const CachePolicy& cache_policy) { m_cache_policy = cache_policy; }
+
+		bool IsOpen() const { return m_handle != INVALID_HANDLE_VALUE; }
+		bool IsDirectIO() const { return m_direct_io; }
+		bool IsSparse() const { return m_sparse; }
+		const fs::path& GetPath() const { return m_path; }
+
+	private:
+		void Preallocate();
+		void MakeSparse();
+		void SetEndOfFile(uint64_t size);
+		void MaybeFlush(size_t bytes_written);
+
+		void WriteRaw(uint64_t offset, const uint8_t* data, size_t size);
+		void WriteDirect(uint64_t offset, const uint8_t* data, size_t size);
+		void ReadBlock(uint64_t offset, uint8_t* buffer);
+	};
+}
+
+#endif // !DOWNLOAD_FILE_WRITER_H
@@ -12,6 +12,7 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <memory>
 
 namespace security
 {
@@ -36,7 +37,12 @@ namespace security
 
 				void generateRandomBytes(std::vector<uint8_t>& buffer) const
 				{
-					if (RAND_bytes(buffer.data(), static_cast<int>(buffer.size())) != 1)
+					generateRandomBytes(buffer.data(), buffer.size());
+				}
+
+				void generateRandomBytes(uint8_t* buffer, size_t size) const
+				{
+					if (RAND_bytes(buffer, static_cast<int>(size)) != 1)
 					{
 						throw std::runtime_error("Error: Could not generate random bytes.");
 					}
@@ -155,6 +161,110 @@ namespace security
 
 					return true;
 				}
+
+				/*
+				 * @brief Mã hoá size byte từ plaintext vào ciphertext (được phép trùng plaintext để mã hoá tại chỗ)
+				 * @brief iv dài 12 byte, tag nhận 16 byte; context của thread hiện tại được dùng lại nên không cấp phát
+				 */
+				bool encrypt(const uint8_t* plaintext, size_t size, const uint8_t* iv, uint8_t* ciphertext, uint8_t* tag) const
+				{
+					if (size > static_cast<size_t>(INT_MAX))
+					{
+						throw std::runtime_error("Error: Data size too large for AES-128 GCM encryption.");
+					}
+
+					EVP_CIPHER_CTX* ctx = threadContext(true);
+					int len;
+
+					if (EVP_EncryptInit_ex(ctx, NULL, NULL, reinterpret_cast<const uint8_t*>(key.data()), iv) != 1)
+					{
+						throw std::runtime_error("Error: Could not set key and IV for encryption.");
+					}
+
+					if (EVP_EncryptUpdate(ctx, ciphertext, &len, plaintext, static_cast<int>(size)) != 1)
+					{
+						throw std::runtime_error("Error: AES-128 GCM encryption failed.");
+					}
+
+					if (EVP_EncryptFinal_ex(ctx, ciphertext + len, &len) != 1)
+					{
+						throw std::runtime_error("Error: AES-128 GCM encryption finalization failed.");
+					}
+
+					if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, 16, tag) != 1)
+					{
+						throw std::runtime_error("Error: Failed to get GCM authentication tag.");
+					}
+
+					return true;
+				}
+
+				// Giải mã size byte từ ciphertext vào plaintext (được phép trùng ciphertext), tag dài 16 byte
+				bool decrypt(const uint8_t* ciphertext, size_t size, const uint8_t* iv, const uint8_t* tag, uint8_t* plaintext) const
+				{
+					if (size > static_cast<size_t>(INT_MAX))
+					{
+						throw std::runtime_error("Error: Data size too large for AES-128 GCM decryption.");
+					}
+
+					EVP_CIPHER_CTX* ctx = threadContext(false);
+					int len;
+
+					if (EVP_DecryptInit_ex(ctx, NULL, NULL, reinterpret_cast<const uint8_t*>(key.data()), iv) != 1)
+					{
+						throw std::runtime_error("Error: Could not set key and IV for decryption.");
+					}
+
+					if (EVP_DecryptUpdate(ctx, plaintext, &len, ciphertext, static_cast<int>(size)) != 1)
+					{
+						throw std::runtime_error("Error: AES-128 GCM decryption failed.");
+					}
+
+					if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, 16, const_cast<uint8_t*>(tag)) != 1)
+					{
+						throw std::runtime_error("Error: Failed to set GCM authentication tag.");
+					}
+
+					if (EVP_DecryptFinal_ex(ctx, plaintext + len, &len) <= 0)
+					{
+						throw std::runtime_error("Error: AES-128 GCM decryption failed or authentication failed.");
+					}
+
+					return true;
+				}
+
+			private:
+				using CipherContext = std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)>;
+
+				// Mỗi thread giữ một context mã hoá và một context giải mã đã gắn sẵn thuật toán, mỗi gói tin chỉ đặt lại key và IV
+				static EVP_CIPHER_CTX* threadContext(bool encrypting)
+				{
+					thread_local CipherContext encrypt_context(newContext(true), &EVP_CIPHER_CTX_free);
+					thread_local CipherContext decrypt_context(newContext(false), &EVP_CIPHER_CTX_free);
+
+					return encrypting ? encrypt_context.get() : decrypt_context.get();
+				}
+
+				static EVP_CIPHER_CTX* newContext(bool encrypting)
+				{
+					EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+					if (!ctx)
+					{
+						throw std::runtime_error("Error: Could not create EVP_CIPHER_CTX.");
+					}
+
+					int result = encrypting
+						? EVP_EncryptInit_ex(ctx, EVP_aes_128_gcm(), NULL, NULL, NULL)
+						: EVP_DecryptInit_ex(ctx, EVP_aes_128_gcm(), NULL, NULL, NULL);
+
+					if (result != 1)
+					{
+						EVP_CIPHER_CTX_free(ctx);
+						throw std::runtime_error("Error: Could not initialize AES-128 GCM context.");
+					}
+
+					return ctx;
+				}
 			};
 		} // namespace encryption
 
@@ -165,6 +275,12 @@ namespace security
 			public:
 				// Tính MD5 checksum cho một mảng byte
 				static std::vector<uint8_t> calcCheckSum(const std::vector<uint8_t>& data)
+				{
+					return calcCheckSum(data.data(), data.size());
+				}
+
+				// Tính MD5 checksum cho một vùng nhớ
+				static std::vector<uint8_t> calcCheckSum(const uint8_t* data, size_t size)
 				{
 					std::vector<uint8_t> md5_result(EVP_MD_size(EVP_md5()));
 
@@ -180,14 +296,14 @@ namespace security
 						throw std::runtime_error("Error: EVP_DigestInit_ex failed.");
 					}
 
-					if (data.size() > static_cast<size_t>(INT_MAX))
+					if (size > static_cast<size_t>(INT_MAX))
 					{
 						EVP_MD_CTX_free(md_ctx);
 						throw std::runtime_error("Error: Data size too large for MD5_Update.");
 					}
-					int data_size = static_cast<int>(data.size());
+					int data_size = static_cast<int>(size);
 
-					if (EVP_DigestUpdate(md_ctx, data.data(), data_size) != 1)
+					if (EVP_DigestUpdate(md_ctx, data, data_size) != 1)
 					{
 						EVP_MD_CTX_free(md_ctx);
 						throw std::runtime_error("Error: EVP_DigestUpdate failed.");
@@ -205,6 +321,84 @@ namespace security
 					return md5_result;
 				}
 
+				/*
+				 * @brief Ghi MD5 checksum (16 byte) của một vùng nhớ vào out
+				 * @brief Dùng lại EVP_MD_CTX của thread hiện tại, không cấp phát trên đường truyền chunk
+				 */
+				static void calcCheckSum(const uint8_t* data, size_t size, uint8_t* out)
+				{
+					thread_local std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> thread_ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+
+					EVP_MD_CTX* md_ctx = thread_ctx.get();
+					if (!md_ctx)
+					{
+						throw std::runtime_error("Error: EVP_MD_CTX_new failed.");
+					}
+
+					if (EVP_DigestInit_ex(md_ctx, EVP_md5(), NULL) != 1)
+					{
+						throw std::runtime_error("Error: EVP_DigestInit_ex failed.");
+					}
+
+					if (EVP_DigestUpdate(md_ctx, data, size) != 1)
+					{
+						throw std::runtime_error("Error: EVP_DigestUpdate failed.");
+					}
+
+					unsigned int md_len = 0;
+					if (EVP_DigestFinal_ex(md_ctx, out, &md_len) != 1)
+					{
+						throw std::runtime_error("Error: EVP_DigestFinal_ex failed.");
+					}
+				}
+
+				// Tính MD5 checksum cho dữ liệu được cung cấp theo từng khối, next_block trả về false khi hết dữ liệu
+				static std::vector<uint8_t> calcCheckSumBlocks(const std::function<bool(const uint8_t*& data, size_t& size)>& next_block)
+				{
+					EVP_MD_CTX* md_ctx = EVP_MD_CTX_new();
+					if (!md_ctx)
+					{
+						throw std::runtime_error("Error: EVP_MD_CTX_new failed.");
+					}
+
+					if (EVP_DigestInit_ex(md_ctx, EVP_md5(), NULL) != 1)
+					{
+						EVP_MD_CTX_free(md_ctx);
+						throw std::runtime_error("Error: EVP_DigestInit_ex failed.");
+					}
+
+					const uint8_t* data = nullptr;
+					size_t size = 0;
+
+					try
+					{
+						while (next_block(data, size))
+						{
+							if (EVP_DigestUpdate(md_ctx, data, size) != 1)
+							{
+								throw std::runtime_error("Error: EVP_DigestUpdate failed.");
+							}
+						}
+					}
+					catch (...)
+					{
+						EVP_MD_CTX_free(md_ctx);
+						throw;
+					}
+
+					std::vector<uint8_t> md5_result(EVP_MD_size(EVP_md5()));
+					unsigned int md_len = 0;
+					if (EVP_DigestFinal_ex(md_ctx, md5_result.data(), &md_len) != 1)
+					{
+						EVP_MD_CTX_free(md_ctx);
+						throw std::runtime_error("Error: EVP_DigestFinal_ex failed.");
+					}
+
+					md5_result.resize(md_len);
+					EVP_MD_CTX_free(md_ctx);
+					return md5_result;
+				}
+
 				// Tính MD5 checksum cho một chunk file
 				static std::vector<uint8_t> calcCheckSumChunk(const std::string& file_path, size_t chunk_size, size_t offset)
 				{
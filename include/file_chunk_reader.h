@@ -0,0 +1,44 @@
+#ifndef FILE_CHUNK_READER_H
+#define FILE_CHUNK_READER_H
+
+#include <cache_policy.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+namespace fs = std::filesystem;
+
+namespace utils
+{
+	class AllocatedRanges;
+
+	// Nguồn dữ liệu cho upload: trả về span của từng vùng file theo offset
+	class FileChunkReader
+	{
+	public:
+		virtual ~FileChunkReader() = default;
+
+		// Span chỉ hợp lệ tới lần gọi Read() tiếp theo
+		virtual std::span<const uint8_t> Read(uint64_t offset, size_t length) = 0;
+
+		virtual uint64_t GetFileSize() const = 0;
+
+		// MD5 của toàn bộ file, đọc qua Read() theo từng khối
+		// allocated (nếu có): khối nằm trọn trong hole được băm từ buffer 0 mà không đọc file
+		std::vector<uint8_t> CalcCheckSum(const std::function<void(size_t)>& progress_callback = nullptr,
+			const AllocatedRanges* allocated = nullptr);
+
+		// direct_io = true: đọc không qua page cache (DirectFileReader), ngược lại dùng file mapping (MappedFileReader) theo cache_policy
+		static std::unique_ptr<FileChunkReader> Open(const fs::path& path, bool direct_io = false,
+			const CachePolicy& cache_policy = CachePolicy());
+
+	protected:
+		// Kích thước khối khi tính checksum, các khối bắt đầu tại bội số của giá trị này
+		virtual size_t GetHashBlockSize() const = 0;
+	};
+}
+
+#endif // !FILE_CHUNK_READER_H
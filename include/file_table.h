@@ -0,0 +1,79 @@
+#ifndef FILE_TABLE_H
+#define FILE_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+namespace fs = std::filesystem;
+
+namespace utils
+{
+	/*
+	 * @brief Danh sách file của một thư mục upload, lưu theo dạng structure-of-arrays:
+	 * @brief mỗi file chỉ giữ id thư mục cha, offset/độ dài tên trong một arena chung, kích thước và thời điểm ghi (26 byte + tên)
+	 * @brief Thư mục được intern thành node (cha, tên) nên tiền tố đường dẫn chung chỉ lưu một lần
+	 * @brief File và thư mục được tham chiếu bằng chỉ số; thread-safe, có thể thêm file trong lúc thread khác đang đọc
+	 */
+	class FileTable
+	{
+	public:
+		static constexpr uint32_t ROOT_DIRECTORY = 0;
+
+	private:
+		struct DirectoryNode
+		{
+			uint32_t parent;
+			uint32_t name_offset;
+			uint32_t name_length;
+		};
+
+		static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+		fs::path m_base;			   // Thư mục cha của thư mục gốc
+		std::vector<wchar_t> m_names;  // Arena chứa tên của mọi thư mục và file, không có ký tự kết thúc
+		std::vector<DirectoryNode> m_directories;
+
+		std::vector<uint32_t> m_file_directory;
+		std::vector<uint32_t> m_file_name_offset;
+		std::vector<uint16_t> m_file_name_length;
+		std::vector<uint64_t> m_file_size;
+		std::vector<uint64_t> m_file_write_time;
+
+		mutable std::mutex m_mutex;
+
+	public:
+		// Đường dẫn tương đối của file được tính từ thư mục cha của root (gồm cả tên thư mục gốc)
+		explicit FileTable(const fs::path& root);
+
+		FileTable(const FileTable&) = delete;
+		FileTable& operator=(const FileTable&) = delete;
+
+		uint32_t AddDirectory(uint32_t parent, std::wstring_view name);
+		// last_write_time theo đơn vị FILETIME, 0 nếu không biết
+		uint32_t AddFile(uint32_t directory, std::wstring_view name, uint64_t size, uint64_t last_write_time = 0);
+
+		size_t GetFileCount() const;
+		uint64_t GetFileSize(uint32_t file) const;
+		uint64_t GetLastWriteTime(uint32_t file) const;
+
+		fs::path GetAbsolutePath(uint32_t file) const;
+		std::string GetRelativePath(uint32_t file) const;
+
+		// Chỉ số mọi file, sắp xếp theo kích thước giảm dần
+		std::vector<uint32_t> SortBySizeDescending() const;
+
+		// Số byte bộ nhớ đang dùng (tính theo capacity)
+		size_t GetMemoryUsage() const;
+
+	private:
+		uint32_t AppendName(std::wstring_view name);
+		// Các thư mục từ gốc tới directory, nối thêm tên file nếu có
+		fs::path BuildPath(fs::path path, uint32_t directory, uint32_t file) const;
+	};
+}
+
+#endif // !FILE_TABLE_H
@@ -1,14 +1,32 @@
-#ifndef FILE_TRANSFER_MANAGER_H
+﻿#ifndef FILE_TRANSFER_MANAGER_H
 #define FILE_TRANSFER_MANAGER_H
 
 #include <network_connection.h>
 #include <session_manager.h>
 #include <progressbar_manager.h>
 #include <encryption_handler.hpp>
+#include <session_pool.h>
+#include <download_file_writer.h>
+#include <file_chunk_reader.h>
+#include <sparse_file.h>
+#include <small_file_loader.h>
+#include <scan_stream.h>
+#include <file_table.h>
+#include <transfer_scheduler.h>
+#include <path_filter.h>
+#include <directory_manifest.h>
 
 #include <string>
+#include <array>
+#include <optional>
+#include <unordered_map>
 #include <memory>
+#include <atomic>
 #include <filesystem>
+#include <functional>
+#include <stop_token>
+#include <span>
+#include <vector>
 namespace fs = std::filesystem;
 
 class FileTransferClient
@@ -18,49 +36,114 @@ private:
 	std::unique_ptr<SessionManager> m_session_manager;
 	std::unique_ptr<ProgressBarManager> m_pb_manager; // Progress bar manager
 	std::unique_ptr<security::datasecurity::integrity::MD5Handler> md5_handler;
+	std::unique_ptr<SessionPool> m_session_pool; // Worker sessions reused by striped transfers
+	bool m_direct_io; // Đọc/ghi file không qua page cache (FILE_FLAG_NO_BUFFERING)
+	utils::CachePolicy m_cache_policy; // Đọc trước / bỏ trang phía sau khi không dùng direct I/O
+	utils::FlushPolicy m_flush_policy; // Ghi dần dữ liệu tải về xuống đĩa
+	size_t m_max_parallelism; // Số phiên song song tối đa khi upload thư mục
+	std::vector<std::string> m_filter_rules; // Luật lọc áp dụng cho mọi thư mục, trước luật trong .transferignore
+
+	// MD5 của một file upload do bên gọi giữ: có giá trị thì upload dùng lại, rỗng thì upload tính và ghi vào
+	using UploadChecksum = std::optional<std::array<uint8_t, 16>>;
+	// Checksum theo chỉ số file trong FileTable, file không có trong map thì upload như bình thường
+	using UploadChecksums = std::unordered_map<uint32_t, UploadChecksum>;
 
 private:
-	struct FileEntry
-	{
-		std::string absolute_path;
-		std::string relative_path;
-		std::string file_name;
-		uint64_t file_size;
-		bool is_directory;
-
-		FileEntry() : file_size(0), is_directory(false)
-		{
-		}
-
-		FileEntry(const std::string& abs_path,
-			const std::string& rel_path,
-			const std::string& name,
-			uint64_t size, bool is_dir,
-			const uint8_t* checksum = nullptr)
-			: absolute_path(abs_path),
-			relative_path(rel_path),
-			file_name(name),
-			file_size(size),
-			is_directory(is_dir)
-		{
-		}
-	};
+	// Truyền các chunk có chunk_index % stripe_count == stripe_index qua kết nối của client này
+	bool UploadStripe(const fs::path& file_path, uint64_t file_size, uint32_t file_id, size_t chunk_size, uint64_t transfer_id,
+		uint16_t stripe_index, uint16_t stripe_count, std::atomic<uint64_t>& total_sent, const std::atomic<bool>& cancelled);
+	// on_chunk_written được gọi (từ luồng của stripe) sau khi chunk đã ghi vào writer
+	bool DownloadStripe(utils::DownloadFileWriter& writer, uint64_t file_size, uint32_t file_id, size_t chunk_size,
+		uint16_t stripe_index, uint16_t stripe_count, std::atomic<uint64_t>& total_received,
+		const std::function<void(uint32_t)>& on_chunk_written, const std::atomic<bool>& cancelled);
+
+	// Gửi dãy chunk trống (hole hoặc toàn byte 0) liên tiếp từ first_chunk bằng một FILE_HOLE_MAP, trả về chunk đầu tiên sau dãy
+	size_t UploadHoleRun(utils::FileChunkReader& reader, const utils::AllocatedRanges& allocated, uint32_t file_id,
+		uint64_t file_size, size_t chunk_size, size_t first_chunk);
+
+	// Đọc một lô file nhỏ liên tiếp từ đầu files qua loader rồi upload inline
+	void UploadSmallFileBatch(utils::SmallFileLoader& loader, const utils::FileTable& table, std::span<const uint32_t> files,
+		std::vector<std::string>& failed_files, size_t& completed, UploadChecksums* checksums = nullptr);
+	// Upload file đầu tiên của files, hoặc cả lô file nhỏ liên tiếp từ đầu files; completed tăng sau mỗi file xử lý xong
+	void UploadNextEntries(utils::SmallFileLoader& loader, const utils::FileTable& table, std::span<const uint32_t> files,
+		std::vector<std::string>& failed_files, size_t& completed, UploadChecksums* checksums = nullptr);
+	// Xử lý một item của TransferScheduler trên phiên này, completed cho biết các file đầu item đã xong nếu có exception
+	void UploadWorkItem(utils::SmallFileLoader& loader, const utils::FileTable& table, const utils::WorkItem& item,
+		std::vector<std::string>& failed_files, size_t& completed);
+
+	// Xếp các file nhỏ lên đầu lô để chúng được đọc chung
+	static void PartitionSmallFiles(const utils::FileTable& table, std::vector<uint32_t>& files);
+	// Checksum bên gọi giữ cho file, nullptr nếu không có
+	static UploadChecksum* ChecksumOf(UploadChecksums* checksums, uint32_t file);
+	// Tổng số file dùng cho tiến trình tổng khi việc quét chưa xong
+	static size_t EstimateTotalFiles(const utils::ScanStream& stream, size_t total_files);
+	// Báo lỗi quét (nếu có) sau khi upload xong, trả về kết quả cho UploadDirectory*
+	static bool FinishScan(const utils::ScanStream& stream);
+
+	// Đóng gói files thành work item: file lớn là một item riêng, file nhỏ gom vào small và được submit khi lô đầy
+	static void SubmitWorkItems(utils::TransferScheduler& scheduler, const utils::FileTable& table, std::span<const uint32_t> files,
+		utils::WorkItem& small);
+	static void FlushSmallBatch(utils::TransferScheduler& scheduler, utils::WorkItem& small);
+	// Chạy các phiên upload song song (số phiên do ConcurrencyController chọn) cho tới khi scheduler hết việc
+	// manifest (nếu có) nhận trạng thái của từng file khi nó bắt đầu và kết thúc
+	void RunDirectoryWorkers(const utils::FileTable& table, utils::TransferScheduler& scheduler, std::vector<std::string>& failed_files,
+		utils::DirectoryManifest* manifest = nullptr);
+
 public:
 	FileTransferClient();
+	~FileTransferClient();
 
 	NetworkConnection& GetConnection() { return *m_connection; }
 	SessionManager& GetSessionManager() { return *m_session_manager; }
 	ProgressBarManager& GetProgressBarManager() { return *m_pb_manager; }
+	SessionPool& GetSessionPool();
+
+	// Opt-in cho file rất lớn: không làm đầy page cache của máy dùng chung
+	void SetDirectIO(bool enabled) { m_direct_io = enabled; }
+	bool IsDirectIO() const { return m_direct_io; }
+	// Opt-in lúc khởi động: buffer direct I/O lớn dùng large page (cần quyền "Lock pages in memory"), false nếu không được phép
+	bool EnableLargePages();
+
+	// Trần số phiên upload thư mục song song, số thực tế do ConcurrencyController chọn theo goodput, RTT và CPU
+	void SetMaxParallelism(size_t max_workers) { m_max_parallelism = max_workers; }
+	size_t GetMaxParallelism() const { return m_max_parallelism; }
+
+	// Luật include/exclude theo cú pháp .gitignore cho các thao tác trên thư mục, ví dụ "node_modules", "*.tmp", "build/"
+	void SetFilterRules(std::vector<std::string> rules) { m_filter_rules = std::move(rules); }
+	const std::vector<std::string>& GetFilterRules() const { return m_filter_rules; }
+	// Luật của client cộng với file .transferignore ở gốc dir_path (nếu có)
+	utils::PathFilter LoadPathFilter(const fs::path& dir_path) const;
+
+	void SetCachePolicy(const utils::CachePolicy& cache_policy) { m_cache_policy = cache_policy; }
+	void SetFlushPolicy(const utils::FlushPolicy& flush_policy) { m_flush_policy = flush_policy; }
 
-	bool UploadFile(const fs::path& file_path, const std::string& remote_path);
-	bool DownloadFile(const std::string& file_name);
+	bool UploadFile(const fs::path& file_path, const std::string& remote_path, UploadChecksum* checksum = nullptr);
+	bool DeltaUploadFile(const fs::path& file_path, const std::string& remote_path);
+	bool UploadSmallFile(const fs::path& file_path, const std::string& remote_path, UploadChecksum* checksum = nullptr);
+	bool UploadInline(const std::string& remote_path, std::span<const uint8_t> data, UploadChecksum* checksum = nullptr);
+	bool UploadFileStriped(const fs::path& file_path, const std::string& remote_path, uint16_t stripe_count);
+	// output_path: ghi vào đường dẫn này (thay thế file cũ) thay vì file_name trong thư mục hiện tại
+	bool DownloadFile(const std::string& file_name, const std::string& output_path = "");
+	bool DeltaDownloadFile(const std::string& file_name);
+	bool DownloadFileStriped(const std::string& file_name, uint16_t stripe_count);
+	// Tải các đoạn byte của file và ghi vào đúng offset của output_path (mặc định là file cùng tên)
+	bool DownloadRanges(const std::string& file_name, const std::vector<ByteRangeDTO>& ranges, const std::string& output_path = "");
 
-	bool ResumeDownload(const std::string& filename);
-	bool GetServerFileList();
+	bool ResumeDownload(uint64_t transfer_id);
+	// Danh sách file và thư mục của user trên server (VIEW_CLOUD)
+	bool GetServerFileList(std::vector<FileEntryDTO>& out_entries);
 
-	std::vector<FileEntry> ScanDirectory(const fs::path& dir_path, size_t total_files);
+	// Ghi các file vào table, trả về chỉ số của chúng theo kích thước giảm dần; throw nếu thư mục rỗng trừ khi allow_empty
+	std::vector<uint32_t> ScanDirectory(const fs::path& dir_path, size_t total_files, utils::FileTable& table, bool allow_empty = false);
 	bool UploadDirectory(const fs::path& dir_path, size_t total_files);
+	// Trạng thái từng file được ghi vào DirectoryManifest: lần chạy sau sau khi bị gián đoạn chỉ upload phần còn lại
 	bool UploadDirectoryParallel(const fs::path& dir_path, size_t total_files);
+	// Chỉ upload file mới hoặc đã thay đổi so với SyncIndex của thư mục, file chưa đổi được bỏ qua mà không đọc nội dung
+	bool SyncDirectory(const fs::path& dir_path, size_t total_files);
+	// Đồng bộ hai chiều với bản trên server: chỉ chép những file khác nhau, xung đột được liệt kê và giữ nguyên
+	bool MirrorDirectory(const fs::path& dir_path, size_t total_files);
+	// Sync một lần rồi upload các file thay đổi ngay khi chúng yên lặng (DirectoryWatcher), chạy tới khi stop được yêu cầu
+	bool WatchDirectory(const fs::path& dir_path, std::stop_token stop);
 	bool ResumeUpload(const fs::path& file_path);
 
 	void CloseSession();
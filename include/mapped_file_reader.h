@@ -0,0 +1,63 @@
+#ifndef MAPPED_FILE_READER_H
+#define MAPPED_FILE_READER_H
+
+#include <Windows.h>
+
+#include <file_chunk_reader.h>
+
+namespace utils
+{
+	constexpr size_t DEFAULT_MAP_WINDOW = 64ULL * 1024 * 1024; // 64MB
+
+	/*
+	 * @brief Đọc file upload qua file mapping: mỗi chunk là một span trỏ thẳng vào page cache, không cấp phát và không copy
+	 * @brief File lớn được map theo từng cửa sổ; trong cửa sổ, vùng phía trước con trỏ được PrefetchVirtualMemory
+	 * @brief và các trang phía sau bị loại khỏi working set theo CachePolicy
+	 * @brief File được mở không chia sẻ quyền ghi để không process nào cắt ngắn được vùng đang map
+	 */
+	class MappedFileReader : public FileChunkReader
+	{
+	private:
+		fs::path m_path;
+		HANDLE m_handle;
+		HANDLE m_mapping;
+		uint64_t m_file_size;
+		size_t m_window_size;
+		DWORD m_granularity;
+		DWORD m_page_size;
+		CachePolicy m_cache_policy;
+
+		const uint8_t* m_view;
+		uint64_t m_view_offset;
+		size_t m_view_size;
+		uint64_t m_prefetched_until; // Đã yêu cầu đọc trước tới offset này (trong cửa sổ hiện tại)
+		uint64_t m_dropped_until;	 // Các trang trước offset này đã bị loại khỏi working set
+
+	public:
+		explicit MappedFileReader(const fs::path& path, size_t window_size = DEFAULT_MAP_WINDOW,
+			const CachePolicy& cache_policy = CachePolicy());
+		~MappedFileReader() override;
+
+		MappedFileReader(const MappedFileReader&) = delete;
+		MappedFileReader& operator=(const MappedFileReader&) = delete;
+
+		// Span chỉ hợp lệ tới lần gọi Read() tiếp theo
+		std::span<const uint8_t> Read(uint64_t offset, size_t length) override;
+
+		uint64_t GetFileSize() const override { return m_file_size; }
+		const fs::path& GetPath() const { return m_path; }
+
+	protected:
+		// Checksum được tính trên từng cửa sổ đã map
+		size_t GetHashBlockSize() const override { return m_window_size; }
+
+	private:
+		void MapWindow(uint64_t offset, size_t length);
+		void Prefetch(uint64_t from, uint64_t to);
+		void DropBehind(uint64_t offset);
+		void Unmap();
+		void Close();
+	};
+}
+
+#endif // !MAPPED_FILE_READER_H
@@ -2,10 +2,13 @@
 #define NETWORK_CONNECTION_H
 
 #include <packet_helper.hpp>
+#include <transfer_arena.h>
+#include <transfer_stats.h>
 
 #include <chrono>
 #include <iostream>
 #include <memory>
+#include <span>
 #include <string>
 #include <thread>
 #include <vector>
@@ -22,6 +25,7 @@ public:
 
 	void Connect(const std::string& server_ip, uint16_t server_port);
 	bool Send(const std::vector<uint8_t>& data) const;
+	bool Send(const uint8_t* data, size_t size) const;
 	bool Receive(uint8_t* data, size_t size) const;
 	void Disconnect();
 	bool Reconnect();
@@ -33,8 +37,9 @@ public:
 	template <typename T>
 	bool sendPacket(const PacketType& type, const T& data, const uint8_t* sessionId = nullptr)
 	{
-		// Tạo gói tin đã tuần tự hoá
-		std::vector<uint8_t> packet = PacketHelper::CreatePacket(type, data, sessionId);
+		// Tạo gói tin đã mã hoá trong arena gửi, vùng nhớ được dùng lại cho gói tin tiếp theo
+		m_send_arena.Reset();
+		std::span<const uint8_t> packet = PacketHelper::CreatePacket(type, data, sessionId, m_send_arena);
 
 		if (packet.empty())
 		{
@@ -43,12 +48,15 @@ public:
 		}
 
 		// Gửi gói tin
-		if (!Send(packet))
+		if (!Send(packet.data(), packet.size()))
 		{
 			std::cerr << "Failed to send packet." << std::endl;
 			return false;
 		}
 
+		m_request_time = std::chrono::steady_clock::now();
+		m_awaiting_response = true;
+
 		return true;
 	}
 
@@ -69,20 +77,24 @@ public:
 			return false;
 		}
 
-		std::vector<uint8_t> encrypted_packet(prefix.encrypted_packet_length);
+		// Gói tin nhận vào arena và giải mã tại chỗ; payload dạng view (PacketFileChunkView) trỏ vào vùng này tới lần nhận tiếp theo
+		m_recv_arena.Reset();
+		uint8_t* encrypted_packet = m_recv_arena.Allocate(prefix.encrypted_packet_length);
 
-		if (!Receive(encrypted_packet.data(), encrypted_packet.size()))
+		if (!Receive(encrypted_packet, prefix.encrypted_packet_length))
 		{
 			std::cerr << "Failed to receive encrypted packet." << std::endl;
 			return false;
 		}
 
-		// Chèn PacketPrefix vào đầu encrypted packet
-		encrypted_packet.insert(encrypted_packet.begin(),
-			reinterpret_cast<uint8_t*>(&prefix),
-			reinterpret_cast<uint8_t*>(&prefix) + sizeof(PacketPrefix));
+		// Giao thức hỏi-đáp: thời gian từ gói gửi gần nhất tới khi nhận đủ gói trả lời là RTT của request
+		if (m_awaiting_response)
+		{
+			utils::TransferStats::Shared().AddRoundTrip(std::chrono::steady_clock::now() - m_request_time);
+			m_awaiting_response = false;
+		}
 
-		std::vector<uint8_t> decrypted_packet = PacketHelper::DecryptPacket(encrypted_packet.data(), encrypted_packet.size());
+		std::span<uint8_t> decrypted_packet = PacketHelper::DecryptPacketInPlace(encrypted_packet, prefix.encrypted_packet_length);
 
 		if (decrypted_packet.empty())
 		{
@@ -136,6 +148,13 @@ private:
 	uint16_t m_server_port;
 	bool m_is_connected;
 
+	// Buffer gói tin của phiên truyền: gửi và nhận tách riêng để view của gói vừa nhận còn hợp lệ khi gửi ACK
+	utils::TransferArena m_send_arena;
+	utils::TransferArena m_recv_arena;
+
+	std::chrono::steady_clock::time_point m_request_time; // Thời điểm gửi gói tin gần nhất
+	bool m_awaiting_response;
+
 	static constexpr auto MAX_ATTEMPTS = 3;
 	static constexpr auto MAX_TIMEOUT = 300; // seconds
 	static constexpr size_t MAX_PAYLOAD_SIZE = 1024 * 1024 * 32 + 1024 * 512; // 32 MB + 512KB
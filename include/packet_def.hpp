@@ -6,6 +6,7 @@
 #include <cstring> // For memcpy
 #include <stdexcept>
 #include <string>
+#include <span>
 #include <utility>
 #include <vector>
 
@@ -48,7 +49,28 @@ enum class PacketType : uint8_t
 	FILE_CHUNK_ACK, // File chunk acknowledgment
 
 	CLOSE_SESSION, // Close the session
-	ERR_PACKET	   // Error packet
+	ERR_PACKET,	   // Error packet
+
+	// New packet types are appended here so the values above stay compatible with older servers
+
+	BLOCK_SIGNATURE_REQUEST,  // Request block signatures of a remote file
+	BLOCK_SIGNATURE_RESPONSE, // Block signatures of a remote file
+	DELTA_UPLOAD_REQUEST,	  // Upload a file as a delta against the remote version
+	DELTA_CHUNK,			  // Chunk of delta instructions
+	DELTA_DOWNLOAD_REQUEST,	  // Download only the blocks that differ from a local copy
+
+	UPLOAD_INLINE_REQUEST, // Upload a small file with its data in a single packet
+	UPLOAD_INLINE_RESPONSE, // Combined upload result of an inline upload
+
+	STRIPED_DOWNLOAD_REQUEST, // Download a file over several connections, chunks are sent only after stripes attach
+	STRIPE_ATTACH_REQUEST,	  // Attach a connection to a striped transfer
+	STRIPE_ATTACH_RESPONSE,	  // Stripe attach result
+
+	RANGE_DOWNLOAD_REQUEST,	 // Download one or more byte ranges of a file
+	RANGE_DOWNLOAD_RESPONSE, // Resolved ranges of a range download
+	RANGE_CHUNK,			 // Data of a byte range at an absolute file offset
+
+	FILE_HOLE_MAP // Zero-filled extents of a sparse file, sent instead of the chunks they cover
 };
 
 
@@ -341,24 +363,31 @@ struct PacketAuthenticationResponse
 	}
 };
 
+// Các bit của FileEntryDTO::is_dir, server cũ chỉ gửi 0 hoặc 1
+constexpr uint8_t FILE_ENTRY_DIRECTORY = 0x01;
+constexpr uint8_t FILE_ENTRY_HAS_CHECKSUM = 0x02; // Entry có thêm 16 byte MD5 sau file_name
+
 struct FileEntryDTO
 {
 	uint64_t file_size;		   // File size (in bytes) - (8 bytes)
-	uint8_t is_dir;			   // Is directory (1 byte)
+	uint8_t is_dir;			   // Is directory (1 byte), xem FILE_ENTRY_*
 	uint16_t file_path_length; // File path length - (2 bytes)
 	uint16_t file_name_length; // File name length - (2 bytes)
 
 	std::string file_path; // File path
 	std::string file_name; // File name
 
-	// Total size: 23 bytes (fixed-size fields) + variable-size fields
+	uint8_t checksum[16]; // Optional: MD5 of the file, present when is_dir has FILE_ENTRY_HAS_CHECKSUM (16 bytes)
+
+	// Total size: 13 bytes (fixed-size fields) + variable-size fields + optional 16 bytes
 
 	FileEntryDTO() : file_size(0),
 		is_dir(0),
 		file_path_length(0),
 		file_name_length(0),
 		file_path(),
-		file_name()
+		file_name(),
+		checksum{ 0 }
 	{
 	}
 
@@ -369,7 +398,8 @@ struct FileEntryDTO
 		file_path_length(static_cast<uint16_t>(path.length())),
 		file_name_length(static_cast<uint16_t>(name.length())),
 		file_path(path),
-		file_name(name)
+		file_name(name),
+		checksum{ 0 }
 	{
 	}
 
@@ -377,7 +407,8 @@ struct FileEntryDTO
 	{
 		return sizeof(file_size) + sizeof(is_dir) +
 			sizeof(file_path_length) + sizeof(file_name_length) +
-			file_path.size() + file_name.size();
+			file_path.size() + file_name.size() +
+			(HasChecksum() ? sizeof(checksum) : 0);
 	}
 
 	std::vector<uint8_t> serialize() const
@@ -405,14 +436,19 @@ struct FileEntryDTO
 		buffer.insert(buffer.end(), file_path.begin(), file_path.end());
 		buffer.insert(buffer.end(), file_name.begin(), file_name.end());
 
+		if (HasChecksum())
+		{
+			buffer.insert(buffer.end(), checksum, checksum + sizeof(checksum));
+		}
+
 		return buffer;
 	}
 
 	static FileEntryDTO deserialize(const uint8_t* data, size_t size)
 	{
 		size_t offset = 0;
-		size_t fixed_size = sizeof(uint64_t) + sizeof(uint64_t) + sizeof(uint8_t) +
-			sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint16_t);
+		size_t fixed_size = sizeof(uint64_t) + sizeof(uint8_t) +
+			sizeof(uint16_t) + sizeof(uint16_t);
 
 		if (size < fixed_size)
 			throw std::runtime_error("Insufficient data for FileEntry deserialization");
@@ -432,7 +468,8 @@ struct FileEntryDTO
 		offset += sizeof(entry.file_name_length);
 
 		// Calculate expected size
-		size_t expected_size = fixed_size + entry.file_path_length + entry.file_name_length;
+		size_t expected_size = fixed_size + entry.file_path_length + entry.file_name_length +
+			(entry.HasChecksum() ? sizeof(entry.checksum) : 0);
 
 		if (size < expected_size)
 			throw std::runtime_error("Insufficient data for FileEntry deserialization");
@@ -442,17 +479,27 @@ struct FileEntryDTO
 		offset += entry.file_path_length;
 
 		entry.file_name.assign(data + offset, data + offset + entry.file_name_length);
-		// No need to increment offset because this is the last field
+		offset += entry.file_name_length;
+
+		if (entry.HasChecksum())
+		{
+			memcpy(entry.checksum, data + offset, sizeof(entry.checksum));
+		}
 
 		return entry;
 	}
 
 	std::string GetFilePath() const { return file_path; }
 	std::string GetFileName() const { return file_name; }
-	bool IsDirectory() const { return is_dir != 0; }
+	bool IsDirectory() const { return (is_dir & FILE_ENTRY_DIRECTORY) != 0; }
+	bool HasChecksum() const { return (is_dir & FILE_ENTRY_HAS_CHECKSUM) != 0; }
 };
 
-// No need to define PacketViewCloudRequest because it does not have any payload
+// VIEW_CLOUD_REQUEST has no payload
+struct PacketViewCloudRequest
+{
+	std::vector<uint8_t> serialize() const { return {}; }
+};
 
 struct PacketViewCloudResponse
 {
@@ -529,6 +576,19 @@ struct PacketViewCloudResponse
 	}
 };
 
+// Payload VIEW_CLOUD_RESPONSE đã tách thành tổng quan và danh sách entry, dùng với recvPacket
+struct PacketViewCloudListing
+{
+	PacketViewCloudResponse summary;
+	std::vector<FileEntryDTO> entries;
+
+	static PacketViewCloudListing deserialize(const uint8_t* data, size_t size)
+	{
+		auto [summary, entries] = PacketViewCloudResponse::deserialize(data, size);
+		return { summary, std::move(entries) };
+	}
+};
+
 struct PacketCreateDirRequest
 {
 	uint16_t dir_path_length; // Directory path length - (2 bytes)
@@ -652,6 +712,44 @@ struct PacketCreateDirResponse
 	}
 };
 
+// Một đoạn byte liên tục của file (dùng cho hole map của file sparse)
+struct FileExtentDTO
+{
+	uint64_t offset; // Start of the extent - (8 bytes)
+	uint64_t length; // Length of the extent - (8 bytes)
+	// Total size: 16 bytes
+
+	FileExtentDTO() : offset(0), length(0) {}
+
+	FileExtentDTO(uint64_t offset, uint64_t length) : offset(offset), length(length) {}
+
+	static size_t GetSize()
+	{
+		return sizeof(offset) + sizeof(length);
+	}
+
+	void serialize(std::vector<uint8_t>& buffer) const
+	{
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&offset),
+			reinterpret_cast<const uint8_t*>(&offset) + sizeof(offset));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&length),
+			reinterpret_cast<const uint8_t*>(&length) + sizeof(length));
+	}
+
+	static FileExtentDTO deserialize(const uint8_t* data)
+	{
+		FileExtentDTO extent{};
+
+		memcpy(&extent.offset, data, sizeof(extent.offset));
+		memcpy(&extent.length, data + sizeof(extent.offset), sizeof(extent.length));
+
+		return extent;
+	}
+};
+
 struct PacketUploadRequest
 {
 	uint64_t file_size;		   // File size (in bytes) - (8 bytes)
@@ -662,7 +760,9 @@ struct PacketUploadRequest
 	std::string file_name; // File name
 	std::string file_type; // File type
 
-	// Total size: 28 bytes (fixed-size fields) + variable-size fields
+	bool sparse_supported; // Optional: client may replace zero chunks with FILE_HOLE_MAP (1 byte)
+
+	// Total size: 28 bytes (fixed-size fields) + variable-size fields + optional 1 byte
 
 	PacketUploadRequest()
 		: file_size(0),
@@ -670,18 +770,20 @@ struct PacketUploadRequest
 		file_name_length(0),
 		file_type_length(0),
 		file_name(),
-		file_type()
+		file_type(),
+		sparse_supported(false)
 	{
 	}
 
 	PacketUploadRequest(const std::string& name, const std::string& type,
-		uint64_t size, const uint8_t* checksum)
+		uint64_t size, const uint8_t* checksum, bool sparse = false)
 		: file_size(size),
 		checksum{ 0 },
 		file_name_length(static_cast<uint16_t>(name.length())),
 		file_type_length(static_cast<uint16_t>(type.length())),
 		file_name(name),
-		file_type(type)
+		file_type(type),
+		sparse_supported(sparse)
 	{
 		if (checksum)
 		{
@@ -717,6 +819,12 @@ struct PacketUploadRequest
 		buffer.insert(buffer.end(), file_name.begin(), file_name.end());
 		buffer.insert(buffer.end(), file_type.begin(), file_type.end());
 
+		// Phần mở rộng, server cũ bỏ qua byte thừa
+		if (sparse_supported)
+		{
+			buffer.push_back(1);
+		}
+
 		return buffer;
 	}
 
@@ -755,7 +863,13 @@ struct PacketUploadRequest
 		offset += request.file_name_length;
 
 		request.file_type.assign(reinterpret_cast<const char*>(data + offset), request.file_type_length);
-		// No need to increment offset because this is the last field
+		offset += request.file_type_length;
+
+		// Optional sparse flag
+		if (size > offset)
+		{
+			request.sparse_supported = data[offset] != 0;
+		}
 
 		return request;
 	}
@@ -876,10 +990,13 @@ struct PacketUploadResponse
 		} out_of_space;
 	};
 
-	PacketUploadResponse() : status(UploadStatus::UPLOAD_ALLOWED), upload_allowed{ 0, 0 } {}
+	bool sparse_accepted; // Optional (UPLOAD_ALLOWED): server accepts FILE_HOLE_MAP for this upload (1 byte)
 
-	PacketUploadResponse(UploadStatus status, uint32_t file_id, uint32_t chunk_size)
-		: status(status)
+	PacketUploadResponse() : status(UploadStatus::UPLOAD_ALLOWED), upload_allowed{ 0, 0 }, sparse_accepted(false) {}
+
+	PacketUploadResponse(UploadStatus status, uint32_t file_id, uint32_t chunk_size, bool sparse = false)
+		: status(status),
+		sparse_accepted(sparse)
 	{
 		if (status == UploadStatus::UPLOAD_ALLOWED)
 		{
@@ -889,7 +1006,8 @@ struct PacketUploadResponse
 	}
 
 	PacketUploadResponse(UploadStatus status, const std::string& msg)
-		: status(status)
+		: status(status),
+		sparse_accepted(false)
 	{
 		if (status == UploadStatus::OUT_OF_SPACE)
 		{
@@ -921,6 +1039,11 @@ struct PacketUploadResponse
 			buffer.insert(buffer.end(),
 				reinterpret_cast<const uint8_t*>(&upload_allowed),
 				reinterpret_cast<const uint8_t*>(&upload_allowed) + sizeof(upload_allowed));
+
+			if (sparse_accepted)
+			{
+				buffer.push_back(1);
+			}
 		}
 		else if (status == UploadStatus::OUT_OF_SPACE)
 		{
@@ -948,6 +1071,13 @@ struct PacketUploadResponse
 				throw std::runtime_error("Insufficient data for PacketUploadResponse deserialization");
 
 			memcpy(&response.upload_allowed, data + offset, sizeof(response.upload_allowed));
+			offset += sizeof(response.upload_allowed);
+
+			// Server cũ không gửi cờ sparse
+			if (size > offset)
+			{
+				response.sparse_accepted = data[offset] != 0;
+			}
 		}
 		else if (response.status == UploadStatus::OUT_OF_SPACE)
 		{
@@ -965,13 +1095,15 @@ struct PacketDownloadRequest
 {
 	uint16_t file_name_length; // File name length - (2 bytes)
 	std::string file_name;	   // File name
-	// Total size: 2 bytes (fixed-size fields) + variable-size fields
+	bool sparse_supported;	   // Optional: client accepts a hole map in the response (1 byte)
+	// Total size: 2 bytes (fixed-size fields) + variable-size fields + optional 1 byte
 
-	PacketDownloadRequest() : file_name_length(0), file_name() {}
+	PacketDownloadRequest() : file_name_length(0), file_name(), sparse_supported(false) {}
 
-	PacketDownloadRequest(const std::string& name)
+	PacketDownloadRequest(const std::string& name, bool sparse = false)
 		: file_name_length(static_cast<uint16_t>(name.length())),
-		file_name(name)
+		file_name(name),
+		sparse_supported(sparse)
 	{
 	}
 
@@ -989,6 +1121,11 @@ struct PacketDownloadRequest
 		// Serialize variable-size fields
 		buffer.insert(buffer.end(), file_name.begin(), file_name.end());
 
+		if (sparse_supported)
+		{
+			buffer.push_back(1);
+		}
+
 		return buffer;
 	}
 
@@ -1014,6 +1151,13 @@ struct PacketDownloadRequest
 
 		// Deserialize variable-size fields
 		request.file_name.assign(reinterpret_cast<const char*>(data + offset), request.file_name_length);
+		offset += request.file_name_length;
+
+		// Optional sparse flag
+		if (size > offset)
+		{
+			request.sparse_supported = data[offset] != 0;
+		}
 
 		return request;
 	}
@@ -1050,12 +1194,17 @@ struct PacketDownloadResponse
 		} error_info;
 	};
 
-	PacketDownloadResponse() : status(DownloadStatus::FILE_FOUND), file_info{ 0, 0, 0 } {}
+	// Optional (FILE_FOUND, chỉ khi client hỗ trợ sparse): các đoạn trống căn theo chunk, server không gửi chunk nằm trong các đoạn này
+	std::vector<FileExtentDTO> holes;
+
+	PacketDownloadResponse() : status(DownloadStatus::FILE_FOUND), file_info{ 0, 0, 0 }, holes() {}
 
 	PacketDownloadResponse(DownloadStatus status,
 		uint32_t file_id, uint64_t size,
-		uint32_t chunk_size, const uint8_t* checksum)
-		: status(status)
+		uint32_t chunk_size, const uint8_t* checksum,
+		const std::vector<FileExtentDTO>& holes = {})
+		: status(status),
+		holes(holes)
 	{
 		if (status == DownloadStatus::FILE_FOUND)
 		{
@@ -1071,7 +1220,8 @@ struct PacketDownloadResponse
 	}
 
 	PacketDownloadResponse(DownloadStatus status, const std::string& msg)
-		: status(status)
+		: status(status),
+		holes()
 	{
 		if (status == DownloadStatus::FILE_NOT_FOUND || status == DownloadStatus::FILE_ACCESS_DENIED)
 		{
@@ -1103,6 +1253,19 @@ struct PacketDownloadResponse
 			buffer.insert(buffer.end(),
 				reinterpret_cast<const uint8_t*>(&file_info),
 				reinterpret_cast<const uint8_t*>(&file_info) + sizeof(file_info));
+
+			if (!holes.empty())
+			{
+				uint32_t hole_count = static_cast<uint32_t>(holes.size());
+				buffer.insert(buffer.end(),
+					reinterpret_cast<const uint8_t*>(&hole_count),
+					reinterpret_cast<const uint8_t*>(&hole_count) + sizeof(hole_count));
+
+				for (const auto& hole : holes)
+				{
+					hole.serialize(buffer);
+				}
+			}
 		}
 		else if (status == DownloadStatus::FILE_NOT_FOUND || status == DownloadStatus::FILE_ACCESS_DENIED)
 		{
@@ -1130,6 +1293,25 @@ struct PacketDownloadResponse
 				throw std::runtime_error("Insufficient data for PacketDownloadResponse deserialization");
 
 			memcpy(&response.file_info, data + offset, sizeof(response.file_info));
+			offset += sizeof(response.file_info);
+
+			// Optional hole map
+			if (size >= offset + sizeof(uint32_t))
+			{
+				uint32_t hole_count = 0;
+				memcpy(&hole_count, data + offset, sizeof(hole_count));
+				offset += sizeof(hole_count);
+
+				if (size < offset + static_cast<size_t>(hole_count) * FileExtentDTO::GetSize())
+					throw std::runtime_error("Insufficient data for PacketDownloadResponse deserialization");
+
+				response.holes.reserve(hole_count);
+				for (uint32_t i = 0; i < hole_count; i++)
+				{
+					response.holes.push_back(FileExtentDTO::deserialize(data + offset));
+					offset += FileExtentDTO::GetSize();
+				}
+			}
 		}
 		else if (response.status == DownloadStatus::FILE_NOT_FOUND || response.status == DownloadStatus::FILE_ACCESS_DENIED)
 		{
@@ -1148,20 +1330,27 @@ struct PacketResumeRequest
 	uint32_t file_id;		   // File ID (unique identifier) - (4 bytes)
 	uint64_t resume_position;  // Resume position (in bytes) - (8 bytes)
 	uint32_t last_chunk_index; // Last chunk index (0-based) - (4 bytes)
-	// Total size: 16 bytes
+	std::vector<uint8_t> chunk_bitmap; // Optional compressed bitmap of the chunks the client already has (utils::ChunkBitmap)
+	// Total size: 16 bytes + optional (4 bytes length + bitmap)
 
-	PacketResumeRequest() : file_id(0), resume_position(0), last_chunk_index(0) {}
+	PacketResumeRequest() : file_id(0), resume_position(0), last_chunk_index(0), chunk_bitmap() {}
 
-	PacketResumeRequest(uint32_t id, uint64_t position, uint32_t index)
+	PacketResumeRequest(uint32_t id, uint64_t position, uint32_t index, const std::vector<uint8_t>& bitmap = {})
 		: file_id(id),
 		resume_position(position),
-		last_chunk_index(index)
+		last_chunk_index(index),
+		chunk_bitmap(bitmap)
 	{
 	}
 
 	std::vector<uint8_t> serialize() const
 	{
 		size_t total_size = sizeof(file_id) + sizeof(resume_position) + sizeof(last_chunk_index);
+		if (!chunk_bitmap.empty())
+		{
+			total_size += sizeof(uint32_t) + chunk_bitmap.size();
+		}
+
 		std::vector<uint8_t> buffer;
 		buffer.reserve(total_size);
 
@@ -1178,6 +1367,16 @@ struct PacketResumeRequest
 			reinterpret_cast<const uint8_t*>(&last_chunk_index),
 			reinterpret_cast<const uint8_t*>(&last_chunk_index) + sizeof(last_chunk_index));
 
+		// Bitmap là phần mở rộng, server cũ chỉ đọc 16 byte đầu
+		if (!chunk_bitmap.empty())
+		{
+			uint32_t bitmap_length = static_cast<uint32_t>(chunk_bitmap.size());
+			buffer.insert(buffer.end(),
+				reinterpret_cast<const uint8_t*>(&bitmap_length),
+				reinterpret_cast<const uint8_t*>(&bitmap_length) + sizeof(bitmap_length));
+			buffer.insert(buffer.end(), chunk_bitmap.begin(), chunk_bitmap.end());
+		}
+
 		return buffer;
 	}
 
@@ -1199,7 +1398,20 @@ struct PacketResumeRequest
 		offset += sizeof(request.resume_position);
 
 		memcpy(&request.last_chunk_index, data + offset, sizeof(request.last_chunk_index));
-		// No need to increment offset because this is the last field
+		offset += sizeof(request.last_chunk_index);
+
+		// Optional chunk bitmap
+		if (size >= offset + sizeof(uint32_t))
+		{
+			uint32_t bitmap_length = 0;
+			memcpy(&bitmap_length, data + offset, sizeof(bitmap_length));
+			offset += sizeof(bitmap_length);
+
+			if (size < offset + bitmap_length)
+				throw std::runtime_error("Insufficient data for PacketResumeRequest deserialization");
+
+			request.chunk_bitmap.assign(data + offset, data + offset + bitmap_length);
+		}
 
 		return request;
 	}
@@ -1234,7 +1446,11 @@ struct PacketResumeResponse
 		} resume_not_found;
 	};
 
-	PacketResumeResponse() : status(ResumeStatus::RESUME_SUPPORTED), resume_allowed{ 0, 0, 0 } {}
+	// Case ResumeStatus::RESUME_SUPPORTED, optional: compressed bitmap of the chunks the receiver already has.
+	// When present only the missing chunks are transferred, in any order
+	std::vector<uint8_t> chunk_bitmap;
+
+	PacketResumeResponse() : status(ResumeStatus::RESUME_SUPPORTED), resume_allowed{ 0, 0, 0 }, chunk_bitmap() {}
 
 	PacketResumeResponse(ResumeStatus status, uint32_t file_id, uint64_t position, uint32_t count)
 		: status(status)
@@ -1280,6 +1496,15 @@ struct PacketResumeResponse
 			buffer.insert(buffer.end(),
 				reinterpret_cast<const uint8_t*>(&resume_allowed),
 				reinterpret_cast<const uint8_t*>(&resume_allowed) + sizeof(resume_allowed));
+
+			if (!chunk_bitmap.empty())
+			{
+				uint32_t bitmap_length = static_cast<uint32_t>(chunk_bitmap.size());
+				buffer.insert(buffer.end(),
+					reinterpret_cast<const uint8_t*>(&bitmap_length),
+					reinterpret_cast<const uint8_t*>(&bitmap_length) + sizeof(bitmap_length));
+				buffer.insert(buffer.end(), chunk_bitmap.begin(), chunk_bitmap.end());
+			}
 		}
 		else if (status == ResumeStatus::RESUME_NOT_FOUND)
 		{
@@ -1307,6 +1532,20 @@ struct PacketResumeResponse
 				throw std::runtime_error("Insufficient data for PacketResumeResponse deserialization");
 
 			memcpy(&response.resume_allowed, data + offset, sizeof(response.resume_allowed));
+			offset += sizeof(response.resume_allowed);
+
+			// Optional chunk bitmap
+			if (size >= offset + sizeof(uint32_t))
+			{
+				uint32_t bitmap_length = 0;
+				memcpy(&bitmap_length, data + offset, sizeof(bitmap_length));
+				offset += sizeof(bitmap_length);
+
+				if (size < offset + bitmap_length)
+					throw std::runtime_error("Insufficient data for PacketResumeResponse deserialization");
+
+				response.chunk_bitmap.assign(data + offset, data + offset + bitmap_length);
+			}
 		}
 		else if (response.status == ResumeStatus::RESUME_NOT_FOUND)
 		{
@@ -1390,6 +1629,20 @@ struct PacketFileChunk
 		return buffer;
 	}
 
+	// Ghi trực tiếp vào buffer có sẵn GetSize() byte
+	void serializeTo(uint8_t* buffer) const
+	{
+		memcpy(buffer, &file_id, sizeof(file_id));
+		memcpy(buffer + 4, &chunk_index, sizeof(chunk_index));
+		memcpy(buffer + 8, &chunk_size, sizeof(chunk_size));
+		memcpy(buffer + 12, checksum, sizeof(checksum));
+
+		if (!data.empty())
+		{
+			memcpy(buffer + GetSizeMetadata(), data.data(), data.size());
+		}
+	}
+
 	static PacketFileChunk deserialize(const uint8_t* data, size_t size)
 	{
 		size_t offset = 0;
@@ -1428,6 +1681,162 @@ struct PacketFileChunk
 	}
 };
 
+/*
+ * FILE_CHUNK không sở hữu dữ liệu, cùng định dạng với PacketFileChunk
+ * Khi gửi: data trỏ vào vùng file đang đọc và được ghi thẳng vào buffer gói tin
+ * Khi nhận: data trỏ vào buffer nhận của NetworkConnection, chỉ hợp lệ tới lần recvPacket tiếp theo
+ */
+struct PacketFileChunkView
+{
+	uint32_t file_id;	  // File ID (unique identifier) - (4 bytes)
+	uint32_t chunk_index; // Chunk index (0-based) - (4 bytes)
+	uint32_t chunk_size;  // Chunk size (in bytes) - (4 bytes)
+	uint8_t checksum[16]; // Checksum of the chunk - (16 bytes)
+
+	const uint8_t* data; // Chunk data (không sở hữu)
+
+	PacketFileChunkView() : file_id(0), chunk_index(0), chunk_size(0), checksum{ 0 }, data(nullptr) {}
+
+	PacketFileChunkView(uint32_t id, uint32_t index, uint32_t size, const uint8_t* checksum, const uint8_t* chunk_data)
+		: file_id(id),
+		chunk_index(index),
+		chunk_size(size),
+		checksum{ 0 },
+		data(chunk_data)
+	{
+		if (checksum)
+		{
+			memcpy(this->checksum, checksum, 16);
+		}
+	}
+
+	size_t GetSize() const
+	{
+		return PacketFileChunk::GetSizeMetadata() + chunk_size;
+	}
+
+	std::vector<uint8_t> serialize() const
+	{
+		std::vector<uint8_t> buffer(GetSize());
+		serializeTo(buffer.data());
+		return buffer;
+	}
+
+	void serializeTo(uint8_t* buffer) const
+	{
+		memcpy(buffer, &file_id, sizeof(file_id));
+		memcpy(buffer + 4, &chunk_index, sizeof(chunk_index));
+		memcpy(buffer + 8, &chunk_size, sizeof(chunk_size));
+		memcpy(buffer + 12, checksum, sizeof(checksum));
+
+		// Giống PacketFileChunk: không có dữ liệu thì gửi chunk toàn số 0
+		if (data)
+		{
+			memcpy(buffer + PacketFileChunk::GetSizeMetadata(), data, chunk_size);
+		}
+		else
+		{
+			memset(buffer + PacketFileChunk::GetSizeMetadata(), 0, chunk_size);
+		}
+	}
+
+	static PacketFileChunkView deserialize(const uint8_t* data, size_t size)
+	{
+		const size_t fixed_size = PacketFileChunk::GetSizeMetadata();
+
+		if (size < fixed_size)
+			throw std::runtime_error("Insufficient data for PacketFileChunkView deserialization");
+
+		PacketFileChunkView chunk{};
+
+		memcpy(&chunk.file_id, data, sizeof(chunk.file_id));
+		memcpy(&chunk.chunk_index, data + 4, sizeof(chunk.chunk_index));
+		memcpy(&chunk.chunk_size, data + 8, sizeof(chunk.chunk_size));
+		memcpy(chunk.checksum, data + 12, sizeof(chunk.checksum));
+
+		if (size < fixed_size + chunk.chunk_size)
+			throw std::runtime_error("Insufficient data for PacketFileChunkView deserialization");
+
+		chunk.data = data + fixed_size;
+
+		return chunk;
+	}
+};
+
+/*
+ * Các đoạn toàn số 0 (hole của file sparse hoặc chunk toàn byte 0) gửi thay cho FILE_CHUNK
+ * Mỗi đoạn bắt đầu tại biên chunk và dài bội số chunk_size (hoặc tới hết file)
+ * Bên nhận trả lời bằng FILE_CHUNK_ACK với chunk_index là chunk đầu tiên của đoạn đầu tiên
+ */
+struct PacketFileHoleMap
+{
+	uint32_t file_id;	  // File ID (unique identifier) - (4 bytes)
+	uint32_t hole_count;  // Number of extents - (4 bytes)
+	std::vector<FileExtentDTO> holes; // Zero-filled extents
+	// Total size: 8 bytes + hole_count * 16 bytes
+
+	PacketFileHoleMap() : file_id(0), hole_count(0), holes() {}
+
+	PacketFileHoleMap(uint32_t id, const std::vector<FileExtentDTO>& holes)
+		: file_id(id),
+		hole_count(static_cast<uint32_t>(holes.size())),
+		holes(holes)
+	{
+	}
+
+	std::vector<uint8_t> serialize() const
+	{
+		size_t total_size = sizeof(file_id) + sizeof(hole_count) + holes.size() * FileExtentDTO::GetSize();
+
+		std::vector<uint8_t> buffer;
+		buffer.reserve(total_size);
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_id),
+			reinterpret_cast<const uint8_t*>(&file_id) + sizeof(file_id));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&hole_count),
+			reinterpret_cast<const uint8_t*>(&hole_count) + sizeof(hole_count));
+
+		for (const auto& hole : holes)
+		{
+			hole.serialize(buffer);
+		}
+
+		return buffer;
+	}
+
+	static PacketFileHoleMap deserialize(const uint8_t* data, size_t size)
+	{
+		size_t offset = 0;
+		size_t fixed_size = sizeof(file_id) + sizeof(hole_count);
+
+		if (size < fixed_size)
+			throw std::runtime_error("Insufficient data for PacketFileHoleMap deserialization");
+
+		PacketFileHoleMap map{};
+
+		memcpy(&map.file_id, data + offset, sizeof(map.file_id));
+		offset += sizeof(map.file_id);
+
+		memcpy(&map.hole_count, data + offset, sizeof(map.hole_count));
+		offset += sizeof(map.hole_count);
+
+		if (size < fixed_size + static_cast<size_t>(map.hole_count) * FileExtentDTO::GetSize())
+			throw std::runtime_error("Insufficient data for PacketFileHoleMap deserialization");
+
+		map.holes.reserve(map.hole_count);
+		for (uint32_t i = 0; i < map.hole_count; i++)
+		{
+			map.holes.push_back(FileExtentDTO::deserialize(data + offset));
+			offset += FileExtentDTO::GetSize();
+		}
+
+		return map;
+	}
+};
+
 struct PacketFileChunkACK
 {
 	uint32_t file_id;	  // File ID (unique identifier) - (4 bytes)
@@ -1465,6 +1874,18 @@ struct PacketFileChunkACK
 		return buffer;
 	}
 
+	size_t GetSize() const
+	{
+		return sizeof(file_id) + sizeof(chunk_index) + sizeof(success);
+	}
+
+	void serializeTo(uint8_t* buffer) const
+	{
+		memcpy(buffer, &file_id, sizeof(file_id));
+		memcpy(buffer + 4, &chunk_index, sizeof(chunk_index));
+		buffer[8] = success;
+	}
+
 	static PacketFileChunkACK deserialize(const uint8_t* data, size_t size)
 	{
 		size_t offset = 0;
@@ -1489,6 +1910,1201 @@ struct PacketFileChunkACK
 	}
 };
 
+struct BlockSignatureDTO
+{
+	uint32_t weak_checksum;	 // Rolling checksum of the block - (4 bytes)
+	uint8_t strong_hash[16]; // MD5 of the block - (16 bytes)
+	// Total size: 20 bytes
+
+	BlockSignatureDTO() : weak_checksum(0), strong_hash{ 0 } {}
+
+	BlockSignatureDTO(uint32_t weak, const uint8_t* strong)
+		: weak_checksum(weak),
+		strong_hash{ 0 }
+	{
+		if (strong)
+		{
+			memcpy(strong_hash, strong, 16);
+		}
+	}
+
+	static size_t GetSize()
+	{
+		return sizeof(weak_checksum) + sizeof(strong_hash);
+	}
+};
+
+struct PacketBlockSignatureRequest
+{
+	uint32_t block_size;	   // Requested block size, 0 lets the server choose - (4 bytes)
+	uint16_t file_name_length; // File name length - (2 bytes)
+	std::string file_name;	   // File name
+	// Total size: 6 bytes (fixed-size fields) + variable-size fields
+
+	PacketBlockSignatureRequest() : block_size(0), file_name_length(0), file_name() {}
+
+	PacketBlockSignatureRequest(const std::string& name, uint32_t size)
+		: block_size(size),
+		file_name_length(static_cast<uint16_t>(name.length())),
+		file_name(name)
+	{
+	}
+
+	std::vector<uint8_t> serialize() const
+	{
+		size_t total_size = sizeof(block_size) + sizeof(file_name_length) + file_name.length();
+		std::vector<uint8_t> buffer;
+		buffer.reserve(total_size);
+
+		// Serialize fixed-size fields
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&block_size),
+			reinterpret_cast<const uint8_t*>(&block_size) + sizeof(block_size));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_name_length),
+			reinterpret_cast<const uint8_t*>(&file_name_length) + sizeof(file_name_length));
+
+		// Serialize variable-size fields
+		buffer.insert(buffer.end(), file_name.begin(), file_name.end());
+
+		return buffer;
+	}
+
+	static PacketBlockSignatureRequest deserialize(const uint8_t* data, size_t size)
+	{
+		size_t offset = 0;
+		size_t fixed_size = sizeof(block_size) + sizeof(file_name_length);
+
+		if (size < fixed_size)
+			throw std::runtime_error("Insufficient data for PacketBlockSignatureRequest deserialization");
+
+		PacketBlockSignatureRequest request{};
+
+		// Deserialize fixed-size fields
+		memcpy(&request.block_size, data + offset, sizeof(request.block_size));
+		offset += sizeof(request.block_size);
+
+		memcpy(&request.file_name_length, data + offset, sizeof(request.file_name_length));
+		offset += sizeof(request.file_name_length);
+
+		if (size < fixed_size + request.file_name_length)
+			throw std::runtime_error("Insufficient data for PacketBlockSignatureRequest deserialization");
+
+		// Deserialize variable-size fields
+		request.file_name.assign(reinterpret_cast<const char*>(data + offset), request.file_name_length);
+
+		return request;
+	}
+};
+
+struct PacketBlockSignatureResponse
+{
+	bool found;			  // Remote file exists (false: no signatures follow) - (1 byte)
+	uint64_t file_size;	  // Size of the remote file (in bytes) - (8 bytes)
+	uint32_t block_size;  // Block size used for the signatures - (4 bytes)
+	uint32_t block_count; // Number of signatures - (4 bytes)
+
+	std::vector<BlockSignatureDTO> signatures; // One signature per block, the last block may be short
+	// Total size: 17 bytes (fixed-size fields) + 20 bytes per block
+
+	PacketBlockSignatureResponse() : found(false), file_size(0), block_size(0), block_count(0), signatures() {}
+
+	std::vector<uint8_t> serialize() const
+	{
+		size_t total_size = sizeof(found) + sizeof(file_size) + sizeof(block_size) + sizeof(block_count) +
+			signatures.size() * BlockSignatureDTO::GetSize();
+
+		std::vector<uint8_t> buffer;
+		buffer.reserve(total_size);
+
+		// Serialize fixed-size fields
+		buffer.push_back(found);
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_size),
+			reinterpret_cast<const uint8_t*>(&file_size) + sizeof(file_size));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&block_size),
+			reinterpret_cast<const uint8_t*>(&block_size) + sizeof(block_size));
+
+		uint32_t count = static_cast<uint32_t>(signatures.size());
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&count),
+			reinterpret_cast<const uint8_t*>(&count) + sizeof(count));
+
+		// Serialize variable-size fields
+		for (const auto& signature : signatures)
+		{
+			buffer.insert(buffer.end(),
+				reinterpret_cast<const uint8_t*>(&signature.weak_checksum),
+				reinterpret_cast<const uint8_t*>(&signature.weak_checksum) + sizeof(signature.weak_checksum));
+
+			buffer.insert(buffer.end(), signature.strong_hash, signature.strong_hash + 16);
+		}
+
+		return buffer;
+	}
+
+	static PacketBlockSignatureResponse deserialize(const uint8_t* data, size_t size)
+	{
+		size_t offset = 0;
+		size_t fixed_size = sizeof(found) + sizeof(file_size) + sizeof(block_size) + sizeof(block_count);
+
+		if (size < fixed_size)
+			throw std::runtime_error("Insufficient data for PacketBlockSignatureResponse deserialization");
+
+		PacketBlockSignatureResponse response{};
+
+		// Deserialize fixed-size fields
+		response.found = static_cast<bool>(data[offset]);
+		offset += sizeof(response.found);
+
+		memcpy(&response.file_size, data + offset, sizeof(response.file_size));
+		offset += sizeof(response.file_size);
+
+		memcpy(&response.block_size, data + offset, sizeof(response.block_size));
+		offset += sizeof(response.block_size);
+
+		memcpy(&response.block_count, data + offset, sizeof(response.block_count));
+		offset += sizeof(response.block_count);
+
+		// Calculate expected size
+		size_t expected_size = fixed_size + static_cast<size_t>(response.block_count) * BlockSignatureDTO::GetSize();
+
+		if (size < expected_size)
+			throw std::runtime_error("Insufficient data for PacketBlockSignatureResponse deserialization");
+
+		// Deserialize variable-size fields
+		response.signatures.resize(response.block_count);
+
+		for (auto& signature : response.signatures)
+		{
+			memcpy(&signature.weak_checksum, data + offset, sizeof(signature.weak_checksum));
+			offset += sizeof(signature.weak_checksum);
+
+			memcpy(signature.strong_hash, data + offset, sizeof(signature.strong_hash));
+			offset += sizeof(signature.strong_hash);
+		}
+
+		return response;
+	}
+};
+
+struct PacketDeltaUploadRequest
+{
+	uint64_t file_size;		   // Size of the new file version (in bytes) - (8 bytes)
+	uint8_t checksum[16];	   // Checksum of the new file version - (16 bytes)
+	uint32_t block_size;	   // Block size the COPY instructions refer to - (4 bytes)
+	uint16_t file_name_length; // File name length - (2 bytes)
+	std::string file_name;	   // File name (must already exist on the server)
+	// Total size: 30 bytes (fixed-size fields) + variable-size fields
+	// The server answers with UPLOAD_RESPONSE, chunk_size is the maximum DELTA_CHUNK payload
+
+	PacketDeltaUploadRequest() : file_size(0), checksum{ 0 }, block_size(0), file_name_length(0), file_name() {}
+
+	PacketDeltaUploadRequest(const std::string& name, uint64_t size, const uint8_t* checksum, uint32_t block)
+		: file_size(size),
+		checksum{ 0 },
+		block_size(block),
+		file_name_length(static_cast<uint16_t>(name.length())),
+		file_name(name)
+	{
+		if (checksum)
+		{
+			memcpy(this->checksum, checksum, 16);
+		}
+	}
+
+	std::vector<uint8_t> serialize() const
+	{
+		size_t total_size = sizeof(file_size) + sizeof(checksum) + sizeof(block_size) +
+			sizeof(file_name_length) + file_name.length();
+
+		std::vector<uint8_t> buffer;
+		buffer.reserve(total_size);
+
+		// Serialize fixed-size fields
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_size),
+			reinterpret_cast<const uint8_t*>(&file_size) + sizeof(file_size));
+
+		buffer.insert(buffer.end(), checksum, checksum + 16);
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&block_size),
+			reinterpret_cast<const uint8_t*>(&block_size) + sizeof(block_size));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_name_length),
+			reinterpret_cast<const uint8_t*>(&file_name_length) + sizeof(file_name_length));
+
+		// Serialize variable-size fields
+		buffer.insert(buffer.end(), file_name.begin(), file_name.end());
+
+		return buffer;
+	}
+
+	static PacketDeltaUploadRequest deserialize(const uint8_t* data, size_t size)
+	{
+		size_t offset = 0;
+		size_t fixed_size = sizeof(file_size) + sizeof(checksum) + sizeof(block_size) + sizeof(file_name_length);
+
+		if (size < fixed_size)
+			throw std::runtime_error("Insufficient data for PacketDeltaUploadRequest deserialization");
+
+		PacketDeltaUploadRequest request{};
+
+		// Deserialize fixed-size fields
+		memcpy(&request.file_size, data + offset, sizeof(request.file_size));
+		offset += sizeof(request.file_size);
+
+		memcpy(request.checksum, data + offset, sizeof(request.checksum));
+		offset += sizeof(request.checksum);
+
+		memcpy(&request.block_size, data + offset, sizeof(request.block_size));
+		offset += sizeof(request.block_size);
+
+		memcpy(&request.file_name_length, data + offset, sizeof(request.file_name_length));
+		offset += sizeof(request.file_name_length);
+
+		if (size < fixed_size + request.file_name_length)
+			throw std::runtime_error("Insufficient data for PacketDeltaUploadRequest deserialization");
+
+		// Deserialize variable-size fields
+		request.file_name.assign(reinterpret_cast<const char*>(data + offset), request.file_name_length);
+
+		return request;
+	}
+};
+
+struct PacketDeltaDownloadRequest
+{
+	uint32_t block_size;	   // Block size of the local signatures - (4 bytes)
+	uint32_t block_count;	   // Number of signatures - (4 bytes)
+	uint16_t file_name_length; // File name length - (2 bytes)
+	std::string file_name;	   // File name
+
+	std::vector<BlockSignatureDTO> signatures; // Signatures of the local copy, the last block may be short
+	// Total size: 10 bytes (fixed-size fields) + variable-size fields
+	// The server answers with DOWNLOAD_RESPONSE followed by DELTA_CHUNK packets, COPY_BLOCKS refer to the local copy
+
+	PacketDeltaDownloadRequest() : block_size(0), block_count(0), file_name_length(0), file_name(), signatures() {}
+
+	PacketDeltaDownloadRequest(const std::string& name, uint32_t size, const std::vector<BlockSignatureDTO>& blocks)
+		: block_size(size),
+		block_count(static_cast<uint32_t>(blocks.size())),
+		file_name_length(static_cast<uint16_t>(name.length())),
+		file_name(name),
+		signatures(blocks)
+	{
+	}
+
+	std::vector<uint8_t> serialize() const
+	{
+		size_t total_size = sizeof(block_size) + sizeof(block_count) + sizeof(file_name_length) +
+			file_name.length() + signatures.size() * BlockSignatureDTO::GetSize();
+
+		std::vector<uint8_t> buffer;
+		buffer.reserve(total_size);
+
+		// Serialize fixed-size fields
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&block_size),
+			reinterpret_cast<const uint8_t*>(&block_size) + sizeof(block_size));
+
+		uint32_t count = static_cast<uint32_t>(signatures.size());
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&count),
+			reinterpret_cast<const uint8_t*>(&count) + sizeof(count));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_name_length),
+			reinterpret_cast<const uint8_t*>(&file_name_length) + sizeof(file_name_length));
+
+		// Serialize variable-size fields
+		buffer.insert(buffer.end(), file_name.begin(), file_name.end());
+
+		for (const auto& signature : signatures)
+		{
+			buffer.insert(buffer.end(),
+				reinterpret_cast<const uint8_t*>(&signature.weak_checksum),
+				reinterpret_cast<const uint8_t*>(&signature.weak_checksum) + sizeof(signature.weak_checksum));
+
+			buffer.insert(buffer.end(), signature.strong_hash, signature.strong_hash + 16);
+		}
+
+		return buffer;
+	}
+
+	static PacketDeltaDownloadRequest deserialize(const uint8_t* data, size_t size)
+	{
+		size_t offset = 0;
+		size_t fixed_size = sizeof(block_size) + sizeof(block_count) + sizeof(file_name_length);
+
+		if (size < fixed_size)
+			throw std::runtime_error("Insufficient data for PacketDeltaDownloadRequest deserialization");
+
+		PacketDeltaDownloadRequest request{};
+
+		// Deserialize fixed-size fields
+		memcpy(&request.block_size, data + offset, sizeof(request.block_size));
+		offset += sizeof(request.block_size);
+
+		memcpy(&request.block_count, data + offset, sizeof(request.block_count));
+		offset += sizeof(request.block_count);
+
+		memcpy(&request.file_name_length, data + offset, sizeof(request.file_name_length));
+		offset += sizeof(request.file_name_length);
+
+		// Calculate expected size
+		size_t expected_size = fixed_size + request.file_name_length +
+			static_cast<size_t>(request.block_count) * BlockSignatureDTO::GetSize();
+
+		if (size < expected_size)
+			throw std::runtime_error("Insufficient data for PacketDeltaDownloadRequest deserialization");
+
+		// Deserialize variable-size fields
+		request.file_name.assign(reinterpret_cast<const char*>(data + offset), request.file_name_length);
+		offset += request.file_name_length;
+
+		request.signatures.resize(request.block_count);
+
+		for (auto& signature : request.signatures)
+		{
+			memcpy(&signature.weak_checksum, data + offset, sizeof(signature.weak_checksum));
+			offset += sizeof(signature.weak_checksum);
+
+			memcpy(signature.strong_hash, data + offset, sizeof(signature.strong_hash));
+			offset += sizeof(signature.strong_hash);
+		}
+
+		return request;
+	}
+};
+
+// Delta instruction stream carried by PacketDeltaChunk::data:
+// COPY_BLOCKS: [op (1 byte)][block_index (4 bytes)][block_count (4 bytes)] - copy blocks of the old version
+// LITERAL:     [op (1 byte)][length (4 bytes)][bytes]                      - insert new data
+enum class DeltaOp : uint8_t
+{
+	COPY_BLOCKS, // Copy a run of blocks from the old version
+	LITERAL		 // Literal data that is not present in the old version
+};
+
+struct PacketDeltaChunk
+{
+	uint32_t file_id;	  // File ID (unique identifier) - (4 bytes)
+	uint32_t sequence;	  // Sequence number of this chunk (0-based) - (4 bytes)
+	uint8_t is_last;	  // Last chunk of the delta stream - (1 byte)
+	uint32_t data_length; // Length of the instruction stream - (4 bytes)
+	uint8_t checksum[16]; // Checksum of the instruction stream - (16 bytes)
+
+	std::vector<uint8_t> data; // Delta instructions
+	// Total size: 29 bytes (minimum) + data_length
+
+	PacketDeltaChunk() : file_id(0), sequence(0), is_last(0), data_length(0), checksum{ 0 }, data() {}
+
+	PacketDeltaChunk(uint32_t id, uint32_t seq, bool last, const uint8_t* checksum, const std::vector<uint8_t>& instructions)
+		: file_id(id),
+		sequence(seq),
+		is_last(last ? 1 : 0),
+		data_length(static_cast<uint32_t>(instructions.size())),
+		checksum{ 0 },
+		data(instructions)
+	{
+		if (checksum)
+		{
+			memcpy(this->checksum, checksum, 16);
+		}
+	}
+
+	std::vector<uint8_t> serialize() const
+	{
+		size_t total_size = sizeof(file_id) + sizeof(sequence) + sizeof(is_last) +
+			sizeof(data_length) + sizeof(checksum) + data.size();
+
+		std::vector<uint8_t> buffer;
+		buffer.reserve(total_size);
+
+		// Serialize fixed-size fields
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_id),
+			reinterpret_cast<const uint8_t*>(&file_id) + sizeof(file_id));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&sequence),
+			reinterpret_cast<const uint8_t*>(&sequence) + sizeof(sequence));
+
+		buffer.push_back(is_last);
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&data_length),
+			reinterpret_cast<const uint8_t*>(&data_length) + sizeof(data_length));
+
+		buffer.insert(buffer.end(), checksum, checksum + 16);
+
+		// Serialize variable-size fields
+		buffer.insert(buffer.end(), data.begin(), data.end());
+
+		return buffer;
+	}
+
+	static PacketDeltaChunk deserialize(const uint8_t* data, size_t size)
+	{
+		size_t offset = 0;
+		size_t fixed_size = sizeof(file_id) + sizeof(sequence) + sizeof(is_last) +
+			sizeof(data_length) + sizeof(checksum);
+
+		if (size < fixed_size)
+			throw std::runtime_error("Insufficient data for PacketDeltaChunk deserialization");
+
+		PacketDeltaChunk chunk{};
+
+		// Deserialize fixed-size fields
+		memcpy(&chunk.file_id, data + offset, sizeof(chunk.file_id));
+		offset += sizeof(chunk.file_id);
+
+		memcpy(&chunk.sequence, data + offset, sizeof(chunk.sequence));
+		offset += sizeof(chunk.sequence);
+
+		chunk.is_last = data[offset++];
+
+		memcpy(&chunk.data_length, data + offset, sizeof(chunk.data_length));
+		offset += sizeof(chunk.data_length);
+
+		memcpy(chunk.checksum, data + offset, sizeof(chunk.checksum));
+		offset += sizeof(chunk.checksum);
+
+		if (size < fixed_size + chunk.data_length)
+			throw std::runtime_error("Insufficient data for PacketDeltaChunk deserialization");
+
+		// Deserialize variable-size fields
+		chunk.data.assign(data + offset, data + offset + chunk.data_length);
+
+		return chunk;
+	}
+};
+
+struct PacketUploadInlineRequest
+{
+	uint64_t file_size;		   // File size (in bytes), also the data length - (8 bytes)
+	uint8_t checksum[16];	   // Checksum of the file - (16 bytes)
+	uint16_t file_name_length; // File name length - (2 bytes)
+	uint16_t file_type_length; // File type length - (2 bytes)
+
+	std::string file_name;	   // File name
+	std::string file_type;	   // File type
+	std::vector<uint8_t> data; // Whole file content
+	// Total size: 28 bytes (fixed-size fields) + variable-size fields
+
+	PacketUploadInlineRequest()
+		: file_size(0),
+		checksum{ 0 },
+		file_name_length(0),
+		file_type_length(0),
+		file_name(),
+		file_type(),
+		data()
+	{
+	}
+
+	PacketUploadInlineRequest(const std::string& name, const std::string& type,
+		const uint8_t* checksum, std::span<const uint8_t> content)
+		: file_size(content.size()),
+		checksum{ 0 },
+		file_name_length(static_cast<uint16_t>(name.length())),
+		file_type_length(static_cast<uint16_t>(type.length())),
+		file_name(name),
+		file_type(type),
+		data(content.begin(), content.end())
+	{
+		if (checksum)
+		{
+			memcpy(this->checksum, checksum, 16);
+		}
+	}
+
+	std::vector<uint8_t> serialize() const
+	{
+		size_t total_size = sizeof(file_size) + sizeof(checksum) +
+			sizeof(file_name_length) + sizeof(file_type_length) +
+			file_name.length() + file_type.length() + data.size();
+
+		std::vector<uint8_t> buffer;
+		buffer.reserve(total_size);
+
+		// Serialize fixed-size fields
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_size),
+			reinterpret_cast<const uint8_t*>(&file_size) + sizeof(file_size));
+
+		buffer.insert(buffer.end(), checksum, checksum + 16);
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_name_length),
+			reinterpret_cast<const uint8_t*>(&file_name_length) + sizeof(file_name_length));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_type_length),
+			reinterpret_cast<const uint8_t*>(&file_type_length) + sizeof(file_type_length));
+
+		// Serialize variable-size fields
+		buffer.insert(buffer.end(), file_name.begin(), file_name.end());
+		buffer.insert(buffer.end(), file_type.begin(), file_type.end());
+		buffer.insert(buffer.end(), data.begin(), data.end());
+
+		return buffer;
+	}
+
+	static PacketUploadInlineRequest deserialize(const uint8_t* data, size_t size)
+	{
+		size_t offset = 0;
+		size_t fixed_size = sizeof(file_size) + sizeof(checksum) +
+			sizeof(file_name_length) + sizeof(file_type_length);
+
+		if (size < fixed_size)
+			throw std::runtime_error("Insufficient data for PacketUploadInlineRequest deserialization");
+
+		PacketUploadInlineRequest request{};
+
+		// Deserialize fixed-size fields
+		memcpy(&request.file_size, data + offset, sizeof(request.file_size));
+		offset += sizeof(request.file_size);
+
+		memcpy(request.checksum, data + offset, sizeof(request.checksum));
+		offset += sizeof(request.checksum);
+
+		memcpy(&request.file_name_length, data + offset, sizeof(request.file_name_length));
+		offset += sizeof(request.file_name_length);
+
+		memcpy(&request.file_type_length, data + offset, sizeof(request.file_type_length));
+		offset += sizeof(request.file_type_length);
+
+		// Calculate expected size
+		size_t expected_size = fixed_size + request.file_name_length + request.file_type_length + request.file_size;
+
+		if (size < expected_size)
+			throw std::runtime_error("Insufficient data for PacketUploadInlineRequest deserialization");
+
+		// Deserialize variable-size fields
+		request.file_name.assign(reinterpret_cast<const char*>(data + offset), request.file_name_length);
+		offset += request.file_name_length;
+
+		request.file_type.assign(reinterpret_cast<const char*>(data + offset), request.file_type_length);
+		offset += request.file_type_length;
+
+		request.data.assign(data + offset, data + offset + request.file_size);
+
+		return request;
+	}
+};
+
+struct PacketUploadInlineResponse
+{
+	UploadStatus status;	 // Upload status (1 byte)
+	bool stored;			 // File was written and its checksum verified (1 byte)
+	uint32_t file_id;		 // File ID (unique identifier) - (4 bytes)
+	uint16_t message_length; // Message length (2 bytes)
+	std::string message;	 // Message (e.g., reason of the failure)
+	// Total size: 8 bytes (fixed-size fields) + variable-size fields
+
+	PacketUploadInlineResponse()
+		: status(UploadStatus::UPLOAD_ALLOWED),
+		stored(false),
+		file_id(0),
+		message_length(0),
+		message()
+	{
+	}
+
+	PacketUploadInlineResponse(UploadStatus status, bool stored, uint32_t file_id, const std::string& msg)
+		: status(status),
+		stored(stored),
+		file_id(file_id),
+		message_length(static_cast<uint16_t>(msg.length())),
+		message(msg)
+	{
+	}
+
+	std::vector<uint8_t> serialize() const
+	{
+		if (message.length() > UINT16_MAX)
+			throw std::runtime_error("Message length exceeds the maximum value");
+
+		size_t total_size = sizeof(status) + sizeof(stored) + sizeof(file_id) + sizeof(message_length) + message.length();
+		std::vector<uint8_t> buffer;
+		buffer.reserve(total_size);
+
+		// Serialize fixed-size fields
+		buffer.push_back(static_cast<uint8_t>(status));
+		buffer.push_back(stored);
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_id),
+			reinterpret_cast<const uint8_t*>(&file_id) + sizeof(file_id));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&message_length),
+			reinterpret_cast<const uint8_t*>(&message_length) + sizeof(message_length));
+
+		// Serialize variable-size fields
+		buffer.insert(buffer.end(), message.begin(), message.end());
+
+		return buffer;
+	}
+
+	static PacketUploadInlineResponse deserialize(const uint8_t* data, size_t size)
+	{
+		size_t offset = 0;
+		size_t fixed_size = sizeof(status) + sizeof(stored) + sizeof(file_id) + sizeof(message_length);
+
+		if (size < fixed_size)
+			throw std::runtime_error("Insufficient data for PacketUploadInlineResponse deserialization");
+
+		PacketUploadInlineResponse response{};
+
+		// Deserialize fixed-size fields
+		response.status = static_cast<UploadStatus>(data[offset++]);
+		response.stored = static_cast<bool>(data[offset++]);
+
+		memcpy(&response.file_id, data + offset, sizeof(response.file_id));
+		offset += sizeof(response.file_id);
+
+		memcpy(&response.message_length, data + offset, sizeof(response.message_length));
+		offset += sizeof(response.message_length);
+
+		if (size < offset + response.message_length)
+			throw std::runtime_error("Insufficient data for PacketUploadInlineResponse deserialization");
+
+		// Deserialize variable-size fields
+		response.message.assign(reinterpret_cast<const char*>(data + offset), response.message_length);
+
+		return response;
+	}
+};
+
+// Hướng của một stripe trong phiên truyền nhiều kết nối
+enum class StripeDirection : uint8_t
+{
+	UPLOAD,
+	DOWNLOAD
+};
+
+// Gắn một kết nối vào phiên truyền nhiều kết nối của một file
+// Stripe k chỉ truyền các chunk có chunk_index % stripe_count == k, server nhận chunk không theo thứ tự
+struct PacketStripeAttachRequest
+{
+	uint32_t file_id;			// File ID returned by UPLOAD_RESPONSE / DOWNLOAD_RESPONSE - (4 bytes)
+	StripeDirection direction;	// Transfer direction (1 byte)
+	uint16_t stripe_index;		// Index of this stripe (2 bytes)
+	uint16_t stripe_count;		// Number of stripes (2 bytes)
+	// Total size: 9 bytes
+
+	PacketStripeAttachRequest()
+		: file_id(0),
+		direction(StripeDirection::UPLOAD),
+		stripe_index(0),
+		stripe_count(0)
+	{
+	}
+
+	PacketStripeAttachRequest(uint32_t file_id, StripeDirection direction, uint16_t stripe_index, uint16_t stripe_count)
+		: file_id(file_id),
+		direction(direction),
+		stripe_index(stripe_index),
+		stripe_count(stripe_count)
+	{
+	}
+
+	std::vector<uint8_t> serialize() const
+	{
+		size_t total_size = sizeof(file_id) + sizeof(direction) + sizeof(stripe_index) + sizeof(stripe_count);
+		std::vector<uint8_t> buffer;
+		buffer.reserve(total_size);
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_id),
+			reinterpret_cast<const uint8_t*>(&file_id) + sizeof(file_id));
+
+		buffer.push_back(static_cast<uint8_t>(direction));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&stripe_index),
+			reinterpret_cast<const uint8_t*>(&stripe_index) + sizeof(stripe_index));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&stripe_count),
+			reinterpret_cast<const uint8_t*>(&stripe_count) + sizeof(stripe_count));
+
+		return buffer;
+	}
+
+	static PacketStripeAttachRequest deserialize(const uint8_t* data, size_t size)
+	{
+		size_t offset = 0;
+		size_t fixed_size = sizeof(file_id) + sizeof(direction) + sizeof(stripe_index) + sizeof(stripe_count);
+
+		if (size < fixed_size)
+			throw std::runtime_error("Insufficient data for PacketStripeAttachRequest deserialization");
+
+		PacketStripeAttachRequest request{};
+
+		memcpy(&request.file_id, data + offset, sizeof(request.file_id));
+		offset += sizeof(request.file_id);
+
+		request.direction = static_cast<StripeDirection>(data[offset++]);
+
+		memcpy(&request.stripe_index, data + offset, sizeof(request.stripe_index));
+		offset += sizeof(request.stripe_index);
+
+		memcpy(&request.stripe_count, data + offset, sizeof(request.stripe_count));
+
+		return request;
+	}
+};
+
+struct PacketStripeAttachResponse
+{
+	bool attached;			 // Stripe was attached to the transfer (1 byte)
+	uint32_t file_id;		 // File ID - (4 bytes)
+	uint32_t chunk_count;	 // Number of chunks this stripe will carry (4 bytes)
+	uint16_t message_length; // Message length (2 bytes)
+	std::string message;	 // Message (e.g., reason of the failure)
+	// Total size: 11 bytes (fixed-size fields) + variable-size fields
+
+	PacketStripeAttachResponse()
+		: attached(false),
+		file_id(0),
+		chunk_count(0),
+		message_length(0),
+		message()
+	{
+	}
+
+	PacketStripeAttachResponse(bool attached, uint32_t file_id, uint32_t chunk_count, const std::string& msg)
+		: attached(attached),
+		file_id(file_id),
+		chunk_count(chunk_count),
+		message_length(static_cast<uint16_t>(msg.length())),
+		message(msg)
+	{
+	}
+
+	std::vector<uint8_t> serialize() const
+	{
+		if (message.length() > UINT16_MAX)
+			throw std::runtime_error("Message length exceeds the maximum value");
+
+		size_t total_size = sizeof(attached) + sizeof(file_id) + sizeof(chunk_count) + sizeof(message_length) + message.length();
+		std::vector<uint8_t> buffer;
+		buffer.reserve(total_size);
+
+		// Serialize fixed-size fields
+		buffer.push_back(attached);
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_id),
+			reinterpret_cast<const uint8_t*>(&file_id) + sizeof(file_id));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&chunk_count),
+			reinterpret_cast<const uint8_t*>(&chunk_count) + sizeof(chunk_count));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&message_length),
+			reinterpret_cast<const uint8_t*>(&message_length) + sizeof(message_length));
+
+		// Serialize variable-size fields
+		buffer.insert(buffer.end(), message.begin(), message.end());
+
+		return buffer;
+	}
+
+	static PacketStripeAttachResponse deserialize(const uint8_t* data, size_t size)
+	{
+		size_t offset = 0;
+		size_t fixed_size = sizeof(attached) + sizeof(file_id) + sizeof(chunk_count) + sizeof(message_length);
+
+		if (size < fixed_size)
+			throw std::runtime_error("Insufficient data for PacketStripeAttachResponse deserialization");
+
+		PacketStripeAttachResponse response{};
+
+		// Deserialize fixed-size fields
+		response.attached = static_cast<bool>(data[offset++]);
+
+		memcpy(&response.file_id, data + offset, sizeof(response.file_id));
+		offset += sizeof(response.file_id);
+
+		memcpy(&response.chunk_count, data + offset, sizeof(response.chunk_count));
+		offset += sizeof(response.chunk_count);
+
+		memcpy(&response.message_length, data + offset, sizeof(response.message_length));
+		offset += sizeof(response.message_length);
+
+		if (size < offset + response.message_length)
+			throw std::runtime_error("Insufficient data for PacketStripeAttachResponse deserialization");
+
+		// Deserialize variable-size fields
+		response.message.assign(reinterpret_cast<const char*>(data + offset), response.message_length);
+
+		return response;
+	}
+};
+
+struct ByteRangeDTO
+{
+	uint64_t offset; // Start of the range, counted back from the end of the file when from_end is set - (8 bytes)
+	uint64_t length; // Length of the range, 0 means up to the end of the file - (8 bytes)
+	bool from_end;	 // Offset is relative to the end of the file (1 byte)
+	// Total size: 17 bytes
+
+	ByteRangeDTO() : offset(0), length(0), from_end(false) {}
+
+	ByteRangeDTO(uint64_t offset, uint64_t length, bool from_end = false)
+		: offset(offset),
+		length(length),
+		from_end(from_end)
+	{
+	}
+
+	static size_t GetSize()
+	{
+		return sizeof(offset) + sizeof(length) + sizeof(from_end);
+	}
+
+	void serialize(std::vector<uint8_t>& buffer) const
+	{
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&offset),
+			reinterpret_cast<const uint8_t*>(&offset) + sizeof(offset));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&length),
+			reinterpret_cast<const uint8_t*>(&length) + sizeof(length));
+
+		buffer.push_back(from_end);
+	}
+
+	static ByteRangeDTO deserialize(const uint8_t* data)
+	{
+		ByteRangeDTO range{};
+		size_t offset = 0;
+
+		memcpy(&range.offset, data + offset, sizeof(range.offset));
+		offset += sizeof(range.offset);
+
+		memcpy(&range.length, data + offset, sizeof(range.length));
+		offset += sizeof(range.length);
+
+		range.from_end = static_cast<bool>(data[offset]);
+
+		return range;
+	}
+};
+
+// Tải một hoặc nhiều đoạn byte của file, server trả lời bằng RANGE_DOWNLOAD_RESPONSE rồi gửi các RANGE_CHUNK
+struct PacketRangeDownloadRequest
+{
+	uint16_t file_name_length;		 // File name length - (2 bytes)
+	uint16_t range_count;			 // Number of ranges - (2 bytes)
+	std::string file_name;			 // File name
+	std::vector<ByteRangeDTO> ranges; // Requested ranges
+	// Total size: 4 bytes (fixed-size fields) + variable-size fields
+
+	PacketRangeDownloadRequest() : file_name_length(0), range_count(0), file_name(), ranges() {}
+
+	PacketRangeDownloadRequest(const std::string& name, const std::vector<ByteRangeDTO>& ranges)
+		: file_name_length(static_cast<uint16_t>(name.length())),
+		range_count(static_cast<uint16_t>(ranges.size())),
+		file_name(name),
+		ranges(ranges)
+	{
+	}
+
+	std::vector<uint8_t> serialize() const
+	{
+		if (ranges.size() > UINT16_MAX)
+			throw std::runtime_error("Range count exceeds the maximum value");
+
+		size_t total_size = sizeof(file_name_length) + sizeof(range_count) +
+			file_name.length() + ranges.size() * ByteRangeDTO::GetSize();
+
+		std::vector<uint8_t> buffer;
+		buffer.reserve(total_size);
+
+		// Serialize fixed-size fields
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_name_length),
+			reinterpret_cast<const uint8_t*>(&file_name_length) + sizeof(file_name_length));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&range_count),
+			reinterpret_cast<const uint8_t*>(&range_count) + sizeof(range_count));
+
+		// Serialize variable-size fields
+		buffer.insert(buffer.end(), file_name.begin(), file_name.end());
+
+		for (const auto& range : ranges)
+		{
+			range.serialize(buffer);
+		}
+
+		return buffer;
+	}
+
+	static PacketRangeDownloadRequest deserialize(const uint8_t* data, size_t size)
+	{
+		size_t offset = 0;
+		size_t fixed_size = sizeof(file_name_length) + sizeof(range_count);
+
+		if (size < fixed_size)
+			throw std::runtime_error("Insufficient data for PacketRangeDownloadRequest deserialization");
+
+		PacketRangeDownloadRequest request{};
+
+		// Deserialize fixed-size fields
+		memcpy(&request.file_name_length, data + offset, sizeof(request.file_name_length));
+		offset += sizeof(request.file_name_length);
+
+		memcpy(&request.range_count, data + offset, sizeof(request.range_count));
+		offset += sizeof(request.range_count);
+
+		// Calculate expected size
+		size_t expected_size = fixed_size + request.file_name_length + request.range_count * ByteRangeDTO::GetSize();
+
+		if (size < expected_size)
+			throw std::runtime_error("Insufficient data for PacketRangeDownloadRequest deserialization");
+
+		// Deserialize variable-size fields
+		request.file_name.assign(reinterpret_cast<const char*>(data + offset), request.file_name_length);
+		offset += request.file_name_length;
+
+		request.ranges.reserve(request.range_count);
+		for (uint16_t i = 0; i < request.range_count; i++)
+		{
+			request.ranges.push_back(ByteRangeDTO::deserialize(data + offset));
+			offset += ByteRangeDTO::GetSize();
+		}
+
+		return request;
+	}
+};
+
+// Các đoạn trong phản hồi đã được server quy về offset tuyệt đối và cắt theo kích thước file
+struct PacketRangeDownloadResponse
+{
+	DownloadStatus status;			 // Download status (1 byte)
+	uint32_t file_id;				 // File ID (unique identifier) - (4 bytes)
+	uint64_t file_size;				 // Size of the whole file - (8 bytes)
+	uint16_t range_count;			 // Number of resolved ranges - (2 bytes)
+	uint16_t message_length;		 // Message length (2 bytes)
+	std::vector<ByteRangeDTO> ranges; // Resolved ranges, in the order they will be sent
+	std::string message;			 // Message (e.g., reason of the failure)
+	// Total size: 17 bytes (fixed-size fields) + variable-size fields
+
+	PacketRangeDownloadResponse()
+		: status(DownloadStatus::FILE_FOUND),
+		file_id(0),
+		file_size(0),
+		range_count(0),
+		message_length(0),
+		ranges(),
+		message()
+	{
+	}
+
+	PacketRangeDownloadResponse(DownloadStatus status, uint32_t file_id, uint64_t file_size,
+		const std::vector<ByteRangeDTO>& ranges, const std::string& msg)
+		: status(status),
+		file_id(file_id),
+		file_size(file_size),
+		range_count(static_cast<uint16_t>(ranges.size())),
+		message_length(static_cast<uint16_t>(msg.length())),
+		ranges(ranges),
+		message(msg)
+	{
+	}
+
+	std::vector<uint8_t> serialize() const
+	{
+		if (message.length() > UINT16_MAX)
+			throw std::runtime_error("Message length exceeds the maximum value");
+
+		size_t total_size = sizeof(status) + sizeof(file_id) + sizeof(file_size) +
+			sizeof(range_count) + sizeof(message_length) +
+			ranges.size() * ByteRangeDTO::GetSize() + message.length();
+
+		std::vector<uint8_t> buffer;
+		buffer.reserve(total_size);
+
+		// Serialize fixed-size fields
+		buffer.push_back(static_cast<uint8_t>(status));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_id),
+			reinterpret_cast<const uint8_t*>(&file_id) + sizeof(file_id));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_size),
+			reinterpret_cast<const uint8_t*>(&file_size) + sizeof(file_size));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&range_count),
+			reinterpret_cast<const uint8_t*>(&range_count) + sizeof(range_count));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&message_length),
+			reinterpret_cast<const uint8_t*>(&message_length) + sizeof(message_length));
+
+		// Serialize variable-size fields
+		for (const auto& range : ranges)
+		{
+			range.serialize(buffer);
+		}
+
+		buffer.insert(buffer.end(), message.begin(), message.end());
+
+		return buffer;
+	}
+
+	static PacketRangeDownloadResponse deserialize(const uint8_t* data, size_t size)
+	{
+		size_t offset = 0;
+		size_t fixed_size = sizeof(status) + sizeof(file_id) + sizeof(file_size) + sizeof(range_count) + sizeof(message_length);
+
+		if (size < fixed_size)
+			throw std::runtime_error("Insufficient data for PacketRangeDownloadResponse deserialization");
+
+		PacketRangeDownloadResponse response{};
+
+		// Deserialize fixed-size fields
+		response.status = static_cast<DownloadStatus>(data[offset++]);
+
+		memcpy(&response.file_id, data + offset, sizeof(response.file_id));
+		offset += sizeof(response.file_id);
+
+		memcpy(&response.file_size, data + offset, sizeof(response.file_size));
+		offset += sizeof(response.file_size);
+
+		memcpy(&response.range_count, data + offset, sizeof(response.range_count));
+		offset += sizeof(response.range_count);
+
+		memcpy(&response.message_length, data + offset, sizeof(response.message_length));
+		offset += sizeof(response.message_length);
+
+		// Calculate expected size
+		size_t expected_size = fixed_size + response.range_count * ByteRangeDTO::GetSize() + response.message_length;
+
+		if (size < expected_size)
+			throw std::runtime_error("Insufficient data for PacketRangeDownloadResponse deserialization");
+
+		// Deserialize variable-size fields
+		response.ranges.reserve(response.range_count);
+		for (uint16_t i = 0; i < response.range_count; i++)
+		{
+			response.ranges.push_back(ByteRangeDTO::deserialize(data + offset));
+			offset += ByteRangeDTO::GetSize();
+		}
+
+		response.message.assign(reinterpret_cast<const char*>(data + offset), response.message_length);
+
+		return response;
+	}
+};
+
+// Dữ liệu của một phần trong đoạn byte, mỗi gói được ACK bằng PacketFileChunkACK với chunk_index = sequence
+struct PacketRangeChunk
+{
+	uint32_t file_id;	   // File ID (unique identifier) - (4 bytes)
+	uint32_t sequence;	   // Sequence number of this chunk in the transfer - (4 bytes)
+	uint64_t offset;	   // Absolute file offset of the data - (8 bytes)
+	uint32_t data_length;  // Data length (in bytes) - (4 bytes)
+	uint8_t checksum[16];  // Checksum of the data - (16 bytes)
+
+	std::vector<uint8_t> data; // Range data
+	// Total size: 36 bytes (minimum) + data_length
+
+	PacketRangeChunk() : file_id(0), sequence(0), offset(0), data_length(0), checksum{ 0 }, data() {}
+
+	static size_t GetSizeMetadata()
+	{
+		return sizeof(file_id) + sizeof(sequence) + sizeof(offset) + sizeof(data_length) + sizeof(checksum);
+	}
+
+	std::vector<uint8_t> serialize() const
+	{
+		size_t total_size = GetSizeMetadata() + data.size();
+
+		std::vector<uint8_t> buffer;
+		buffer.reserve(total_size);
+
+		// Serialize fixed-size fields
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&file_id),
+			reinterpret_cast<const uint8_t*>(&file_id) + sizeof(file_id));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&sequence),
+			reinterpret_cast<const uint8_t*>(&sequence) + sizeof(sequence));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&offset),
+			reinterpret_cast<const uint8_t*>(&offset) + sizeof(offset));
+
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&data_length),
+			reinterpret_cast<const uint8_t*>(&data_length) + sizeof(data_length));
+
+		buffer.insert(buffer.end(), checksum, checksum + 16);
+
+		// Serialize variable-size fields
+		buffer.insert(buffer.end(), data.begin(), data.end());
+
+		return buffer;
+	}
+
+	static PacketRangeChunk deserialize(const uint8_t* data, size_t size)
+	{
+		size_t offset = 0;
+		size_t fixed_size = GetSizeMetadata();
+
+		if (size < fixed_size)
+			throw std::runtime_error("Insufficient data for PacketRangeChunk deserialization");
+
+		PacketRangeChunk chunk{};
+
+		// Deserialize fixed-size fields
+		memcpy(&chunk.file_id, data + offset, sizeof(chunk.file_id));
+		offset += sizeof(chunk.file_id);
+
+		memcpy(&chunk.sequence, data + offset, sizeof(chunk.sequence));
+		offset += sizeof(chunk.sequence);
+
+		memcpy(&chunk.offset, data + offset, sizeof(chunk.offset));
+		offset += sizeof(chunk.offset);
+
+		memcpy(&chunk.data_length, data + offset, sizeof(chunk.data_length));
+		offset += sizeof(chunk.data_length);
+
+		memcpy(chunk.checksum, data + offset, sizeof(chunk.checksum));
+		offset += sizeof(chunk.checksum);
+
+		// Calculate expected size
+		size_t expected_size = fixed_size + chunk.data_length;
+
+		if (size < expected_size)
+			throw std::runtime_error("Insufficient data for PacketRangeChunk deserialization");
+
+		// Deserialize variable-size fields
+		chunk.data.assign(data + offset, data + offset + chunk.data_length);
+
+		return chunk;
+	}
+};
+
 // Packet to close the session, for client
 struct PacketCloseSession
 {
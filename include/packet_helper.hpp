@@ -3,7 +3,10 @@
 
 #include "packet_def.hpp"
 #include "encryption_handler.hpp"
+#include "transfer_arena.h"
+#include <concepts>
 #include <iostream>
+#include <span>
 
 // Packet helper namespace
 namespace PacketHelper
@@ -58,6 +61,106 @@ namespace PacketHelper
 		}
 	}
 
+	constexpr size_t IV_SIZE = 12;
+	constexpr size_t TAG_SIZE = 16;
+
+	// Payload biết trước kích thước và tự ghi vào buffer gói tin, không cần vector trung gian
+	template <typename T>
+	concept SerializableInto = requires(const T& data, uint8_t* buffer)
+	{
+		{ data.GetSize() } -> std::convertible_to<size_t>;
+		data.serializeTo(buffer);
+	};
+
+	/*
+	 * @brief Tạo gói tin trong arena: [prefix][iv][tag][header + payload], phần header + payload được mã hoá tại chỗ
+	 * @brief Payload SerializableInto được ghi thẳng vào arena, các payload khác đi qua serialize()
+	 * @brief Span trả về thuộc arena, rỗng nếu lỗi
+	 */
+	template <typename T>
+	std::span<const uint8_t> CreatePacket(PacketType type, const T& data, const uint8_t* session_id, utils::TransferArena& arena)
+	{
+		try
+		{
+			std::vector<uint8_t> payload;
+			size_t payload_size = 0;
+
+			if constexpr (SerializableInto<T>)
+			{
+				payload_size = data.GetSize();
+			}
+			else
+			{
+				payload = data.serialize();
+				payload_size = payload.size();
+			}
+
+			const size_t plain_size = sizeof(PacketHeader) + payload_size;
+			const size_t packet_size = sizeof(PacketPrefix) + IV_SIZE + TAG_SIZE + plain_size;
+
+			uint8_t* packet = arena.Allocate(packet_size);
+			uint8_t* iv = packet + sizeof(PacketPrefix);
+			uint8_t* tag = iv + IV_SIZE;
+			uint8_t* plain = tag + TAG_SIZE;
+
+			PacketHeader header(type, session_id, static_cast<uint32_t>(payload_size));
+			memcpy(plain, &header, sizeof(PacketHeader));
+
+			if constexpr (SerializableInto<T>)
+			{
+				data.serializeTo(plain + sizeof(PacketHeader));
+			}
+			else if (payload_size > 0)
+			{
+				memcpy(plain + sizeof(PacketHeader), payload.data(), payload_size);
+			}
+
+			// Mã hóa gói tin
+			aes.generateRandomBytes(iv, IV_SIZE);
+			aes.encrypt(plain, plain_size, iv, plain, tag);
+
+			PacketPrefix prefix{};
+			prefix.encrypted_packet_length = static_cast<uint32_t>(IV_SIZE + TAG_SIZE + plain_size);
+			memcpy(packet, &prefix, sizeof(PacketPrefix));
+
+			return { packet, packet_size };
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "[PacketHelper::CreatePacket] Error: " << e.what() << std::endl;
+			return {};
+		}
+	}
+
+	/*
+	 * @brief Giải mã tại chỗ gói tin đã bỏ prefix ([iv][tag][ciphertext], length = encrypted_packet_length)
+	 * @brief Trả về span của header + payload nằm trong chính buffer đầu vào, rỗng nếu lỗi
+	 */
+	static std::span<uint8_t> DecryptPacketInPlace(uint8_t* encrypted_packet, size_t length)
+	{
+		try
+		{
+			if (length < IV_SIZE + TAG_SIZE)
+			{
+				throw std::runtime_error("Insufficient data for packet decryption. Length: " + std::to_string(length));
+			}
+
+			const uint8_t* iv = encrypted_packet;
+			const uint8_t* tag = iv + IV_SIZE;
+			uint8_t* cipher = encrypted_packet + IV_SIZE + TAG_SIZE;
+			const size_t cipher_size = length - IV_SIZE - TAG_SIZE;
+
+			aes.decrypt(cipher, cipher_size, iv, tag, cipher);
+
+			return { cipher, cipher_size };
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "[PacketHelper::DecryptPacketInPlace] Error: " << e.what() << std::endl;
+			return {};
+		}
+	}
+
 	static std::vector<uint8_t> DecryptPacket(const uint8_t* data, size_t length)
 	{
 		try
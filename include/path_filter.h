@@ -0,0 +1,119 @@
+#ifndef PATH_FILTER_H
+#define PATH_FILTER_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+namespace fs = std::filesystem;
+
+namespace utils
+{
+	/*
+	 * @brief Bộ lọc include/exclude theo cú pháp .gitignore: "node_modules", "*.tmp", "build/", "src/generated", "!keep.tmp", "**" khớp nhiều cấp thư mục
+	 * @brief Các luật được biên dịch một lần khi thêm vào: tên chính xác và "*.ext" tra bằng hash map, đường dẫn neo theo gốc
+	 * @brief nằm trong một prefix trie (mỗi thư mục chỉ giữ nút trie của nó), chỉ các glob còn lại phải so khớp từng luật
+	 * @brief Giống git, luật khớp sau cùng quyết định; thư mục bị loại thì không được duyệt vào nên file bên trong không thể được include lại
+	 * @brief So khớp không phân biệt hoa thường như file system của Windows
+	 */
+	class PathFilter
+	{
+	public:
+		static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+		// Trạng thái của một thư mục trong lúc duyệt cây, do IsExcluded() dựng cho thư mục con
+		struct Context
+		{
+			uint32_t trie_node = 0; // Nút trie tương ứng với đường dẫn, NO_NODE nếu không còn luật neo nào khớp tiền tố
+			std::wstring path;		// Đường dẫn tương đối (đã đổi về chữ thường, dấu '/'), chỉ được dựng khi có glob neo theo gốc
+		};
+
+	private:
+		enum class TokenType : uint8_t
+		{
+			LITERAL,
+			ANY_CHAR,	  // '?'
+			STAR,		  // '*', không vượt qua '/'
+			ANY_DIRS,	  // "**/": rỗng hoặc một số thư mục bất kỳ
+			ANY_SUFFIX,	  // "**" ở cuối: mọi thứ còn lại
+			CHAR_CLASS	  // "[...]", value là chỉ số trong m_classes
+		};
+
+		struct GlobToken
+		{
+			TokenType type;
+			wchar_t ch;
+			uint32_t value;
+		};
+
+		struct CharClass
+		{
+			bool negate;
+			std::vector<std::pair<wchar_t, wchar_t>> ranges;
+		};
+
+		struct Rule
+		{
+			bool negate;		 // "!pattern": include lại
+			bool directory_only; // "pattern/": chỉ khớp thư mục
+		};
+
+		struct Glob
+		{
+			uint32_t rule;
+			std::vector<GlobToken> tokens;
+		};
+
+		struct TrieNode
+		{
+			std::unordered_map<std::wstring, uint32_t> children;
+			std::vector<uint32_t> rules;
+		};
+
+		// Chỉ số luật trong mỗi danh sách luôn tăng dần theo thứ tự thêm
+		std::vector<Rule> m_rules;
+		std::unordered_map<std::wstring, std::vector<uint32_t>> m_names;	  // Tên chính xác ở mọi độ sâu
+		std::unordered_map<std::wstring, std::vector<uint32_t>> m_extensions; // "*.ext", khoá là ".ext"
+		std::vector<TrieNode> m_trie;										  // Đường dẫn chính xác neo theo gốc, nút 0 là gốc
+		std::vector<Glob> m_name_globs;										  // Glob không neo, so với tên
+		std::vector<Glob> m_path_globs;										  // Glob neo theo gốc, so với đường dẫn tương đối
+		std::vector<CharClass> m_classes;
+
+	public:
+		static constexpr const wchar_t* IGNORE_FILE_NAME = L".transferignore";
+
+		PathFilter();
+
+		// Một dòng theo cú pháp .gitignore, trả về false nếu là dòng trống, chú thích hoặc không có luật
+		bool AddRule(std::string_view line);
+		// Thêm các luật trong file (UTF-8), trả về false nếu không mở được file
+		bool LoadIgnoreFile(const fs::path& path);
+
+		bool IsEmpty() const { return m_rules.empty(); }
+		size_t GetRuleCount() const { return m_rules.size(); }
+
+		Context Root() const { return Context{ 0, {} }; }
+
+		// Kiểm tra một entry của thư mục parent; thư mục không bị loại thì child (nếu có) nhận context để duyệt tiếp
+		// Thread-safe sau khi đã thêm xong luật
+		bool IsExcluded(const Context& parent, std::wstring_view name, bool is_directory, Context* child = nullptr) const;
+		// Đường dẫn tương đối so với gốc không đến từ việc duyệt cây: kiểm tra cả các thư mục cha
+		bool IsExcludedPath(const fs::path& relative_path, bool is_directory) const;
+
+	private:
+		static std::wstring FoldCase(std::wstring_view text);
+		static bool HasWildcard(std::wstring_view pattern);
+
+		std::vector<GlobToken> CompileGlob(std::wstring_view pattern);
+		bool MatchClass(const CharClass& char_class, wchar_t ch) const;
+		bool MatchGlob(const std::vector<GlobToken>& tokens, size_t token, std::wstring_view text, size_t pos) const;
+
+		// Cập nhật best với luật áp dụng được có chỉ số lớn nhất trong rules
+		void Consider(const std::vector<uint32_t>& rules, bool is_directory, int64_t& best) const;
+	};
+}
+
+#endif // !PATH_FILTER_H
@@ -1,6 +1,7 @@
 ﻿#ifndef PROGRESSBAR_MANAGER_H
 #define PROGRESSBAR_MANAGER_H
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <string>
@@ -111,12 +112,18 @@ public:
 		redrawProgressBars();
 	}
 
+	// Tổng số file có thể thay đổi khi danh sách file được quét song song với việc upload
+	void SetTotalFiles(size_t total_files)
+	{
+		m_total_files = total_files;
+	}
+
 	void UpdateTotalProgress(size_t current_finished_files)
 	{
-		if (m_show_total_progress)
+		if (m_show_total_progress && m_total_files > 0)
 		{
 			float progress = (static_cast<float>(current_finished_files) / m_total_files) * 100.0f;
-			m_total_progress = progress;
+			m_total_progress = (std::min)(progress, 100.0f);
 		}
 	}
 
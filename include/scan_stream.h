@@ -0,0 +1,65 @@
+#ifndef SCAN_STREAM_H
+#define SCAN_STREAM_H
+
+#include <bounded_queue.h>
+#include <directory_scanner.h>
+#include <file_table.h>
+#include <path_filter.h>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <thread>
+#include <vector>
+namespace fs = std::filesystem;
+
+namespace utils
+{
+	/*
+	 * @brief Quét thư mục trên thread nền, ghi từng file vào FileTable và đẩy chỉ số của nó vào BoundedQueue ngay khi tìm thấy,
+	 * @brief để upload bắt đầu trong lúc vẫn đang quét; consumer chỉ nhận chỉ số, đường dẫn được dựng lại từ bảng khi cần
+	 * @brief Hàng đợi đầy thì các worker quét bị chặn lại cho tới khi consumer lấy bớt
+	 */
+	class ScanStream
+	{
+	private:
+		PathFilter m_filter;
+		DirectoryScanner m_scanner;
+		FileTable m_table;
+		BoundedQueue<uint32_t> m_queue;
+		std::atomic<size_t> m_discovered; // Số file đã tìm thấy
+		std::atomic<uint64_t> m_discovered_bytes;
+		std::atomic<bool> m_complete;	  // Đã quét xong toàn bộ cây (không lỗi, không bị huỷ)
+		std::atomic<bool> m_cancelled;
+		std::exception_ptr m_error;
+		std::thread m_producer;
+
+	public:
+		static constexpr size_t DEFAULT_CAPACITY = 4096;
+
+		// File và thư mục bị filter loại không được đưa vào bảng
+		explicit ScanStream(const fs::path& root, PathFilter filter = PathFilter(), size_t capacity = DEFAULT_CAPACITY);
+		~ScanStream();
+
+		ScanStream(const ScanStream&) = delete;
+		ScanStream& operator=(const ScanStream&) = delete;
+
+		// Thread-safe; chờ file tiếp theo, trả về 0 khi đã quét xong (hoặc lỗi) và hàng đợi rỗng
+		size_t PopBatch(std::vector<uint32_t>& out, size_t max_items);
+
+		// Dừng quét, các file còn trong hàng đợi vẫn lấy được
+		void Cancel();
+
+		const FileTable& GetTable() const { return m_table; }
+
+		size_t GetDiscoveredCount() const { return m_discovered.load(); }
+		uint64_t GetDiscoveredBytes() const { return m_discovered_bytes.load(); }
+		bool IsComplete() const { return m_complete.load(); }
+
+		// Gọi sau khi PopBatch() trả về 0: throw lại lỗi quét nếu có
+		void RethrowIfFailed() const;
+	};
+}
+
+#endif // !SCAN_STREAM_H
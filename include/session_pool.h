@@ -0,0 +1,44 @@
+#ifndef SESSION_POOL_H
+#define SESSION_POOL_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+class FileTransferClient;
+
+/*
+ * @brief Giữ các phiên làm việc phụ (đã kết nối và xác thực) để dùng lại giữa các lần truyền song song
+ * @brief Mỗi phiên chỉ được dùng bởi một luồng tại một thời điểm
+ */
+class SessionPool
+{
+private:
+	std::pair<std::string, uint16_t> m_server_info;
+	std::pair<std::string, std::string> m_credential;
+
+	std::mutex m_mutex;
+	std::vector<std::unique_ptr<FileTransferClient>> m_idle_sessions;
+
+public:
+	SessionPool(const std::pair<std::string, uint16_t>& server_info,
+		const std::pair<std::string, std::string>& credential);
+	~SessionPool();
+
+	// Lấy một phiên rảnh hoặc mở phiên mới, ném exception nếu không kết nối được
+	std::unique_ptr<FileTransferClient> Acquire();
+
+	// Trả phiên về pool, phiên đã mất kết nối sẽ bị huỷ
+	void Release(std::unique_ptr<FileTransferClient> session);
+
+	void CloseAll();
+
+	static std::unique_ptr<FileTransferClient> OpenSession(
+		const std::pair<std::string, uint16_t>& server_info,
+		const std::pair<std::string, std::string>& credential);
+};
+
+#endif // !SESSION_POOL_H
@@ -0,0 +1,73 @@
+#ifndef SMALL_FILE_LOADER_H
+#define SMALL_FILE_LOADER_H
+
+#include <Windows.h>
+
+#include <transfer_arena.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+namespace fs = std::filesystem;
+
+namespace utils
+{
+	struct SmallFileRequest
+	{
+		fs::path path;
+		uint64_t size_hint; // Kích thước lúc quét thư mục, dùng thay cho một lần stat riêng
+	};
+
+	struct SmallFileResult
+	{
+		std::span<const uint8_t> data; // Nằm trong arena của loader, hợp lệ tới lần LoadBatch() tiếp theo
+		bool loaded;				   // false: không mở/đọc được hoặc file đã lớn hơn size_hint
+	};
+
+	/*
+	 * @brief Đọc nhiều file nhỏ cùng lúc: mỗi file được mở với FILE_FLAG_OVERLAPPED, gắn vào một I/O completion port
+	 * @brief và đọc toàn bộ bằng một ReadFile duy nhất; tối đa queue_depth lệnh đọc được treo đồng thời
+	 * @brief và các completion được lấy theo lô bằng GetQueuedCompletionStatusEx
+	 * @brief Lệnh đọc hoàn thành ngay (dữ liệu đã có trong cache) không đi qua completion port
+	 */
+	class SmallFileLoader
+	{
+	private:
+		struct Slot
+		{
+			OVERLAPPED overlapped;
+			HANDLE handle;
+			size_t request_index;
+			uint8_t* buffer;
+			size_t capacity;
+		};
+
+		HANDLE m_port;
+		size_t m_queue_depth;
+		TransferArena m_arena;
+		std::vector<Slot> m_slots;
+		std::vector<size_t> m_free_slots;
+
+	public:
+		static constexpr size_t DEFAULT_QUEUE_DEPTH = 64;
+		static constexpr size_t ARENA_BLOCK_SIZE = 4 * 1024 * 1024; // 4MB
+
+		explicit SmallFileLoader(size_t queue_depth = DEFAULT_QUEUE_DEPTH);
+		~SmallFileLoader();
+
+		SmallFileLoader(const SmallFileLoader&) = delete;
+		SmallFileLoader& operator=(const SmallFileLoader&) = delete;
+
+		// Kết quả thứ i tương ứng với requests[i]
+		std::vector<SmallFileResult> LoadBatch(std::span<const SmallFileRequest> requests);
+
+	private:
+		// Mở file và gửi lệnh đọc, trả về false nếu slot đã được giải phóng (lỗi hoặc hoàn thành ngay)
+		bool Submit(size_t slot_index, const SmallFileRequest& request, std::vector<SmallFileResult>& results);
+		void Complete(size_t slot_index, DWORD bytes_read, bool success, std::vector<SmallFileResult>& results);
+	};
+}
+
+#endif // !SMALL_FILE_LOADER_H
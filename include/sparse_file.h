@@ -0,0 +1,52 @@
+#ifndef SPARSE_FILE_H
+#define SPARSE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+namespace fs = std::filesystem;
+
+namespace utils
+{
+	struct FileExtent
+	{
+		uint64_t offset;
+		uint64_t length;
+
+		uint64_t End() const { return offset + length; }
+	};
+
+	/*
+	 * @brief Các vùng đã được cấp phát (có dữ liệu) của một file, lấy từ FSCTL_QUERY_ALLOCATED_RANGES
+	 * @brief File không sparse hoặc file system không hỗ trợ truy vấn được coi là có dữ liệu trên toàn bộ file
+	 */
+	class AllocatedRanges
+	{
+	private:
+		std::vector<FileExtent> m_ranges; // Sắp xếp theo offset, không chồng lấn
+		uint64_t m_file_size;
+
+	public:
+		AllocatedRanges() : m_ranges(), m_file_size(0) {}
+
+		static AllocatedRanges Query(const fs::path& path, uint64_t file_size);
+
+		// Vùng [offset, offset + length) có chứa byte nào đã cấp phát không
+		bool Overlaps(uint64_t offset, uint64_t length) const;
+
+		// Tổng số byte đã cấp phát
+		uint64_t GetAllocatedBytes() const;
+
+		// File có ít nhất một hole
+		bool HasHoles() const { return GetAllocatedBytes() < m_file_size; }
+
+		const std::vector<FileExtent>& GetRanges() const { return m_ranges; }
+	};
+
+	// Vùng nhớ chỉ gồm byte 0
+	bool IsZeroBlock(std::span<const uint8_t> data);
+}
+
+#endif // !SPARSE_FILE_H
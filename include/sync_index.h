@@ -0,0 +1,75 @@
+#ifndef SYNC_INDEX_H
+#define SYNC_INDEX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+namespace fs = std::filesystem;
+
+namespace utils
+{
+	constexpr auto DEFAULT_SYNC_INDEX_DIR = "./checkpoint/sync";
+
+	// Trạng thái của một file tại lần sync thành công gần nhất
+	struct SyncEntry
+	{
+		uint64_t size = 0;
+		uint64_t last_write_time = 0;	// FILETIME
+		uint64_t file_id = 0;			// Volume serial number (32 bit cao) và file index (32 bit thấp) của NTFS, 0 nếu không lấy được
+		std::array<uint8_t, 16> content_hash{}; // MD5 của nội dung đã upload
+		bool has_hash = false;
+		std::string remote_path;		// Đường dẫn trên server
+	};
+
+	/*
+	 * @brief Chỉ mục trạng thái file của một thư mục sync, khoá là đường dẫn tương đối (như FileTable::GetRelativePath)
+	 * @brief File có cùng kích thước và thời điểm ghi với bản ghi được coi là chưa đổi và bỏ qua mà không đọc nội dung
+	 * @brief Lưu thành một file nhị phân, Save() ghi ra file tạm rồi đổi tên để crash giữa chừng không làm hỏng chỉ mục cũ
+	 */
+	class SyncIndex
+	{
+	private:
+		fs::path m_path;
+
+		mutable std::mutex m_mutex;
+		std::unordered_map<std::string, SyncEntry> m_entries;
+		bool m_dirty;
+
+	public:
+		// Đọc chỉ mục từ path nếu có, file hỏng hoặc khác phiên bản được bỏ qua (mọi file sẽ được upload lại)
+		explicit SyncIndex(const fs::path& path);
+
+		SyncIndex(const SyncIndex&) = delete;
+		SyncIndex& operator=(const SyncIndex&) = delete;
+
+		// File chỉ mục của thư mục root trong DEFAULT_SYNC_INDEX_DIR
+		static fs::path PathFor(const fs::path& root);
+		// Định danh file trên volume (chỉ mở lấy thuộc tính, không đọc nội dung), 0 nếu không lấy được
+		static uint64_t QueryFileId(const fs::path& path);
+		// Kích thước và thời điểm ghi hiện tại của file (giống kết quả DirectoryScanner), false nếu không đọc được thuộc tính
+		static bool Stat(const fs::path& path, SyncEntry& out_entry);
+
+		bool Find(const std::string& relative_path, SyncEntry& out_entry) const;
+		void Put(const std::string& relative_path, const SyncEntry& entry);
+
+		// Xoá bản ghi của các file không còn trong seen, trả về số bản ghi bị xoá
+		size_t Retain(const std::unordered_set<std::string>& seen);
+
+		size_t GetEntryCount() const;
+
+		// Ghi xuống đĩa nếu có thay đổi, trả về false nếu ghi thất bại
+		bool Save();
+		// Bỏ trạng thái trong bộ nhớ và đọc lại từ đĩa (sau khi một SyncIndex khác của cùng thư mục đã Save())
+		void Reload();
+
+	private:
+		void Load();
+	};
+}
+
+#endif // !SYNC_INDEX_H
@@ -0,0 +1,98 @@
+#ifndef SYNC_PLAN_H
+#define SYNC_PLAN_H
+
+#include <file_table.h>
+#include <sync_index.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace utils
+{
+	enum class SyncAction : uint8_t
+	{
+		UPLOAD,
+		DOWNLOAD,
+		SKIP,
+		CONFLICT,
+		DELETED // Đã sync trước đây nhưng bị xoá ở một bên và bên còn lại không đổi: không chép lại
+	};
+
+	// Một file trong danh sách VIEW_CLOUD
+	struct RemoteFile
+	{
+		std::string remote_path; // Đường dẫn như server gửi, dùng cho request tải về
+		uint64_t size = 0;
+		bool has_checksum = false;
+		std::array<uint8_t, 16> checksum{};
+	};
+
+	struct SyncPlanEntry
+	{
+		SyncAction action;
+		std::string path;		  // Đường dẫn tương đối đã chuẩn hoá (dấu '/'), tính cả tên thư mục gốc
+		uint32_t local_file;	  // Chỉ số trong FileTable, SyncPlanner::NO_LOCAL_FILE nếu chỉ có trên server
+		size_t remote_file;		  // Chỉ số trong danh sách trên server, SyncPlanner::NO_REMOTE_FILE nếu chỉ có ở local
+		uint64_t local_size;
+		uint64_t remote_size;
+	};
+
+	struct SyncPlan
+	{
+		std::vector<SyncPlanEntry> entries;
+
+		size_t Count(SyncAction action) const;
+		// Tổng số byte phải truyền theo action (UPLOAD: kích thước local, DOWNLOAD: kích thước trên server)
+		uint64_t Bytes(SyncAction action) const;
+	};
+
+	/*
+	 * @brief So sánh kết quả quét local với danh sách trên server theo đường dẫn, kích thước và MD5
+	 * @brief Khi hai bên khác nhau, bản ghi SyncIndex của lần sync trước cho biết bên nào đã thay đổi:
+	 * @brief chỉ một bên đổi thì chép bên đó sang bên kia, cả hai cùng đổi (hoặc không có bản ghi) là xung đột
+	 * @brief Server không gửi checksum thì hai file cùng kích thước được coi là giống nhau (như quick check của rsync)
+	 * @brief File chỉ có ở một bên nhưng có bản ghi là file đã bị xoá ở bên kia: DELETED nếu bên còn lại không đổi, ngược lại CONFLICT
+	 */
+	class SyncPlanner
+	{
+	public:
+		static constexpr uint32_t NO_LOCAL_FILE = UINT32_MAX;
+		static constexpr size_t NO_REMOTE_FILE = SIZE_MAX;
+
+		// Tính MD5 của một file local, trả về false nếu không đọc được; chỉ được gọi khi cần so với checksum của server
+		using HashFunction = std::function<bool(uint32_t file, std::array<uint8_t, 16>& out_hash)>;
+
+	private:
+		const FileTable& m_table;
+		const SyncIndex* m_index;
+		HashFunction m_hash_local;
+
+	public:
+		// index có thể là nullptr (chưa sync lần nào)
+		SyncPlanner(const FileTable& table, const SyncIndex* index, HashFunction hash_local);
+
+		// remote_files chỉ nên chứa các file nằm dưới thư mục gốc của table
+		SyncPlan Build(std::span<const uint32_t> local_files, const std::vector<RemoteFile>& remote_files) const;
+
+		// Dấu '\\' thành '/', bỏ "./" và '/' ở đầu
+		static std::string NormalizePath(std::string path);
+		// Đường dẫn đã chuẩn hoá có an toàn để ghi dưới thư mục local không: không có "..", ".", thành phần rỗng,
+		// tên ổ đĩa hay ':' (alternate data stream)
+		static bool IsSafeRelativePath(const std::string& path);
+
+	private:
+		SyncAction Decide(uint32_t local_file, const std::string& relative_path, const RemoteFile& remote) const;
+		SyncAction DecideLocalOnly(uint32_t local_file, const std::string& relative_path) const;
+		SyncAction DecideRemoteOnly(const std::string& path, const RemoteFile& remote) const;
+
+		// Bản trên server vẫn là bản đã ghi trong base
+		static bool IsRemoteUnchanged(const SyncEntry& base, const RemoteFile& remote);
+	};
+}
+
+#endif // !SYNC_PLAN_H
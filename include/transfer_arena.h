@@ -0,0 +1,47 @@
+#ifndef TRANSFER_ARENA_H
+#define TRANSFER_ARENA_H
+
+#include <aligned_buffer_pool.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utils
+{
+	/*
+	 * @brief Bump allocator cho buffer gói tin của một phiên truyền, các khối nhớ lấy từ AlignedBufferPool
+	 * @brief Reset() thu hồi toàn bộ vùng đã cấp nhưng giữ lại khối lớn nhất, nên khi các gói tin có kích thước ổn định
+	 * @brief thì mỗi chunk không còn cấp phát heap nào; Release() trả mọi khối về pool
+	 * @brief Không thread-safe: mỗi NetworkConnection giữ arena riêng
+	 */
+	class TransferArena
+	{
+	private:
+		AlignedBufferPool& m_pool;
+		size_t m_block_size;
+		std::vector<AlignedBufferPool::Buffer> m_blocks;
+		size_t m_used; // Số byte đã cấp trong khối cuối
+
+	public:
+		static constexpr size_t DEFAULT_BLOCK_SIZE = 256 * 1024; // 256KB
+		static constexpr size_t DEFAULT_ALIGNMENT = 16;
+
+		explicit TransferArena(AlignedBufferPool& pool = AlignedBufferPool::Shared(), size_t block_size = DEFAULT_BLOCK_SIZE);
+		~TransferArena() = default;
+
+		TransferArena(const TransferArena&) = delete;
+		TransferArena& operator=(const TransferArena&) = delete;
+
+		// Vùng nhớ size byte, hợp lệ tới lần Reset()/Release() tiếp theo
+		uint8_t* Allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT);
+
+		void Reset();
+		void Release();
+
+		// Tổng dung lượng các khối đang giữ
+		size_t GetCapacity() const;
+	};
+}
+
+#endif // !TRANSFER_ARENA_H
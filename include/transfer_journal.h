@@ -0,0 +1,134 @@
+#ifndef TRANSFER_JOURNAL_H
+#define TRANSFER_JOURNAL_H
+
+#include <Windows.h>
+
+#include <chunk_bitmap.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+namespace fs = std::filesystem;
+
+namespace utils
+{
+	constexpr auto DEFAULT_JOURNAL_PATH = "./checkpoint/transfers.journal";
+	constexpr size_t MAX_JOURNAL_SLOTS = 8; // Số tiến trình tối đa dùng journal cùng lúc trong một thư mục làm việc
+
+	// Journal đang thuộc về một tiến trình khác
+	class JournalInUseError : public std::runtime_error
+	{
+	public:
+		using std::runtime_error::runtime_error;
+	};
+
+	enum class TransferDirection : uint8_t
+	{
+		UPLOAD,
+		DOWNLOAD
+	};
+
+	// Trạng thái mới nhất của một phiên truyền chưa hoàn tất
+	struct TransferState
+	{
+		uint64_t transfer_id = 0;
+		TransferDirection direction = TransferDirection::UPLOAD;
+		std::string local_path;
+		std::string remote_path;
+		uint32_t file_id = 0;
+		uint64_t file_size = 0;
+		uint32_t chunk_size = 0;
+		uint32_t chunk_index = 0; // Last completed chunk, valid when position > 0
+		uint64_t position = 0;	  // Bytes completed
+		ChunkBitmap completed_chunks; // Các chunk đã hoàn tất (không cần liên tiếp), rỗng nếu chunk_size == 0
+	};
+
+	// Group commit: các bản ghi tiến độ được gom lại và FlushFileBuffers một lần
+	struct JournalCommitPolicy
+	{
+		size_t max_pending_records = 256;
+		std::chrono::milliseconds max_delay = std::chrono::milliseconds(200);
+		uint64_t compact_threshold_bytes = 4ULL * 1024 * 1024; // Compact khi journal lớn hơn ngưỡng này
+	};
+
+	/*
+	 * @brief Journal ghi nối tiếp (append-only) với bản ghi kích thước cố định, dùng chung cho mọi phiên truyền
+	 * @brief Khi khởi động journal được đọc lại để dựng trạng thái, bản ghi hỏng ở cuối file (do crash) bị cắt bỏ
+	 * @brief Mỗi journal thuộc về một tiến trình qua file khoá "<journal>.lock" mở độc quyền; tiến trình khác chạy cùng lúc
+	 * @brief (ví dụ CLI trong khi WatchDirectory đang chạy) dùng slot journal tiếp theo, xem Shared()
+	 */
+	class TransferJournal
+	{
+	private:
+		fs::path m_path;
+		JournalCommitPolicy m_policy;
+		HANDLE m_handle;
+		HANDLE m_lock; // Khoá sở hữu, file khoá tự xoá khi đóng
+
+		mutable std::mutex m_mutex; // Bảo vệ trạng thái và bộ đệm
+		std::mutex m_io_mutex;		// Giữ thứ tự ghi xuống file
+		std::condition_variable m_cv;
+
+		std::unordered_map<uint64_t, TransferState> m_states;
+		std::vector<uint8_t> m_pending;
+		size_t m_pending_records;
+		uint64_t m_end_offset;
+		uint64_t m_next_id;
+
+		bool m_stop;
+		std::thread m_flusher;
+
+	public:
+		explicit TransferJournal(const fs::path& path, const JournalCommitPolicy& policy = JournalCommitPolicy());
+		~TransferJournal();
+
+		TransferJournal(const TransferJournal&) = delete;
+		TransferJournal& operator=(const TransferJournal&) = delete;
+
+		// Journal dùng chung của tiến trình, mở ở lần gọi đầu tiên tại slot đầu tiên chưa có tiến trình nào giữ;
+		// phiên dang dở trong journal của các tiến trình đã thoát được chuyển vào journal này
+		static TransferJournal& Shared();
+		// Slot 0 là DEFAULT_JOURNAL_PATH
+		static fs::path SlotPath(size_t slot);
+
+		// Ghi bền vững ngay (không chờ group commit), trả về transfer ID mới
+		uint64_t BeginTransfer(TransferDirection direction, const std::string& local_path, const std::string& remote_path,
+			uint32_t file_id, uint64_t file_size, uint32_t chunk_size);
+
+		// Đánh dấu chunk_index đã hoàn tất, bản ghi được ghi vào bộ đệm và commit theo JournalCommitPolicy
+		void RecordProgress(uint64_t transfer_id, uint32_t chunk_index, uint64_t position);
+
+		// Nhận phiên dang dở từ journal khác (giữ bitmap và tiến độ), trả về transfer ID mới
+		uint64_t AdoptTransfer(const TransferState& state);
+
+		void CompleteTransfer(uint64_t transfer_id);
+		void AbortTransfer(uint64_t transfer_id);
+
+		bool GetState(uint64_t transfer_id, TransferState& out_state) const;
+		std::vector<TransferState> GetActiveTransfers() const;
+
+		void Commit();
+		void Compact();
+
+	private:
+		static std::unique_ptr<TransferJournal> OpenShared();
+
+		// Throw JournalInUseError nếu tiến trình khác đang giữ journal
+		void Lock();
+		void Open();
+		void Replay();
+		void FinishTransfer(uint64_t transfer_id, uint8_t record_type);
+		void FlusherLoop();
+		void WriteAll(HANDLE handle, uint64_t offset, const std::vector<uint8_t>& data);
+	};
+}
+
+#endif // !TRANSFER_JOURNAL_H
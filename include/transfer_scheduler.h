@@ -0,0 +1,95 @@
+#ifndef TRANSFER_SCHEDULER_H
+#define TRANSFER_SCHEDULER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace utils
+{
+	enum class WorkKind : uint8_t
+	{
+		SMALL_BATCH,  // Nhiều file nhỏ, đọc chung một lô và gửi inline
+		FILE,		  // Một file upload theo chunk trên phiên của worker
+		STRIPED_FILE, // Một file lớn chia stripe qua nhiều kết nối
+		RESUME_FILE,  // File lớn đã upload dở ở lần chạy trước, tiếp tục theo checkpoint của nó
+	};
+
+	struct WorkItem
+	{
+		WorkKind kind;
+		std::vector<uint32_t> files; // Chỉ số trong FileTable
+		uint64_t bytes;
+		uint32_t attempts; // Số lần đã thất bại và được đưa lại vào hàng đợi
+	};
+
+	/*
+	 * @brief Phân phối công việc cho các worker upload song song: mỗi worker có deque riêng,
+	 * @brief item mới vào deque đang ít byte nhất, worker hết việc lấy trộm từ cuối deque đang nhiều byte nhất
+	 * @brief Item thất bại được đưa lại vào hàng đợi (tối đa MAX_ATTEMPTS lần) để worker khác xử lý
+	 * @brief Next() trả về false khi đã Close(), mọi item đã hoàn thành và không còn item nào chờ, hoặc khi Cancel()
+	 */
+	class TransferScheduler
+	{
+	private:
+		struct WorkerQueue
+		{
+			std::deque<WorkItem> items;
+			uint64_t queued_bytes = 0;
+		};
+
+		std::mutex m_mutex;
+		std::condition_variable m_work_available;
+		std::condition_variable m_space_available;
+		std::vector<WorkerQueue> m_queues;
+		size_t m_capacity;	  // Số item tối đa đang chờ, Submit() chặn khi đầy
+		size_t m_queued;	  // Số item đang chờ trong các deque
+		size_t m_outstanding; // Số item đã nhận nhưng chưa Complete()
+		bool m_closed;
+		bool m_cancelled;
+
+	public:
+		static constexpr size_t DEFAULT_CAPACITY = 1024;
+		static constexpr uint32_t MAX_ATTEMPTS = 3;
+
+		explicit TransferScheduler(size_t worker_count, size_t capacity = DEFAULT_CAPACITY);
+
+		TransferScheduler(const TransferScheduler&) = delete;
+		TransferScheduler& operator=(const TransferScheduler&) = delete;
+
+		// Chặn khi hàng đợi đầy, trả về false nếu scheduler đã bị huỷ
+		bool Submit(WorkItem item);
+
+		// Chờ item cho worker, trả về false khi không còn việc
+		bool Next(size_t worker, WorkItem& item);
+
+		// Item đã xong (thành công hoặc lỗi không thử lại)
+		void Complete();
+
+		// Đưa item thất bại lại vào hàng đợi, trả về false nếu đã hết số lần thử (item vẫn chưa Complete())
+		bool Requeue(WorkItem&& item);
+
+		// Không còn item mới, các worker dừng khi làm xong phần còn lại
+		void Close();
+
+		// Dừng ngay: Submit() và Next() trả về false
+		void Cancel();
+
+		// Các item chưa được worker nào nhận (sau Cancel())
+		std::vector<WorkItem> TakeRemaining();
+
+		// Đã Close() và mọi item đều đã Complete()
+		bool IsDone();
+
+	private:
+		// Chỉ số deque có ít byte đang chờ nhất (gọi khi đang giữ m_mutex)
+		size_t LeastLoadedQueue() const;
+		void Enqueue(WorkItem&& item);
+		bool IsFinished() const { return m_closed && m_outstanding == 0; }
+	};
+}
+
+#endif // !TRANSFER_SCHEDULER_H
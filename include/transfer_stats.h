@@ -0,0 +1,53 @@
+#ifndef TRANSFER_STATS_H
+#define TRANSFER_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace utils
+{
+	/*
+	 * @brief Bộ đếm dùng chung cho mọi kết nối trong tiến trình: số byte gửi/nhận và thời gian từ lúc gửi request tới khi nhận response
+	 * @brief Được lấy mẫu định kỳ (hiệu hai Snapshot) để tính goodput và RTT trung bình của các lần truyền song song
+	 */
+	class TransferStats
+	{
+	public:
+		struct Snapshot
+		{
+			uint64_t bytes_sent;
+			uint64_t bytes_received;
+			uint64_t round_trip_us; // Tổng thời gian các round trip
+			uint64_t round_trips;
+		};
+
+	private:
+		std::atomic<uint64_t> m_bytes_sent;
+		std::atomic<uint64_t> m_bytes_received;
+		std::atomic<uint64_t> m_round_trip_us;
+		std::atomic<uint64_t> m_round_trips;
+
+	public:
+		TransferStats() : m_bytes_sent(0), m_bytes_received(0), m_round_trip_us(0), m_round_trips(0) {}
+
+		static TransferStats& Shared();
+
+		void AddSent(uint64_t bytes) { m_bytes_sent.fetch_add(bytes, std::memory_order_relaxed); }
+		void AddReceived(uint64_t bytes) { m_bytes_received.fetch_add(bytes, std::memory_order_relaxed); }
+
+		void AddRoundTrip(std::chrono::steady_clock::duration elapsed)
+		{
+			m_round_trip_us.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()), std::memory_order_relaxed);
+			m_round_trips.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		Snapshot Take() const
+		{
+			return { m_bytes_sent.load(std::memory_order_relaxed), m_bytes_received.load(std::memory_order_relaxed),
+				m_round_trip_us.load(std::memory_order_relaxed), m_round_trips.load(std::memory_order_relaxed) };
+		}
+	};
+}
+
+#endif // !TRANSFER_STATS_H
@@ -0,0 +1,222 @@
+#include <aligned_buffer_pool.h>
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+utils::AlignedBufferPool::Buffer::Buffer(Buffer&& other) noexcept
+	: m_pool(other.m_pool),
+	m_data(other.m_data),
+	m_size(other.m_size)
+{
+	other.m_pool = nullptr;
+	other.m_data = nullptr;
+	other.m_size = 0;
+}
+
+utils::AlignedBufferPool::Buffer& utils::AlignedBufferPool::Buffer::operator=(Buffer&& other) noexcept
+{
+	if (this != &other)
+	{
+		Release();
+
+		m_pool = other.m_pool;
+		m_data = other.m_data;
+		m_size = other.m_size;
+
+		other.m_pool = nullptr;
+		other.m_data = nullptr;
+		other.m_size = 0;
+	}
+	return *this;
+}
+
+void utils::AlignedBufferPool::Buffer::Release()
+{
+	if (m_pool != nullptr && m_data != nullptr)
+	{
+		m_pool->Return(m_data, m_size);
+	}
+
+	m_pool = nullptr;
+	m_data = nullptr;
+	m_size = 0;
+}
+
+utils::AlignedBufferPool::AlignedBufferPool(size_t max_idle_bytes)
+	: m_mutex(),
+	m_idle(),
+	m_idle_bytes(0),
+	m_max_idle_bytes(max_idle_bytes),
+	m_large_page_size(0)
+{
+}
+
+utils::AlignedBufferPool::~AlignedBufferPool()
+{
+	for (auto& size_class : m_idle)
+	{
+		for (uint8_t* data : size_class)
+		{
+			VirtualFree(data, 0, MEM_RELEASE);
+		}
+	}
+}
+
+utils::AlignedBufferPool& utils::AlignedBufferPool::Shared()
+{
+	static AlignedBufferPool pool;
+	return pool;
+}
+
+size_t utils::AlignedBufferPool::SizeClassIndex(size_t size)
+{
+	if (size <= MIN_CLASS_SIZE)
+	{
+		return 0;
+	}
+
+	if (size > MAX_CLASS_SIZE)
+	{
+		return SIZE_CLASS_COUNT;
+	}
+
+	// base < size <= 2 * base, khoảng này chia thành CLASSES_PER_DOUBLING bước bằng nhau
+	const size_t doubling = static_cast<size_t>(std::bit_width((size - 1) / MIN_CLASS_SIZE)) - 1;
+	const size_t base = MIN_CLASS_SIZE << doubling;
+	const size_t step_size = base / CLASSES_PER_DOUBLING;
+	const size_t step = (size - base + step_size - 1) / step_size;
+
+	return 1 + doubling * CLASSES_PER_DOUBLING + (step - 1);
+}
+
+size_t utils::AlignedBufferPool::SizeClassSize(size_t index)
+{
+	if (index == 0)
+	{
+		return MIN_CLASS_SIZE;
+	}
+
+	const size_t doubling = (index - 1) / CLASSES_PER_DOUBLING;
+	const size_t step = (index - 1) % CLASSES_PER_DOUBLING + 1;
+	const size_t base = MIN_CLASS_SIZE << doubling;
+
+	return base + step * (base / CLASSES_PER_DOUBLING);
+}
+
+size_t utils::AlignedBufferPool::RoundToSizeClass(size_t size)
+{
+	const size_t index = SizeClassIndex(size);
+
+	// Buffer vượt class cuối chỉ làm tròn theo allocation granularity
+	return index < SIZE_CLASS_COUNT ? SizeClassSize(index) : static_cast<size_t>(AlignUp(size, MIN_CLASS_SIZE));
+}
+
+bool utils::AlignedBufferPool::EnableLargePages()
+{
+	const SIZE_T large_page_size = GetLargePageMinimum();
+	if (large_page_size == 0)
+	{
+		return false;
+	}
+
+	HANDLE token = nullptr;
+	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+	{
+		return false;
+	}
+
+	TOKEN_PRIVILEGES privileges{};
+	privileges.PrivilegeCount = 1;
+	privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+	// AdjustTokenPrivileges thành công cả khi tài khoản không có quyền, phải kiểm tra ERROR_NOT_ALL_ASSIGNED
+	bool enabled = LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) &&
+		AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+		GetLastError() == ERROR_SUCCESS;
+
+	CloseHandle(token);
+
+	if (!enabled)
+	{
+		std::cerr << "[AlignedBufferPool] SeLockMemoryPrivilege is not granted, using regular pages." << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_large_page_size = large_page_size;
+	return true;
+}
+
+utils::AlignedBufferPool::Buffer utils::AlignedBufferPool::Acquire(size_t size)
+{
+	size = RoundToSizeClass((std::max)(size, static_cast<size_t>(1)));
+
+	const size_t index = SizeClassIndex(size);
+	if (index < SIZE_CLASS_COUNT)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto& size_class = m_idle[index];
+		if (!size_class.empty())
+		{
+			uint8_t* data = size_class.back();
+			size_class.pop_back();
+			m_idle_bytes -= size;
+			return Buffer(this, data, size);
+		}
+	}
+
+	return Buffer(this, Allocate(size), size);
+}
+
+uint8_t* utils::AlignedBufferPool::Allocate(size_t size)
+{
+	size_t large_page_size = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		large_page_size = m_large_page_size;
+	}
+
+	// MEM_LARGE_PAGES yêu cầu kích thước là bội số của large page, có thể thất bại khi bộ nhớ vật lý bị phân mảnh
+	if (large_page_size != 0 && size % large_page_size == 0)
+	{
+		void* data = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (data != nullptr)
+		{
+			return static_cast<uint8_t*>(data);
+		}
+	}
+
+	void* data = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+	if (data == nullptr)
+	{
+		throw std::runtime_error("Failed to allocate aligned buffer (error " + std::to_string(GetLastError()) + ")");
+	}
+
+	return static_cast<uint8_t*>(data);
+}
+
+void utils::AlignedBufferPool::Return(uint8_t* data, size_t size)
+{
+	const size_t index = SizeClassIndex(size);
+
+	if (index < SIZE_CLASS_COUNT)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (m_idle_bytes + size <= m_max_idle_bytes)
+		{
+			m_idle[index].push_back(data);
+			m_idle_bytes += size;
+			return;
+		}
+	}
+
+	VirtualFree(data, 0, MEM_RELEASE);
+}
@@ -0,0 +1,30 @@
+#include <cache_policy.h>
+
+utils::ScopedMemoryPriority::ScopedMemoryPriority(bool enabled, ULONG priority)
+	: m_previous(MEMORY_PRIORITY_NORMAL),
+	m_changed(false)
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	MEMORY_PRIORITY_INFORMATION info{};
+	if (GetThreadInformation(GetCurrentThread(), ThreadMemoryPriority, &info, sizeof(info)))
+	{
+		m_previous = info.MemoryPriority;
+	}
+
+	info.MemoryPriority = priority;
+	m_changed = SetThreadInformation(GetCurrentThread(), ThreadMemoryPriority, &info, sizeof(info)) != FALSE;
+}
+
+utils::ScopedMemoryPriority::~ScopedMemoryPriority()
+{
+	if (m_changed)
+	{
+		MEMORY_PRIORITY_INFORMATION info{};
+		info.MemoryPriority = m_previous;
+		SetThreadInformation(GetCurrentThread(), ThreadMemoryPriority, &info, sizeof(info));
+	}
+}
@@ -0,0 +1,162 @@
+#include <checkpoint_store.h>
+
+#include <algorithm>
+#include <cctype>
+
+utils::CheckpointStore::CheckpointStore(TransferJournal& journal)
+	: m_journal(journal),
+	m_mutex(),
+	m_upload_index(),
+	m_download_index()
+{
+	std::vector<uint64_t> shadowed;
+
+	// Danh sách theo thứ tự transfer ID nên checkpoint mới hơn của cùng một file sẽ thay thế bản cũ
+	for (const auto& state : m_journal.GetActiveTransfers())
+	{
+		auto& slot = IndexOf(state.direction)[NormalizePath(state.local_path)];
+		if (slot != 0)
+		{
+			shadowed.push_back(slot);
+		}
+		slot = state.transfer_id;
+	}
+
+	for (uint64_t transfer_id : shadowed)
+	{
+		m_journal.AbortTransfer(transfer_id);
+	}
+}
+
+utils::CheckpointStore& utils::CheckpointStore::Shared()
+{
+	static CheckpointStore store(TransferJournal::Shared());
+	return store;
+}
+
+std::string utils::CheckpointStore::NormalizePath(const fs::path& path)
+{
+	std::error_code ec;
+	fs::path absolute = fs::absolute(path, ec);
+
+	std::string key = (ec ? path : absolute).lexically_normal().string();
+
+	// Đường dẫn trên Windows không phân biệt hoa thường
+	std::transform(key.begin(), key.end(), key.begin(),
+		[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	std::replace(key.begin(), key.end(), '\\', '/');
+
+	return key;
+}
+
+std::unordered_map<std::string, uint64_t>& utils::CheckpointStore::IndexOf(TransferDirection direction)
+{
+	return (direction == TransferDirection::UPLOAD) ? m_upload_index : m_download_index;
+}
+
+const std::unordered_map<std::string, uint64_t>& utils::CheckpointStore::IndexOf(TransferDirection direction) const
+{
+	return (direction == TransferDirection::UPLOAD) ? m_upload_index : m_download_index;
+}
+
+uint64_t utils::CheckpointStore::Begin(TransferDirection direction, const fs::path& local_path, const std::string& remote_path,
+	uint32_t file_id, uint64_t file_size, uint32_t chunk_size)
+{
+	const std::string key = NormalizePath(local_path);
+	uint64_t replaced_id = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto& index = IndexOf(direction);
+		auto it = index.find(key);
+		if (it != index.end())
+		{
+			replaced_id = it->second;
+			index.erase(it);
+		}
+	}
+
+	if (replaced_id != 0)
+	{
+		m_journal.AbortTransfer(replaced_id);
+	}
+
+	uint64_t transfer_id = m_journal.BeginTransfer(direction, fs::absolute(local_path).string(), remote_path,
+		file_id, file_size, chunk_size);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	IndexOf(direction)[key] = transfer_id;
+
+	return transfer_id;
+}
+
+void utils::CheckpointStore::Progress(uint64_t transfer_id, uint32_t chunk_index, uint64_t position)
+{
+	m_journal.RecordProgress(transfer_id, chunk_index, position);
+}
+
+void utils::CheckpointStore::Complete(uint64_t transfer_id)
+{
+	Unindex(transfer_id);
+	m_journal.CompleteTransfer(transfer_id);
+}
+
+void utils::CheckpointStore::Abort(uint64_t transfer_id)
+{
+	Unindex(transfer_id);
+	m_journal.AbortTransfer(transfer_id);
+}
+
+void utils::CheckpointStore::Unindex(uint64_t transfer_id)
+{
+	TransferState state;
+	if (!m_journal.GetState(transfer_id, state))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto& index = IndexOf(state.direction);
+	auto it = index.find(NormalizePath(state.local_path));
+	if (it != index.end() && it->second == transfer_id)
+	{
+		index.erase(it);
+	}
+}
+
+bool utils::CheckpointStore::Get(uint64_t transfer_id, TransferState& out_state) const
+{
+	return m_journal.GetState(transfer_id, out_state);
+}
+
+bool utils::CheckpointStore::Find(TransferDirection direction, const fs::path& local_path, TransferState& out_state) const
+{
+	uint64_t transfer_id = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		const auto& index = IndexOf(direction);
+		auto it = index.find(NormalizePath(local_path));
+		if (it == index.end())
+		{
+			return false;
+		}
+		transfer_id = it->second;
+	}
+
+	return m_journal.GetState(transfer_id, out_state);
+}
+
+std::vector<utils::TransferState> utils::CheckpointStore::List(TransferDirection direction) const
+{
+	std::vector<TransferState> states = m_journal.GetActiveTransfers();
+
+	states.erase(std::remove_if(states.begin(), states.end(),
+		[direction](const TransferState& state) { return state.direction != direction; }),
+		states.end());
+
+	return states;
+}
@@ -0,0 +1,172 @@
+#include <chunk_bitmap.h>
+
+#include <stdexcept>
+
+namespace
+{
+	void AppendVarint(std::vector<uint8_t>& buffer, uint32_t value)
+	{
+		while (value >= 0x80)
+		{
+			buffer.push_back(static_cast<uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		buffer.push_back(static_cast<uint8_t>(value));
+	}
+
+	uint32_t ReadVarint(const uint8_t* data, size_t size, size_t& offset)
+	{
+		uint32_t value = 0;
+
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			if (offset >= size)
+				throw std::runtime_error("Insufficient data for ChunkBitmap deserialization");
+
+			uint8_t byte = data[offset++];
+			value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+
+			if ((byte & 0x80) == 0)
+				return value;
+		}
+
+		throw std::runtime_error("Invalid varint in ChunkBitmap");
+	}
+}
+
+utils::ChunkBitmap::ChunkBitmap() : m_words(), m_chunk_count(0), m_completed(0)
+{
+}
+
+utils::ChunkBitmap::ChunkBitmap(uint32_t chunk_count)
+	: m_words((static_cast<size_t>(chunk_count) + 63) / 64, 0),
+	m_chunk_count(chunk_count),
+	m_completed(0)
+{
+}
+
+void utils::ChunkBitmap::Set(uint32_t chunk_index)
+{
+	if (chunk_index >= m_chunk_count)
+		throw std::out_of_range("Chunk index out of range");
+
+	uint64_t& word = m_words[chunk_index / 64];
+	const uint64_t mask = 1ULL << (chunk_index % 64);
+
+	if ((word & mask) == 0)
+	{
+		word |= mask;
+		m_completed++;
+	}
+}
+
+bool utils::ChunkBitmap::Test(uint32_t chunk_index) const
+{
+	if (chunk_index >= m_chunk_count)
+		return false;
+
+	return (m_words[chunk_index / 64] >> (chunk_index % 64)) & 1;
+}
+
+uint32_t utils::ChunkBitmap::GetCompletedPrefix() const
+{
+	uint32_t prefix = 0;
+
+	for (uint64_t word : m_words)
+	{
+		if (word == ~0ULL)
+		{
+			prefix += 64;
+			continue;
+		}
+
+		// Số bit 1 liên tiếp ở cuối word
+		while (word & 1)
+		{
+			prefix++;
+			word >>= 1;
+		}
+		break;
+	}
+
+	return (prefix < m_chunk_count) ? prefix : m_chunk_count;
+}
+
+std::vector<uint32_t> utils::ChunkBitmap::GetMissingChunks() const
+{
+	std::vector<uint32_t> missing;
+	missing.reserve(GetMissingCount());
+
+	for (uint32_t i = 0; i < m_chunk_count; i++)
+	{
+		if (!Test(i))
+		{
+			missing.push_back(i);
+		}
+	}
+
+	return missing;
+}
+
+std::vector<uint8_t> utils::ChunkBitmap::Encode() const
+{
+	std::vector<uint8_t> buffer;
+	AppendVarint(buffer, m_chunk_count);
+
+	bool current = false; // Đoạn đầu tiên là các chunk còn thiếu
+	uint32_t run = 0;
+
+	for (uint32_t i = 0; i < m_chunk_count; i++)
+	{
+		if (Test(i) != current)
+		{
+			AppendVarint(buffer, run);
+			current = !current;
+			run = 0;
+		}
+		run++;
+	}
+
+	if (m_chunk_count > 0)
+	{
+		AppendVarint(buffer, run);
+	}
+
+	return buffer;
+}
+
+utils::ChunkBitmap utils::ChunkBitmap::Decode(const uint8_t* data, size_t size, uint32_t expected_chunk_count)
+{
+	size_t offset = 0;
+
+	// Số chunk đến từ dữ liệu bên ngoài: không cấp phát theo nó trước khi so với kích thước file
+	const uint32_t chunk_count = ReadVarint(data, size, offset);
+	if (chunk_count != expected_chunk_count)
+		throw std::runtime_error("Chunk count mismatch in ChunkBitmap");
+
+	ChunkBitmap bitmap(chunk_count);
+
+	bool current = false;
+	uint32_t position = 0;
+
+	while (position < bitmap.m_chunk_count)
+	{
+		uint32_t run = ReadVarint(data, size, offset);
+
+		if (run > bitmap.m_chunk_count - position)
+			throw std::runtime_error("Invalid run length in ChunkBitmap");
+
+		if (current)
+		{
+			for (uint32_t i = 0; i < run; i++)
+			{
+				bitmap.Set(position + i);
+			}
+		}
+
+		position += run;
+		current = !current;
+	}
+
+	return bitmap;
+}
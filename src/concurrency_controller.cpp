@@ -0,0 +1,136 @@
+#include <concurrency_controller.h>
+
+#include <Windows.h>
+
+#include <algorithm>
+
+namespace
+{
+	uint64_t ToUInt64(const FILETIME& time)
+	{
+		return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+	}
+}
+
+utils::ConcurrencyController::ConcurrencyController(size_t initial_workers, size_t max_workers,
+	std::chrono::steady_clock::duration interval, size_t min_workers)
+	: m_min_workers((std::max)(min_workers, size_t(1))),
+	m_max_workers((std::max)(max_workers, m_min_workers)),
+	m_target(std::clamp(initial_workers, m_min_workers, m_max_workers)),
+	m_interval(interval),
+	m_last_sample(std::chrono::steady_clock::now()),
+	m_last_stats(TransferStats::Shared().Take()),
+	m_last_cpu_idle(0),
+	m_last_cpu_total(0),
+	m_goodput(0.0),
+	m_last_goodput(0.0),
+	m_round_trip_us(0.0),
+	m_base_round_trip_us(0.0),
+	m_cpu_usage(0.0),
+	m_last_step(0),
+	m_slow_start(true),
+	m_hold(0)
+{
+	SampleCpuUsage();
+}
+
+size_t utils::ConcurrencyController::Update()
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (now - m_last_sample < m_interval)
+	{
+		return m_target;
+	}
+
+	const double seconds = std::chrono::duration<double>(now - m_last_sample).count();
+	const TransferStats::Snapshot stats = TransferStats::Shared().Take();
+
+	m_goodput = static_cast<double>((stats.bytes_sent - m_last_stats.bytes_sent) + (stats.bytes_received - m_last_stats.bytes_received)) / seconds;
+
+	const uint64_t round_trips = stats.round_trips - m_last_stats.round_trips;
+	if (round_trips > 0)
+	{
+		m_round_trip_us = static_cast<double>(stats.round_trip_us - m_last_stats.round_trip_us) / round_trips;
+
+		if (m_base_round_trip_us == 0.0 || m_round_trip_us < m_base_round_trip_us)
+		{
+			m_base_round_trip_us = m_round_trip_us;
+		}
+	}
+
+	m_cpu_usage = SampleCpuUsage();
+
+	m_last_sample = now;
+	m_last_stats = stats;
+
+	const bool gained = m_goodput >= m_last_goodput * MIN_GAIN;
+	const bool rtt_inflated = m_base_round_trip_us > 0.0 && m_round_trip_us > m_base_round_trip_us * RTT_INFLATION;
+	long long step = 0;
+
+	if (m_hold > 0)
+	{
+		m_hold--;
+	}
+	else if (m_cpu_usage >= CPU_SATURATION)
+	{
+		// Thêm kết nối chỉ làm tăng tranh chấp
+		step = -1;
+		m_slow_start = false;
+	}
+	else if (m_last_step > 0 && !gained)
+	{
+		// Các worker vừa thêm không mang lại goodput: quay lại mức trước đó
+		step = -m_last_step;
+		m_slow_start = false;
+		m_hold = HOLD_INTERVALS;
+	}
+	else if (rtt_inflated && !gained)
+	{
+		// Hàng đợi mạng đang đầy
+		step = -1;
+		m_slow_start = false;
+	}
+	else if (m_last_step < 0 && m_goodput * MIN_GAIN >= m_last_goodput)
+	{
+		// Bớt worker mà goodput không giảm: tiếp tục bớt
+		step = -1;
+	}
+	else if (m_target < m_max_workers)
+	{
+		step = m_slow_start ? static_cast<long long>(m_target) : 1;
+	}
+
+	step = std::clamp(step, static_cast<long long>(m_min_workers) - static_cast<long long>(m_target),
+		static_cast<long long>(m_max_workers) - static_cast<long long>(m_target));
+	m_target = static_cast<size_t>(static_cast<long long>(m_target) + step);
+	m_last_step = step;
+	m_last_goodput = m_goodput;
+
+	return m_target;
+}
+
+double utils::ConcurrencyController::SampleCpuUsage()
+{
+	FILETIME idle_time, kernel_time, user_time;
+	if (!GetSystemTimes(&idle_time, &kernel_time, &user_time))
+	{
+		return 0.0;
+	}
+
+	// Kernel time đã bao gồm idle time
+	const uint64_t idle = ToUInt64(idle_time);
+	const uint64_t total = ToUInt64(kernel_time) + ToUInt64(user_time);
+
+	const uint64_t idle_delta = idle - m_last_cpu_idle;
+	const uint64_t total_delta = total - m_last_cpu_total;
+
+	m_last_cpu_idle = idle;
+	m_last_cpu_total = total;
+
+	if (total_delta == 0)
+	{
+		return 0.0;
+	}
+
+	return 1.0 - static_cast<double>(idle_delta) / static_cast<double>(total_delta);
+}
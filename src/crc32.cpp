@@ -0,0 +1,29 @@
+#include <crc32.h>
+
+#include <array>
+
+uint32_t utils::Crc32(const uint8_t* data, size_t size, uint32_t crc)
+{
+	// Bảng được dựng lúc biên dịch: lần gọi đầu tiên có thể đến đồng thời từ nhiều luồng
+	static constexpr auto table = []()
+		{
+			std::array<uint32_t, 256> result{};
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++)
+				{
+					c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+				}
+				result[i] = c;
+			}
+			return result;
+		}();
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+	{
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
@@ -0,0 +1,529 @@
+#include <delta_sync.h>
+#include <encryption_handler.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+	constexpr size_t COPY_INSTRUCTION_SIZE = sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint32_t); // op + block_index + block_count
+	constexpr size_t LITERAL_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint32_t);						// op + length
+	constexpr size_t DELTA_READ_SIZE = 4ULL * 1024 * 1024;											// 4MB
+
+	uint16_t WeakTag(uint32_t weak)
+	{
+		return static_cast<uint16_t>((weak ^ (weak >> 16)) & 0xFFFF);
+	}
+
+	void AppendU32(std::vector<uint8_t>& buffer, uint32_t value)
+	{
+		buffer.insert(buffer.end(),
+			reinterpret_cast<const uint8_t*>(&value),
+			reinterpret_cast<const uint8_t*>(&value) + sizeof(value));
+	}
+}
+
+utils::RollingChecksum::RollingChecksum() : m_a(0), m_b(0), m_window(0)
+{
+}
+
+void utils::RollingChecksum::Reset(const uint8_t* data, size_t length)
+{
+	m_a = 0;
+	m_b = 0;
+	m_window = length;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		m_a += data[i];
+		m_b += static_cast<uint32_t>(length - i) * data[i];
+	}
+}
+
+void utils::RollingChecksum::Roll(uint8_t out_byte, uint8_t in_byte)
+{
+	// Modular arithmetic on uint32_t is exact for the low 16 bits used by Digest()
+	m_a += in_byte - out_byte;
+	m_b += m_a - static_cast<uint32_t>(m_window) * out_byte;
+}
+
+uint32_t utils::RollingChecksum::Digest() const
+{
+	return (m_a & 0xFFFF) | ((m_b & 0xFFFF) << 16);
+}
+
+uint32_t utils::RollingChecksum::Compute(const uint8_t* data, size_t length)
+{
+	RollingChecksum checksum;
+	checksum.Reset(data, length);
+	return checksum.Digest();
+}
+
+utils::DeltaEncoder::DeltaEncoder(const std::vector<BlockSignatureDTO>& signatures, uint32_t block_size, size_t max_instruction_size)
+	: m_signatures(signatures),
+	m_block_size(block_size),
+	m_max_instruction_size(max_instruction_size),
+	m_weak_index(),
+	m_weak_filter(0x10000, false),
+	m_pending(),
+	m_copy_start(0),
+	m_copy_count(0),
+	m_matched_bytes(0),
+	m_literal_bytes(0)
+{
+	if (m_block_size == 0)
+	{
+		throw std::invalid_argument("Block size for delta encoding must not be zero.");
+	}
+
+	if (m_max_instruction_size <= COPY_INSTRUCTION_SIZE + LITERAL_HEADER_SIZE)
+	{
+		throw std::invalid_argument("Maximum instruction size is too small for delta encoding.");
+	}
+
+	m_weak_index.reserve(m_signatures.size());
+
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_signatures.size()); i++)
+	{
+		m_weak_index[m_signatures[i].weak_checksum].push_back(i);
+		m_weak_filter[WeakTag(m_signatures[i].weak_checksum)] = true;
+	}
+
+	m_pending.reserve(m_max_instruction_size);
+}
+
+bool utils::DeltaEncoder::Encode(const fs::path& file_path, const FlushCallback& on_flush, const ProgressCallback& on_progress)
+{
+	std::ifstream file(file_path, std::ios::binary);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open file for delta encoding.");
+	}
+
+	const size_t block_size = m_block_size;
+	std::vector<uint8_t> buffer(std::max<size_t>(DELTA_READ_SIZE, block_size * 2) + block_size);
+
+	size_t valid = 0;		   // Bytes of buffer holding file data
+	size_t pos = 0;			   // Start of the current window
+	size_t literal_start = 0;  // Start of data not yet covered by an instruction
+	uint64_t buffer_base = 0;  // File offset of buffer[0]
+	bool eof = false;
+	bool window_ready = false;
+
+	RollingChecksum checksum;
+
+	while (true)
+	{
+		// Keep at least one byte beyond the window so it can be rolled forward
+		if (valid - pos <= block_size && !eof)
+		{
+			if (literal_start < pos)
+			{
+				if (!EmitLiteral(buffer.data() + literal_start, pos - literal_start, on_flush))
+					return false;
+			}
+
+			std::memmove(buffer.data(), buffer.data() + pos, valid - pos);
+			valid -= pos;
+			buffer_base += pos;
+			pos = 0;
+			literal_start = 0;
+
+			file.read(reinterpret_cast<char*>(buffer.data() + valid), buffer.size() - valid);
+			std::streamsize bytes_read = file.gcount();
+
+			if (file.bad())
+			{
+				throw std::runtime_error("Failed to read file for delta encoding.");
+			}
+
+			valid += static_cast<size_t>(bytes_read);
+			eof = file.eof() || bytes_read == 0;
+
+			if (on_progress)
+			{
+				on_progress(buffer_base);
+			}
+			continue;
+		}
+
+		// The remaining tail is shorter than a block
+		if (valid - pos < block_size)
+			break;
+
+		if (!window_ready)
+		{
+			checksum.Reset(buffer.data() + pos, block_size);
+			window_ready = true;
+		}
+
+		uint32_t block_index = 0;
+		if (FindMatch(buffer.data() + pos, checksum.Digest(), block_index))
+		{
+			if (literal_start < pos)
+			{
+				if (!EmitLiteral(buffer.data() + literal_start, pos - literal_start, on_flush))
+					return false;
+			}
+
+			if (!EmitCopy(block_index, on_flush))
+				return false;
+
+			pos += block_size;
+			literal_start = pos;
+			window_ready = false;
+			continue;
+		}
+
+		if (pos + block_size >= valid)
+			break;
+
+		checksum.Roll(buffer[pos], buffer[pos + block_size]);
+		pos++;
+
+		// Do not let a long unmatched run grow beyond one packet
+		if (pos - literal_start >= m_max_instruction_size)
+		{
+			if (!EmitLiteral(buffer.data() + literal_start, pos - literal_start, on_flush))
+				return false;
+
+			literal_start = pos;
+		}
+	}
+
+	if (literal_start < valid)
+	{
+		if (!EmitLiteral(buffer.data() + literal_start, valid - literal_start, on_flush))
+			return false;
+	}
+
+	if (!FlushPendingCopy(on_flush))
+		return false;
+
+	if (on_progress)
+	{
+		on_progress(buffer_base + valid);
+	}
+
+	// The last chunk is always sent, even when empty, so the server knows the stream has ended
+	bool result = on_flush(m_pending, true);
+	m_pending.clear();
+
+	return result;
+}
+
+bool utils::DeltaEncoder::FindMatch(const uint8_t* window, uint32_t weak, uint32_t& out_block_index) const
+{
+	if (!m_weak_filter[WeakTag(weak)])
+		return false;
+
+	auto it = m_weak_index.find(weak);
+	if (it == m_weak_index.end())
+		return false;
+
+	const std::vector<uint8_t> strong = security::datasecurity::integrity::MD5Handler::calcCheckSum(window, m_block_size);
+
+	// Prefer the block that extends the current COPY run
+	const uint32_t next_block = m_copy_start + m_copy_count;
+	bool found = false;
+
+	for (uint32_t candidate : it->second)
+	{
+		if (memcmp(m_signatures[candidate].strong_hash, strong.data(), 16) != 0)
+			continue;
+
+		if (!found || (m_copy_count > 0 && candidate == next_block))
+		{
+			out_block_index = candidate;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+bool utils::DeltaEncoder::EmitCopy(uint32_t block_index, const FlushCallback& on_flush)
+{
+	m_matched_bytes += m_block_size;
+
+	if (m_copy_count > 0 && block_index == m_copy_start + m_copy_count)
+	{
+		m_copy_count++;
+		return true;
+	}
+
+	if (!FlushPendingCopy(on_flush))
+		return false;
+
+	m_copy_start = block_index;
+	m_copy_count = 1;
+
+	return true;
+}
+
+bool utils::DeltaEncoder::EmitLiteral(const uint8_t* data, size_t length, const FlushCallback& on_flush)
+{
+	if (!FlushPendingCopy(on_flush))
+		return false;
+
+	m_literal_bytes += length;
+
+	while (length > 0)
+	{
+		if (m_pending.size() + LITERAL_HEADER_SIZE >= m_max_instruction_size)
+		{
+			if (!on_flush(m_pending, false))
+				return false;
+
+			m_pending.clear();
+		}
+
+		size_t piece = std::min<size_t>(length, m_max_instruction_size - m_pending.size() - LITERAL_HEADER_SIZE);
+
+		m_pending.push_back(static_cast<uint8_t>(DeltaOp::LITERAL));
+		AppendU32(m_pending, static_cast<uint32_t>(piece));
+		m_pending.insert(m_pending.end(), data, data + piece);
+
+		data += piece;
+		length -= piece;
+	}
+
+	return FlushIfFull(on_flush);
+}
+
+bool utils::DeltaEncoder::FlushPendingCopy(const FlushCallback& on_flush)
+{
+	if (m_copy_count == 0)
+		return true;
+
+	m_pending.push_back(static_cast<uint8_t>(DeltaOp::COPY_BLOCKS));
+	AppendU32(m_pending, m_copy_start);
+	AppendU32(m_pending, m_copy_count);
+
+	m_copy_start = 0;
+	m_copy_count = 0;
+
+	return FlushIfFull(on_flush);
+}
+
+bool utils::DeltaEncoder::FlushIfFull(const FlushCallback& on_flush)
+{
+	// Flush once another COPY instruction would no longer fit
+	if (m_pending.size() + COPY_INSTRUCTION_SIZE <= m_max_instruction_size)
+		return true;
+
+	if (!on_flush(m_pending, false))
+		return false;
+
+	m_pending.clear();
+	return true;
+}
+
+uint32_t utils::ChooseDeltaBlockSize(uint64_t file_size)
+{
+	constexpr uint64_t MIN_BLOCK_SIZE = 4ULL * 1024;		  // 4KB
+	constexpr uint64_t MAX_BLOCK_SIZE = 16ULL * 1024 * 1024; // 16MB
+	constexpr uint64_t MAX_BLOCK_COUNT = 1'000'000;		  // ~20MB of signatures
+
+	uint64_t block_size = static_cast<uint64_t>(std::sqrt(static_cast<double>(file_size)));
+
+	// Round up to a multiple of 1KB
+	block_size = (block_size + 1023) & ~static_cast<uint64_t>(1023);
+
+	block_size = std::max<uint64_t>(block_size, (file_size + MAX_BLOCK_COUNT - 1) / MAX_BLOCK_COUNT);
+	block_size = std::clamp<uint64_t>(block_size, MIN_BLOCK_SIZE, MAX_BLOCK_SIZE);
+
+	return static_cast<uint32_t>(block_size);
+}
+
+std::vector<BlockSignatureDTO> utils::ComputeBlockSignatures(const fs::path& file_path, uint32_t block_size,
+	const std::function<void(uint64_t bytes_processed)>& on_progress)
+{
+	if (block_size == 0)
+	{
+		throw std::invalid_argument("Block size for signatures must not be zero.");
+	}
+
+	std::ifstream file(file_path, std::ios::binary);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open file to compute block signatures.");
+	}
+
+	std::vector<BlockSignatureDTO> signatures;
+	std::vector<uint8_t> block(block_size);
+	uint64_t processed = 0;
+
+	while (file.good())
+	{
+		file.read(reinterpret_cast<char*>(block.data()), block.size());
+		std::streamsize bytes_read = file.gcount();
+
+		if (bytes_read <= 0)
+			break;
+
+		const size_t length = static_cast<size_t>(bytes_read);
+		const std::vector<uint8_t> strong = security::datasecurity::integrity::MD5Handler::calcCheckSum(block.data(), length);
+
+		signatures.emplace_back(RollingChecksum::Compute(block.data(), length), strong.data());
+		processed += length;
+
+		if (on_progress)
+		{
+			on_progress(processed);
+		}
+	}
+
+	if (file.bad())
+	{
+		throw std::runtime_error("Failed to read file to compute block signatures.");
+	}
+
+	return signatures;
+}
+
+utils::DeltaPatcher::DeltaPatcher(const fs::path& basis_path, uint32_t block_size)
+	: m_basis_path(basis_path),
+	m_temp_path(basis_path.string() + ".delta"),
+	m_basis(basis_path, std::ios::binary),
+	m_output(),
+	m_basis_size(0),
+	m_block_size(block_size),
+	m_bytes_written(0),
+	m_reused_bytes(0),
+	m_copy_buffer()
+{
+	if (!m_basis.is_open())
+	{
+		throw std::runtime_error("Failed to open local file to apply delta.");
+	}
+
+	if (m_block_size == 0)
+	{
+		throw std::invalid_argument("Block size for delta patching must not be zero.");
+	}
+
+	m_basis_size = fs::file_size(m_basis_path);
+
+	m_output.open(m_temp_path, std::ios::binary | std::ios::trunc);
+	if (!m_output.is_open())
+	{
+		throw std::runtime_error("Failed to create temporary file to apply delta.");
+	}
+
+	m_copy_buffer.resize(std::min<size_t>(DELTA_READ_SIZE, std::max<size_t>(m_block_size, 64 * 1024)));
+}
+
+utils::DeltaPatcher::~DeltaPatcher()
+{
+	// Bỏ file tạm nếu chưa Commit()
+	std::error_code ec;
+	if (fs::exists(m_temp_path, ec))
+	{
+		Abort();
+	}
+}
+
+void utils::DeltaPatcher::Apply(const std::vector<uint8_t>& instructions)
+{
+	size_t offset = 0;
+
+	while (offset < instructions.size())
+	{
+		DeltaOp op = static_cast<DeltaOp>(instructions[offset++]);
+
+		if (op == DeltaOp::COPY_BLOCKS)
+		{
+			if (instructions.size() - offset < 2 * sizeof(uint32_t))
+				throw std::runtime_error("Truncated COPY_BLOCKS instruction.");
+
+			uint32_t block_index = 0;
+			uint32_t block_count = 0;
+
+			memcpy(&block_index, instructions.data() + offset, sizeof(block_index));
+			offset += sizeof(block_index);
+
+			memcpy(&block_count, instructions.data() + offset, sizeof(block_count));
+			offset += sizeof(block_count);
+
+			uint64_t source = static_cast<uint64_t>(block_index) * m_block_size;
+			if (source >= m_basis_size)
+				throw std::runtime_error("COPY_BLOCKS instruction is out of range of the local file.");
+
+			// The last block of the local file may be short
+			uint64_t remaining = std::min<uint64_t>(static_cast<uint64_t>(block_count) * m_block_size, m_basis_size - source);
+
+			m_basis.clear();
+			m_basis.seekg(static_cast<std::streamoff>(source), std::ios::beg);
+
+			while (remaining > 0)
+			{
+				size_t piece = static_cast<size_t>(std::min<uint64_t>(remaining, m_copy_buffer.size()));
+
+				if (!m_basis.read(reinterpret_cast<char*>(m_copy_buffer.data()), piece))
+					throw std::runtime_error("Failed to read block from the local file.");
+
+				m_output.write(reinterpret_cast<const char*>(m_copy_buffer.data()), piece);
+
+				remaining -= piece;
+				m_bytes_written += piece;
+				m_reused_bytes += piece;
+			}
+		}
+		else if (op == DeltaOp::LITERAL)
+		{
+			if (instructions.size() - offset < sizeof(uint32_t))
+				throw std::runtime_error("Truncated LITERAL instruction.");
+
+			uint32_t length = 0;
+			memcpy(&length, instructions.data() + offset, sizeof(length));
+			offset += sizeof(length);
+
+			if (instructions.size() - offset < length)
+				throw std::runtime_error("Truncated LITERAL data.");
+
+			m_output.write(reinterpret_cast<const char*>(instructions.data() + offset), length);
+
+			offset += length;
+			m_bytes_written += length;
+		}
+		else
+		{
+			throw std::runtime_error("Unknown delta instruction.");
+		}
+
+		if (!m_output.good())
+			throw std::runtime_error("Failed to write patched data.");
+	}
+}
+
+void utils::DeltaPatcher::Close()
+{
+	if (m_output.is_open())
+	{
+		m_output.close();
+	}
+
+	if (m_basis.is_open())
+	{
+		m_basis.close();
+	}
+}
+
+void utils::DeltaPatcher::Commit()
+{
+	Close();
+
+	// Thay thế bản cũ bằng bản đã vá
+	fs::rename(m_temp_path, m_basis_path);
+}
+
+void utils::DeltaPatcher::Abort()
+{
+	Close();
+
+	std::error_code ec;
+	fs::remove(m_temp_path, ec);
+}
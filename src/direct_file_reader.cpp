@@ -0,0 +1,88 @@
+#include <direct_file_reader.h>
+
+#include <stdexcept>
+#include <string>
+
+utils::DirectFileReader::DirectFileReader(const fs::path& path)
+	: m_path(path),
+	m_handle(INVALID_HANDLE_VALUE),
+	m_file_size(0),
+	m_buffer()
+{
+	m_handle = CreateFileW(
+		m_path.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN,
+		nullptr);
+
+	if (m_handle == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Cannot open file to read: " + m_path.string() + " (error " + std::to_string(GetLastError()) + ")");
+	}
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(m_handle, &size))
+	{
+		CloseHandle(m_handle);
+		throw std::runtime_error("Failed to get file size: " + m_path.string());
+	}
+	m_file_size = static_cast<uint64_t>(size.QuadPart);
+}
+
+utils::DirectFileReader::~DirectFileReader()
+{
+	if (m_handle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_handle);
+	}
+}
+
+std::span<const uint8_t> utils::DirectFileReader::Read(uint64_t offset, size_t length)
+{
+	if (offset > m_file_size || length > m_file_size - offset)
+	{
+		throw std::out_of_range("Read beyond end of file: " + m_path.string());
+	}
+
+	if (length == 0)
+	{
+		return {};
+	}
+
+	// Offset, độ dài và địa chỉ buffer đều phải căn theo sector
+	const uint64_t aligned_offset = AlignDown(offset, DIRECT_IO_ALIGNMENT);
+	const size_t head = static_cast<size_t>(offset - aligned_offset);
+	const size_t aligned_length = static_cast<size_t>(AlignUp(head + length, DIRECT_IO_ALIGNMENT));
+
+	if (m_buffer.size() < aligned_length)
+	{
+		m_buffer.Release();
+		m_buffer = AlignedBufferPool::Shared().Acquire(aligned_length);
+	}
+
+	size_t read_total = 0;
+
+	while (read_total < head + length)
+	{
+		const uint64_t position = aligned_offset + read_total;
+
+		OVERLAPPED overlapped{};
+		overlapped.Offset = static_cast<DWORD>(position & 0xFFFFFFFF);
+		overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+		// Vẫn yêu cầu độ dài đã căn chỉnh, ReadFile trả về ít hơn khi chạm EOF
+		DWORD read = 0;
+		DWORD to_read = static_cast<DWORD>(std::min<size_t>(aligned_length - read_total, AlignDown(MAXDWORD, DIRECT_IO_ALIGNMENT)));
+		if (!ReadFile(m_handle, m_buffer.data() + read_total, to_read, &read, &overlapped) || read == 0)
+		{
+			throw std::runtime_error("Failed to read file chunk (error " + std::to_string(GetLastError()) + ")");
+		}
+
+		read_total += read;
+	}
+
+	return { m_buffer.data() + head, length };
+}
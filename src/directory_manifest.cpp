@@ -0,0 +1,371 @@
+#include <directory_manifest.h>
+#include <checkpoint_store.h>
+#include <crc32.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+	constexpr uint32_t MANIFEST_MAGIC = 0x32464D44; // "DMF2"
+	constexpr size_t COMPACT_FACTOR = 2;			// Viết lại khi số bản ghi gấp đôi số file
+
+	// Bản ghi trên đĩa, theo sau là path_length byte đường dẫn tương đối; crc tính trên bản ghi (với crc = 0) và đường dẫn
+#pragma pack(push, 1)
+	struct ManifestRecord
+	{
+		uint32_t crc;
+		uint64_t size;
+		uint64_t last_write_time;
+		uint8_t state;
+		uint16_t path_length;
+	};
+#pragma pack(pop)
+
+	struct ManifestHeader
+	{
+		uint32_t magic;
+		uint32_t reserved;
+	};
+
+	void AppendRecord(std::vector<char>& buffer, const std::string& relative_path, const utils::ManifestEntry& entry)
+	{
+		ManifestRecord record{};
+		record.size = entry.size;
+		record.last_write_time = entry.last_write_time;
+		record.state = static_cast<uint8_t>(entry.state);
+		record.path_length = static_cast<uint16_t>(relative_path.size());
+
+		const size_t start = buffer.size();
+		const char* bytes = reinterpret_cast<const char*>(&record);
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(record));
+		buffer.insert(buffer.end(), relative_path.begin(), relative_path.begin() + record.path_length);
+
+		record.crc = utils::Crc32(reinterpret_cast<const uint8_t*>(buffer.data() + start), buffer.size() - start);
+		memcpy(buffer.data() + start + offsetof(ManifestRecord, crc), &record.crc, sizeof(record.crc));
+	}
+
+	bool WriteAll(HANDLE handle, uint64_t offset, const std::vector<char>& data)
+	{
+		size_t written_total = 0;
+
+		while (written_total < data.size())
+		{
+			const uint64_t position = offset + written_total;
+
+			OVERLAPPED overlapped{};
+			overlapped.Offset = static_cast<DWORD>(position & 0xFFFFFFFF);
+			overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+			DWORD written = 0;
+			const DWORD to_write = static_cast<DWORD>(std::min<size_t>(data.size() - written_total, 64 * 1024 * 1024));
+
+			if (!WriteFile(handle, data.data() + written_total, to_write, &written, &overlapped) || written == 0)
+			{
+				return false;
+			}
+
+			written_total += written;
+		}
+
+		return true;
+	}
+}
+
+utils::DirectoryManifest::DirectoryManifest(const fs::path& path)
+	: m_path(path),
+	m_mutex(),
+	m_entries(),
+	m_resumed_count(0),
+	m_handle(INVALID_HANDLE_VALUE),
+	m_end_offset(0),
+	m_pending(),
+	m_last_flush(std::chrono::steady_clock::now()),
+	m_failed(false)
+{
+	bool clean = true;
+	const size_t record_count = Load(clean);
+	m_resumed_count = m_entries.size();
+
+	// Manifest mới, hỏng hoặc có nhiều bản ghi đã bị thay thế: viết lại chỉ với trạng thái hiện tại
+	if (record_count == 0 || !clean || record_count > m_entries.size() * COMPACT_FACTOR)
+	{
+		if (!Compact())
+		{
+			m_failed = true;
+			return;
+		}
+	}
+
+	if (!Open())
+	{
+		std::cerr << "Failed to open directory manifest: " << m_path.string() << std::endl;
+		m_failed = true;
+	}
+}
+
+utils::DirectoryManifest::~DirectoryManifest()
+{
+	Flush();
+
+	if (m_handle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_handle);
+	}
+}
+
+fs::path utils::DirectoryManifest::PathFor(const fs::path& root)
+{
+	const std::string key = CheckpointStore::NormalizePath(root);
+
+	// Tên thư mục giúp dễ nhận ra file, hash của đường dẫn đầy đủ tránh trùng giữa các thư mục cùng tên
+	std::ostringstream name;
+	name << fs::path(key).filename().string() << '-' << std::hex << std::hash<std::string>{}(key) << ".manifest";
+
+	return fs::path(DEFAULT_MANIFEST_DIR) / name.str();
+}
+
+utils::ManifestFileState utils::DirectoryManifest::Add(const std::string& relative_path, uint64_t size, uint64_t last_write_time)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto [it, inserted] = m_entries.try_emplace(relative_path);
+	ManifestEntry& entry = it->second;
+
+	if (!inserted && entry.size == size && entry.last_write_time == last_write_time)
+	{
+		return entry.state;
+	}
+
+	entry = ManifestEntry{ size, last_write_time, ManifestFileState::PENDING };
+	Append(relative_path, entry);
+
+	return ManifestFileState::PENDING;
+}
+
+void utils::DirectoryManifest::SetState(const std::string& relative_path, ManifestFileState state)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto it = m_entries.find(relative_path);
+	if (it == m_entries.end() || it->second.state == state)
+	{
+		return;
+	}
+
+	it->second.state = state;
+	Append(relative_path, it->second);
+}
+
+size_t utils::DirectoryManifest::GetResumedCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_resumed_count;
+}
+
+size_t utils::DirectoryManifest::Count(ManifestFileState state) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return static_cast<size_t>(std::count_if(m_entries.begin(), m_entries.end(),
+		[state](const auto& entry) { return entry.second.state == state; }));
+}
+
+bool utils::DirectoryManifest::Flush()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return FlushLocked();
+}
+
+void utils::DirectoryManifest::Remove()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_pending.clear();
+
+	if (m_handle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_handle);
+		m_handle = INVALID_HANDLE_VALUE;
+	}
+
+	std::error_code ec;
+	fs::remove(m_path, ec);
+}
+
+size_t utils::DirectoryManifest::Load(bool& out_clean)
+{
+	out_clean = true;
+
+	std::ifstream file(m_path, std::ios::binary);
+	if (!file)
+	{
+		return 0; // Lần upload mới
+	}
+
+	std::vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	ManifestHeader header{};
+	if (buffer.size() < sizeof(header) || (memcpy(&header, buffer.data(), sizeof(header)), header.magic != MANIFEST_MAGIC))
+	{
+		std::cerr << "Ignoring invalid directory manifest: " << m_path.string() << std::endl;
+		out_clean = false;
+		return 0;
+	}
+
+	size_t offset = sizeof(header);
+	size_t record_count = 0;
+
+	while (offset < buffer.size())
+	{
+		ManifestRecord record{};
+		if (buffer.size() - offset < sizeof(record))
+		{
+			out_clean = false;
+			break;
+		}
+
+		memcpy(&record, buffer.data() + offset, sizeof(record));
+
+		if (buffer.size() - offset - sizeof(record) < record.path_length || record.state > static_cast<uint8_t>(ManifestFileState::DONE))
+		{
+			out_clean = false;
+			break;
+		}
+
+		// Bản ghi ghi dở vẫn có thể đọc ra được: chỉ tin bản ghi có CRC đúng
+		std::vector<uint8_t> copy(buffer.begin() + offset, buffer.begin() + offset + sizeof(record) + record.path_length);
+		memset(copy.data() + offsetof(ManifestRecord, crc), 0, sizeof(record.crc));
+
+		if (Crc32(copy.data(), copy.size()) != record.crc)
+		{
+			out_clean = false;
+			break;
+		}
+
+		offset += sizeof(record);
+
+		std::string relative_path(buffer.data() + offset, record.path_length);
+		offset += record.path_length;
+
+		m_entries[std::move(relative_path)] = ManifestEntry{ record.size, record.last_write_time, static_cast<ManifestFileState>(record.state) };
+		record_count++;
+	}
+
+	if (!out_clean)
+	{
+		// Bản ghi cuối bị ghi dở khi crash: giữ phần trước nó
+		std::cerr << "Directory manifest is truncated: " << m_path.string() << std::endl;
+	}
+
+	return record_count;
+}
+
+bool utils::DirectoryManifest::Compact()
+{
+	std::vector<char> buffer(sizeof(ManifestHeader));
+
+	ManifestHeader header{ MANIFEST_MAGIC, 0 };
+	memcpy(buffer.data(), &header, sizeof(header));
+
+	for (const auto& [relative_path, entry] : m_entries)
+	{
+		AppendRecord(buffer, relative_path, entry);
+	}
+
+	std::error_code ec;
+	fs::create_directories(m_path.parent_path(), ec);
+
+	fs::path temp_path = m_path;
+	temp_path += ".tmp";
+
+	HANDLE temp = CreateFileW(temp_path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (temp == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "Failed to create directory manifest: " << temp_path.string() << std::endl;
+		return false;
+	}
+
+	// Bản mới phải nằm trên đĩa trước khi thay thế bản cũ
+	const bool written = WriteAll(temp, 0, buffer) && FlushFileBuffers(temp);
+	CloseHandle(temp);
+
+	if (!written)
+	{
+		std::cerr << "Failed to write directory manifest: " << temp_path.string() << std::endl;
+		fs::remove(temp_path, ec);
+		return false;
+	}
+
+	fs::rename(temp_path, m_path, ec);
+	if (ec)
+	{
+		std::cerr << "Failed to replace directory manifest: " << m_path.string() << " (" << ec.message() << ")" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool utils::DirectoryManifest::Open()
+{
+	m_handle = CreateFileW(m_path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(m_handle, &size))
+	{
+		return false;
+	}
+
+	m_end_offset = static_cast<uint64_t>(size.QuadPart);
+	return true;
+}
+
+void utils::DirectoryManifest::Append(const std::string& relative_path, const ManifestEntry& entry)
+{
+	AppendRecord(m_pending, relative_path, entry);
+
+	if (m_pending.size() >= FLUSH_BYTES || std::chrono::steady_clock::now() - m_last_flush >= FLUSH_INTERVAL)
+	{
+		FlushLocked();
+	}
+}
+
+bool utils::DirectoryManifest::FlushLocked()
+{
+	m_last_flush = std::chrono::steady_clock::now();
+
+	if (m_pending.empty())
+	{
+		return !m_failed;
+	}
+
+	// Không ghi được thì manifest chỉ còn tác dụng trong lần chạy này
+	if (m_failed || m_handle == INVALID_HANDLE_VALUE)
+	{
+		m_pending.clear();
+		return false;
+	}
+
+	// Ghi xong mới flush xuống đĩa như TransferJournal, để bản ghi sống sót khi mất điện
+	if (!WriteAll(m_handle, m_end_offset, m_pending) || !FlushFileBuffers(m_handle))
+	{
+		std::cerr << "Failed to write directory manifest: " << m_path.string() << std::endl;
+		m_failed = true;
+	}
+	else
+	{
+		m_end_offset += m_pending.size();
+	}
+
+	m_pending.clear();
+	return !m_failed;
+}
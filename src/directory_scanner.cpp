@@ -0,0 +1,328 @@
+#include <directory_scanner.h>
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cwchar>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+	// Đóng find handle cả khi sink hoặc bộ lọc throw giữa chừng
+	class ScopedFindHandle
+	{
+	private:
+		HANDLE m_handle;
+
+	public:
+		explicit ScopedFindHandle(HANDLE handle) : m_handle(handle) {}
+		~ScopedFindHandle()
+		{
+			if (m_handle != INVALID_HANDLE_VALUE)
+			{
+				FindClose(m_handle);
+			}
+		}
+
+		ScopedFindHandle(const ScopedFindHandle&) = delete;
+		ScopedFindHandle& operator=(const ScopedFindHandle&) = delete;
+
+		HANDLE Get() const { return m_handle; }
+	};
+}
+
+utils::DirectoryScanner::DirectoryScanner(size_t thread_count)
+	: m_thread_count(thread_count),
+	m_filter(nullptr),
+	m_queues(),
+	m_pending(0),
+	m_queued(0),
+	m_idle(0),
+	m_visited(0),
+	m_failed(false),
+	m_error()
+{
+	if (m_thread_count == 0)
+	{
+		m_thread_count = static_cast<size_t>(std::thread::hardware_concurrency()) * 2;
+	}
+
+	m_thread_count = std::clamp<size_t>(m_thread_count, 4, MAX_THREADS);
+
+	for (size_t i = 0; i < m_thread_count; i++)
+	{
+		m_queues.push_back(std::make_unique<WorkerQueue>());
+	}
+}
+
+void utils::DirectoryScanner::Scan(const fs::path& root, const FileSink& sink, const ProgressCallback& progress,
+	const DirectorySink& on_directory)
+{
+	for (auto& queue : m_queues)
+	{
+		queue->tasks.clear();
+	}
+
+	m_pending = 1;
+	m_queued = 0;
+	m_visited = 0;
+	m_failed = false;
+	m_error.clear();
+
+	PushTask(0, DirectoryTask{ root, 0, m_filter ? m_filter->Root() : PathFilter::Context{} });
+
+	std::vector<std::thread> workers;
+	workers.reserve(m_thread_count);
+
+	for (size_t i = 0; i < m_thread_count; i++)
+	{
+		workers.emplace_back(&DirectoryScanner::WorkerLoop, this, i, std::cref(sink), std::cref(on_directory));
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(m_done_mutex);
+
+		while (!m_done_cv.wait_for(lock, std::chrono::milliseconds(100), [this]() { return m_pending == 0 || m_failed; }))
+		{
+			if (progress)
+			{
+				lock.unlock();
+				progress(m_visited.load());
+				lock.lock();
+			}
+		}
+	}
+
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+
+	if (m_failed)
+	{
+		throw std::runtime_error(m_error);
+	}
+
+	if (progress)
+	{
+		progress(m_visited.load());
+	}
+}
+
+void utils::DirectoryScanner::WorkerLoop(size_t worker, const FileSink& sink, const DirectorySink& on_directory)
+{
+	while (true)
+	{
+		DirectoryTask task;
+
+		if (PopTask(worker, task))
+		{
+			// Sau khi có lỗi chỉ rút hết hàng đợi, không liệt kê thêm
+			if (!m_failed)
+			{
+				try
+				{
+					ListDirectory(worker, task, sink, on_directory);
+				}
+				catch (const std::exception& e)
+				{
+					Fail(e.what());
+				}
+			}
+
+			// Thư mục con đã được đếm vào m_pending trước khi thư mục cha hoàn thành
+			if (m_pending.fetch_sub(1) == 1)
+			{
+				NotifyDone();
+				WakeIdleWorkers(true);
+			}
+			continue;
+		}
+
+		// Các worker khác vẫn đang liệt kê và có thể sinh thêm thư mục: ngủ cho tới khi có thư mục mới hoặc đã quét xong
+		// (worker đang liệt kê có thể bị chặn lâu trong sink, ví dụ khi hàng đợi của ScanStream đầy)
+		std::unique_lock<std::mutex> lock(m_idle_mutex);
+		m_idle++;
+		m_idle_cv.wait(lock, [this]() { return m_queued > 0 || m_pending == 0; });
+		m_idle--;
+
+		if (m_pending == 0)
+		{
+			break;
+		}
+	}
+}
+
+bool utils::DirectoryScanner::PopTask(size_t worker, DirectoryTask& task)
+{
+	// Lấy từ cuối hàng đợi của mình (thư mục vừa gặp, theo chiều sâu)
+	{
+		WorkerQueue& own = *m_queues[worker];
+		std::lock_guard<std::mutex> lock(own.mutex);
+
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			m_queued--;
+			return true;
+		}
+	}
+
+	// Lấy trộm từ đầu hàng đợi của worker khác (thư mục gần gốc, thường chứa nhiều việc nhất)
+	for (size_t i = 1; i < m_thread_count; i++)
+	{
+		WorkerQueue& victim = *m_queues[(worker + i) % m_thread_count];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			m_queued--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void utils::DirectoryScanner::PushTask(size_t worker, DirectoryTask&& task)
+{
+	{
+		WorkerQueue& own = *m_queues[worker];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		own.tasks.push_back(std::move(task));
+		m_queued++;
+	}
+
+	// m_queued tăng trước khi đọc m_idle: worker sắp ngủ hoặc thấy thư mục mới, hoặc được đánh thức
+	if (m_idle > 0)
+	{
+		WakeIdleWorkers(false);
+	}
+}
+
+void utils::DirectoryScanner::ListDirectory(size_t worker, const DirectoryTask& task, const FileSink& sink, const DirectorySink& on_directory)
+{
+	const std::wstring pattern = (task.path / L"*").wstring();
+
+	// FindExInfoBasic bỏ qua tên 8.3, LARGE_FETCH lấy nhiều entry hơn trong mỗi lần gọi xuống file system
+	WIN32_FIND_DATAW data;
+	const ScopedFindHandle find(FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &data, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH));
+
+	if (find.Get() == INVALID_HANDLE_VALUE)
+	{
+		const DWORD error = GetLastError();
+
+		// Bỏ qua thư mục không có quyền đọc hoặc đã bị xoá trong lúc quét
+		if (error != ERROR_ACCESS_DENIED && error != ERROR_FILE_NOT_FOUND && error != ERROR_PATH_NOT_FOUND)
+		{
+			Fail("Error scanning directory " + task.path.string() + " (error " + std::to_string(error) + ")");
+		}
+		return;
+	}
+
+	do
+	{
+		const wchar_t* name = data.cFileName;
+		if (wcscmp(name, L".") == 0 || wcscmp(name, L"..") == 0)
+		{
+			continue;
+		}
+
+		const bool is_directory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+		const bool is_reparse_point = (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+
+		// Cắt cả cây con bị loại ngay tại đây, trước khi thư mục được đưa vào hàng đợi
+		PathFilter::Context child_filter;
+		if (m_filter && m_filter->IsExcluded(task.filter, name, is_directory, &child_filter))
+		{
+			continue;
+		}
+
+		m_visited++;
+
+		if (is_directory)
+		{
+			if (!is_reparse_point)
+			{
+				const uint32_t directory = on_directory ? on_directory(task.directory, name) : 0;
+
+				m_pending++;
+				PushTask(worker, DirectoryTask{ task.path / name, directory, std::move(child_filter) });
+			}
+			continue;
+		}
+
+		uint64_t size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+
+		// Symlink tới file: kích thước trong kết quả liệt kê là của link, cần stat file đích
+		if (is_reparse_point)
+		{
+			const fs::path path = task.path / name;
+			std::error_code ec;
+			if (!fs::is_regular_file(path, ec))
+			{
+				continue;
+			}
+
+			size = fs::file_size(path, ec);
+			if (ec)
+			{
+				continue;
+			}
+		}
+
+		const uint64_t last_write_time = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+
+		sink(worker, ScannedFile{ task.directory, name, size, last_write_time });
+	} while (FindNextFileW(find.Get(), &data));
+
+	const DWORD error = GetLastError();
+
+	if (error != ERROR_NO_MORE_FILES)
+	{
+		Fail("Error scanning directory " + task.path.string() + " (error " + std::to_string(error) + ")");
+	}
+}
+
+void utils::DirectoryScanner::Fail(const std::string& message)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_error_mutex);
+		if (m_error.empty())
+		{
+			m_error = message;
+		}
+	}
+
+	m_failed = true;
+	NotifyDone();
+}
+
+void utils::DirectoryScanner::NotifyDone()
+{
+	// Khoá để thread đang chờ không bỏ lỡ thông báo giữa lúc kiểm tra điều kiện và lúc ngủ
+	std::lock_guard<std::mutex> lock(m_done_mutex);
+	m_done_cv.notify_all();
+}
+
+void utils::DirectoryScanner::WakeIdleWorkers(bool all)
+{
+	// Khoá như NotifyDone() để worker không ngủ sau khi đã kiểm tra điều kiện mà bỏ lỡ thông báo
+	{
+		std::lock_guard<std::mutex> lock(m_idle_mutex);
+	}
+
+	if (all)
+	{
+		m_idle_cv.notify_all();
+	}
+	else
+	{
+		m_idle_cv.notify_one();
+	}
+}
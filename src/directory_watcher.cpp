@@ -0,0 +1,249 @@
+#include <directory_watcher.h>
+
+#include <stdexcept>
+
+utils::DirectoryWatcher::DirectoryWatcher(const fs::path& root, std::chrono::steady_clock::duration debounce)
+	: m_root(root),
+	m_debounce(debounce),
+	m_directory(INVALID_HANDLE_VALUE),
+	m_stop_event(nullptr),
+	m_thread(),
+	m_mutex(),
+	m_cv(),
+	m_pending(),
+	m_overflowed(false),
+	m_stopped(false),
+	m_error()
+{
+}
+
+utils::DirectoryWatcher::~DirectoryWatcher()
+{
+	Stop();
+
+	if (m_directory != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_directory);
+	}
+
+	if (m_stop_event)
+	{
+		CloseHandle(m_stop_event);
+	}
+}
+
+void utils::DirectoryWatcher::Start()
+{
+	m_directory = CreateFileW(m_root.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+
+	if (m_directory == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Failed to open directory for watching: " + m_root.string() + " (error " + std::to_string(GetLastError()) + ")");
+	}
+
+	m_stop_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	if (!m_stop_event)
+	{
+		throw std::runtime_error("Failed to create stop event for directory watcher.");
+	}
+
+	m_thread = std::thread(&DirectoryWatcher::WatchLoop, this);
+}
+
+void utils::DirectoryWatcher::Stop()
+{
+	if (m_stop_event)
+	{
+		SetEvent(m_stop_event);
+	}
+
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopped = true;
+	}
+
+	m_cv.notify_all();
+}
+
+bool utils::DirectoryWatcher::WaitForChanges(std::vector<fs::path>& out_paths, bool& out_overflowed)
+{
+	out_paths.clear();
+	out_overflowed = false;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		if (m_stopped)
+		{
+			return false;
+		}
+
+		if (m_overflowed)
+		{
+			// Quét lại toàn bộ sẽ thấy mọi thay đổi đang chờ
+			m_overflowed = false;
+			m_pending.clear();
+			out_overflowed = true;
+			return true;
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		auto next_deadline = std::chrono::steady_clock::time_point::max();
+
+		for (auto it = m_pending.begin(); it != m_pending.end();)
+		{
+			const auto deadline = (std::min)(it->second.last_event + m_debounce, it->second.first_event + m_debounce * MAX_DELAY_FACTOR);
+
+			if (deadline <= now)
+			{
+				out_paths.emplace_back(it->first);
+				it = m_pending.erase(it);
+				continue;
+			}
+
+			next_deadline = (std::min)(next_deadline, deadline);
+			++it;
+		}
+
+		if (!out_paths.empty())
+		{
+			return true;
+		}
+
+		if (m_pending.empty())
+		{
+			m_cv.wait(lock);
+		}
+		else
+		{
+			m_cv.wait_until(lock, next_deadline);
+		}
+	}
+}
+
+std::string utils::DirectoryWatcher::GetError()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_error;
+}
+
+void utils::DirectoryWatcher::WatchLoop()
+{
+	// FILE_NOTIFY_INFORMATION phải căn theo DWORD
+	std::vector<DWORD> buffer(BUFFER_SIZE / sizeof(DWORD));
+
+	OVERLAPPED overlapped{};
+	overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	if (!overlapped.hEvent)
+	{
+		Fail("Failed to create event for directory watcher.");
+		return;
+	}
+
+	const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+
+	while (true)
+	{
+		ResetEvent(overlapped.hEvent);
+
+		if (!ReadDirectoryChangesW(m_directory, buffer.data(), BUFFER_SIZE, TRUE, filter, nullptr, &overlapped, nullptr))
+		{
+			Fail("Failed to watch directory " + m_root.string() + " (error " + std::to_string(GetLastError()) + ")");
+			break;
+		}
+
+		HANDLE handles[2] = { m_stop_event, overlapped.hEvent };
+		const DWORD signaled = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+
+		DWORD bytes = 0;
+
+		if (signaled != WAIT_OBJECT_0 + 1)
+		{
+			// Stop(): huỷ lệnh đọc đang chờ và đợi nó kết thúc trước khi giải phóng buffer
+			CancelIoEx(m_directory, &overlapped);
+			GetOverlappedResult(m_directory, &overlapped, &bytes, TRUE);
+			break;
+		}
+
+		if (!GetOverlappedResult(m_directory, &overlapped, &bytes, FALSE))
+		{
+			const DWORD error = GetLastError();
+			if (error == ERROR_NOTIFY_ENUM_DIR)
+			{
+				Overflow();
+				continue;
+			}
+
+			Fail("Failed to read directory changes of " + m_root.string() + " (error " + std::to_string(error) + ")");
+			break;
+		}
+
+		// 0 byte: hệ thống đã bỏ các sự kiện vì buffer đầy
+		if (bytes == 0)
+		{
+			Overflow();
+			continue;
+		}
+
+		const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer.data());
+
+		while (true)
+		{
+			const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(data);
+			Record(info);
+
+			if (info->NextEntryOffset == 0)
+			{
+				break;
+			}
+			data += info->NextEntryOffset;
+		}
+
+		m_cv.notify_all();
+	}
+
+	CloseHandle(overlapped.hEvent);
+}
+
+void utils::DirectoryWatcher::Record(const FILE_NOTIFY_INFORMATION* info)
+{
+	// Mọi loại sự kiện (kể cả xoá, đổi tên) đều chỉ đánh dấu đường dẫn, người gọi kiểm tra trạng thái hiện tại của nó
+	std::wstring path(info->FileName, info->FileNameLength / sizeof(wchar_t));
+	const auto now = std::chrono::steady_clock::now();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto [it, inserted] = m_pending.try_emplace(std::move(path), PendingChange{ now, now });
+	if (!inserted)
+	{
+		it->second.last_event = now;
+	}
+}
+
+void utils::DirectoryWatcher::Overflow()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_overflowed = true;
+	}
+
+	m_cv.notify_all();
+}
+
+void utils::DirectoryWatcher::Fail(const std::string& message)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_error = message;
+		m_stopped = true;
+	}
+
+	m_cv.notify_all();
+}
@@ -0,0 +1,337 @@
+#include <download_file_writer.h>
+#include <aligned_buffer_pool.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+utils::DownloadFileWriter::DownloadFileWriter(const fs::path& path, uint64_t file_size, uint32_t chunk_size,
+	const FlushPolicy& policy, bool truncate, bool direct_io, bool sparse)
+	: m_path(path),
+	m_handle(INVALID_HANDLE_VALUE),
+	m_file_size(file_size),
+	m_chunk_size(chunk_size),
+	m_direct_io(direct_io),
+	m_sparse(sparse),
+	m_truncated(truncate),
+	m_policy(policy),
+	m_cache_policy(),
+	m_on_flush(),
+	m_flush_mutex(),
+	m_unflushed_bytes(0),
+	m_last_flush(std::chrono::steady_clock::now())
+{
+	if (m_direct_io && m_chunk_size % DIRECT_IO_ALIGNMENT != 0)
+	{
+		std::cerr << "Chunk size " << m_chunk_size << " is not sector aligned, using buffered I/O for " << m_path.string() << std::endl;
+		m_direct_io = false;
+	}
+
+	m_handle = CreateFileW(
+		m_path.c_str(),
+		GENERIC_READ | GENERIC_WRITE,
+		FILE_SHARE_READ,
+		nullptr,
+		truncate ? CREATE_ALWAYS : OPEN_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL | (m_direct_io ? FILE_FLAG_NO_BUFFERING : 0),
+		nullptr);
+
+	if (m_handle == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Cannot open file to write: " + m_path.string() + " (error " + std::to_string(GetLastError()) + ")");
+	}
+
+	if (m_sparse)
+	{
+		MakeSparse();
+	}
+
+	Preallocate();
+}
+
+utils::DownloadFileWriter::~DownloadFileWriter()
+{
+	try
+	{
+		Close();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Failed to close " << m_path.string() << ": " << e.what() << std::endl;
+	}
+}
+
+void utils::DownloadFileWriter::MakeSparse()
+{
+	DWORD returned = 0;
+
+	if (!DeviceIoControl(m_handle, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &returned, nullptr))
+	{
+		std::cerr << "File system does not support sparse files, holes of " << m_path.string() << " will be written as zeros (error " << GetLastError() << ")" << std::endl;
+		m_sparse = false;
+	}
+}
+
+void utils::DownloadFileWriter::Preallocate()
+{
+	// File sparse chỉ cấp phát các vùng có dữ liệu khi được ghi
+	if (m_sparse)
+	{
+		SetEndOfFile(m_file_size);
+		return;
+	}
+
+	// Cấp phát một lần cho cả file để tránh phân mảnh, sau đó đặt EOF đúng bằng file_size
+	FILE_ALLOCATION_INFO allocation_info{};
+	allocation_info.AllocationSize.QuadPart = static_cast<LONGLONG>(m_file_size);
+
+	if (!SetFileInformationByHandle(m_handle, FileAllocationInfo, &allocation_info, sizeof(allocation_info)))
+	{
+		// Không phải file system nào cũng hỗ trợ, vẫn có thể ghi bình thường
+		std::cerr << "Failed to preallocate " << m_path.string() << " (error " << GetLastError() << ")" << std::endl;
+	}
+
+	SetEndOfFile(m_file_size);
+}
+
+void utils::DownloadFileWriter::SetEndOfFile(uint64_t size)
+{
+	FILE_END_OF_FILE_INFO eof_info{};
+	eof_info.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+
+	if (!SetFileInformationByHandle(m_handle, FileEndOfFileInfo, &eof_info, sizeof(eof_info)))
+	{
+		throw std::runtime_error("Failed to set file size (error " + std::to_string(GetLastError()) + ")");
+	}
+}
+
+void utils::DownloadFileWriter::WriteChunk(uint32_t chunk_index, const uint8_t* data, size_t size)
+{
+	WriteAt(static_cast<uint64_t>(chunk_index) * m_chunk_size, data, size);
+}
+
+void utils::DownloadFileWriter::WriteAt(uint64_t offset, const uint8_t* data, size_t size)
+{
+	if (!IsOpen())
+	{
+		throw std::runtime_error("File is not open.");
+	}
+
+	if (offset > m_file_size || size > m_file_size - offset)
+	{
+		throw std::out_of_range("Write beyond the end of the file.");
+	}
+
+	if (m_direct_io)
+	{
+		WriteDirect(offset, data, size);
+	}
+	else
+	{
+		// Trang cache bẩn của file tải về không đẩy dữ liệu của các dịch vụ khác ra khỏi standby list
+		ScopedMemoryPriority priority(m_cache_policy.low_memory_priority);
+		WriteRaw(offset, data, size);
+	}
+
+	MaybeFlush(size);
+}
+
+void utils::DownloadFileWriter::PunchHole(uint64_t offset, uint64_t length)
+{
+	if (!IsOpen())
+	{
+		throw std::runtime_error("File is not open.");
+	}
+
+	if (offset > m_file_size || length > m_file_size - offset)
+	{
+		throw std::out_of_range("Hole beyond the end of the file.");
+	}
+
+	if (length == 0)
+	{
+		return;
+	}
+
+	if (m_sparse)
+	{
+		FILE_ZERO_DATA_INFORMATION zero_data{};
+		zero_data.FileOffset.QuadPart = static_cast<LONGLONG>(offset);
+		zero_data.BeyondFinalZero.QuadPart = static_cast<LONGLONG>(offset + length);
+
+		DWORD returned = 0;
+		if (!DeviceIoControl(m_handle, FSCTL_SET_ZERO_DATA, &zero_data, sizeof(zero_data), nullptr, 0, &returned, nullptr))
+		{
+			throw std::runtime_error("Failed to deallocate file range (error " + std::to_string(GetLastError()) + ")");
+		}
+		return;
+	}
+
+	// File vừa tạo đã đọc ra số 0 sau EOF, chỉ file giữ nội dung cũ mới cần ghi đè
+	if (m_truncated)
+	{
+		return;
+	}
+
+	constexpr size_t ZERO_BLOCK_SIZE = 1024 * 1024;
+	AlignedBufferPool::Buffer zeros = AlignedBufferPool::Shared().Acquire(ZERO_BLOCK_SIZE);
+	memset(zeros.data(), 0, ZERO_BLOCK_SIZE);
+
+	for (uint64_t written = 0; written < length; written += ZERO_BLOCK_SIZE)
+	{
+		WriteAt(offset + written, zeros.data(), static_cast<size_t>(std::min<uint64_t>(ZERO_BLOCK_SIZE, length - written)));
+	}
+}
+
+void utils::DownloadFileWriter::WriteRaw(uint64_t offset, const uint8_t* data, size_t size)
+{
+	size_t written_total = 0;
+
+	while (written_total < size)
+	{
+		const uint64_t position = offset + written_total;
+		const DWORD to_write = static_cast<DWORD>(std::min<size_t>(size - written_total, AlignDown(MAXDWORD, DIRECT_IO_ALIGNMENT)));
+
+		// Ghi theo vị trí qua OVERLAPPED, không dùng chung con trỏ file nên an toàn giữa các luồng
+		OVERLAPPED overlapped{};
+		overlapped.Offset = static_cast<DWORD>(position & 0xFFFFFFFF);
+		overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+		DWORD written = 0;
+		if (!WriteFile(m_handle, data + written_total, to_write, &written, &overlapped) || written == 0)
+		{
+			throw std::runtime_error("Failed to write file chunk (error " + std::to_string(GetLastError()) + ")");
+		}
+
+		written_total += written;
+	}
+}
+
+void utils::DownloadFileWriter::WriteDirect(uint64_t offset, const uint8_t* data, size_t size)
+{
+	// Mở rộng vùng ghi ra biên sector và chép dữ liệu vào buffer căn chỉnh
+	const uint64_t aligned_offset = AlignDown(offset, DIRECT_IO_ALIGNMENT);
+	const size_t head = static_cast<size_t>(offset - aligned_offset);
+	const size_t aligned_length = static_cast<size_t>(AlignUp(head + size, DIRECT_IO_ALIGNMENT));
+
+	AlignedBufferPool::Buffer buffer = AlignedBufferPool::Shared().Acquire(aligned_length);
+
+	// Sector đầu/cuối chỉ bị ghi một phần: giữ lại nội dung hiện có (phần sau EOF được đọc là 0)
+	if (head > 0)
+	{
+		ReadBlock(aligned_offset, buffer.data());
+	}
+
+	if ((head + size) % DIRECT_IO_ALIGNMENT != 0 && (head == 0 || aligned_length > DIRECT_IO_ALIGNMENT))
+	{
+		ReadBlock(aligned_offset + aligned_length - DIRECT_IO_ALIGNMENT, buffer.data() + aligned_length - DIRECT_IO_ALIGNMENT);
+	}
+
+	memcpy(buffer.data() + head, data, size);
+
+	WriteRaw(aligned_offset, buffer.data(), aligned_length);
+
+	// Chunk cuối được ghi đệm tới biên sector, đặt lại EOF đúng file_size
+	if (aligned_offset + aligned_length > m_file_size)
+	{
+		SetEndOfFile(m_file_size);
+	}
+}
+
+void utils::DownloadFileWriter::ReadBlock(uint64_t offset, uint8_t* buffer)
+{
+	memset(buffer, 0, DIRECT_IO_ALIGNMENT);
+
+	OVERLAPPED overlapped{};
+	overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+	overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+	DWORD read = 0;
+	if (!ReadFile(m_handle, buffer, static_cast<DWORD>(DIRECT_IO_ALIGNMENT), &read, &overlapped) && GetLastError() != ERROR_HANDLE_EOF)
+	{
+		throw std::runtime_error("Failed to read existing block (error " + std::to_string(GetLastError()) + ")");
+	}
+}
+
+void utils::DownloadFileWriter::MaybeFlush(size_t bytes_written)
+{
+	bool flush_needed = false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_flush_mutex);
+		m_unflushed_bytes += bytes_written;
+
+		auto now = std::chrono::steady_clock::now();
+
+		if ((m_policy.max_unflushed_bytes > 0 && m_unflushed_bytes >= m_policy.max_unflushed_bytes) ||
+			(m_policy.max_interval.count() > 0 && now - m_last_flush >= m_policy.max_interval))
+		{
+			m_unflushed_bytes = 0;
+			m_last_flush = now;
+			flush_needed = true;
+		}
+	}
+
+	if (flush_needed)
+	{
+		if (!FlushFileBuffers(m_handle))
+		{
+			throw std::runtime_error("Failed to flush file (error " + std::to_string(GetLastError()) + ")");
+		}
+
+		if (m_on_flush)
+		{
+			m_on_flush();
+		}
+	}
+}
+
+void utils::DownloadFileWriter::Flush()
+{
+	if (!IsOpen())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_flush_mutex);
+		m_unflushed_bytes = 0;
+		m_last_flush = std::chrono::steady_clock::now();
+	}
+
+	if (!FlushFileBuffers(m_handle))
+	{
+		throw std::runtime_error("Failed to flush file (error " + std::to_string(GetLastError()) + ")");
+	}
+
+	if (m_on_flush)
+	{
+		m_on_flush();
+	}
+}
+
+void utils::DownloadFileWriter::Close()
+{
+	if (!IsOpen())
+	{
+		return;
+	}
+
+	HANDLE handle = m_handle;
+
+	try
+	{
+		Flush();
+	}
+	catch (...)
+	{
+		m_handle = INVALID_HANDLE_VALUE;
+		CloseHandle(handle);
+		throw;
+	}
+
+	m_handle = INVALID_HANDLE_VALUE;
+	CloseHandle(handle);
+}
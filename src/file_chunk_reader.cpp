@@ -0,0 +1,59 @@
+#include <file_chunk_reader.h>
+#include <mapped_file_reader.h>
+#include <direct_file_reader.h>
+#include <sparse_file.h>
+#include <encryption_handler.hpp>
+
+#include <algorithm>
+
+std::vector<uint8_t> utils::FileChunkReader::CalcCheckSum(const std::function<void(size_t)>& progress_callback,
+	const AllocatedRanges* allocated)
+{
+	const uint64_t file_size = GetFileSize();
+	const size_t block_size = GetHashBlockSize();
+	uint64_t offset = 0;
+
+	// Chỉ cấp phát khi file thực sự có hole
+	std::vector<uint8_t> zeros;
+
+	return security::datasecurity::integrity::MD5Handler::calcCheckSumBlocks(
+		[this, file_size, block_size, allocated, &zeros, &offset, &progress_callback](const uint8_t*& data, size_t& size)
+		{
+			if (offset >= file_size)
+			{
+				return false;
+			}
+
+			size = static_cast<size_t>(std::min<uint64_t>(block_size, file_size - offset));
+
+			if (allocated && !allocated->Overlaps(offset, size))
+			{
+				zeros.resize(block_size);
+				data = zeros.data();
+			}
+			else
+			{
+				std::span<const uint8_t> block = Read(offset, size);
+				data = block.data();
+			}
+			offset += size;
+
+			if (progress_callback)
+			{
+				progress_callback(static_cast<size_t>(offset));
+			}
+
+			return true;
+		});
+}
+
+std::unique_ptr<utils::FileChunkReader> utils::FileChunkReader::Open(const fs::path& path, bool direct_io,
+	const CachePolicy& cache_policy)
+{
+	if (direct_io)
+	{
+		return std::make_unique<DirectFileReader>(path);
+	}
+
+	return std::make_unique<MappedFileReader>(path, DEFAULT_MAP_WINDOW, cache_policy);
+}
@@ -0,0 +1,155 @@
+#include <file_table.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+utils::FileTable::FileTable(const fs::path& root)
+	: m_base(root.parent_path()),
+	m_names(),
+	m_directories(),
+	m_file_directory(),
+	m_file_name_offset(),
+	m_file_name_length(),
+	m_file_size(),
+	m_file_write_time()
+{
+	// Giống fs::relative(entry, root.parent_path()): node gốc mang tên của chính thư mục gốc
+	const std::wstring root_name = fs::relative(root, m_base).wstring();
+	m_directories.push_back({ NO_PARENT, AppendName(root_name), static_cast<uint32_t>(root_name.length()) });
+}
+
+uint32_t utils::FileTable::AddDirectory(uint32_t parent, std::wstring_view name)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (parent >= m_directories.size())
+	{
+		throw std::out_of_range("Invalid parent directory.");
+	}
+
+	const uint32_t offset = AppendName(name);
+	m_directories.push_back({ parent, offset, static_cast<uint32_t>(name.length()) });
+
+	return static_cast<uint32_t>(m_directories.size() - 1);
+}
+
+uint32_t utils::FileTable::AddFile(uint32_t directory, std::wstring_view name, uint64_t size, uint64_t last_write_time)
+{
+	// Tên file trên NTFS tối đa 255 ký tự
+	if (name.length() > (std::numeric_limits<uint16_t>::max)())
+	{
+		throw std::length_error("File name is too long.");
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (directory >= m_directories.size())
+	{
+		throw std::out_of_range("Invalid directory.");
+	}
+
+	if (m_file_size.size() >= (std::numeric_limits<uint32_t>::max)())
+	{
+		throw std::length_error("Too many files in the file table.");
+	}
+
+	m_file_directory.push_back(directory);
+	m_file_name_offset.push_back(AppendName(name));
+	m_file_name_length.push_back(static_cast<uint16_t>(name.length()));
+	m_file_size.push_back(size);
+	m_file_write_time.push_back(last_write_time);
+
+	return static_cast<uint32_t>(m_file_size.size() - 1);
+}
+
+size_t utils::FileTable::GetFileCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_file_size.size();
+}
+
+uint64_t utils::FileTable::GetFileSize(uint32_t file) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_file_size.at(file);
+}
+
+uint64_t utils::FileTable::GetLastWriteTime(uint32_t file) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_file_write_time.at(file);
+}
+
+fs::path utils::FileTable::GetAbsolutePath(uint32_t file) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return BuildPath(m_base, m_file_directory.at(file), file);
+}
+
+std::string utils::FileTable::GetRelativePath(uint32_t file) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return BuildPath(fs::path(), m_file_directory.at(file), file).string();
+}
+
+std::vector<uint32_t> utils::FileTable::SortBySizeDescending() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::vector<uint32_t> order(m_file_size.size());
+	std::iota(order.begin(), order.end(), 0);
+
+	std::stable_sort(order.begin(), order.end(),
+		[this](uint32_t a, uint32_t b) { return m_file_size[a] > m_file_size[b]; });
+
+	return order;
+}
+
+size_t utils::FileTable::GetMemoryUsage() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_names.capacity() * sizeof(wchar_t) +
+		m_directories.capacity() * sizeof(DirectoryNode) +
+		m_file_directory.capacity() * sizeof(uint32_t) +
+		m_file_name_offset.capacity() * sizeof(uint32_t) +
+		m_file_name_length.capacity() * sizeof(uint16_t) +
+		m_file_size.capacity() * sizeof(uint64_t) +
+		m_file_write_time.capacity() * sizeof(uint64_t);
+}
+
+uint32_t utils::FileTable::AppendName(std::wstring_view name)
+{
+	if (m_names.size() + name.length() > (std::numeric_limits<uint32_t>::max)())
+	{
+		throw std::length_error("File table name arena is full.");
+	}
+
+	const uint32_t offset = static_cast<uint32_t>(m_names.size());
+	m_names.insert(m_names.end(), name.begin(), name.end());
+
+	return offset;
+}
+
+fs::path utils::FileTable::BuildPath(fs::path path, uint32_t directory, uint32_t file) const
+{
+	// Thu thập chuỗi thư mục từ directory lên gốc rồi nối theo chiều ngược lại
+	std::vector<uint32_t> chain;
+
+	for (uint32_t node = directory; node != NO_PARENT; node = m_directories[node].parent)
+	{
+		chain.push_back(node);
+	}
+
+	for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+	{
+		const DirectoryNode& node = m_directories[*it];
+		path /= std::wstring_view(m_names.data() + node.name_offset, node.name_length);
+	}
+
+	path /= std::wstring_view(m_names.data() + m_file_name_offset[file], m_file_name_length[file]);
+
+	return path;
+}
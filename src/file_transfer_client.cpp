@@ -1,8 +1,22 @@
 ﻿#include <file_transfer_client.h>
 #include <packet_helper.hpp>
 #include <path_resolver.h>
+#include <delta_sync.h>
+#include <download_file_writer.h>
+#include <checkpoint_store.h>
+#include <file_chunk_reader.h>
+#include <small_file_loader.h>
+#include <directory_scanner.h>
+#include <scan_stream.h>
+#include <transfer_scheduler.h>
+#include <concurrency_controller.h>
+#include <sync_index.h>
+#include <sync_plan.h>
+#include <directory_watcher.h>
+#include <aligned_buffer_pool.h>
 using namespace utils;
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
@@ -10,23 +24,49 @@ using namespace utils;
 #include <thread>
 #include <chrono>
 #include <sstream>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 namespace fs = std::filesystem;
 
 
 constexpr auto CHECKSUM_FLAG = true;
+constexpr uint64_t INLINE_UPLOAD_THRESHOLD = 64ULL * 1024; // Files up to 64KB are uploaded in a single packet
+constexpr size_t SMALL_FILE_BATCH_COUNT = 256;					// Số file nhỏ tối đa trong một lô đọc
+constexpr uint64_t SMALL_FILE_BATCH_BYTES = 8ULL * 1024 * 1024; // Tổng kích thước tối đa của một lô đọc
+constexpr uint64_t STRIPED_UPLOAD_THRESHOLD = 256ULL * 1024 * 1024; // File trong thư mục từ 256MB được chia stripe
+constexpr uint16_t DIRECTORY_STRIPE_COUNT = 4;
+constexpr size_t DEFAULT_MAX_PARALLELISM = 32;	// Trần mặc định số phiên upload thư mục
+constexpr auto SYNC_INDEX_SAVE_INTERVAL = std::chrono::seconds(30); // Lưu chỉ mục sync định kỳ trong lúc upload
+constexpr size_t INITIAL_DIRECTORY_WORKERS = 2; // Số phiên upload thư mục lúc bắt đầu, ConcurrencyController tăng/giảm dần
 
 bool is_uploading_directory = false;
 
-FileTransferClient::FileTransferClient()
+FileTransferClient::FileTransferClient() : m_direct_io(false), m_cache_policy(), m_flush_policy(), m_max_parallelism(DEFAULT_MAX_PARALLELISM), m_filter_rules()
 {
 	m_connection = std::make_unique<NetworkConnection>();
 	m_session_manager = std::make_unique<SessionManager>(*m_connection);
 	m_pb_manager = std::make_unique<ProgressBarManager>();
 }
 
+FileTransferClient::~FileTransferClient() = default;
+
+SessionPool& FileTransferClient::GetSessionPool()
+{
+	// Các phiên phụ dùng lại thông tin đăng nhập của phiên chính
+	if (!m_session_pool)
+	{
+		m_session_pool = std::make_unique<SessionPool>(m_connection->GetServerInfo(), m_session_manager->GetUserCredential());
+	}
+
+	return *m_session_pool;
+}
+
 bool FileTransferClient::UploadFile(
 	const std::filesystem::path& file_path,
-	const std::string& remote_path)
+	const std::string& remote_path,
+	UploadChecksum* known_checksum)
 {
 	// Check if the file exists
 	if (!fs::exists(file_path))
@@ -43,17 +83,47 @@ bool FileTransferClient::UploadFile(
 		throw std::runtime_error("Failed to get file size.");
 	}
 
+	// File nhỏ (kể cả file rỗng) được gửi trong một gói tin duy nhất
+	if (static_cast<uint64_t>(fileSize) <= INLINE_UPLOAD_THRESHOLD)
+	{
+		return UploadSmallFile(file_path, remote_path, known_checksum);
+	}
+
+	// File được mở một lần, checksum và các chunk đều đọc từ cùng một reader (file mapping hoặc direct I/O)
+	std::unique_ptr<FileChunkReader> reader = FileChunkReader::Open(file_path, m_direct_io, m_cache_policy);
+
 	std::vector<uint8_t> checksum{};
+	AllocatedRanges allocated;
 
-	if (!is_uploading_directory)
+	if (known_checksum && known_checksum->has_value())
+	{
+		// Bên gọi đã hash file (sync so với chỉ mục): không đọc file thêm lần nữa
+		checksum.assign((*known_checksum)->begin(), (*known_checksum)->end());
+	}
+	else if (known_checksum)
+	{
+		// Bên gọi cần checksum: tính một lần, dùng cho cả request lẫn bên gọi
+		allocated = AllocatedRanges::Query(file_path, fileSize);
+		checksum = reader->CalcCheckSum(nullptr, allocated.HasHoles() ? &allocated : nullptr);
+
+		if (checksum.size() == 16)
+		{
+			known_checksum->emplace();
+			std::copy(checksum.begin(), checksum.end(), (*known_checksum)->begin());
+		}
+	}
+	else if (!is_uploading_directory)
 	{
 		m_pb_manager->AddFile("Calculating checksum");
 
+		// Hole không cần đọc khi tính checksum, danh sách vùng được dùng lại nếu server nhận hole map
+		allocated = AllocatedRanges::Query(file_path, fileSize);
+
 		// Calculate the checksum
-		checksum = md5_handler->calcCheckSumFile(file_path.string(), [this, &fileSize](size_t progress)
+		checksum = reader->CalcCheckSum([this, &fileSize](size_t progress)
 			{
 				m_pb_manager->UpdateProgress("Calculating checksum", static_cast<float>(progress * 100.0f / fileSize));
-			});
+			}, allocated.HasHoles() ? &allocated : nullptr);
 
 		m_pb_manager->Cleanup();
 	}
@@ -63,7 +133,7 @@ bool FileTransferClient::UploadFile(
 	}
 
 	// Prepare the upload request
-	PacketUploadRequest uploadReq(remote_path, "File", fileSize, checksum.data());
+	PacketUploadRequest uploadReq(remote_path, "File", fileSize, checksum.data(), true);
 
 	if (!m_connection->sendPacket(PacketType::UPLOAD_REQUEST, uploadReq))
 	{
@@ -97,61 +167,22 @@ bool FileTransferClient::UploadFile(
 		return false;
 	}
 
-	// Trường hợp đặc biệt với file có kích thước bằng 0
-	if (fileSize == 0)
-	{
-		// Gửi thông báo đặc biệt cho server biết rằng upload đã hoàn tất
-		// Có thể gửi một PacketFileChunk với chunk_size = 0
-		PacketFileChunk fileChunk(
-			uploadResp.upload_allowed.file_id,    // File ID
-			0,                                    // Chunk index
-			0,                                    // Chunk size
-			checksum.data(),                      // Checksum
-			nullptr                               // Không có dữ liệu
-		);
-
-		if (!m_connection->sendPacket(PacketType::FILE_CHUNK, fileChunk))
-		{
-			throw std::runtime_error("Failed to send file chunk for zero-sized file.");
-		}
-
-		PacketHeader ackHeader;
-		PacketFileChunkACK ack;
-
-		if (!m_connection->recvPacket(PacketType::FILE_CHUNK_ACK, ackHeader, ack))
-		{
-			throw std::runtime_error("Failed to receive chunk acknowledgment for zero-sized file.");
-		}
-
-		if (!ack.success ||
-			ack.file_id != uploadResp.upload_allowed.file_id ||
-			ack.chunk_index != 0)
-		{
-			throw std::runtime_error("Chunk ACK validation failed for zero-sized file.");
-		}
-
-		if (!is_uploading_directory)
-		{
-			std::cout << "File uploaded successfully : " << remote_path << std::endl;
-		}
-
-		return true;
-	}
-
-	const std::string file_ckp = file_path.stem().string() + ".ckp"; // Checkpoint file
-	std::ofstream state_file(file_ckp, std::ios::binary | std::ios::trunc);
-
 	// Upload the file
 	size_t chunk_size = uploadResp.upload_allowed.chunk_size;
 	size_t chunk_count = ((fileSize + chunk_size - 1) / chunk_size);
 
-	// Open the file
-	std::ifstream file(file_path, std::ios::binary);
-	if (!file.is_open())
+	// Server nhận hole map: chunk nằm trong hole không cần đọc, chunk toàn byte 0 không cần gửi
+	const bool sparse_upload = uploadResp.sparse_accepted;
+	if (sparse_upload && is_uploading_directory)
 	{
-		throw std::runtime_error("Failed to open file.");
+		allocated = AllocatedRanges::Query(file_path, fileSize);
 	}
 
+	// Checkpoint
+	CheckpointStore& checkpoints = CheckpointStore::Shared();
+	uint64_t transfer_id = checkpoints.Begin(TransferDirection::UPLOAD, file_path, remote_path,
+		uploadResp.upload_allowed.file_id, fileSize, static_cast<uint32_t>(chunk_size));
+
 	if (!is_uploading_directory)
 	{
 		std::cout << "Starting to upload the file in " << chunk_count << " chunks." << std::endl;
@@ -167,7 +198,8 @@ bool FileTransferClient::UploadFile(
 	const int MAX_RETRIES = 3;
 	const int BASE_TIMEOUT = 1000; // 1 second
 
-	m_pb_manager->AddFile(file_path.filename().string());
+	const std::string file_name = file_path.filename().string();
+	m_pb_manager->AddFile(file_name);
 
 	for (size_t i = 0; i < chunk_count; i++)
 	{
@@ -181,29 +213,47 @@ bool FileTransferClient::UploadFile(
 				// Read the chunk data from the file
 				size_t current_chunk_size = std::min<size_t>(chunk_size, fileSize - total_sent);
 
-				std::vector<uint8_t> chunk_data(current_chunk_size);
-				if (!file.read(reinterpret_cast<char*>(chunk_data.data()), current_chunk_size))
+				std::span<const uint8_t> chunk_data{};
+				if (!sparse_upload || allocated.Overlaps(i * chunk_size, current_chunk_size))
 				{
-					throw std::runtime_error("Failed to read file chunk.");
+					chunk_data = reader->Read(i * chunk_size, current_chunk_size);
+				}
+
+				// Chunk trống: gửi cả dãy chunk trống phía sau bằng một hole map
+				if (sparse_upload && IsZeroBlock(chunk_data))
+				{
+					const size_t run_end = UploadHoleRun(*reader, allocated, uploadResp.upload_allowed.file_id, fileSize, chunk_size, i);
+
+					for (; i < run_end; i++)
+					{
+						total_sent += std::min<size_t>(chunk_size, fileSize - total_sent);
+						checkpoints.Progress(transfer_id, static_cast<uint32_t>(i), total_sent);
+					}
+					i--; // Vòng for tăng lại i
+
+					m_pb_manager->UpdateProgress(file_name, (static_cast<float>(total_sent) / fileSize) * 100.0f);
+
+					chunk_sent = true;
+					continue;
 				}
 
 				// Caclulate the checksum
-				std::vector<uint8_t> checksum{};
+				uint8_t checksum[16]{};
 				if (CHECKSUM_FLAG)
 				{
 					if (!is_uploading_directory)
 					{
-						checksum = md5_handler->calcCheckSum(chunk_data);
+						md5_handler->calcCheckSum(chunk_data.data(), chunk_data.size(), checksum);
 					}
 				}
 
 				// Prepare the file chunk packet
-				PacketFileChunk fileChunk(
+				PacketFileChunkView fileChunk(
 					uploadResp.upload_allowed.file_id,				// File ID
 					static_cast<uint32_t>(i),						// Chunk index
 					static_cast<uint32_t>(current_chunk_size),		// Chunk size
-					checksum.data(),								// Checksum
-					reinterpret_cast<uint8_t*>(chunk_data.data())	// Chunk data
+					checksum,										// Checksum
+					chunk_data.data()								// Chunk data
 				);
 
 				if (!m_connection->sendPacket(PacketType::FILE_CHUNK, fileChunk))
@@ -247,14 +297,10 @@ bool FileTransferClient::UploadFile(
 				last_sent = total_sent;
 
 				float progress = (static_cast<float>(total_sent) / fileSize) * 100.0f;
-				m_pb_manager->UpdateProgress(file_path.filename().string(), progress);
-
-				// Lưu trạng thái upload 
-				// (file_id, chunk_size, chunk_index)
-				state_file.seekp(0);
-				state_file.write(reinterpret_cast<const char*>(&uploadResp.upload_allowed.file_id), sizeof(uploadResp.upload_allowed.file_id));
-				state_file.write(reinterpret_cast<const char*>(&chunk_size), sizeof(chunk_size));
-				state_file.write(reinterpret_cast<const char*>(&i), sizeof(i));
+				m_pb_manager->UpdateProgress(file_name, progress);
+
+				// Lưu trạng thái upload
+				checkpoints.Progress(transfer_id, static_cast<uint32_t>(i), total_sent);
 			}
 			catch (const std::exception& e)
 			{
@@ -281,16 +327,10 @@ bool FileTransferClient::UploadFile(
 		}
 	}
 
-	m_pb_manager->UpdateProgress(file_path.filename().string(), 100.0f);
-
-	// Đóng checkpoint file
-	if (fs::exists(file_ckp))
-	{
-		state_file.close();
-		fs::remove(file_ckp);
-	}
+	m_pb_manager->UpdateProgress(file_name, 100.0f);
 
-	file.close(); // Đóng file sau khi upload xong
+	// Xoá checkpoint
+	checkpoints.Complete(transfer_id);
 
 	auto end_time = std::chrono::steady_clock::now();
 	std::chrono::duration<double> total_duration = end_time - start_time;
@@ -307,658 +347,2912 @@ bool FileTransferClient::UploadFile(
 	return true;
 }
 
-bool FileTransferClient::DownloadFile(const std::string& file_name)
+size_t FileTransferClient::UploadHoleRun(FileChunkReader& reader, const AllocatedRanges& allocated, uint32_t file_id,
+	uint64_t file_size, size_t chunk_size, size_t first_chunk)
 {
-	// Create check point folder
-	PathResolver pathResolver;
-	uint32_t file_id = 0;
-	uint64_t resume_position = 0;
-	uint32_t last_chunk_index = 0;
+	const size_t chunk_count = static_cast<size_t>((file_size + chunk_size - 1) / chunk_size);
 
-	fs::path path(file_name);
-	std::string namePart = path.stem().string();
-	std::string check_point_path = utils::DEFAULT_CHECK_POINT_PATH + namePart + ".ckp";
-
-	if (!pathResolver.CheckDirPathExist(utils::DEFAULT_CHECK_POINT_PATH))
+	// Chunk đầu đã được xác định là trống, mở rộng dãy tới chunk có dữ liệu đầu tiên
+	size_t run_end = first_chunk + 1;
+	while (run_end < chunk_count)
 	{
-		pathResolver.CreateCheckPointDirectory();
-	}
+		const uint64_t offset = static_cast<uint64_t>(run_end) * chunk_size;
+		const size_t length = static_cast<size_t>(std::min<uint64_t>(chunk_size, file_size - offset));
 
-	// Create check point file
-	pathResolver.CreateFileWithName(check_point_path);
+		if (allocated.Overlaps(offset, length) && !IsZeroBlock(reader.Read(offset, length)))
+		{
+			break;
+		}
 
+		run_end++;
+	}
 
-	// Prepare the download request
-	PacketDownloadRequest p_request(file_name);
+	const uint64_t hole_offset = static_cast<uint64_t>(first_chunk) * chunk_size;
+	const uint64_t hole_end = std::min<uint64_t>(static_cast<uint64_t>(run_end) * chunk_size, file_size);
 
-	if (!m_connection->sendPacket(PacketType::DOWNLOAD_REQUEST, p_request))
+	PacketFileHoleMap holeMap(file_id, { FileExtentDTO(hole_offset, hole_end - hole_offset) });
+
+	if (!m_connection->sendPacket(PacketType::FILE_HOLE_MAP, holeMap))
 	{
-		throw std::runtime_error("Failed to send download request.");
+		throw std::runtime_error("Failed to send hole map.");
 	}
 
-	PacketHeader header;
-	PacketDownloadResponse p_response;
+	PacketHeader ackHeader;
+	PacketFileChunkACK ack;
 
-	if (!m_connection->recvPacket(PacketType::DOWNLOAD_RESPONSE, header, p_response))
+	if (!m_connection->recvPacket(PacketType::FILE_CHUNK_ACK, ackHeader, ack))
 	{
-		throw std::runtime_error("Failed to receive download response.");
+		throw std::runtime_error("Failed to receive hole map acknowledgment.");
 	}
 
-	if (p_response.status != DownloadStatus::FILE_FOUND)
+	if (!ack.success || ack.file_id != file_id || ack.chunk_index != first_chunk)
 	{
-		if (p_response.status == DownloadStatus::FILE_ACCESS_DENIED)
-			std::cerr << "Server denied the download. Message: " << p_response.error_info.message << std::endl;
-		else if (p_response.status == DownloadStatus::FILE_NOT_FOUND)
-			std::cerr << "Server does not find that file. Message: " << p_response.error_info.message << std::endl;
-		return false;
+		throw std::runtime_error("Hole map ACK validation failed.");
 	}
 
-	std::cout << "The server has allowed the download." << std::endl;
-	std::cout << "File size: " << p_response.file_info.file_size << " bytes." << std::endl;
+	return run_end;
+}
 
-	// Receive file chunks
-	size_t total_received = 0;
-	size_t file_size = p_response.file_info.file_size;
-	std::vector<uint8_t> checksum(p_response.file_info.checksum, p_response.file_info.checksum + 16);
+bool FileTransferClient::UploadSmallFile(
+	const std::filesystem::path& file_path,
+	const std::string& remote_path,
+	UploadChecksum* known_checksum)
+{
+	std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open file.");
+	}
 
-	// Check file name exist to generate new name
-	std::string new_file_name = file_name;
-	std::ifstream check(file_name, std::ios::binary);
-	if (check.is_open())
+	std::streamsize fileSize = file.tellg();
+	if (fileSize < 0 || static_cast<uint64_t>(fileSize) > INLINE_UPLOAD_THRESHOLD)
 	{
-		new_file_name = pathResolver.GenerateNewFileName(file_name);
+		throw std::runtime_error("File is too large for an inline upload.");
 	}
 
-	std::ofstream file(new_file_name, std::ios::binary);
+	std::vector<uint8_t> data(static_cast<size_t>(fileSize));
 
-	auto start_time = std::chrono::steady_clock::now();
-	auto last_time = start_time;
-	size_t last_received = 0;
+	file.seekg(0, std::ios::beg);
+	if (fileSize > 0 && !file.read(reinterpret_cast<char*>(data.data()), fileSize))
+	{
+		throw std::runtime_error("Failed to read file.");
+	}
 
-	m_pb_manager->AddFile(new_file_name);
+	file.close();
 
-	std::unordered_map<uint32_t, int> retry_counts;
+	return UploadInline(remote_path, data, known_checksum);
+}
 
-	if (!file.is_open())
+bool FileTransferClient::UploadInline(const std::string& remote_path, std::span<const uint8_t> data, UploadChecksum* known_checksum)
+{
+	// Checksum được tính trên dữ liệu đã đọc, không cần đọc file thêm một lần
+	uint8_t checksum[16];
+	md5_handler->calcCheckSum(data.data(), data.size(), checksum);
+
+	if (known_checksum)
 	{
-		std::cout << "Cannot open file to write." << std::endl;
-		return false;
+		known_checksum->emplace();
+		std::copy(std::begin(checksum), std::end(checksum), (*known_checksum)->begin());
 	}
-	std::ofstream resume_out(check_point_path, std::ios::binary);
-	while (total_received < file_size)
-	{
-		PacketHeader header;
-		PacketFileChunk fileChunk;
 
-		if (!m_connection->recvPacket(PacketType::FILE_CHUNK, header, fileChunk))
-		{
-			throw std::runtime_error("Failed to receive file chunk.");
-		}
+	PacketUploadInlineRequest inlineReq(remote_path, "File", checksum, data);
 
-		if (fileChunk.file_id != p_response.file_info.file_id)
+	const int MAX_RETRIES = 3;
+	const int BASE_TIMEOUT = 1000; // 1 second
+
+	for (int retries = 0; retries < MAX_RETRIES; retries++)
+	{
+		if (retries > 0)
 		{
-			throw std::runtime_error("Invalid file ID in file chunk.");
+			// Exponential backoff
+			int timeout = BASE_TIMEOUT * (1 << retries);
+			std::cout << "Retrying in " << timeout << " ms..." << std::endl;
+			std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
 		}
 
-
-		// Validate checksum
-		bool checksum_valid = true;
-		if (CHECKSUM_FLAG)
+		if (!m_connection->sendPacket(PacketType::UPLOAD_INLINE_REQUEST, inlineReq))
 		{
-			const std::vector<uint8_t>& chunk_checksum = md5_handler->calcCheckSum(fileChunk.data);
-
-			if (memcmp(chunk_checksum.data(), fileChunk.checksum, 16) != 0)
-			{
-				std::cerr << "Checksum mismatch in chunk " << fileChunk.chunk_index << std::endl;
-				checksum_valid = false;
-			}
+			throw std::runtime_error("Failed to send inline upload request.");
 		}
 
-		// Acknowledge the chunk
-		PacketFileChunkACK chunkACK(
-			fileChunk.file_id,
-			fileChunk.chunk_index,
-			checksum_valid);
+		PacketHeader header;
+		PacketUploadInlineResponse inlineResp;
 
-		if (!m_connection->sendPacket(PacketType::FILE_CHUNK_ACK, chunkACK))
+		if (!m_connection->recvPacket(PacketType::UPLOAD_INLINE_RESPONSE, header, inlineResp))
 		{
-			throw std::runtime_error("Failed to send chunk acknowledgment.");
+			throw std::runtime_error("Failed to receive inline upload response.");
 		}
 
-		if (checksum_valid)
+		if (inlineResp.status != UploadStatus::UPLOAD_ALLOWED)
 		{
-			// Write the chunk data to the file
-			file.write(reinterpret_cast<const char*>(fileChunk.data.data()), fileChunk.chunk_size);
-			file.flush();
-
-			total_received += fileChunk.chunk_size;
-
-			// Save info for resuming transfer
-			size_t len = new_file_name.length();
-			resume_out.seekp(0);
-			resume_out.write(reinterpret_cast<const char*>(&len), sizeof(len));
-			resume_out.write(reinterpret_cast<const char*>(new_file_name.data()), sizeof(char) * len);
-			resume_out.write(reinterpret_cast<const char*>(&p_response.file_info.file_id), sizeof(p_response.file_info.file_id));
-			resume_out.write(reinterpret_cast<const char*>(&total_received), sizeof(total_received));
-			resume_out.write(reinterpret_cast<const char*>(&fileChunk.chunk_index), sizeof(fileChunk.chunk_index));
-			resume_out.write(reinterpret_cast<const char*>(&file_size), sizeof(file_size));
-
-			// Calculate download speed
-			auto current_time = std::chrono::steady_clock::now();
-			std::chrono::duration<double> elapsed = current_time - last_time;
-			size_t bytes_received_since_last = total_received - last_received;
-			double seconds = elapsed.count();
-
-			double speed_mbps = 0.0;
-			if (seconds > 0)
+			if (!is_uploading_directory)
 			{
-				speed_mbps = (bytes_received_since_last * 8.0) / (seconds * 1'000'000.0); // Mbps
+				std::cerr << "The server has denied the upload." << std::endl;
+				std::cerr << "Error message: " << inlineResp.message << std::endl;
 			}
-
-			// Update time and bytes received
-			last_time = current_time;
-			last_received = total_received;
-
-			// Calculate progress
-			float progress = (static_cast<float>(total_received) / file_size) * 100.0f;
-			m_pb_manager->UpdateProgress(new_file_name, progress);
+			return false;
 		}
-		else
+
+		if (inlineResp.stored)
 		{
-			retry_counts[fileChunk.chunk_index]++;
-			if (retry_counts[fileChunk.chunk_index] >= 3)
+			if (!is_uploading_directory)
 			{
-				std::cerr << "Max retries reached for chunk " << fileChunk.chunk_index << ". Aborting." << std::endl;
-				file.close();
-				return false;
+				std::cout << "File uploaded successfully : " << remote_path << std::endl;
+				std::cout << "File ID of this upload: " << inlineResp.file_id << std::endl;
 			}
-
-			// Inform the user and wait before retrying
-			std::cerr << "\nRequesting retransmission of chunk " << fileChunk.chunk_index << " (Retry " << retry_counts[fileChunk.chunk_index] << ")" << std::endl;
-			// Optionally, add a delay before the next attempt
-			std::this_thread::sleep_for(std::chrono::milliseconds(500));
+			return true;
 		}
+
+		// Server nhận được gói tin nhưng checksum không khớp, gửi lại
+		std::cerr << "Attempt " << retries + 1 << " failed: " << inlineResp.message << std::endl;
 	}
 
-	resume_out.close();
-	file.close();
+	std::cerr << "Max retries reached. Aborting." << std::endl;
+	return false;
+}
 
-	// Validate checksum
-	if (CHECKSUM_FLAG)
+void FileTransferClient::UploadSmallFileBatch(
+	SmallFileLoader& loader,
+	const FileTable& table,
+	std::span<const uint32_t> files,
+	std::vector<std::string>& failed_files,
+	size_t& completed,
+	UploadChecksums* checksums)
+{
+	// Lô gồm các file nhỏ liên tiếp, kích thước lấy từ lần quét thư mục nên không cần stat lại từng file
+	std::vector<SmallFileRequest> requests;
+	uint64_t batch_bytes = 0;
+
+	for (uint32_t file : files)
 	{
-		const std::vector<uint8_t>& file_checksum = md5_handler->calcCheckSumFile(new_file_name);
-		if (memcmp(file_checksum.data(), checksum.data(), 16) != 0)
+		const uint64_t file_size = table.GetFileSize(file);
+
+		if (file_size > INLINE_UPLOAD_THRESHOLD || requests.size() >= SMALL_FILE_BATCH_COUNT ||
+			(!requests.empty() && batch_bytes + file_size > SMALL_FILE_BATCH_BYTES))
 		{
-			std::cerr << "Checksum mismatch in the downloaded file." << std::endl;
-			return false;
+			break;
 		}
+
+		requests.push_back({ table.GetAbsolutePath(file), file_size });
+		batch_bytes += file_size;
 	}
 
-	auto end_time = std::chrono::steady_clock::now();
-	std::chrono::duration<double> total_duration = end_time - start_time;
+	std::vector<SmallFileResult> results = loader.LoadBatch(requests);
 
-	std::cout << "Total time: " << std::fixed << std::setprecision(2) << total_duration.count() << " seconds" << std::endl;
-	double avg_speed = (total_received * 8.0) / (total_duration.count() * 1'000'000.0); // Mbps
-	std::cout << "Average speed: " << std::fixed << std::setprecision(2) << avg_speed << " Mbps" << std::endl;
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		const std::string relative_path = table.GetRelativePath(files[i]);
+		UploadChecksum* checksum = ChecksumOf(checksums, files[i]);
 
-	// If file download successful, then delete resume status of this file
-	pathResolver.DeleteFileWithName(check_point_path);
+		// File không đọc được hoặc đã thay đổi sau khi quét: để UploadFile kiểm tra lại và báo lỗi như bình thường
+		const bool uploaded = results[i].loaded
+			? UploadInline(relative_path, results[i].data, checksum)
+			: UploadFile(requests[i].path, relative_path, checksum);
 
-	return true;
+		if (!uploaded)
+		{
+			failed_files.push_back(relative_path);
+		}
+
+		completed++;
+	}
 }
 
-bool  FileTransferClient::ResumeDownload(const std::string& file_name)
+bool FileTransferClient::UploadFileStriped(
+	const std::filesystem::path& file_path,
+	const std::string& remote_path,
+	uint16_t stripe_count)
 {
-	PathResolver pathResolver;
-	uint32_t file_id_read{};
-	uint64_t resume_position_read{};
-	uint32_t last_chunk_index_read{};
-	uint64_t file_size{};
-	std::string temp;
-	size_t len{};
+	// Check if the file exists
+	if (!fs::exists(file_path))
+	{
+		throw std::runtime_error("File does not exist.");
+	}
 
-	std::stringstream ss(file_name);
+	std::error_code ec;
+	uint64_t fileSize = fs::file_size(file_path, ec);
 
-	fs::path path(file_name.data());
-	std::string namePart = path.stem().string();
-	std::string check_point_path = utils::DEFAULT_CHECK_POINT_PATH + namePart + ".ckp";
-	std::ifstream resume_in(check_point_path, std::ios::binary);
+	if (ec)
+	{
+		throw std::runtime_error("Failed to get file size.");
+	}
 
-	// Repair info resuming transfer
-	if (resume_in.is_open())
+	if (stripe_count <= 1 || fileSize <= INLINE_UPLOAD_THRESHOLD)
 	{
-		resume_in.read(reinterpret_cast<char*>(&len), sizeof(len));
-		resume_in.read(reinterpret_cast<char*>(temp.data()), sizeof(char) * len);
-		resume_in.read(reinterpret_cast<char*>(&file_id_read), sizeof(file_id_read));
-		resume_in.read(reinterpret_cast<char*>(&resume_position_read), sizeof(resume_position_read));
-		resume_in.read(reinterpret_cast<char*>(&last_chunk_index_read), sizeof(last_chunk_index_read));
-		resume_in.read(reinterpret_cast<char*>(&file_size), sizeof(file_size));
+		return UploadFile(file_path, remote_path);
 	}
-	resume_in.close();
 
-	// Prepare the download request
-	PacketResumeRequest p_request(file_id_read, resume_position_read, last_chunk_index_read);
+	m_pb_manager->AddFile("Calculating checksum");
 
-	if (!m_connection->sendPacket(PacketType::RESUME_DOWNLOAD_REQUEST, p_request))
+	std::vector<uint8_t> checksum = FileChunkReader::Open(file_path, m_direct_io, m_cache_policy)->CalcCheckSum([this, &fileSize](size_t progress)
+		{
+			m_pb_manager->UpdateProgress("Calculating checksum", static_cast<float>(progress * 100.0f / fileSize));
+		});
+
+	m_pb_manager->Cleanup();
+
+	PacketUploadRequest uploadReq(remote_path, "File", fileSize, checksum.data());
+
+	if (!m_connection->sendPacket(PacketType::UPLOAD_REQUEST, uploadReq))
 	{
-		throw std::runtime_error("Failed to send download request.");
+		throw std::runtime_error("Failed to send upload request.");
 	}
 
 	PacketHeader header;
-	PacketResumeResponse p_response;
+	PacketUploadResponse uploadResp;
 
-	if (!m_connection->recvPacket(PacketType::RESUME_RESPONSE, header, p_response))
+	if (!m_connection->recvPacket(PacketType::UPLOAD_RESPONSE, header, uploadResp))
 	{
-		throw std::runtime_error("Failed to receive download response.");
+		throw std::runtime_error("Failed to receive upload response.");
 	}
 
-	if (p_response.status != ResumeStatus::RESUME_SUPPORTED)
+	if (uploadResp.status != UploadStatus::UPLOAD_ALLOWED)
 	{
-		std::cerr << "Server is not support resuming this file. Message: " << p_response.resume_not_found.message << std::endl;
-
-		// If the resume state is invalid, then delete resume status of this file
-		pathResolver.DeleteFileWithName(check_point_path);
+		std::cerr << "The server has denied the upload." << std::endl;
+		std::cerr << "Error message: " << uploadResp.out_of_space.message << std::endl;
 		return false;
 	}
 
-	std::cout << "The server has allowed resuming download." << std::endl;
-	std::cout << "File id: " << p_response.resume_allowed.file_id << std::endl;
-	std::cout << "Resume position : " << p_response.resume_allowed.resume_position << std::endl;
-	std::cout << "Remainning chunk : " << p_response.resume_allowed.remaining_chunk_count << std::endl;
+	const uint32_t file_id = uploadResp.upload_allowed.file_id;
+	const size_t chunk_size = uploadResp.upload_allowed.chunk_size;
+	const uint64_t chunk_count = (fileSize + chunk_size - 1) / chunk_size;
 
-	// Receive file chunks
-	size_t total_received = resume_position_read;
+	// Stripe 0 dùng kết nối hiện tại, các stripe còn lại lấy phiên từ pool
+	std::vector<std::unique_ptr<FileTransferClient>> workers;
+	const uint16_t wanted = static_cast<uint16_t>(std::min<uint64_t>(stripe_count, chunk_count));
 
-	std::ofstream file(file_name, std::ios::binary | std::ios::app);
+	for (uint16_t s = 1; s < wanted; s++)
+	{
+		try
+		{
+			workers.push_back(GetSessionPool().Acquire());
+			workers.back()->SetDirectIO(m_direct_io);
+			workers.back()->SetCachePolicy(m_cache_policy);
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "Failed to open connection for stripe " << s << ": " << e.what() << std::endl;
+			break;
+		}
+	}
 
-	auto start_time = std::chrono::steady_clock::now();
-	auto last_time = start_time;
-	size_t last_received = 0;
+	const uint16_t stripes = static_cast<uint16_t>(workers.size() + 1);
 
-	m_pb_manager->AddFile(file_name);
+	std::cout << "The server has allowed the upload." << std::endl;
+	std::cout << "File ID of this upload: " << file_id << std::endl;
+	std::cout << "Starting to upload the file in " << chunk_count << " chunks over " << stripes << " connections." << std::endl;
 
-	std::unordered_map<uint32_t, int> retry_counts;
+	// Checkpoint: các stripe hoàn tất chunk không theo thứ tự, bitmap trong journal cho phép ResumeUpload gửi phần còn thiếu
+	CheckpointStore& checkpoints = CheckpointStore::Shared();
+	const uint64_t transfer_id = checkpoints.Begin(TransferDirection::UPLOAD, file_path, remote_path,
+		file_id, fileSize, static_cast<uint32_t>(chunk_size));
 
-	if (!file.is_open())
-	{
-		std::cout << "Cannot open file to write." << std::endl;
-		return false;
-	}
-	std::ofstream resume_out(check_point_path, std::ios::binary);
+	std::atomic<uint64_t> total_sent{ 0 };
+	std::atomic<bool> cancelled{ false };
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	std::vector<std::future<bool>> results;
+	for (uint16_t s = 0; s < stripes; s++)
+	{
+		FileTransferClient* client = (s == 0) ? this : workers[s - 1].get();
+
+		results.push_back(std::async(std::launch::async,
+			[client, s, stripes, &file_path, fileSize, file_id, chunk_size, transfer_id, &total_sent, &cancelled]()
+			{
+				try
+				{
+					return client->UploadStripe(file_path, fileSize, file_id, chunk_size, transfer_id, s, stripes, total_sent, cancelled);
+				}
+				catch (const std::exception& e)
+				{
+					std::cerr << "Stripe " << s << " failed: " << e.what() << std::endl;
+					cancelled = true;
+					return false;
+				}
+			}));
+	}
+
+	// Chỉ luồng chính cập nhật progress bar
+	m_pb_manager->AddFile(file_path.filename().string());
+
+	for (auto& result : results)
+	{
+		while (result.wait_for(std::chrono::milliseconds(200)) != std::future_status::ready)
+		{
+			float progress = (static_cast<float>(total_sent.load()) / fileSize) * 100.0f;
+			m_pb_manager->UpdateProgress(file_path.filename().string(), progress);
+		}
+	}
+
+	bool success = true;
+	for (size_t s = 0; s < results.size(); s++)
+	{
+		bool stripe_ok = results[s].get();
+		success = success && stripe_ok;
+
+		// Phiên của stripe lỗi có thể đang lệch giao thức, không trả về pool
+		if (s > 0 && stripe_ok)
+		{
+			GetSessionPool().Release(std::move(workers[s - 1]));
+		}
+	}
+
+	if (!success)
+	{
+		std::cerr << "Striped upload failed: " << remote_path << std::endl;
+		return false;
+	}
+
+	m_pb_manager->UpdateProgress(file_path.filename().string(), 100.0f);
+
+	checkpoints.Complete(transfer_id);
+
+	auto end_time = std::chrono::steady_clock::now();
+	std::chrono::duration<double> total_duration = end_time - start_time;
+
+	std::cout << std::endl
+		<< "File uploaded successfully : " << remote_path << std::endl;
+	std::cout << "Total time: " << std::fixed << std::setprecision(2) << total_duration.count() << " seconds" << std::endl;
+	double avg_speed = (total_sent * 8.0) / (total_duration.count() * 1000000.0); // Mbps
+	std::cout << "Average speed: " << std::fixed << std::setprecision(2) << avg_speed << " Mbps" << std::endl;
+
+	return true;
+}
+
+bool FileTransferClient::UploadStripe(
+	const std::filesystem::path& file_path,
+	uint64_t file_size,
+	uint32_t file_id,
+	size_t chunk_size,
+	uint64_t transfer_id,
+	uint16_t stripe_index,
+	uint16_t stripe_count,
+	std::atomic<uint64_t>& total_sent,
+	const std::atomic<bool>& cancelled)
+{
+	PacketStripeAttachRequest attachReq(file_id, StripeDirection::UPLOAD, stripe_index, stripe_count);
+
+	if (!m_connection->sendPacket(PacketType::STRIPE_ATTACH_REQUEST, attachReq))
+	{
+		throw std::runtime_error("Failed to send stripe attach request.");
+	}
+
+	PacketHeader header;
+	PacketStripeAttachResponse attachResp;
+
+	if (!m_connection->recvPacket(PacketType::STRIPE_ATTACH_RESPONSE, header, attachResp))
+	{
+		throw std::runtime_error("Failed to receive stripe attach response.");
+	}
+
+	if (!attachResp.attached || attachResp.file_id != file_id)
+	{
+		throw std::runtime_error("Server rejected stripe: " + attachResp.message);
+	}
+
+	// Mỗi stripe mở reader riêng
+	std::unique_ptr<FileChunkReader> reader = FileChunkReader::Open(file_path, m_direct_io, m_cache_policy);
+
+	const uint64_t chunk_count = (file_size + chunk_size - 1) / chunk_size;
+	const int MAX_RETRIES = 3;
+	const int BASE_TIMEOUT = 1000; // 1 second
+
+	for (uint64_t i = stripe_index; i < chunk_count; i += stripe_count)
+	{
+		if (cancelled)
+		{
+			return false;
+		}
+
+		const uint64_t offset = i * chunk_size;
+		const size_t current_chunk_size = static_cast<size_t>(std::min<uint64_t>(chunk_size, file_size - offset));
+
+		std::span<const uint8_t> chunk_data = reader->Read(offset, current_chunk_size);
+
+		uint8_t checksum[16]{};
+		if (CHECKSUM_FLAG)
+		{
+			md5_handler->calcCheckSum(chunk_data.data(), chunk_data.size(), checksum);
+		}
+
+		PacketFileChunkView fileChunk(
+			file_id,
+			static_cast<uint32_t>(i),
+			static_cast<uint32_t>(current_chunk_size),
+			checksum,
+			chunk_data.data()
+		);
+
+		int retries = 0;
+		bool chunk_sent = false;
+
+		while (!chunk_sent)
+		{
+			try
+			{
+				if (!m_connection->sendPacket(PacketType::FILE_CHUNK, fileChunk))
+				{
+					throw std::runtime_error("Failed to send file chunk.");
+				}
+
+				PacketHeader ackHeader;
+				PacketFileChunkACK ack;
+
+				if (!m_connection->recvPacket(PacketType::FILE_CHUNK_ACK, ackHeader, ack))
+				{
+					throw std::runtime_error("Failed to receive chunk acknowledgment.");
+				}
+
+				if (!ack.success || ack.file_id != file_id || ack.chunk_index != i)
+				{
+					throw std::runtime_error("Chunk ACK validation failed.");
+				}
+
+				chunk_sent = true;
+				const uint64_t sent = (total_sent += current_chunk_size);
+
+				CheckpointStore::Shared().Progress(transfer_id, static_cast<uint32_t>(i), sent);
+			}
+			catch (const std::exception& e)
+			{
+				retries++;
+				std::cerr << "Stripe " << stripe_index << ", chunk " << i << ": attempt " << retries << " failed: " << e.what() << std::endl;
+
+				if (retries >= MAX_RETRIES)
+				{
+					std::cerr << "Max retries reached. Aborting." << std::endl;
+					return false;
+				}
+
+				// Exponential backoff
+				int timeout = BASE_TIMEOUT * (1 << retries);
+				std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+			}
+		}
+	}
+
+	return true;
+}
+
+bool FileTransferClient::DeltaUploadFile(
+	const std::filesystem::path& file_path,
+	const std::string& remote_path)
+{
+	// Check if the file exists
+	if (!fs::exists(file_path))
+	{
+		throw std::runtime_error("File does not exist.");
+	}
+
+	// Get the file size
+	std::error_code ec;
+	uint64_t fileSize = fs::file_size(file_path, ec);
+
+	if (ec)
+	{
+		throw std::runtime_error("Failed to get file size.");
+	}
+
+	// Lấy chữ ký khối của phiên bản file trên server
+	PacketBlockSignatureRequest signatureReq(remote_path, 0); // Block size 0: server tự chọn
+
+	if (!m_connection->sendPacket(PacketType::BLOCK_SIGNATURE_REQUEST, signatureReq))
+	{
+		throw std::runtime_error("Failed to send block signature request.");
+	}
+
+	PacketHeader header;
+	PacketBlockSignatureResponse signatureResp;
+
+	if (!m_connection->recvPacket(PacketType::BLOCK_SIGNATURE_RESPONSE, header, signatureResp))
+	{
+		throw std::runtime_error("Failed to receive block signature response.");
+	}
+
+	if (!signatureResp.found || signatureResp.block_size == 0 || signatureResp.signatures.empty())
+	{
+		std::cout << "The file does not exist on the server, uploading the whole file." << std::endl;
+		return UploadFile(file_path, remote_path);
+	}
+
+	std::cout << "Remote file size: " << signatureResp.file_size << " bytes, "
+		<< signatureResp.block_count << " blocks of " << signatureResp.block_size << " bytes." << std::endl;
+
+	// Calculate the checksum of the new version
+	m_pb_manager->AddFile("Calculating checksum");
+
+	std::vector<uint8_t> checksum = FileChunkReader::Open(file_path, m_direct_io, m_cache_policy)->CalcCheckSum([this, &fileSize](size_t progress)
+		{
+			m_pb_manager->UpdateProgress("Calculating checksum", static_cast<float>(progress * 100.0f / fileSize));
+		});
+
+	m_pb_manager->Cleanup();
+
+	PacketDeltaUploadRequest deltaReq(remote_path, fileSize, checksum.data(), signatureResp.block_size);
+
+	if (!m_connection->sendPacket(PacketType::DELTA_UPLOAD_REQUEST, deltaReq))
+	{
+		throw std::runtime_error("Failed to send delta upload request.");
+	}
+
+	PacketUploadResponse uploadResp;
+
+	if (!m_connection->recvPacket(PacketType::UPLOAD_RESPONSE, header, uploadResp))
+	{
+		throw std::runtime_error("Failed to receive upload response.");
+	}
+
+	if (uploadResp.status != UploadStatus::UPLOAD_ALLOWED)
+	{
+		std::cerr << "The server has denied the upload." << std::endl;
+		std::cerr << "Error message: " << uploadResp.out_of_space.message << std::endl;
+		return false;
+	}
+
+	const uint32_t file_id = uploadResp.upload_allowed.file_id;
+	const std::string progress_name = file_path.filename().string();
+
+	const int MAX_RETRIES = 3;
+	const int BASE_TIMEOUT = 1000; // 1 second
+
+	uint32_t sequence = 0;
+	uint64_t total_sent = 0;
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	m_pb_manager->AddFile(progress_name);
+
+	// Gửi từng đoạn lệnh delta và chờ ACK như một FILE_CHUNK thông thường
+	auto send_instructions = [&](const std::vector<uint8_t>& instructions, bool is_last) -> bool
+		{
+			std::vector<uint8_t> chunk_checksum = md5_handler->calcCheckSum(instructions);
+			PacketDeltaChunk deltaChunk(file_id, sequence, is_last, chunk_checksum.data(), instructions);
+
+			for (int retries = 0; retries < MAX_RETRIES; retries++)
+			{
+				if (retries > 0)
+				{
+					// Exponential backoff
+					int timeout = BASE_TIMEOUT * (1 << retries);
+					std::cout << "Retrying in " << timeout << " ms..." << std::endl;
+					std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+				}
+
+				if (!m_connection->sendPacket(PacketType::DELTA_CHUNK, deltaChunk))
+				{
+					std::cerr << "Attempt " << retries + 1 << " failed: Failed to send delta chunk." << std::endl;
+					continue;
+				}
+
+				PacketHeader ackHeader;
+				PacketFileChunkACK ack;
+
+				if (!m_connection->recvPacket(PacketType::FILE_CHUNK_ACK, ackHeader, ack))
+				{
+					std::cerr << "Attempt " << retries + 1 << " failed: Failed to receive chunk acknowledgment." << std::endl;
+					continue;
+				}
+
+				if (!ack.success || ack.file_id != file_id || ack.chunk_index != sequence)
+				{
+					std::cerr << "Attempt " << retries + 1 << " failed: Chunk ACK validation failed." << std::endl;
+					continue;
+				}
+
+				sequence++;
+				total_sent += instructions.size();
+				return true;
+			}
+
+			std::cerr << "Max retries reached. Aborting." << std::endl;
+			return false;
+		};
+
+	auto update_progress = [this, &progress_name, fileSize](uint64_t processed)
+		{
+			if (fileSize > 0)
+			{
+				m_pb_manager->UpdateProgress(progress_name, (static_cast<float>(processed) / fileSize) * 100.0f);
+			}
+		};
+
+	utils::DeltaEncoder encoder(signatureResp.signatures, signatureResp.block_size, uploadResp.upload_allowed.chunk_size);
+
+	if (!encoder.Encode(file_path, send_instructions, update_progress))
+	{
+		std::cerr << "Failed to send delta of file: " << remote_path << std::endl;
+		return false;
+	}
+
+	m_pb_manager->UpdateProgress(progress_name, 100.0f);
+
+	auto end_time = std::chrono::steady_clock::now();
+	std::chrono::duration<double> total_duration = end_time - start_time;
+
+	std::cout << std::endl
+		<< "File uploaded successfully : " << remote_path << std::endl;
+	std::cout << "Reused from server: " << encoder.GetMatchedBytes() << " bytes, sent as literal: "
+		<< encoder.GetLiteralBytes() << " bytes (" << sequence << " delta chunks, " << total_sent << " bytes on the wire)" << std::endl;
+	std::cout << "Total time: " << std::fixed << std::setprecision(2) << total_duration.count() << " seconds" << std::endl;
+
+	return true;
+}
+
+bool FileTransferClient::DownloadFile(const std::string& file_name, const std::string& output_path)
+{
+	PathResolver pathResolver;
+
+	// Prepare the download request
+	PacketDownloadRequest p_request(file_name, true);
+
+	if (!m_connection->sendPacket(PacketType::DOWNLOAD_REQUEST, p_request))
+	{
+		throw std::runtime_error("Failed to send download request.");
+	}
+
+	PacketHeader header;
+	PacketDownloadResponse p_response;
+
+	if (!m_connection->recvPacket(PacketType::DOWNLOAD_RESPONSE, header, p_response))
+	{
+		throw std::runtime_error("Failed to receive download response.");
+	}
+
+	if (p_response.status != DownloadStatus::FILE_FOUND)
+	{
+		if (p_response.status == DownloadStatus::FILE_ACCESS_DENIED)
+			std::cerr << "Server denied the download. Message: " << p_response.error_info.message << std::endl;
+		else if (p_response.status == DownloadStatus::FILE_NOT_FOUND)
+			std::cerr << "Server does not find that file. Message: " << p_response.error_info.message << std::endl;
+		return false;
+	}
+
+	std::cout << "The server has allowed the download." << std::endl;
+	std::cout << "File size: " << p_response.file_info.file_size << " bytes." << std::endl;
+
+	// Receive file chunks
+	size_t total_received = 0;
+	size_t file_size = p_response.file_info.file_size;
+	std::vector<uint8_t> checksum(p_response.file_info.checksum, p_response.file_info.checksum + 16);
+
+	// Các đoạn trống phải căn theo chunk, tăng dần và không chồng lấn: server sẽ không gửi chunk nào trong đó
+	const uint64_t download_chunk_size = p_response.file_info.chunk_size;
+	uint64_t hole_end = 0;
+	for (const auto& hole : p_response.holes)
+	{
+		if (download_chunk_size == 0 ||
+			hole.offset % download_chunk_size != 0 ||
+			hole.offset < hole_end ||
+			hole.length == 0 ||
+			hole.offset > file_size || hole.length > file_size - hole.offset ||
+			(hole.length % download_chunk_size != 0 && hole.offset + hole.length != file_size))
+		{
+			throw std::runtime_error("Invalid hole map in download response.");
+		}
+		hole_end = hole.offset + hole.length;
+	}
+
+	// Check file name exist to generate new name
+	std::string new_file_name = file_name;
+	if (!output_path.empty())
+	{
+		// Nơi ghi do người gọi chọn (bản local cũ đã được xác định là lỗi thời)
+		new_file_name = output_path;
+
+		std::error_code ec;
+		fs::create_directories(fs::path(output_path).parent_path(), ec);
+	}
+	else
+	{
+		std::ifstream check(file_name, std::ios::binary);
+		if (check.is_open())
+		{
+			new_file_name = pathResolver.GenerateNewFileName(file_name);
+		}
+	}
+
+	// Các chunk đã ghi nhưng chưa flush, được đưa vào journal khi writer flush (khai báo trước writer vì callback tham chiếu tới chúng)
+	std::vector<uint32_t> unflushed_chunks;
+	uint64_t written_position = 0;
+
+	// Cấp phát trước toàn bộ file (file sparse chỉ đặt kích thước), chunk được ghi tại chunk_index * chunk_size
+	DownloadFileWriter file(new_file_name, file_size, p_response.file_info.chunk_size, m_flush_policy, true, m_direct_io,
+		!p_response.holes.empty());
+	file.SetCachePolicy(m_cache_policy);
+
+	// Checkpoint
+	CheckpointStore& checkpoints = CheckpointStore::Shared();
+	uint64_t transfer_id = checkpoints.Begin(TransferDirection::DOWNLOAD, new_file_name, file_name,
+		p_response.file_info.file_id, file_size, p_response.file_info.chunk_size);
+
+	// Chỉ ghi tiến độ sau khi dữ liệu đã được flush xuống đĩa
+	file.SetFlushCallback([&checkpoints, transfer_id, &unflushed_chunks, &written_position]()
+		{
+			for (uint32_t chunk_index : unflushed_chunks)
+			{
+				checkpoints.Progress(transfer_id, chunk_index, written_position);
+			}
+			unflushed_chunks.clear();
+		});
+
+	// Tạo lại các hole, chunk trong hole được coi là đã nhận
+	for (const auto& hole : p_response.holes)
+	{
+		file.PunchHole(hole.offset, hole.length);
+
+		for (uint64_t offset = hole.offset; offset < hole.offset + hole.length; offset += download_chunk_size)
+		{
+			unflushed_chunks.push_back(static_cast<uint32_t>(offset / download_chunk_size));
+		}
+
+		total_received += hole.length;
+		written_position = total_received;
+	}
+
+	auto start_time = std::chrono::steady_clock::now();
+	auto last_time = start_time;
+	size_t last_received = total_received;
+
+	m_pb_manager->AddFile(new_file_name);
+
+	std::unordered_map<uint32_t, int> retry_counts;
+
+	while (total_received < file_size)
+	{
+		PacketHeader header;
+		PacketFileChunkView fileChunk;
+
+		if (!m_connection->recvPacket(PacketType::FILE_CHUNK, header, fileChunk))
+		{
+			throw std::runtime_error("Failed to receive file chunk.");
+		}
+
+		if (fileChunk.file_id != p_response.file_info.file_id)
+		{
+			throw std::runtime_error("Invalid file ID in file chunk.");
+		}
+
+
+		// Validate checksum
+		bool checksum_valid = true;
+		if (CHECKSUM_FLAG)
+		{
+			uint8_t chunk_checksum[16];
+			md5_handler->calcCheckSum(fileChunk.data, fileChunk.chunk_size, chunk_checksum);
+
+			if (memcmp(chunk_checksum, fileChunk.checksum, 16) != 0)
+			{
+				std::cerr << "Checksum mismatch in chunk " << fileChunk.chunk_index << std::endl;
+				checksum_valid = false;
+			}
+		}
+
+		// Acknowledge the chunk
+		PacketFileChunkACK chunkACK(
+			fileChunk.file_id,
+			fileChunk.chunk_index,
+			checksum_valid);
+
+		if (!m_connection->sendPacket(PacketType::FILE_CHUNK_ACK, chunkACK))
+		{
+			throw std::runtime_error("Failed to send chunk acknowledgment.");
+		}
+
+		if (checksum_valid)
+		{
+			total_received += fileChunk.chunk_size;
+
+			// Write the chunk data to the file
+			file.WriteChunk(fileChunk.chunk_index, fileChunk.data, fileChunk.chunk_size);
+
+			unflushed_chunks.push_back(fileChunk.chunk_index);
+			written_position = total_received;
+
+			// Calculate download speed
+			auto current_time = std::chrono::steady_clock::now();
+			std::chrono::duration<double> elapsed = current_time - last_time;
+			size_t bytes_received_since_last = total_received - last_received;
+			double seconds = elapsed.count();
+
+			double speed_mbps = 0.0;
+			if (seconds > 0)
+			{
+				speed_mbps = (bytes_received_since_last * 8.0) / (seconds * 1'000'000.0); // Mbps
+			}
+
+			// Update time and bytes received
+			last_time = current_time;
+			last_received = total_received;
+
+			// Calculate progress
+			float progress = (static_cast<float>(total_received) / file_size) * 100.0f;
+			m_pb_manager->UpdateProgress(new_file_name, progress);
+		}
+		else
+		{
+			retry_counts[fileChunk.chunk_index]++;
+			if (retry_counts[fileChunk.chunk_index] >= 3)
+			{
+				std::cerr << "Max retries reached for chunk " << fileChunk.chunk_index << ". Aborting." << std::endl;
+				file.Close();
+				return false;
+			}
+
+			// Inform the user and wait before retrying
+			std::cerr << "\nRequesting retransmission of chunk " << fileChunk.chunk_index << " (Retry " << retry_counts[fileChunk.chunk_index] << ")" << std::endl;
+			// Optionally, add a delay before the next attempt
+			std::this_thread::sleep_for(std::chrono::milliseconds(500));
+		}
+	}
+
+	file.Close();
+
+	// Validate checksum, hole trong file vừa ghi được băm như byte 0 mà không đọc lại
+	if (CHECKSUM_FLAG)
+	{
+		const AllocatedRanges written = AllocatedRanges::Query(new_file_name, file_size);
+		const std::vector<uint8_t>& file_checksum = FileChunkReader::Open(new_file_name, m_direct_io, m_cache_policy)->CalcCheckSum(
+			nullptr, written.HasHoles() ? &written : nullptr);
+		if (memcmp(file_checksum.data(), checksum.data(), 16) != 0)
+		{
+			std::cerr << "Checksum mismatch in the downloaded file." << std::endl;
+			return false;
+		}
+	}
+
+	auto end_time = std::chrono::steady_clock::now();
+	std::chrono::duration<double> total_duration = end_time - start_time;
+
+	std::cout << "Total time: " << std::fixed << std::setprecision(2) << total_duration.count() << " seconds" << std::endl;
+	double avg_speed = (total_received * 8.0) / (total_duration.count() * 1'000'000.0); // Mbps
+	std::cout << "Average speed: " << std::fixed << std::setprecision(2) << avg_speed << " Mbps" << std::endl;
+
+	// If file download successful, then delete resume status of this file
+	checkpoints.Complete(transfer_id);
+
+	return true;
+}
+
+bool FileTransferClient::DeltaDownloadFile(const std::string& file_name)
+{
+	// Không có bản local thì tải lại toàn bộ file
+	if (!fs::exists(file_name) || !fs::is_regular_file(file_name))
+	{
+		return DownloadFile(file_name);
+	}
+
+	uint64_t local_size = fs::file_size(file_name);
+	uint32_t block_size = utils::ChooseDeltaBlockSize(local_size);
+
+	// Tính chữ ký khối của bản local
+	m_pb_manager->AddFile("Calculating signatures");
+
+	std::vector<BlockSignatureDTO> signatures = utils::ComputeBlockSignatures(file_name, block_size,
+		[this, local_size](uint64_t processed)
+		{
+			m_pb_manager->UpdateProgress("Calculating signatures", static_cast<float>(processed * 100.0f / local_size));
+		});
+
+	m_pb_manager->Cleanup();
+
+	PacketDeltaDownloadRequest p_request(file_name, block_size, signatures);
+
+	if (!m_connection->sendPacket(PacketType::DELTA_DOWNLOAD_REQUEST, p_request))
+	{
+		throw std::runtime_error("Failed to send delta download request.");
+	}
+
+	PacketHeader header;
+	PacketDownloadResponse p_response;
+
+	if (!m_connection->recvPacket(PacketType::DOWNLOAD_RESPONSE, header, p_response))
+	{
+		throw std::runtime_error("Failed to receive download response.");
+	}
+
+	if (p_response.status != DownloadStatus::FILE_FOUND)
+	{
+		if (p_response.status == DownloadStatus::FILE_ACCESS_DENIED)
+			std::cerr << "Server denied the download. Message: " << p_response.error_info.message << std::endl;
+		else if (p_response.status == DownloadStatus::FILE_NOT_FOUND)
+			std::cerr << "Server does not find that file. Message: " << p_response.error_info.message << std::endl;
+		return false;
+	}
+
+	std::cout << "The server has allowed the refresh." << std::endl;
+	std::cout << "File size: " << p_response.file_info.file_size << " bytes." << std::endl;
+
+	const uint64_t file_size = p_response.file_info.file_size;
+	std::vector<uint8_t> checksum(p_response.file_info.checksum, p_response.file_info.checksum + 16);
+
+	utils::DeltaPatcher patcher(file_name, block_size);
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	m_pb_manager->AddFile(file_name);
+
+	std::unordered_map<uint32_t, int> retry_counts;
+	uint32_t expected_sequence = 0;
+	uint64_t total_received = 0;
+	bool finished = false;
+
+	while (!finished)
+	{
+		PacketDeltaChunk deltaChunk;
+
+		if (!m_connection->recvPacket(PacketType::DELTA_CHUNK, header, deltaChunk))
+		{
+			throw std::runtime_error("Failed to receive delta chunk.");
+		}
+
+		if (deltaChunk.file_id != p_response.file_info.file_id)
+		{
+			throw std::runtime_error("Invalid file ID in delta chunk.");
+		}
+
+		// Validate checksum
+		bool checksum_valid = true;
+		if (CHECKSUM_FLAG)
+		{
+			const std::vector<uint8_t>& chunk_checksum = md5_handler->calcCheckSum(deltaChunk.data);
+
+			if (memcmp(chunk_checksum.data(), deltaChunk.checksum, 16) != 0)
+			{
+				std::cerr << "Checksum mismatch in delta chunk " << deltaChunk.sequence << std::endl;
+				checksum_valid = false;
+			}
+		}
+
+		// Acknowledge the chunk
+		PacketFileChunkACK chunkACK(
+			deltaChunk.file_id,
+			deltaChunk.sequence,
+			checksum_valid);
+
+		if (!m_connection->sendPacket(PacketType::FILE_CHUNK_ACK, chunkACK))
+		{
+			throw std::runtime_error("Failed to send chunk acknowledgment.");
+		}
+
+		if (!checksum_valid)
+		{
+			if (++retry_counts[deltaChunk.sequence] >= 3)
+			{
+				std::cerr << "Max retries reached for delta chunk " << deltaChunk.sequence << ". Aborting." << std::endl;
+				patcher.Abort();
+				return false;
+			}
+
+			std::cerr << "\nRequesting retransmission of delta chunk " << deltaChunk.sequence << " (Retry " << retry_counts[deltaChunk.sequence] << ")" << std::endl;
+			continue;
+		}
+
+		// Bỏ qua chunk đã áp dụng (server gửi lại vì mất ACK)
+		if (deltaChunk.sequence < expected_sequence)
+		{
+			continue;
+		}
+
+		if (deltaChunk.sequence != expected_sequence)
+		{
+			patcher.Abort();
+			throw std::runtime_error("Delta chunk received out of order.");
+		}
+
+		patcher.Apply(deltaChunk.data);
+
+		expected_sequence++;
+		total_received += deltaChunk.data_length;
+		finished = deltaChunk.is_last != 0;
+
+		if (file_size > 0)
+		{
+			float progress = (static_cast<float>(patcher.GetBytesWritten()) / file_size) * 100.0f;
+			m_pb_manager->UpdateProgress(file_name, progress);
+		}
+	}
+
+	patcher.Close();
+
+	if (patcher.GetBytesWritten() != file_size)
+	{
+		std::cerr << "Patched file size does not match the server file size." << std::endl;
+		patcher.Abort();
+		return false;
+	}
+
+	// Validate checksum
+	if (CHECKSUM_FLAG)
+	{
+		const std::vector<uint8_t>& file_checksum = md5_handler->calcCheckSumFile(patcher.GetTempPath().string());
+		if (memcmp(file_checksum.data(), checksum.data(), 16) != 0)
+		{
+			std::cerr << "Checksum mismatch in the refreshed file." << std::endl;
+			patcher.Abort();
+			return false;
+		}
+	}
+
+	patcher.Commit();
+
+	m_pb_manager->UpdateProgress(file_name, 100.0f);
+
+	auto end_time = std::chrono::steady_clock::now();
+	std::chrono::duration<double> total_duration = end_time - start_time;
+
+	std::cout << "Reused from local copy: " << patcher.GetReusedBytes() << " bytes, received: " << total_received << " bytes." << std::endl;
+	std::cout << "Total time: " << std::fixed << std::setprecision(2) << total_duration.count() << " seconds" << std::endl;
+
+	return true;
+}
+
+bool FileTransferClient::DownloadFileStriped(const std::string& file_name, uint16_t stripe_count)
+{
+	if (stripe_count <= 1)
+	{
+		return DownloadFile(file_name);
+	}
+
+	// Server chỉ gửi chunk sau khi các stripe đã gắn vào phiên truyền
+	PacketDownloadRequest p_request(file_name);
+
+	if (!m_connection->sendPacket(PacketType::STRIPED_DOWNLOAD_REQUEST, p_request))
+	{
+		throw std::runtime_error("Failed to send download request.");
+	}
+
+	PacketHeader header;
+	PacketDownloadResponse p_response;
+
+	if (!m_connection->recvPacket(PacketType::DOWNLOAD_RESPONSE, header, p_response))
+	{
+		throw std::runtime_error("Failed to receive download response.");
+	}
+
+	if (p_response.status != DownloadStatus::FILE_FOUND)
+	{
+		if (p_response.status == DownloadStatus::FILE_ACCESS_DENIED)
+			std::cerr << "Server denied the download. Message: " << p_response.error_info.message << std::endl;
+		else if (p_response.status == DownloadStatus::FILE_NOT_FOUND)
+			std::cerr << "Server does not find that file. Message: " << p_response.error_info.message << std::endl;
+		return false;
+	}
+
+	const uint32_t file_id = p_response.file_info.file_id;
+	const uint64_t file_size = p_response.file_info.file_size;
+	const size_t chunk_size = p_response.file_info.chunk_size;
+	if (chunk_size == 0)
+	{
+		throw std::runtime_error("Invalid chunk size in download response.");
+	}
+
+	const uint64_t chunk_count = (file_size + chunk_size - 1) / chunk_size;
+	std::vector<uint8_t> checksum(p_response.file_info.checksum, p_response.file_info.checksum + 16);
+
+	std::cout << "The server has allowed the download." << std::endl;
+	std::cout << "File size: " << file_size << " bytes." << std::endl;
+
+	// Check file name exist to generate new name
+	PathResolver pathResolver;
+	std::string new_file_name = file_name;
+	if (fs::exists(file_name))
+	{
+		new_file_name = pathResolver.GenerateNewFileName(file_name);
+	}
+
+	// Chunk các stripe đã ghi nhưng chưa flush, được đưa vào journal khi writer flush (khai báo trước writer vì callback tham chiếu tới chúng)
+	std::mutex progress_mutex;
+	std::vector<uint32_t> unflushed_chunks;
+	ChunkBitmap flushed_chunks(static_cast<uint32_t>(chunk_count));
+
+	// Tạo file đủ kích thước trước để các stripe ghi thẳng vào vị trí của chunk
+	DownloadFileWriter writer(new_file_name, file_size, static_cast<uint32_t>(chunk_size), m_flush_policy, true, m_direct_io);
+	writer.SetCachePolicy(m_cache_policy);
+
+	// Checkpoint: chunk hoàn tất không theo thứ tự, bitmap trong journal cho phép ResumeDownload chỉ tải phần còn thiếu
+	CheckpointStore& checkpoints = CheckpointStore::Shared();
+	const uint64_t transfer_id = checkpoints.Begin(TransferDirection::DOWNLOAD, new_file_name, file_name,
+		file_id, file_size, static_cast<uint32_t>(chunk_size));
+
+	writer.SetFlushCallback([&checkpoints, transfer_id, file_size, chunk_size, &progress_mutex, &unflushed_chunks, &flushed_chunks]()
+		{
+			std::lock_guard<std::mutex> lock(progress_mutex);
+
+			for (uint32_t chunk_index : unflushed_chunks)
+			{
+				flushed_chunks.Set(chunk_index);
+			}
+
+			// Server không hỗ trợ bitmap thì resume tuần tự: vị trí chỉ tính phần liên tiếp từ đầu file
+			const uint64_t position = std::min<uint64_t>(file_size, static_cast<uint64_t>(flushed_chunks.GetCompletedPrefix()) * chunk_size);
+
+			for (uint32_t chunk_index : unflushed_chunks)
+			{
+				checkpoints.Progress(transfer_id, chunk_index, position);
+			}
+			unflushed_chunks.clear();
+		});
+
+	auto on_chunk_written = [&progress_mutex, &unflushed_chunks](uint32_t chunk_index)
+		{
+			std::lock_guard<std::mutex> lock(progress_mutex);
+			unflushed_chunks.push_back(chunk_index);
+		};
+
+	std::vector<std::unique_ptr<FileTransferClient>> workers;
+	const uint16_t wanted = static_cast<uint16_t>(std::min<uint64_t>(stripe_count, std::max<uint64_t>(chunk_count, 1)));
+
+	for (uint16_t s = 1; s < wanted; s++)
+	{
+		try
+		{
+			workers.push_back(GetSessionPool().Acquire());
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "Failed to open connection for stripe " << s << ": " << e.what() << std::endl;
+			break;
+		}
+	}
+
+	const uint16_t stripes = static_cast<uint16_t>(workers.size() + 1);
+
+	std::atomic<uint64_t> total_received{ 0 };
+	std::atomic<bool> cancelled{ false };
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	std::vector<std::future<bool>> results;
+	for (uint16_t s = 0; s < stripes; s++)
+	{
+		FileTransferClient* client = (s == 0) ? this : workers[s - 1].get();
+
+		results.push_back(std::async(std::launch::async,
+			[client, s, stripes, &writer, file_size, file_id, chunk_size, &total_received, &on_chunk_written, &cancelled]()
+			{
+				try
+				{
+					// Một stripe lỗi thì file không thể hoàn tất: dừng các stripe khác thay vì tải hết phần của chúng
+					if (!client->DownloadStripe(writer, file_size, file_id, chunk_size, s, stripes, total_received, on_chunk_written, cancelled))
+					{
+						cancelled = true;
+						return false;
+					}
+					return true;
+				}
+				catch (const std::exception& e)
+				{
+					std::cerr << "Stripe " << s << " failed: " << e.what() << std::endl;
+					cancelled = true;
+					return false;
+				}
+			}));
+	}
+
+	m_pb_manager->AddFile(new_file_name);
+
+	for (auto& result : results)
+	{
+		while (result.wait_for(std::chrono::milliseconds(200)) != std::future_status::ready)
+		{
+			float progress = (file_size > 0) ? (static_cast<float>(total_received.load()) / file_size) * 100.0f : 100.0f;
+			m_pb_manager->UpdateProgress(new_file_name, progress);
+		}
+	}
+
+	bool success = true;
+	for (size_t s = 0; s < results.size(); s++)
+	{
+		bool stripe_ok = results[s].get();
+		success = success && stripe_ok;
+
+		if (s > 0 && stripe_ok)
+		{
+			GetSessionPool().Release(std::move(workers[s - 1]));
+		}
+	}
+
+	// Close flush phần đã ghi nên checkpoint giữ được cả các chunk của lần tải thất bại
+	writer.Close();
+
+	if (!success)
+	{
+		std::cerr << "Striped download failed: " << file_name << std::endl;
+		std::cerr << "The downloaded chunks were saved, resume with transfer ID " << transfer_id << std::endl;
+		return false;
+	}
+
+	m_pb_manager->UpdateProgress(new_file_name, 100.0f);
+
+	// Validate checksum, hole trong file vừa ghi được băm như byte 0 mà không đọc lại
+	if (CHECKSUM_FLAG)
+	{
+		const AllocatedRanges written = AllocatedRanges::Query(new_file_name, file_size);
+		const std::vector<uint8_t>& file_checksum = FileChunkReader::Open(new_file_name, m_direct_io, m_cache_policy)->CalcCheckSum(
+			nullptr, written.HasHoles() ? &written : nullptr);
+		if (memcmp(file_checksum.data(), checksum.data(), 16) != 0)
+		{
+			std::cerr << "Checksum mismatch in the downloaded file." << std::endl;
+			return false;
+		}
+	}
+
+	auto end_time = std::chrono::steady_clock::now();
+	std::chrono::duration<double> total_duration = end_time - start_time;
+
+	std::cout << "Total time: " << std::fixed << std::setprecision(2) << total_duration.count() << " seconds" << std::endl;
+	double avg_speed = (total_received * 8.0) / (total_duration.count() * 1'000'000.0); // Mbps
+	std::cout << "Average speed: " << std::fixed << std::setprecision(2) << avg_speed << " Mbps" << std::endl;
+
+	checkpoints.Complete(transfer_id);
+
+	return true;
+}
+
+bool FileTransferClient::DownloadStripe(
+	DownloadFileWriter& writer,
+	uint64_t file_size,
+	uint32_t file_id,
+	size_t chunk_size,
+	uint16_t stripe_index,
+	uint16_t stripe_count,
+	std::atomic<uint64_t>& total_received,
+	const std::function<void(uint32_t)>& on_chunk_written,
+	const std::atomic<bool>& cancelled)
+{
+	const uint64_t chunk_count = (file_size + chunk_size - 1) / chunk_size;
+	const uint64_t expected_chunks = (chunk_count > stripe_index) ? (chunk_count - stripe_index + stripe_count - 1) / stripe_count : 0;
+
+	PacketStripeAttachRequest attachReq(file_id, StripeDirection::DOWNLOAD, stripe_index, stripe_count);
+
+	if (!m_connection->sendPacket(PacketType::STRIPE_ATTACH_REQUEST, attachReq))
+	{
+		throw std::runtime_error("Failed to send stripe attach request.");
+	}
+
+	PacketHeader header;
+	PacketStripeAttachResponse attachResp;
+
+	if (!m_connection->recvPacket(PacketType::STRIPE_ATTACH_RESPONSE, header, attachResp))
+	{
+		throw std::runtime_error("Failed to receive stripe attach response.");
+	}
+
+	if (!attachResp.attached || attachResp.file_id != file_id || attachResp.chunk_count != expected_chunks)
+	{
+		throw std::runtime_error("Server rejected stripe: " + attachResp.message);
+	}
+
+	std::vector<bool> received(expected_chunks, false);
+	std::unordered_map<uint32_t, int> retry_counts;
+	uint64_t received_chunks = 0;
+
+	while (received_chunks < expected_chunks)
+	{
+		if (cancelled)
+		{
+			return false;
+		}
+
+		PacketHeader chunkHeader;
+		PacketFileChunkView fileChunk;
+
+		if (!m_connection->recvPacket(PacketType::FILE_CHUNK, chunkHeader, fileChunk))
+		{
+			throw std::runtime_error("Failed to receive file chunk.");
+		}
+
+		const uint64_t offset = static_cast<uint64_t>(fileChunk.chunk_index) * chunk_size;
+
+		if (fileChunk.file_id != file_id ||
+			fileChunk.chunk_index % stripe_count != stripe_index ||
+			fileChunk.chunk_index >= chunk_count ||
+			offset + fileChunk.chunk_size > file_size)
+		{
+			throw std::runtime_error("Invalid file chunk for this stripe.");
+		}
+
+		bool checksum_valid = true;
+		if (CHECKSUM_FLAG)
+		{
+			uint8_t chunk_checksum[16];
+			md5_handler->calcCheckSum(fileChunk.data, fileChunk.chunk_size, chunk_checksum);
+
+			if (memcmp(chunk_checksum, fileChunk.checksum, 16) != 0)
+			{
+				std::cerr << "Checksum mismatch in chunk " << fileChunk.chunk_index << std::endl;
+				checksum_valid = false;
+			}
+		}
+
+		PacketFileChunkACK chunkACK(fileChunk.file_id, fileChunk.chunk_index, checksum_valid);
+
+		if (!m_connection->sendPacket(PacketType::FILE_CHUNK_ACK, chunkACK))
+		{
+			throw std::runtime_error("Failed to send chunk acknowledgment.");
+		}
+
+		if (!checksum_valid)
+		{
+			if (++retry_counts[fileChunk.chunk_index] >= 3)
+			{
+				std::cerr << "Max retries reached for chunk " << fileChunk.chunk_index << ". Aborting." << std::endl;
+				return false;
+			}
+			continue;
+		}
+
+		const uint64_t slot = fileChunk.chunk_index / stripe_count;
+		if (received[slot])
+		{
+			continue; // Chunk gửi lại sau khi ACK bị mất
+		}
+
+		writer.WriteAt(offset, fileChunk.data, fileChunk.chunk_size);
+		on_chunk_written(fileChunk.chunk_index);
+
+		received[slot] = true;
+		received_chunks++;
+		total_received += fileChunk.chunk_size;
+	}
+
+	return true;
+}
+
+bool FileTransferClient::DownloadRanges(
+	const std::string& file_name,
+	const std::vector<ByteRangeDTO>& ranges,
+	const std::string& output_path)
+{
+	if (ranges.empty())
+	{
+		throw std::invalid_argument("No byte range to download.");
+	}
+
+	PacketRangeDownloadRequest p_request(file_name, ranges);
+
+	if (!m_connection->sendPacket(PacketType::RANGE_DOWNLOAD_REQUEST, p_request))
+	{
+		throw std::runtime_error("Failed to send range download request.");
+	}
+
+	PacketHeader header;
+	PacketRangeDownloadResponse p_response;
+
+	if (!m_connection->recvPacket(PacketType::RANGE_DOWNLOAD_RESPONSE, header, p_response))
+	{
+		throw std::runtime_error("Failed to receive range download response.");
+	}
+
+	if (p_response.status != DownloadStatus::FILE_FOUND)
+	{
+		if (p_response.status == DownloadStatus::FILE_ACCESS_DENIED)
+			std::cerr << "Server denied the download. Message: " << p_response.message << std::endl;
+		else if (p_response.status == DownloadStatus::FILE_NOT_FOUND)
+			std::cerr << "Server does not find that file. Message: " << p_response.message << std::endl;
+		return false;
+	}
+
+	// Các đoạn trả về là offset tuyệt đối, chỉ cần kiểm tra chúng nằm trong file
+	uint64_t total_size = 0;
+	for (const auto& range : p_response.ranges)
+	{
+		if (range.from_end || range.offset > p_response.file_size || range.length > p_response.file_size - range.offset)
+		{
+			throw std::runtime_error("Server returned an invalid byte range.");
+		}
+		total_size += range.length;
+	}
+
+	std::cout << "File size: " << p_response.file_size << " bytes, downloading " << total_size << " bytes in "
+		<< p_response.ranges.size() << " range(s)." << std::endl;
+
+	// Ghi thẳng vào đúng offset của file đích, không xoá nội dung đã có, kích thước file được đặt bằng file trên server
+	// Offset của các đoạn không căn theo sector nên luôn ghi qua cache (chunk_size không dùng vì chỉ ghi bằng WriteAt)
+	const std::string target = output_path.empty() ? file_name : output_path;
+	DownloadFileWriter file(target, p_response.file_size, 0, m_flush_policy, false, false);
+	file.SetCachePolicy(m_cache_policy);
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	m_pb_manager->AddFile(target);
+
+	std::unordered_map<uint32_t, int> retry_counts;
+	uint64_t total_received = 0;
+	size_t range_index = 0;
+	uint64_t cursor = p_response.ranges.empty() ? 0 : p_response.ranges[0].offset;
+
+	while (total_received < total_size)
+	{
+		// Bỏ qua các đoạn rỗng hoặc đã nhận xong
+		while (cursor == p_response.ranges[range_index].offset + p_response.ranges[range_index].length)
+		{
+			range_index++;
+			cursor = p_response.ranges[range_index].offset;
+		}
+
+		const uint64_t range_end = p_response.ranges[range_index].offset + p_response.ranges[range_index].length;
+
+		PacketHeader chunkHeader;
+		PacketRangeChunk rangeChunk;
+
+		if (!m_connection->recvPacket(PacketType::RANGE_CHUNK, chunkHeader, rangeChunk))
+		{
+			throw std::runtime_error("Failed to receive range chunk.");
+		}
+
+		if (rangeChunk.file_id != p_response.file_id)
+		{
+			throw std::runtime_error("Invalid file ID in range chunk.");
+		}
+
+		// Server gửi các đoạn theo thứ tự, chunk gửi lại có cùng offset với chunk bị lỗi
+		if (rangeChunk.offset != cursor || rangeChunk.data_length == 0 || rangeChunk.data_length > range_end - cursor)
+		{
+			throw std::runtime_error("Range chunk does not match the expected offset.");
+		}
+
+		bool checksum_valid = true;
+		if (CHECKSUM_FLAG)
+		{
+			const std::vector<uint8_t>& chunk_checksum = md5_handler->calcCheckSum(rangeChunk.data);
+
+			if (memcmp(chunk_checksum.data(), rangeChunk.checksum, 16) != 0)
+			{
+				std::cerr << "Checksum mismatch in range chunk " << rangeChunk.sequence << std::endl;
+				checksum_valid = false;
+			}
+		}
+
+		PacketFileChunkACK chunkACK(rangeChunk.file_id, rangeChunk.sequence, checksum_valid);
+
+		if (!m_connection->sendPacket(PacketType::FILE_CHUNK_ACK, chunkACK))
+		{
+			throw std::runtime_error("Failed to send chunk acknowledgment.");
+		}
+
+		if (!checksum_valid)
+		{
+			if (++retry_counts[rangeChunk.sequence] >= 3)
+			{
+				std::cerr << "Max retries reached for range chunk " << rangeChunk.sequence << ". Aborting." << std::endl;
+				return false;
+			}
+			continue;
+		}
+
+		file.WriteAt(rangeChunk.offset, rangeChunk.data.data(), rangeChunk.data_length);
+
+		cursor += rangeChunk.data_length;
+		total_received += rangeChunk.data_length;
+
+		float progress = (static_cast<float>(total_received) / total_size) * 100.0f;
+		m_pb_manager->UpdateProgress(target, progress);
+	}
+
+	file.Close();
+
+	m_pb_manager->UpdateProgress(target, 100.0f);
+
+	auto end_time = std::chrono::steady_clock::now();
+	std::chrono::duration<double> total_duration = end_time - start_time;
+
+	std::cout << "Total time: " << std::fixed << std::setprecision(2) << total_duration.count() << " seconds" << std::endl;
+
+	return true;
+}
+
+bool  FileTransferClient::ResumeDownload(uint64_t transfer_id)
+{
+	CheckpointStore& checkpoints = CheckpointStore::Shared();
+	TransferState state;
+
+	if (!checkpoints.Get(transfer_id, state) || state.direction != TransferDirection::DOWNLOAD)
+	{
+		std::cerr << "No download checkpoint with ID " << transfer_id << std::endl;
+		return false;
+	}
+
+	const std::string& file_name = state.local_path;
+	uint32_t file_id_read = state.file_id;
+	uint64_t resume_position_read = state.position;
+	uint32_t last_chunk_index_read = state.chunk_index;
+	uint64_t file_size = state.file_size;
+	const uint32_t chunk_size = state.chunk_size;
+	ChunkBitmap completed = state.completed_chunks;
+
+	// File đích được đặt lại đúng file_size, không thể tiếp tục khi thiếu trạng thái
+	if (file_size == 0 || resume_position_read > file_size || !fs::exists(file_name))
+	{
+		std::cerr << "Invalid resume state for " << file_name << std::endl;
+		checkpoints.Abort(transfer_id);
+		return false;
+	}
+
+	// Prepare the download request, gửi kèm bitmap các chunk đã có để server chỉ gửi phần còn thiếu
+	PacketResumeRequest p_request(file_id_read, resume_position_read, last_chunk_index_read,
+		completed.GetChunkCount() > 0 ? completed.Encode() : std::vector<uint8_t>());
+
+	if (!m_connection->sendPacket(PacketType::RESUME_DOWNLOAD_REQUEST, p_request))
+	{
+		throw std::runtime_error("Failed to send download request.");
+	}
+
+	PacketHeader header;
+	PacketResumeResponse p_response;
+
+	if (!m_connection->recvPacket(PacketType::RESUME_RESPONSE, header, p_response))
+	{
+		throw std::runtime_error("Failed to receive download response.");
+	}
+
+	if (p_response.status != ResumeStatus::RESUME_SUPPORTED)
+	{
+		std::cerr << "Server is not support resuming this file. Message: " << p_response.resume_not_found.message << std::endl;
+
+		// If the resume state is invalid, then delete resume status of this file
+		checkpoints.Abort(transfer_id);
+		return false;
+	}
+
+	std::cout << "The server has allowed resuming download." << std::endl;
+	std::cout << "File id: " << p_response.resume_allowed.file_id << std::endl;
+	std::cout << "Resume position : " << p_response.resume_allowed.resume_position << std::endl;
+	std::cout << "Remainning chunk : " << p_response.resume_allowed.remaining_chunk_count << std::endl;
+
+	// Server có hỗ trợ bitmap thì chỉ gửi các chunk còn thiếu (không theo thứ tự), ngược lại gửi tuần tự từ resume_position
+	const bool bitmap_mode = !p_response.chunk_bitmap.empty() && completed.GetChunkCount() > 0;
+
+	// Receive file chunks
+	size_t total_received = resume_position_read;
+
+	std::vector<uint32_t> unflushed_chunks;
+	uint64_t written_position = total_received;
+
+	// Giữ lại phần đã tải, các chunk tiếp theo được ghi tại offset của chúng
+	DownloadFileWriter file(file_name, file_size, chunk_size, m_flush_policy, false, m_direct_io);
+	file.SetCachePolicy(m_cache_policy);
+
+	// Chỉ ghi tiến độ sau khi dữ liệu đã được flush xuống đĩa
+	file.SetFlushCallback([&checkpoints, transfer_id, &unflushed_chunks, &written_position]()
+		{
+			for (uint32_t chunk_index : unflushed_chunks)
+			{
+				checkpoints.Progress(transfer_id, chunk_index, written_position);
+			}
+			unflushed_chunks.clear();
+		});
+
+	auto start_time = std::chrono::steady_clock::now();
+	auto last_time = start_time;
+	size_t last_received = 0;
+
+	m_pb_manager->AddFile(file_name);
+
+	std::unordered_map<uint32_t, int> retry_counts;
 
 	while (p_response.resume_allowed.remaining_chunk_count-- > 0)
 	{
-		PacketHeader header;
-		PacketFileChunk fileChunk;
+		PacketHeader header;
+		PacketFileChunkView fileChunk;
+
+		if (!m_connection->recvPacket(PacketType::FILE_CHUNK, header, fileChunk))
+		{
+			throw std::runtime_error("Failed to receive file chunk.");
+		}
+
+		if (fileChunk.file_id != p_response.resume_allowed.file_id)
+		{
+			throw std::runtime_error("Invalid file ID in file chunk.");
+		}
+
+		if (bitmap_mode && fileChunk.chunk_index >= completed.GetChunkCount())
+		{
+			throw std::runtime_error("Invalid chunk index in file chunk.");
+		}
+
+
+		// Validate checksum
+		bool checksum_valid = true;
+		if (CHECKSUM_FLAG)
+		{
+			uint8_t chunk_checksum[16];
+			md5_handler->calcCheckSum(fileChunk.data, fileChunk.chunk_size, chunk_checksum);
+
+			if (memcmp(chunk_checksum, fileChunk.checksum, 16) != 0)
+			{
+				std::cerr << "Checksum mismatch in chunk " << fileChunk.chunk_index << std::endl;
+				checksum_valid = false;
+			}
+		}
+
+		// Acknowledge the chunk
+		PacketFileChunkACK chunkACK(
+			fileChunk.file_id,
+			fileChunk.chunk_index,
+			checksum_valid);
+
+		if (!m_connection->sendPacket(PacketType::FILE_CHUNK_ACK, chunkACK))
+		{
+			throw std::runtime_error("Failed to send chunk acknowledgment.");
+		}
+
+		if (checksum_valid)
+		{
+			// Write the chunk data to the file
+			if (bitmap_mode)
+			{
+				file.WriteChunk(fileChunk.chunk_index, fileChunk.data, fileChunk.chunk_size);
+				completed.Set(fileChunk.chunk_index);
+			}
+			else
+			{
+				file.WriteAt(total_received, fileChunk.data, fileChunk.chunk_size);
+			}
+
+			total_received += fileChunk.chunk_size;
+			unflushed_chunks.push_back(fileChunk.chunk_index);
+			written_position = total_received;
+
+			// Calculate download speed
+			auto current_time = std::chrono::steady_clock::now();
+			std::chrono::duration<double> elapsed = current_time - last_time;
+			size_t bytes_received_since_last = total_received - last_received;
+			double seconds = elapsed.count();
+
+			double speed_mbps = 0.0;
+			if (seconds > 0)
+			{
+				speed_mbps = (bytes_received_since_last * 8.0) / (seconds * 1'000'000.0); // Mbps
+			}
+
+			// Update time and bytes received
+			last_time = current_time;
+			last_received = total_received;
+
+			// Calculate progress
+			float progress = (static_cast<float>(total_received) / file_size) * 100.0f;
+			m_pb_manager->UpdateProgress(file_name, progress);
+
+		}
+		else
+		{
+			retry_counts[fileChunk.chunk_index]++;
+			if (retry_counts[fileChunk.chunk_index] >= 3)
+			{
+				std::cerr << "Max retries reached for chunk " << fileChunk.chunk_index << ". Aborting." << std::endl;
+				file.Close();
+				return false;
+			}
+
+			// Inform the user and wait before retrying
+			std::cerr << "\nRequesting retransmission of chunk " << fileChunk.chunk_index << " (Retry " << retry_counts[fileChunk.chunk_index] << ")" << std::endl;
+			// Optionally, add a delay before the next attempt
+			std::this_thread::sleep_for(std::chrono::milliseconds(500));
+		}
+	}
+	file.Close();
+
+	// Server gửi thiếu chunk: giữ checkpoint để lần sau tiếp tục
+	if (bitmap_mode && !completed.IsComplete())
+	{
+		std::cerr << "Download is still missing " << completed.GetMissingCount() << " chunks." << std::endl;
+		return false;
+	}
+
+	// Validate checksum
+	/*if (CHECKSUM_FLAG)
+	{
+		std::vector<uint8_t> file_checksum = md5Handler->calcCheckSumFile(filename);
+		if (memcmp(file_checksum.data(), checksum.data(), 16) != 0)
+		{
+			std::cerr << "Checksum mismatch in the downloaded file." << std::endl;
+			return false;
+		}
+	}*/
+
+	auto end_time = std::chrono::steady_clock::now();
+	std::chrono::duration<double> total_duration = end_time - start_time;
+
+	std::cout << "Total time: " << std::fixed << std::setprecision(2) << total_duration.count() << " seconds" << std::endl;
+	double avg_speed = (total_received * 8.0) / (total_duration.count() * 1'000'000.0); // Mbps
+	std::cout << "Average speed: " << std::fixed << std::setprecision(2) << avg_speed << " Mbps" << std::endl;
+
+	// If file download successful, then delete resume status of this file
+	checkpoints.Complete(transfer_id);
+
+	return true;
+}
+
+bool FileTransferClient::EnableLargePages()
+{
+	return AlignedBufferPool::Shared().EnableLargePages();
+}
+
+PathFilter FileTransferClient::LoadPathFilter(const fs::path& dir_path) const
+{
+	PathFilter filter;
+
+	for (const auto& rule : m_filter_rules)
+	{
+		filter.AddRule(rule);
+	}
+
+	// Luật trong thư mục được thêm sau nên thắng luật chung khi mâu thuẫn
+	const fs::path ignore_file = dir_path / PathFilter::IGNORE_FILE_NAME;
+	std::error_code ec;
+	if (fs::is_regular_file(ignore_file, ec) && !filter.LoadIgnoreFile(ignore_file))
+	{
+		std::cerr << "Failed to read filter rules: " << ignore_file.string() << std::endl;
+	}
+
+	return filter;
+}
+
+std::vector<uint32_t> FileTransferClient::ScanDirectory(const fs::path& dir_path, size_t total_files, FileTable& table, bool allow_empty)
+{
+	// Kiểm tra xem thư mục có tồn tại không
+	if (!fs::exists(dir_path) || !fs::is_directory(dir_path))
+	{
+		throw std::runtime_error("Directory does not exist or is not a valid directory: " + dir_path.string());
+	}
+
+	// Quét tất cả các file trong thư mục, các thư mục con được liệt kê song song
+	m_pb_manager->AddFile("Scan Directory");
+
+	const PathFilter filter = LoadPathFilter(dir_path);
+
+	DirectoryScanner scanner;
+	if (!filter.IsEmpty())
+	{
+		scanner.SetFilter(&filter);
+	}
+
+	scanner.Scan(dir_path,
+		[&table](size_t, const ScannedFile& file) { table.AddFile(file.directory, file.name, file.size, file.last_write_time); },
+		[this, total_files](size_t visited)
+		{
+			// Hiển thị tiến trình quét thư mục
+			float progress = (static_cast<float>(visited) / (std::max)(total_files, size_t(1))) * 100.0f;
+			m_pb_manager->UpdateProgress("Scan Directory", (std::min)(progress, 100.0f));
+		},
+		[&table](uint32_t parent, std::wstring_view name) { return table.AddDirectory(parent, name); });
+
+	m_pb_manager->Cleanup();
+
+	// Đảm bảo có file trong thư mục
+	if (table.GetFileCount() == 0 && !allow_empty)
+	{
+		throw std::runtime_error("No files found in the directory.");
+	}
+
+	// Sắp xếp file theo kích thước giảm dần
+	return table.SortBySizeDescending();
+}
+
+bool FileTransferClient::UploadDirectory(const fs::path& dir_path, size_t total_files)
+{
+	// Kiểm tra xem thư mục có tồn tại không
+	if (!fs::is_directory(dir_path))
+	{
+		std::cerr << "Failed to scan directory: Directory does not exist or is not a valid directory: " << dir_path.string() << std::endl;
+		return false;
+	}
+
+	is_uploading_directory = true;
+
+	std::vector<std::string> failed_files;
+
+	m_pb_manager->ShowTotalProgress(true, total_files);
+	size_t current_file_count = 0;
+
+	// Upload bắt đầu ngay khi tìm thấy file đầu tiên, việc quét tiếp tục trên thread nền
+	ScanStream stream(dir_path, LoadPathFilter(dir_path));
+	SmallFileLoader loader;
+
+	const FileTable& table = stream.GetTable();
+	std::vector<uint32_t> files;
+
+	while (stream.PopBatch(files, SMALL_FILE_BATCH_COUNT) > 0)
+	{
+		PartitionSmallFiles(table, files);
+
+		// Upload từng file (hoặc từng lô file nhỏ) trong danh sách
+		size_t completed = 0;
+		while (completed < files.size())
+		{
+			UploadNextEntries(loader, table, std::span<const uint32_t>(files).subspan(completed), failed_files, completed);
+
+			// Cập nhật tiến trình tổng, tổng số file được ước lượng lại theo tiến độ quét
+			m_pb_manager->SetTotalFiles(EstimateTotalFiles(stream, total_files));
+			m_pb_manager->UpdateTotalProgress(current_file_count + completed);
+		}
+
+		current_file_count += files.size();
+	}
+
+	m_pb_manager->SetTotalFiles(current_file_count);
+	m_pb_manager->UpdateTotalProgress(current_file_count);
+
+	is_uploading_directory = false;
+
+	if (!failed_files.empty())
+	{
+		std::cerr << "\n\nFailed to upload the following files:" << std::endl;
+
+		for (const auto& file : failed_files)
+		{
+			std::cerr << file << std::endl;
+		}
+	}
+
+	return FinishScan(stream);
+}
+
+bool FileTransferClient::UploadDirectoryParallel(const fs::path& dir_path, size_t total_files)
+{
+	// Kiểm tra xem thư mục có tồn tại không
+	if (!fs::is_directory(dir_path))
+	{
+		std::cerr << "Failed to scan directory: Directory does not exist or is not a valid directory: " << dir_path.string() << std::endl;
+		return false;
+	}
+
+	is_uploading_directory = true;
+
+	// Manifest được tạo ngay từ đầu, nếu lần trước bị gián đoạn thì nó cho biết phần việc đã xong
+	DirectoryManifest manifest(DirectoryManifest::PathFor(dir_path));
+	if (manifest.GetResumedCount() > 0)
+	{
+		std::cout << "Resuming interrupted directory upload: " << manifest.Count(ManifestFileState::DONE) << " of "
+			<< manifest.GetResumedCount() << " files already uploaded." << std::endl;
+	}
+
+	ScanStream stream(dir_path, LoadPathFilter(dir_path));
+	const FileTable& table = stream.GetTable();
+	TransferScheduler scheduler((std::max)(m_max_parallelism, size_t(1)));
+
+	std::vector<std::string> failed_files;
+	std::atomic<size_t> skipped_files = 0;
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	// Đóng gói kết quả quét thành work item ngay khi nhận được
+	std::thread feeder(
+		[&stream, &table, &scheduler, &manifest, &skipped_files]()
+		{
+			std::vector<uint32_t> files;
+			std::vector<uint32_t> remaining;
+			WorkItem small{ WorkKind::SMALL_BATCH, {}, 0, 0 };
+
+			while (stream.PopBatch(files, SMALL_FILE_BATCH_COUNT) > 0)
+			{
+				// Bỏ file đã xong và chưa thay đổi, file lớn đang upload dở được tiếp tục từ checkpoint
+				remaining.clear();
+				for (uint32_t file : files)
+				{
+					const uint64_t file_size = table.GetFileSize(file);
+					const ManifestFileState state = manifest.Add(table.GetRelativePath(file), file_size, table.GetLastWriteTime(file));
+
+					if (state == ManifestFileState::DONE)
+					{
+						skipped_files++;
+						continue;
+					}
+
+					if (state == ManifestFileState::IN_FLIGHT && file_size > INLINE_UPLOAD_THRESHOLD)
+					{
+						scheduler.Submit(WorkItem{ WorkKind::RESUME_FILE, { file }, file_size, 0 });
+						continue;
+					}
+
+					remaining.push_back(file);
+				}
+
+				SubmitWorkItems(scheduler, table, remaining, small);
+
+				// Không giữ lô dở dang khi hàng đợi quét đang trống, để worker không phải chờ
+				FlushSmallBatch(scheduler, small);
+			}
+
+			FlushSmallBatch(scheduler, small);
+			scheduler.Close();
+		});
+
+	RunDirectoryWorkers(table, scheduler, failed_files, &manifest);
+
+	// Dừng quét nếu các worker dừng sớm, các file chưa được nhận coi như lỗi
+	scheduler.Cancel();
+	stream.Cancel();
+	feeder.join();
+
+	for (const auto& item : scheduler.TakeRemaining())
+	{
+		for (uint32_t file : item.files)
+		{
+			failed_files.push_back(table.GetRelativePath(file));
+		}
+	}
+
+	is_uploading_directory = false;
+
+	auto end_time = std::chrono::steady_clock::now();
+
+	if (!failed_files.empty())
+	{
+		std::cerr << "\n\nFailed to upload the following files:" << std::endl;
+
+		for (const auto& file : failed_files)
+		{
+			std::cerr << "- " << file << std::endl;
+		}
+	}
+
+	std::chrono::duration<double> total_duration = end_time - start_time;
+
+	if (skipped_files > 0)
+	{
+		std::cout << "\n\nSkipped " << skipped_files << " files uploaded by the interrupted run." << std::endl;
+	}
+
+	std::cout << "\n\nTotal time: " << std::fixed << std::setprecision(2) << total_duration.count() << " seconds" << std::endl;
+
+	// Manifest chỉ được xoá khi cả cây đã được quét và mọi file đều đã lên server
+	if (stream.IsComplete() && failed_files.empty())
+	{
+		manifest.Remove();
+	}
+	else if (manifest.Flush())
+	{
+		std::cerr << "Upload state saved, upload the directory again to resume." << std::endl;
+	}
+
+	return FinishScan(stream);
+}
+
+void FileTransferClient::SubmitWorkItems(TransferScheduler& scheduler, const FileTable& table, std::span<const uint32_t> files, WorkItem& small)
+{
+	// File nhỏ gom thành lô, file lớn là một item riêng (chia stripe nếu đủ lớn)
+	for (uint32_t file : files)
+	{
+		const uint64_t file_size = table.GetFileSize(file);
+
+		if (file_size > INLINE_UPLOAD_THRESHOLD)
+		{
+			const WorkKind kind = file_size >= STRIPED_UPLOAD_THRESHOLD ? WorkKind::STRIPED_FILE : WorkKind::FILE;
+			scheduler.Submit(WorkItem{ kind, { file }, file_size, 0 });
+			continue;
+		}
+
+		if (small.files.size() >= SMALL_FILE_BATCH_COUNT || small.bytes + file_size > SMALL_FILE_BATCH_BYTES)
+		{
+			FlushSmallBatch(scheduler, small);
+		}
+
+		small.files.push_back(file);
+		small.bytes += file_size;
+	}
+}
+
+void FileTransferClient::FlushSmallBatch(TransferScheduler& scheduler, WorkItem& small)
+{
+	if (!small.files.empty())
+	{
+		scheduler.Submit(std::move(small));
+		small = WorkItem{ WorkKind::SMALL_BATCH, {}, 0, 0 };
+	}
+}
+
+void FileTransferClient::RunDirectoryWorkers(const FileTable& table, TransferScheduler& scheduler, std::vector<std::string>& failed_files,
+	DirectoryManifest* manifest)
+{
+	const size_t max_workers = (std::max)(m_max_parallelism, size_t(1));
+
+	ConcurrencyController controller(INITIAL_DIRECTORY_WORKERS, max_workers);
+	std::atomic<size_t> active_workers = controller.GetTarget();
+	std::mutex failed_files_mutex;
+
+	// Mỗi worker giữ một phiên từ pool, lấy item từ scheduler cho tới khi hết việc
+	// hoặc cho tới khi chỉ số của nó vượt quá số worker mà controller cho phép
+	SessionPool& pool = GetSessionPool();
+
+	auto run_worker = [&pool, &table, &scheduler, &active_workers, &failed_files, &failed_files_mutex, manifest](size_t i)
+			{
+				std::unique_ptr<FileTransferClient> session;
+				SmallFileLoader loader;
+				WorkItem item;
+				std::vector<std::string> item_failed;
+
+				// count file đầu item đã xử lý xong, file không nằm trong item_failed đã lên server
+				auto record_done = [&table, &item, &item_failed, manifest](size_t count)
+					{
+						if (!manifest)
+						{
+							return;
+						}
+
+						for (size_t f = 0; f < count; f++)
+						{
+							const std::string relative_path = table.GetRelativePath(item.files[f]);
+							if (std::find(item_failed.begin(), item_failed.end(), relative_path) == item_failed.end())
+							{
+								manifest->SetState(relative_path, ManifestFileState::DONE);
+							}
+						}
+					};
+
+				while (i < active_workers.load() && scheduler.Next(i, item))
+				{
+					size_t completed = 0;
+					item_failed.clear();
+
+					// File upload theo chunk có checkpoint riêng: đánh dấu để lần chạy sau tiếp tục thay vì upload lại từ đầu
+					if (manifest && item.kind != WorkKind::SMALL_BATCH)
+					{
+						manifest->SetState(table.GetRelativePath(item.files.front()), ManifestFileState::IN_FLIGHT);
+					}
+
+					try
+					{
+						if (!session)
+						{
+							session = pool.Acquire();
+						}
+
+						session->UploadWorkItem(loader, table, item, item_failed, completed);
+						record_done(item.files.size());
+						scheduler.Complete();
+					}
+					catch (const std::exception& e)
+					{
+						std::cerr << "Thread " << i << " failed: " << e.what() << std::endl;
+
+						// Phiên có thể đang lệch giao thức: bỏ phiên, phần chưa xong được worker khác làm lại
+						session.reset();
+						record_done(completed);
+						item.files.erase(item.files.begin(), item.files.begin() + completed);
+
+						if (!scheduler.Requeue(std::move(item)))
+						{
+							for (uint32_t file : item.files)
+							{
+								item_failed.push_back(table.GetRelativePath(file));
+							}
+							scheduler.Complete();
+						}
+					}
+
+					if (!item_failed.empty())
+					{
+						std::unique_lock<std::mutex> lock(failed_files_mutex);
+						failed_files.insert(failed_files.end(), item_failed.begin(), item_failed.end());
+					}
+				}
+
+				pool.Release(std::move(session));
+			};
+
+	std::vector<std::future<void>> workers(max_workers);
+
+	while (true)
+	{
+		size_t running = 0;
+		for (auto& worker : workers)
+		{
+			if (worker.valid() && worker.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+			{
+				worker.get();
+			}
+			running += worker.valid() ? 1 : 0;
+		}
 
-		if (!m_connection->recvPacket(PacketType::FILE_CHUNK, header, fileChunk))
+		if (running == 0 && scheduler.IsDone())
 		{
-			throw std::runtime_error("Failed to receive file chunk.");
+			break;
 		}
 
-		if (fileChunk.file_id != p_response.resume_allowed.file_id)
+		// Khởi động worker cho các vị trí còn trống trong giới hạn hiện tại, worker vượt giới hạn tự dừng sau item đang làm
+		active_workers = controller.Update();
+		for (size_t i = 0; i < active_workers.load(); ++i)
 		{
-			throw std::runtime_error("Invalid file ID in file chunk.");
+			if (!workers[i].valid())
+			{
+				workers[i] = std::async(std::launch::async, run_worker, i);
+			}
 		}
 
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	}
+}
 
-		// Validate checksum
-		bool checksum_valid = true;
-		if (CHECKSUM_FLAG)
+bool FileTransferClient::SyncDirectory(const fs::path& dir_path, size_t total_files)
+{
+	// Kiểm tra xem thư mục có tồn tại không
+	if (!fs::is_directory(dir_path))
+	{
+		std::cerr << "Failed to scan directory: Directory does not exist or is not a valid directory: " << dir_path.string() << std::endl;
+		return false;
+	}
+
+	SyncIndex index(SyncIndex::PathFor(dir_path));
+	FileTable table(dir_path);
+	std::vector<uint32_t> files;
+
+	try
+	{
+		files = ScanDirectory(dir_path, total_files, table);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Failed to scan directory: " << e.what() << std::endl;
+		return false;
+	}
+
+	// So sánh kết quả quét với chỉ mục: chỉ file đổi kích thước hoặc thời điểm ghi mới cần xem xét
+	std::unordered_set<std::string> seen;
+	std::unordered_map<uint32_t, SyncEntry> pending; // Trạng thái sẽ ghi vào chỉ mục khi file upload xong
+	std::vector<uint32_t> changed;
+	size_t unchanged = 0;
+	UploadChecksums checksums; // Checksum sẽ ghi vào chỉ mục, lấy từ lúc so sánh hoặc do chính lần upload tính
+
+	m_pb_manager->AddFile("Compare with sync index");
+
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		if (i % 1024 == 0)
 		{
-			std::vector<uint8_t> chunk_checksum = md5_handler->calcCheckSum(fileChunk.data);
+			m_pb_manager->UpdateProgress("Compare with sync index", static_cast<float>(i * 100.0f / files.size()));
+		}
+
+		const uint32_t file = files[i];
+		const std::string relative_path = table.GetRelativePath(file);
+		seen.insert(relative_path);
 
-			if (memcmp(chunk_checksum.data(), fileChunk.checksum, 16) != 0)
+		SyncEntry entry;
+		entry.size = table.GetFileSize(file);
+		entry.last_write_time = table.GetLastWriteTime(file);
+		entry.remote_path = relative_path;
+
+		SyncEntry previous;
+		const bool indexed = index.Find(relative_path, previous);
+
+		if (indexed)
+		{
+			if (previous.size == entry.size && previous.last_write_time == entry.last_write_time)
 			{
-				std::cerr << "Checksum mismatch in chunk " << fileChunk.chunk_index << std::endl;
-				checksum_valid = false;
+				unchanged++;
+				continue;
 			}
-		}
 
-		// Acknowledge the chunk
-		PacketFileChunkACK chunkACK(
-			fileChunk.file_id,
-			fileChunk.chunk_index,
-			checksum_valid);
+			// Kích thước đổi thì nội dung chắc chắn đã đổi; chỉ hash khi kích thước trùng để nhận ra file chỉ đổi thời điểm ghi
+			// (touch, khôi phục bản cũ), các file còn lại lấy checksum do chính lần upload tính
+			if (entry.size > 0 && previous.size == entry.size)
+			{
+				try
+				{
+					const std::vector<uint8_t> checksum = FileChunkReader::Open(table.GetAbsolutePath(file), m_direct_io, m_cache_policy)->CalcCheckSum();
+					if (checksum.size() == entry.content_hash.size())
+					{
+						std::copy(checksum.begin(), checksum.end(), entry.content_hash.begin());
+						entry.has_hash = true;
+					}
+				}
+				catch (const std::exception&)
+				{
+					// Không đọc được lúc này: upload sẽ báo lỗi nếu file vẫn không đọc được
+				}
+			}
 
-		if (!m_connection->sendPacket(PacketType::FILE_CHUNK_ACK, chunkACK))
+			const bool same_content = previous.size == entry.size &&
+				(entry.size == 0 || (previous.has_hash && entry.has_hash && previous.content_hash == entry.content_hash));
+
+			if (same_content)
+			{
+				entry.file_id = previous.file_id;
+				index.Put(relative_path, entry);
+				unchanged++;
+				continue;
+			}
+		}
+
+		// File nhỏ được hash sẵn khi gửi inline; file lớn mới chưa có trong chỉ mục không bị đọc thêm một lần chỉ để hash
+		if (entry.has_hash)
 		{
-			throw std::runtime_error("Failed to send chunk acknowledgment.");
+			checksums.emplace(file, entry.content_hash);
+		}
+		else if (indexed || entry.size <= INLINE_UPLOAD_THRESHOLD)
+		{
+			checksums.emplace(file, std::nullopt);
 		}
 
-		if (checksum_valid)
+		changed.push_back(file);
+		pending.emplace(file, std::move(entry));
+	}
+
+	m_pb_manager->Cleanup();
+
+	const size_t removed = index.Retain(seen);
+
+	std::cout << "New or changed: " << changed.size() << ", unchanged: " << unchanged
+		<< ", removed since last sync: " << removed << std::endl;
+
+	is_uploading_directory = true;
+
+	std::vector<std::string> failed_files;
+
+	m_pb_manager->ShowTotalProgress(true, changed.size());
+
+	SmallFileLoader loader;
+	PartitionSmallFiles(table, changed);
+
+	auto last_save = std::chrono::steady_clock::now();
+	size_t completed = 0;
+
+	try
+	{
+		while (completed < changed.size())
 		{
-			// Write the chunk data to the file
-			file.write(reinterpret_cast<const char*>(fileChunk.data.data()), fileChunk.chunk_size);
-			file.flush();
+			const size_t first = completed;
+			const size_t failed_before = failed_files.size();
 
-			total_received += fileChunk.chunk_size;
+			UploadNextEntries(loader, table, std::span<const uint32_t>(changed).subspan(completed), failed_files, completed, &checksums);
 
-			resume_out.seekp(0);
-			resume_out.write(reinterpret_cast<const char*>(&len), sizeof(len));
-			resume_out.write(reinterpret_cast<const char*>(temp.data()), sizeof(char) * len);
-			resume_out.write(reinterpret_cast<const char*>(&p_response.resume_allowed.file_id), sizeof(p_response.resume_allowed.file_id));
-			resume_out.write(reinterpret_cast<const char*>(&total_received), sizeof(total_received));
-			resume_out.write(reinterpret_cast<const char*>(&fileChunk.chunk_index), sizeof(fileChunk.chunk_index));
-			resume_out.write(reinterpret_cast<const char*>(&file_size), sizeof(file_size));
+			// Ghi nhận các file vừa upload thành công
+			const std::unordered_set<std::string> failed(failed_files.begin() + failed_before, failed_files.end());
 
-			// Calculate download speed
-			auto current_time = std::chrono::steady_clock::now();
-			std::chrono::duration<double> elapsed = current_time - last_time;
-			size_t bytes_received_since_last = total_received - last_received;
-			double seconds = elapsed.count();
+			for (size_t i = first; i < completed; i++)
+			{
+				SyncEntry& entry = pending.at(changed[i]);
 
-			double speed_mbps = 0.0;
-			if (seconds > 0)
+				if (!failed.contains(entry.remote_path))
+				{
+					if (const UploadChecksum* checksum = ChecksumOf(&checksums, changed[i]); !entry.has_hash && checksum && *checksum)
+					{
+						entry.content_hash = **checksum;
+						entry.has_hash = true;
+					}
+
+					entry.file_id = SyncIndex::QueryFileId(table.GetAbsolutePath(changed[i]));
+					index.Put(entry.remote_path, entry);
+				}
+			}
+
+			// Lưu định kỳ để lần sync bị ngắt không phải upload lại những file đã xong
+			if (std::chrono::steady_clock::now() - last_save >= SYNC_INDEX_SAVE_INTERVAL)
 			{
-				speed_mbps = (bytes_received_since_last * 8.0) / (seconds * 1'000'000.0); // Mbps
+				index.Save();
+				last_save = std::chrono::steady_clock::now();
 			}
 
-			// Update time and bytes received
-			last_time = current_time;
-			last_received = total_received;
+			m_pb_manager->UpdateTotalProgress(completed);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Sync interrupted: " << e.what() << std::endl;
 
-			// Calculate progress
-			float progress = (static_cast<float>(total_received) / file_size) * 100.0f;
-			m_pb_manager->UpdateProgress(file_name, progress);
+		is_uploading_directory = false;
+		index.Save();
+		return false;
+	}
+
+	is_uploading_directory = false;
+
+	if (!failed_files.empty())
+	{
+		std::cerr << "\n\nFailed to upload the following files:" << std::endl;
 
+		for (const auto& file : failed_files)
+		{
+			std::cerr << file << std::endl;
 		}
-		else
+	}
+
+	return index.Save();
+}
+
+bool FileTransferClient::MirrorDirectory(const fs::path& dir_path, size_t total_files)
+{
+	// Kiểm tra xem thư mục có tồn tại không
+	if (!fs::is_directory(dir_path))
+	{
+		std::cerr << "Failed to scan directory: Directory does not exist or is not a valid directory: " << dir_path.string() << std::endl;
+		return false;
+	}
+
+	std::vector<FileEntryDTO> listing;
+	if (!GetServerFileList(listing))
+	{
+		std::cerr << "Failed to get the file list from the server." << std::endl;
+		return false;
+	}
+
+	// Chỉ so sánh với các file nằm dưới thư mục cùng tên trên server, file bị lọc ở local cũng không được tải về
+	const PathFilter filter = LoadPathFilter(dir_path);
+	const std::string root_prefix = SyncPlanner::NormalizePath(fs::relative(dir_path, dir_path.parent_path()).string()) + "/";
+
+	std::vector<RemoteFile> remote_files;
+	for (const auto& entry : listing)
+	{
+		if (entry.IsDirectory())
 		{
-			retry_counts[fileChunk.chunk_index]++;
-			if (retry_counts[fileChunk.chunk_index] >= 3)
+			continue;
+		}
+
+		// Tuỳ server, file_path có thể đã gồm tên file
+		std::string remote_path = SyncPlanner::NormalizePath(entry.GetFilePath());
+		const std::string name = entry.GetFileName();
+
+		if (remote_path != name && !remote_path.ends_with("/" + name))
+		{
+			remote_path = remote_path.empty() ? name : remote_path + "/" + name;
+		}
+
+		if (!remote_path.starts_with(root_prefix) || filter.IsExcludedPath(fs::path(remote_path.substr(root_prefix.size())), false))
+		{
+			continue;
+		}
+
+		// Đường dẫn do server gửi: không cho phép ghi ra ngoài thư mục đang mirror
+		const fs::path target = (dir_path.parent_path() / fs::path(remote_path)).lexically_normal();
+		const fs::path inside = target.lexically_relative(dir_path.lexically_normal());
+
+		if (!SyncPlanner::IsSafeRelativePath(remote_path) || inside.empty() || *inside.begin() == "..")
+		{
+			std::cerr << "Ignoring unsafe path from server: " << remote_path << std::endl;
+			continue;
+		}
+
+		RemoteFile remote;
+		remote.remote_path = std::move(remote_path);
+		remote.size = entry.file_size;
+		remote.has_checksum = entry.HasChecksum();
+		std::copy(std::begin(entry.checksum), std::end(entry.checksum), remote.checksum.begin());
+
+		remote_files.push_back(std::move(remote));
+	}
+
+	SyncIndex index(SyncIndex::PathFor(dir_path));
+	FileTable table(dir_path);
+	std::vector<uint32_t> files;
+
+	try
+	{
+		files = ScanDirectory(dir_path, total_files, table, true);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Failed to scan directory: " << e.what() << std::endl;
+		return false;
+	}
+
+	// Hash của file local chỉ được tính khi kích thước trùng với bản trên server, giữ lại để ghi vào chỉ mục
+	std::unordered_map<uint32_t, std::array<uint8_t, 16>> local_hashes;
+
+	SyncPlanner planner(table, &index,
+		[this, &table, &local_hashes](uint32_t file, std::array<uint8_t, 16>& out_hash)
+		{
+			try
+			{
+				const std::vector<uint8_t> checksum = FileChunkReader::Open(table.GetAbsolutePath(file), m_direct_io, m_cache_policy)->CalcCheckSum();
+				if (checksum.size() != out_hash.size())
+				{
+					return false;
+				}
+
+				std::copy(checksum.begin(), checksum.end(), out_hash.begin());
+				local_hashes[file] = out_hash;
+				return true;
+			}
+			catch (const std::exception&)
 			{
-				std::cerr << "Max retries reached for chunk " << fileChunk.chunk_index << ". Aborting." << std::endl;
-				file.close();
 				return false;
 			}
+		});
 
-			// Inform the user and wait before retrying
-			std::cerr << "\nRequesting retransmission of chunk " << fileChunk.chunk_index << " (Retry " << retry_counts[fileChunk.chunk_index] << ")" << std::endl;
-			// Optionally, add a delay before the next attempt
-			std::this_thread::sleep_for(std::chrono::milliseconds(500));
-		}
-	}
-	resume_out.close();
-	file.close();
+	const SyncPlan plan = planner.Build(files, remote_files);
 
-	// Validate checksum
-	/*if (CHECKSUM_FLAG)
+	std::cout << "Upload: " << plan.Count(SyncAction::UPLOAD) << " files (" << plan.Bytes(SyncAction::UPLOAD) << " bytes)"
+		<< ", download: " << plan.Count(SyncAction::DOWNLOAD) << " files (" << plan.Bytes(SyncAction::DOWNLOAD) << " bytes)"
+		<< ", unchanged: " << plan.Count(SyncAction::SKIP)
+		<< ", deleted: " << plan.Count(SyncAction::DELETED)
+		<< ", conflicts: " << plan.Count(SyncAction::CONFLICT) << std::endl;
+
+	std::vector<uint32_t> uploads;
+	for (const auto& entry : plan.entries)
 	{
-		std::vector<uint8_t> file_checksum = md5Handler->calcCheckSumFile(filename);
-		if (memcmp(file_checksum.data(), checksum.data(), 16) != 0)
+		if (entry.action == SyncAction::UPLOAD)
 		{
-			std::cerr << "Checksum mismatch in the downloaded file." << std::endl;
-			return false;
+			uploads.push_back(entry.local_file);
 		}
-	}*/
+	}
 
-	auto end_time = std::chrono::steady_clock::now();
-	std::chrono::duration<double> total_duration = end_time - start_time;
+	std::vector<std::string> failed_files;
 
-	std::cout << "Total time: " << std::fixed << std::setprecision(2) << total_duration.count() << " seconds" << std::endl;
-	double avg_speed = (total_received * 8.0) / (total_duration.count() * 1'000'000.0); // Mbps
-	std::cout << "Average speed: " << std::fixed << std::setprecision(2) << avg_speed << " Mbps" << std::endl;
+	// Upload qua TransferScheduler như UploadDirectoryParallel
+	if (!uploads.empty())
+	{
+		is_uploading_directory = true;
 
-	// If file download successful, then delete resume status of this file
-	pathResolver.DeleteFileWithName(check_point_path);
+		TransferScheduler scheduler((std::max)(m_max_parallelism, size_t(1)));
 
-	return true;
-}
+		std::thread feeder(
+			[&scheduler, &table, &uploads]()
+			{
+				WorkItem small{ WorkKind::SMALL_BATCH, {}, 0, 0 };
 
-std::vector<FileTransferClient::FileEntry> FileTransferClient::ScanDirectory(const fs::path& dir_path, size_t total_files)
-{
-	// Quét thư mục và lưu các file vào danh sách file entries
-	std::vector<FileEntry> fileEntries;
-	std::error_code ec;
+				SubmitWorkItems(scheduler, table, uploads, small);
+				FlushSmallBatch(scheduler, small);
+				scheduler.Close();
+			});
 
-	// Kiểm tra xem thư mục có tồn tại không
-	if (!fs::exists(dir_path) || !fs::is_directory(dir_path))
-	{
-		throw std::runtime_error("Directory does not exist or is not a valid directory: " + dir_path.string());
+		RunDirectoryWorkers(table, scheduler, failed_files);
+
+		scheduler.Cancel();
+		feeder.join();
+
+		for (const auto& item : scheduler.TakeRemaining())
+		{
+			for (uint32_t file : item.files)
+			{
+				failed_files.push_back(table.GetRelativePath(file));
+			}
+		}
+
+		is_uploading_directory = false;
 	}
 
-	// Quét tất cả các file trong thư mục
-	m_pb_manager->AddFile("Scan Directory");
-	FileEntry file_entry{};
-	size_t current_file_count = 0;
+	// Tải về tuần tự trên kết nối chính, file local cũ (nếu có) bị thay thế
+	std::unordered_set<std::string> failed_downloads;
 
-	for (const auto& entry : fs::recursive_directory_iterator(dir_path, fs::directory_options::skip_permission_denied, ec))
+	for (const auto& entry : plan.entries)
 	{
-		if (ec) // Nếu gặp lỗi trong quá trình quét thư mục
+		if (entry.action != SyncAction::DOWNLOAD)
+		{
+			continue;
+		}
+
+		const fs::path local_path = dir_path.parent_path() / fs::path(entry.path).make_preferred();
+
+		try
 		{
-			throw std::runtime_error("Error scanning directory: " + ec.message());
+			if (!DownloadFile(remote_files[entry.remote_file].remote_path, local_path.string()))
+			{
+				failed_downloads.insert(entry.path);
+			}
 		}
-
-		if (fs::is_regular_file(entry)) // Kiểm tra nếu là file
+		catch (const std::exception& e)
 		{
-			file_entry.absolute_path = entry.path().string();
-			file_entry.relative_path = fs::relative(entry.path(), dir_path.parent_path()).string();
-			file_entry.file_name = entry.path().filename().string();
-			file_entry.file_size = fs::file_size(entry);
-
-			fileEntries.emplace_back(file_entry);
+			std::cerr << "Failed to download " << entry.path << ": " << e.what() << std::endl;
+			failed_downloads.insert(entry.path);
 		}
-
-		current_file_count++;
-
-		// Hiển thị tiến trình quét thư mục
-		float progress = (static_cast<float>(current_file_count) / total_files) * 100.0f;
-		m_pb_manager->UpdateProgress("Scan Directory", progress);
 	}
 
-	m_pb_manager->Cleanup();
+	// Ghi trạng thái hai bên đã giống nhau vào chỉ mục, bản ghi của file xung đột được giữ nguyên cho lần sau
+	const std::unordered_set<std::string> failed_uploads(failed_files.begin(), failed_files.end());
+	std::unordered_set<std::string> seen;
 
-	// Đảm bảo có file trong thư mục
-	if (fileEntries.empty())
+	for (const auto& entry : plan.entries)
 	{
-		throw std::runtime_error("No files found in the directory.");
-	}
+		const std::string relative_path = entry.local_file != SyncPlanner::NO_LOCAL_FILE
+			? table.GetRelativePath(entry.local_file)
+			: fs::path(entry.path).make_preferred().string();
+		seen.insert(relative_path);
 
-	// Sắp xếp file theo kích thước giảm dần
-	std::stable_sort(fileEntries.begin(), fileEntries.end(),
-		[](const FileEntry& a, const FileEntry& b) {
-			return a.file_size > b.file_size;
-		});
+		const RemoteFile* remote = entry.remote_file != SyncPlanner::NO_REMOTE_FILE ? &remote_files[entry.remote_file] : nullptr;
+		const fs::path local_path = dir_path.parent_path() / fs::path(relative_path);
 
-	return fileEntries;
-}
+		SyncEntry synced;
+		synced.remote_path = remote ? remote->remote_path : relative_path;
 
-bool FileTransferClient::UploadDirectory(const fs::path& dir_path, size_t total_files)
-{
-	// Quét thư mục và lưu các file vào danh sách file entries
-	std::vector<FileEntry> fileEntries;
-	try
-	{
-		fileEntries = ScanDirectory(dir_path, total_files);
-	}
-	catch (const std::exception& e)
-	{
-		std::cerr << "Failed to scan directory: " << e.what() << std::endl;
-		return false;
-	}
+		switch (entry.action)
+		{
+		case SyncAction::UPLOAD:
+		case SyncAction::SKIP:
+		{
+			if (entry.action == SyncAction::UPLOAD && failed_uploads.contains(relative_path))
+			{
+				continue;
+			}
 
-	is_uploading_directory = true;
+			synced.size = table.GetFileSize(entry.local_file);
+			synced.last_write_time = table.GetLastWriteTime(entry.local_file);
 
-	std::vector<std::string> failed_files;
+			auto hash = local_hashes.find(entry.local_file);
+			SyncEntry previous;
 
-	m_pb_manager->ShowTotalProgress(true, total_files);
-	size_t current_file_count = 0;
+			if (hash != local_hashes.end())
+			{
+				synced.content_hash = hash->second;
+				synced.has_hash = true;
+			}
+			else if (entry.action == SyncAction::SKIP && remote && remote->has_checksum)
+			{
+				synced.content_hash = remote->checksum;
+				synced.has_hash = true;
+			}
+			else if (index.Find(relative_path, previous) && previous.has_hash &&
+				previous.size == synced.size && previous.last_write_time == synced.last_write_time)
+			{
+				synced.content_hash = previous.content_hash;
+				synced.has_hash = true;
+			}
+			break;
+		}
+		case SyncAction::DOWNLOAD:
+		{
+			if (failed_downloads.contains(entry.path) || !SyncIndex::Stat(local_path, synced))
+			{
+				continue;
+			}
 
-	// Upload từng file trong danh sách
-	for (const auto& fileEntry : fileEntries)
+			// DownloadFile đã kiểm tra nội dung với checksum của server
+			synced.has_hash = remote->has_checksum;
+			synced.content_hash = remote->checksum;
+			break;
+		}
+		case SyncAction::CONFLICT:
+		case SyncAction::DELETED:
+			// Giữ bản ghi cũ để lần sau vẫn nhận ra đây là file đã bị xoá, không phải file mới
+			continue;
+		}
+
+		synced.file_id = SyncIndex::QueryFileId(local_path);
+		index.Put(relative_path, synced);
+	}
+
+	index.Retain(seen);
+
+	if (!failed_files.empty() || !failed_downloads.empty())
 	{
-		if (!UploadFile(fileEntry.absolute_path, fileEntry.relative_path))
+		std::cerr << "\n\nFailed to transfer the following files:" << std::endl;
+
+		for (const auto& file : failed_files)
 		{
-			failed_files.push_back(fileEntry.relative_path);
+			std::cerr << "- " << file << std::endl;
 		}
 
-		// Cập nhật tiến trình tổng
-		m_pb_manager->UpdateTotalProgress(++current_file_count);
-
-		std::this_thread::sleep_for(std::chrono::milliseconds(150)); // Delay 150ms
+		for (const auto& file : failed_downloads)
+		{
+			std::cerr << "- " << file << std::endl;
+		}
 	}
 
-	m_pb_manager->UpdateTotalProgress(total_files);
+	if (plan.Count(SyncAction::CONFLICT) > 0)
+	{
+		std::cerr << "\nConflicts (changed on both sides, left untouched):" << std::endl;
 
-	is_uploading_directory = false;
+		for (const auto& entry : plan.entries)
+		{
+			if (entry.action != SyncAction::CONFLICT)
+			{
+				continue;
+			}
 
-	if (!failed_files.empty())
+			if (entry.local_file == SyncPlanner::NO_LOCAL_FILE)
+			{
+				std::cerr << "- " << entry.path << " (deleted locally, changed on server)" << std::endl;
+			}
+			else if (entry.remote_file == SyncPlanner::NO_REMOTE_FILE)
+			{
+				std::cerr << "- " << entry.path << " (changed locally, deleted on server)" << std::endl;
+			}
+			else
+			{
+				std::cerr << "- " << entry.path << " (local " << entry.local_size << " bytes, server " << entry.remote_size << " bytes)" << std::endl;
+			}
+		}
+	}
+
+	if (plan.Count(SyncAction::DELETED) > 0)
 	{
-		std::cerr << "\n\nFailed to upload the following files:" << std::endl;
+		std::cout << "\nDeleted on one side since the last sync (not copied back):" << std::endl;
 
-		for (const auto& file : failed_files)
+		for (const auto& entry : plan.entries)
 		{
-			std::cerr << file << std::endl;
+			if (entry.action == SyncAction::DELETED)
+			{
+				std::cout << "- " << entry.path << (entry.local_file == SyncPlanner::NO_LOCAL_FILE ? " (deleted locally)" : " (deleted on server)") << std::endl;
+			}
 		}
 	}
 
-	return true;
+	const bool saved = index.Save();
+	return saved && failed_files.empty() && failed_downloads.empty();
 }
 
-bool FileTransferClient::UploadDirectoryParallel(const fs::path& dir_path, size_t total_files)
+bool FileTransferClient::WatchDirectory(const fs::path& dir_path, std::stop_token stop)
 {
-	// Quét thư mục và lưu các file vào danh sách file entries
-	std::vector<FileEntry> fileEntries;
+	// Kiểm tra xem thư mục có tồn tại không
+	if (!fs::is_directory(dir_path))
+	{
+		std::cerr << "Failed to watch directory: Directory does not exist or is not a valid directory: " << dir_path.string() << std::endl;
+		return false;
+	}
+
+	// Bắt đầu theo dõi trước khi sync để không bỏ lỡ thay đổi xảy ra trong lúc sync
+	DirectoryWatcher watcher(dir_path);
+
 	try
 	{
-		fileEntries = ScanDirectory(dir_path, total_files);
+		watcher.Start();
 	}
 	catch (const std::exception& e)
 	{
-		std::cerr << "Failed to scan directory: " << e.what() << std::endl;
+		std::cerr << e.what() << std::endl;
 		return false;
 	}
 
-	const auto& server_info = m_connection->GetServerInfo();
-	const auto& credential_info = m_session_manager->GetUserCredential();
+	std::stop_callback on_stop(stop, [&watcher]() { watcher.Stop(); });
 
-	is_uploading_directory = true;
-	const size_t num_clients = 4;
+	// Đưa server về trạng thái hiện tại một lần, sau đó chỉ xử lý các đường dẫn có sự kiện
+	if (!SyncDirectory(dir_path, 0))
+	{
+		std::cerr << "Initial sync failed, continuing with change notifications." << std::endl;
+	}
+
+	SyncIndex index(SyncIndex::PathFor(dir_path));
+	const fs::path root_name = fs::relative(dir_path, dir_path.parent_path());
+	PathFilter filter = LoadPathFilter(dir_path);
 
-	// Distribute files evenly among clients
-	std::vector<std::vector<FileEntry>> clientFileEntries(num_clients);
+	// Một phiên trong pool được giữ suốt thời gian theo dõi, chỉ mở lại khi phiên bị lỗi
+	SessionPool& pool = GetSessionPool();
+	std::unique_ptr<FileTransferClient> session;
 
-	size_t filesPerClient = fileEntries.size() / 4;
-	size_t remainingFiles = fileEntries.size() % 4;
-	size_t startIndex = 0;
+	std::vector<fs::path> changes;
+	bool overflowed = false;
 
-	for (size_t i = 0; i < num_clients; ++i)
+	while (watcher.WaitForChanges(changes, overflowed))
 	{
-		size_t endIndex = startIndex + filesPerClient;
-		if (remainingFiles > 0)
+		if (overflowed)
 		{
-			++endIndex;
-			--remainingFiles;
+			// Hệ thống đã bỏ sự kiện: chỉ quét lại khi thực sự cần, chỉ mục giúp bỏ qua các file không đổi
+			std::cerr << "Change notifications overflowed, rescanning " << dir_path.string() << std::endl;
+			SyncDirectory(dir_path, 0);
+			index.Reload();
+			continue;
 		}
-		clientFileEntries[i].assign(fileEntries.begin() + startIndex, fileEntries.begin() + endIndex);
-		startIndex = endIndex;
-	}
-
-	is_uploading_directory = true;
 
-	std::vector<std::string> failed_files;
-	std::mutex failed_files_mutex;
+		// Luật lọc đổi thì áp dụng cho các sự kiện từ nay về sau
+		for (const auto& change : changes)
+		{
+			if (change == fs::path(PathFilter::IGNORE_FILE_NAME))
+			{
+				filter = LoadPathFilter(dir_path);
+				break;
+			}
+		}
 
-	auto start_time = std::chrono::steady_clock::now();
+		// Thư mục mới (hoặc được chuyển vào) chỉ sinh một sự kiện cho chính nó: lấy các file bên trong
+		std::vector<fs::path> candidates;
+		for (const auto& change : changes)
+		{
+			const fs::path path = dir_path / change;
+			std::error_code ec;
 
-	// Start the threads
-	std::vector<std::thread> threads;
-	for (size_t i = 0; i < num_clients; ++i)
-	{
-		std::thread t(
-			[this, i, &failed_files, &failed_files_mutex, &clientFileEntries, &server_info, &credential_info]()
+			if (fs::is_directory(path, ec))
 			{
-				try
+				if (filter.IsExcludedPath(change, true))
 				{
-					std::unique_ptr<FileTransferClient> client = std::make_unique<FileTransferClient>();
-
-					client->GetConnection().Disconnect();
-
-					std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Delay 100ms
-
-					client->GetSessionManager().ResetSession();
-
-					client->GetConnection().Connect(server_info.first, server_info.second);
+					continue;
+				}
 
-					std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Delay 100ms
+				for (auto it = fs::recursive_directory_iterator(path, fs::directory_options::skip_permission_denied, ec);
+					!ec && it != fs::recursive_directory_iterator(); it.increment(ec))
+				{
+					const bool is_directory = it->is_directory(ec);
 
-					if (!client->GetConnection().IsConnected())
+					if (filter.IsExcludedPath(fs::relative(it->path(), dir_path), is_directory))
 					{
-						throw std::runtime_error("Failed to connect to the server.");
+						// Không duyệt vào thư mục bị loại
+						if (is_directory)
+						{
+							it.disable_recursion_pending();
+						}
+						continue;
 					}
 
-					if (!client->GetSessionManager().PerformHandshake())
+					if (it->is_regular_file(ec))
 					{
-						throw std::runtime_error("Failed to perform handshake.");
+						candidates.push_back(it->path());
 					}
+				}
+			}
+			else if (fs::is_regular_file(path, ec) && !filter.IsExcludedPath(change, false))
+			{
+				candidates.push_back(path);
+			}
+		}
 
-					std::this_thread::sleep_for(std::chrono::milliseconds(500)); // Delay 500ms
+		size_t uploaded = 0;
+		is_uploading_directory = true;
 
-					if (!client->GetSessionManager().PerformAuthentication(credential_info.first, credential_info.second))
-					{
-						throw std::runtime_error("Failed to authenticate.");
-					}
+		for (const auto& path : candidates)
+		{
+			const std::string relative_path = (root_name / fs::relative(path, dir_path)).string();
 
-					std::this_thread::sleep_for(std::chrono::milliseconds(500)); // Delay 500ms
+			// Sự kiện không kèm thay đổi nội dung (đã upload ở lần trước, chỉ đổi thuộc tính...) được bỏ qua
+			SyncEntry current;
+			SyncEntry previous;
+			if (!SyncIndex::Stat(path, current) ||
+				(index.Find(relative_path, previous) && previous.size == current.size && previous.last_write_time == current.last_write_time))
+			{
+				continue;
+			}
 
-					system("cls");
+			try
+			{
+				if (!session)
+				{
+					session = pool.Acquire();
+				}
 
-					for (const auto& fileEntry : clientFileEntries[i])
-					{
-						if (!client->UploadFile(fileEntry.absolute_path, fileEntry.relative_path))
-						{
-							std::unique_lock<std::mutex> lock(failed_files_mutex);
-							failed_files.push_back(fileEntry.relative_path);
-						}
+				if (!session->UploadFile(path, relative_path))
+				{
+					std::cerr << "Failed to upload " << relative_path << std::endl;
+					continue;
+				}
+			}
+			catch (const std::exception& e)
+			{
+				// File có thể vẫn đang bị ghi, lần sửa tiếp theo sẽ sinh sự kiện mới
+				std::cerr << "Failed to upload " << relative_path << ": " << e.what() << std::endl;
+				session.reset();
+				continue;
+			}
 
-						std::this_thread::sleep_for(std::chrono::milliseconds(150)); // Delay 150ms
-					}
+			current.file_id = SyncIndex::QueryFileId(path);
+			current.remote_path = relative_path;
+			index.Put(relative_path, current);
+			uploaded++;
+		}
 
-					std::this_thread::sleep_for(std::chrono::milliseconds(500)); // Delay 1000ms
+		is_uploading_directory = false;
 
-					client->CloseSession();
+		if (uploaded > 0)
+		{
+			index.Save();
+			std::cout << "Uploaded " << uploaded << " changed file(s)." << std::endl;
+		}
+	}
 
-					client->GetSessionManager().ResetSession();
+	pool.Release(std::move(session));
+	index.Save();
 
-					client->GetConnection().Disconnect();
-				}
-				catch (const std::exception& e)
-				{
-					std::cerr << "Thread " << i << " failed: " << e.what() << std::endl;
-				}
-			});
+	const std::string error = watcher.GetError();
+	if (!error.empty())
+	{
+		std::cerr << error << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void FileTransferClient::PartitionSmallFiles(const FileTable& table, std::vector<uint32_t>& files)
+{
+	// Gom các file nhỏ lên đầu để chúng được đọc chung một lô
+	std::stable_partition(files.begin(), files.end(),
+		[&table](uint32_t file) { return table.GetFileSize(file) <= INLINE_UPLOAD_THRESHOLD; });
+}
 
-		threads.push_back(std::move(t));
+FileTransferClient::UploadChecksum* FileTransferClient::ChecksumOf(UploadChecksums* checksums, uint32_t file)
+{
+	if (checksums == nullptr)
+	{
+		return nullptr;
 	}
 
-	for (auto& t : threads)
+	auto it = checksums->find(file);
+	return it != checksums->end() ? &it->second : nullptr;
+}
+
+size_t FileTransferClient::EstimateTotalFiles(const ScanStream& stream, size_t total_files)
+{
+	// Quét xong thì tổng là chính xác, trước đó không nhỏ hơn số file đã tìm thấy
+	if (stream.IsComplete())
 	{
-		if (t.joinable())
-		{
-			t.join();
-		}
+		return stream.GetDiscoveredCount();
 	}
 
-	is_uploading_directory = false;
+	return (std::max)(total_files, stream.GetDiscoveredCount());
+}
 
-	auto end_time = std::chrono::steady_clock::now();
+bool FileTransferClient::FinishScan(const ScanStream& stream)
+{
+	try
+	{
+		stream.RethrowIfFailed();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Failed to scan directory: " << e.what() << std::endl;
+		return false;
+	}
 
-	if (!failed_files.empty())
+	// Đảm bảo có file trong thư mục
+	if (stream.IsComplete() && stream.GetDiscoveredCount() == 0)
 	{
-		std::cerr << "\n\nFailed to upload the following files:" << std::endl;
+		std::cerr << "Failed to scan directory: No files found in the directory." << std::endl;
+		return false;
+	}
 
-		for (const auto& file : failed_files)
+	return true;
+}
+
+void FileTransferClient::UploadNextEntries(
+	SmallFileLoader& loader,
+	const FileTable& table,
+	std::span<const uint32_t> files,
+	std::vector<std::string>& failed_files,
+	size_t& completed,
+	UploadChecksums* checksums)
+{
+	// File nhỏ được đọc theo lô và gửi inline, mỗi file chỉ là một cặp request/response nên không cần delay
+	if (table.GetFileSize(files.front()) <= INLINE_UPLOAD_THRESHOLD)
+	{
+		UploadSmallFileBatch(loader, table, files, failed_files, completed, checksums);
+		return;
+	}
+
+	const std::string relative_path = table.GetRelativePath(files.front());
+
+	if (!UploadFile(table.GetAbsolutePath(files.front()), relative_path, ChecksumOf(checksums, files.front())))
+	{
+		failed_files.push_back(relative_path);
+	}
+
+	completed++;
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(150)); // Delay 150ms
+}
+
+void FileTransferClient::UploadWorkItem(
+	SmallFileLoader& loader,
+	const FileTable& table,
+	const WorkItem& item,
+	std::vector<std::string>& failed_files,
+	size_t& completed)
+{
+	// File upload dở ở lần chạy trước: gửi các chunk còn thiếu theo bitmap trong checkpoint,
+	// checkpoint không còn hoặc file đã đổi kích thước thì upload lại từ đầu
+	if (item.kind == WorkKind::RESUME_FILE)
+	{
+		const fs::path file_path = table.GetAbsolutePath(item.files.front());
+		const std::string relative_path = table.GetRelativePath(item.files.front());
+
+		TransferState state;
+		const bool resumable = CheckpointStore::Shared().Find(TransferDirection::UPLOAD, file_path, state) &&
+			state.chunk_size > 0 && state.file_size == table.GetFileSize(item.files.front());
+
+		if (!(resumable && ResumeUpload(file_path)) && !UploadFile(file_path, relative_path))
 		{
-			std::cerr << "- " << file << std::endl;
+			failed_files.push_back(relative_path);
 		}
+
+		completed++;
+		return;
 	}
 
-	std::chrono::duration<double> total_duration = end_time - start_time;
+	// File lớn được chia stripe qua các phiên phụ của chính phiên này
+	if (item.kind == WorkKind::STRIPED_FILE)
+	{
+		const std::string relative_path = table.GetRelativePath(item.files.front());
 
-	std::cout << "\n\nTotal time: " << std::fixed << std::setprecision(2) << total_duration.count() << " seconds" << std::endl;
+		if (!UploadFileStriped(table.GetAbsolutePath(item.files.front()), relative_path, DIRECTORY_STRIPE_COUNT))
+		{
+			failed_files.push_back(relative_path);
+		}
 
-	return true;
+		completed++;
+		return;
+	}
+
+	while (completed < item.files.size())
+	{
+		UploadNextEntries(loader, table, std::span<const uint32_t>(item.files).subspan(completed), failed_files, completed);
+	}
 }
 
 bool FileTransferClient::ResumeUpload(const fs::path& file_path)
@@ -980,25 +3274,32 @@ bool FileTransferClient::ResumeUpload(const fs::path& file_path)
 		return false;
 	}
 
-	// Get checkpoint file
-	const std::string file_ckp = file_path.stem().string() + ".ckp";
+	// Get checkpoint
+	CheckpointStore& checkpoints = CheckpointStore::Shared();
+	TransferState state;
+
+	if (!checkpoints.Find(TransferDirection::UPLOAD, file_path, state) || state.chunk_size == 0)
+	{
+		std::cerr << "Checkpoint not found. The file cannot be resumed." << std::endl;
+		std::cerr << "Please upload the file from the beginning." << std::endl;
+		return false;
+	}
 
-	if (!fs::exists(file_ckp))
+	if (static_cast<uint64_t>(fileSize) != state.file_size)
 	{
-		std::cerr << "Checkpoint file not found. The file cannot be resumed." << std::endl;
+		std::cerr << "The file has changed since the upload was interrupted." << std::endl;
 		std::cerr << "Please upload the file from the beginning." << std::endl;
+		checkpoints.Abort(state.transfer_id);
 		return false;
 	}
 
-	// Read the checkpoint file
-	std::ifstream state_file(file_ckp, std::ios::binary);
-	uint32_t file_id{};
-	size_t chunk_size{};
-	state_file.read(reinterpret_cast<char*>(&file_id), sizeof(file_id));
-	state_file.read(reinterpret_cast<char*>(&chunk_size), sizeof(chunk_size));
-	state_file.close();
+	const uint64_t transfer_id = state.transfer_id;
+	const uint32_t file_id = state.file_id;
+	const size_t chunk_size = state.chunk_size;
 
-	PacketResumeRequest resumeReq(file_id, 0, 0); // Resume position sẽ mặc định là 0, kết quả sẽ cập nhật theo của Server
+	// Resume position sẽ mặc định là 0, kết quả sẽ cập nhật theo của Server (server là bên quyết định các chunk còn thiếu)
+	PacketResumeRequest resumeReq(file_id, 0, 0,
+		state.completed_chunks.GetChunkCount() > 0 ? state.completed_chunks.Encode() : std::vector<uint8_t>());
 
 	if (!m_connection->sendPacket(PacketType::RESUME_UPLOAD_REQUEST, resumeReq))
 	{
@@ -1030,33 +3331,61 @@ bool FileTransferClient::ResumeUpload(const fs::path& file_path)
 
 	// Upload the file
 	size_t chunk_count = ((fileSize + chunk_size - 1) / chunk_size);
-	size_t last_sent_chunk_index = chunk_count - resumeResp.resume_allowed.remaining_chunk_count - 1;
+	size_t total_sent = resumeResp.resume_allowed.resume_position;
 
-	// Open the file
-	std::ifstream file(file_path, std::ios::binary);
-	if (!file.is_open())
+	// Danh sách chunk cần gửi: theo bitmap của server nếu có, ngược lại là phần đuôi sau resume_position
+	std::vector<uint32_t> pending_chunks;
+	ChunkBitmap server_chunks;
+
+	if (!resumeResp.chunk_bitmap.empty())
 	{
-		throw std::runtime_error("Failed to open file.");
+		try
+		{
+			server_chunks = ChunkBitmap::Decode(resumeResp.chunk_bitmap, static_cast<uint32_t>(chunk_count));
+		}
+		catch (const std::exception&)
+		{
+			std::cerr << "The server's chunk bitmap does not match the file." << std::endl;
+			return false;
+		}
+
+		pending_chunks = server_chunks.GetMissingChunks();
+		total_sent = fileSize;
+		for (uint32_t i : pending_chunks)
+		{
+			total_sent -= std::min<size_t>(chunk_size, fileSize - static_cast<size_t>(i) * chunk_size);
+		}
+	}
+	else
+	{
+		if (resumeResp.resume_allowed.remaining_chunk_count > chunk_count)
+		{
+			std::cerr << "Invalid remaining chunk count from the server." << std::endl;
+			return false;
+		}
+
+		for (size_t i = chunk_count - resumeResp.resume_allowed.remaining_chunk_count; i < chunk_count; i++)
+		{
+			pending_chunks.push_back(static_cast<uint32_t>(i));
+		}
 	}
 
-	// Seek to the last position
-	file.seekg(resumeResp.resume_allowed.resume_position, std::ios::beg);
+	std::unique_ptr<FileChunkReader> reader = FileChunkReader::Open(file_path, m_direct_io, m_cache_policy);
 
-	std::cout << "Starting to resume the upload in " << chunk_count << " chunks." << std::endl;
+	std::cout << "Starting to resume the upload in " << pending_chunks.size() << " of " << chunk_count << " chunks." << std::endl;
 
 	auto start_time = std::chrono::steady_clock::now();
 	auto last_time = start_time;
 	size_t last_sent = 0;
 	double total_speed = 0.0;
 
-	size_t total_sent = resumeResp.resume_allowed.resume_position;
-
 	const int MAX_RETRIES = 3;
 	const int BASE_TIMEOUT = 1000; // 1 second
 
-	m_pb_manager->AddFile(file_path.filename().string());
+	const std::string file_name = file_path.filename().string();
+	m_pb_manager->AddFile(file_name);
 
-	for (size_t i = last_sent_chunk_index + 1; i < chunk_count; i++)
+	for (uint32_t i : pending_chunks)
 	{
 		int retries = 0;
 		bool chunk_sent = false;
@@ -1066,28 +3395,25 @@ bool FileTransferClient::ResumeUpload(const fs::path& file_path)
 			try
 			{
 				// Read the chunk data from the file
-				size_t current_chunk_size = std::min<size_t>(chunk_size, fileSize - total_sent);
+				const size_t chunk_offset = static_cast<size_t>(i) * chunk_size;
+				size_t current_chunk_size = std::min<size_t>(chunk_size, fileSize - chunk_offset);
 
-				std::vector<uint8_t> chunk_data(current_chunk_size);
-				if (!file.read(reinterpret_cast<char*>(chunk_data.data()), current_chunk_size))
-				{
-					throw std::runtime_error("Failed to read file chunk.");
-				}
+				std::span<const uint8_t> chunk_data = reader->Read(chunk_offset, current_chunk_size);
 
 				// Caclulate the checksum
-				std::vector<uint8_t> checksum;
+				uint8_t checksum[16]{};
 				if (CHECKSUM_FLAG)
 				{
-					checksum = md5_handler->calcCheckSum(chunk_data);
+					md5_handler->calcCheckSum(chunk_data.data(), chunk_data.size(), checksum);
 				}
 
 				// Prepare the file chunk packet
-				PacketFileChunk fileChunk(
+				PacketFileChunkView fileChunk(
 					resumeResp.resume_allowed.file_id,				// File ID
-					static_cast<uint32_t>(i),						// Chunk index
+					i,												// Chunk index
 					static_cast<uint32_t>(current_chunk_size),		// Chunk size
-					checksum.data(),								// Checksum
-					reinterpret_cast<uint8_t*>(chunk_data.data())	// Chunk data
+					checksum,										// Checksum
+					chunk_data.data()								// Chunk data
 				);
 
 				if (!m_connection->sendPacket(PacketType::FILE_CHUNK, fileChunk))
@@ -1130,14 +3456,11 @@ bool FileTransferClient::ResumeUpload(const fs::path& file_path)
 				last_time = current_time;
 				last_sent = total_sent;
 
-				float progress = (static_cast<float>(resumeReq.resume_position + total_sent) / fileSize) * 100.0f;
-				m_pb_manager->UpdateProgress(file_path.filename().string(), progress);
+				float progress = (static_cast<float>(total_sent) / fileSize) * 100.0f;
+				m_pb_manager->UpdateProgress(file_name, progress);
 
-				// Lưu trạng thái upload 
-				std::ofstream state_file(file_ckp, std::ios::binary | std::ios::trunc);
-				state_file.write(reinterpret_cast<const char*>(&resumeResp.resume_allowed.file_id), sizeof(resumeResp.resume_allowed.file_id));
-				state_file.write(reinterpret_cast<const char*>(&i), sizeof(i));
-				state_file.close();
+				// Lưu trạng thái upload
+				checkpoints.Progress(transfer_id, i, total_sent);
 			}
 			catch (const std::exception& e)
 			{
@@ -1164,13 +3487,8 @@ bool FileTransferClient::ResumeUpload(const fs::path& file_path)
 		}
 	}
 
-	// Đóng checkpoint file
-	if (fs::exists(file_ckp))
-	{
-		fs::remove(file_ckp);
-	}
-
-	file.close(); // Đóng file sau khi upload xong
+	// Xoá checkpoint
+	checkpoints.Complete(transfer_id);
 
 	auto end_time = std::chrono::steady_clock::now();
 	std::chrono::duration<double> total_duration = end_time - start_time;
@@ -1184,14 +3502,34 @@ bool FileTransferClient::ResumeUpload(const fs::path& file_path)
 	return true;
 }
 
-bool FileTransferClient::GetServerFileList()
+bool FileTransferClient::GetServerFileList(std::vector<FileEntryDTO>& out_entries)
 {
+	if (!m_connection->sendPacket(PacketType::VIEW_CLOUD_REQUEST, PacketViewCloudRequest()))
+	{
+		std::cerr << "Failed to send view cloud request." << std::endl;
+		return false;
+	}
 
-	return false;
+	PacketHeader header;
+	PacketViewCloudListing listing;
+
+	if (!m_connection->recvPacket(PacketType::VIEW_CLOUD_RESPONSE, header, listing))
+	{
+		std::cerr << "Failed to receive view cloud response." << std::endl;
+		return false;
+	}
+
+	out_entries = std::move(listing.entries);
+	return true;
 }
 
 void FileTransferClient::CloseSession()
 {
+	if (m_session_pool)
+	{
+		m_session_pool->CloseAll();
+	}
+
 	PacketCloseSession closeReq = PacketCloseSession();
 
 	if (!m_connection->sendPacket(PacketType::CLOSE_SESSION, closeReq))
@@ -0,0 +1,204 @@
+#include <mapped_file_reader.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+utils::MappedFileReader::MappedFileReader(const fs::path& path, size_t window_size, const CachePolicy& cache_policy)
+	: m_path(path),
+	m_handle(INVALID_HANDLE_VALUE),
+	m_mapping(nullptr),
+	m_file_size(0),
+	m_window_size(window_size),
+	m_granularity(0),
+	m_page_size(0),
+	m_cache_policy(cache_policy),
+	m_view(nullptr),
+	m_view_offset(0),
+	m_view_size(0),
+	m_prefetched_until(0),
+	m_dropped_until(0)
+{
+	SYSTEM_INFO system_info{};
+	GetSystemInfo(&system_info);
+	m_granularity = system_info.dwAllocationGranularity;
+	m_page_size = system_info.dwPageSize;
+
+	// Cửa sổ phải là bội số của allocation granularity
+	m_window_size = (std::max)(m_window_size, static_cast<size_t>(m_granularity));
+	m_window_size -= m_window_size % m_granularity;
+
+	// Không chia sẻ quyền ghi: file bị process khác cắt ngắn khi đang map sẽ gây EXCEPTION_IN_PAGE_ERROR khi đọc
+	// và làm sập cả process; file đang được ghi thì mở thất bại (sharing violation) và lần truyền đó báo lỗi
+	m_handle = CreateFileW(
+		m_path.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+		nullptr);
+
+	if (m_handle == INVALID_HANDLE_VALUE)
+	{
+		const DWORD error = GetLastError();
+		if (error == ERROR_SHARING_VIOLATION)
+		{
+			throw std::runtime_error("File is being written by another process: " + m_path.string());
+		}
+
+		throw std::runtime_error("Cannot open file to read: " + m_path.string() + " (error " + std::to_string(error) + ")");
+	}
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(m_handle, &size))
+	{
+		Close();
+		throw std::runtime_error("Failed to get file size: " + m_path.string());
+	}
+	m_file_size = static_cast<uint64_t>(size.QuadPart);
+
+	// Không thể tạo mapping cho file rỗng
+	if (m_file_size > 0)
+	{
+		m_mapping = CreateFileMappingW(m_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (m_mapping == nullptr)
+		{
+			const DWORD error = GetLastError();
+			Close();
+			throw std::runtime_error("Failed to map file: " + m_path.string() + " (error " + std::to_string(error) + ")");
+		}
+	}
+}
+
+utils::MappedFileReader::~MappedFileReader()
+{
+	Close();
+}
+
+std::span<const uint8_t> utils::MappedFileReader::Read(uint64_t offset, size_t length)
+{
+	if (offset > m_file_size || length > m_file_size - offset)
+	{
+		throw std::out_of_range("Read beyond end of file: " + m_path.string());
+	}
+
+	if (length == 0)
+	{
+		return {};
+	}
+
+	if (m_view == nullptr || offset < m_view_offset || offset + length > m_view_offset + m_view_size)
+	{
+		MapWindow(offset, length);
+	}
+
+	const uint64_t view_end = m_view_offset + m_view_size;
+	const uint64_t end = offset + length;
+
+	// Giữ vùng đọc trước luôn vượt con trỏ ít nhất nửa readahead_bytes, mỗi lần yêu cầu thêm tới readahead_bytes
+	if (m_cache_policy.readahead_bytes > 0 &&
+		m_prefetched_until < std::min<uint64_t>(view_end, end + m_cache_policy.readahead_bytes / 2))
+	{
+		const uint64_t from = (std::max)(m_prefetched_until, offset);
+		const uint64_t to = std::min<uint64_t>(view_end, end + m_cache_policy.readahead_bytes);
+
+		Prefetch(from, to);
+		m_prefetched_until = to;
+	}
+
+	if (m_cache_policy.drop_behind)
+	{
+		DropBehind(offset);
+	}
+
+	return { m_view + (offset - m_view_offset), length };
+}
+
+void utils::MappedFileReader::MapWindow(uint64_t offset, size_t length)
+{
+	Unmap();
+
+	const uint64_t aligned_offset = offset - offset % m_granularity;
+	const uint64_t wanted = (std::max)(static_cast<uint64_t>(m_window_size), offset - aligned_offset + length);
+	const size_t view_size = static_cast<size_t>(std::min<uint64_t>(wanted, m_file_size - aligned_offset));
+
+	void* view = MapViewOfFile(
+		m_mapping,
+		FILE_MAP_READ,
+		static_cast<DWORD>(aligned_offset >> 32),
+		static_cast<DWORD>(aligned_offset & 0xFFFFFFFF),
+		view_size);
+
+	if (view == nullptr)
+	{
+		throw std::runtime_error("Failed to map view of " + m_path.string() + " (error " + std::to_string(GetLastError()) + ")");
+	}
+
+	m_view = static_cast<const uint8_t*>(view);
+	m_view_offset = aligned_offset;
+	m_view_size = view_size;
+	m_prefetched_until = aligned_offset;
+	m_dropped_until = aligned_offset;
+}
+
+void utils::MappedFileReader::Prefetch(uint64_t from, uint64_t to)
+{
+	if (from >= to)
+	{
+		return;
+	}
+
+	// Trang được đọc trước bởi luồng có memory priority thấp sẽ bị thu hồi trước các dữ liệu khác trong cache
+	ScopedMemoryPriority priority(m_cache_policy.low_memory_priority);
+
+	// Lỗi chỉ làm mất phần đọc trước nên bỏ qua
+	WIN32_MEMORY_RANGE_ENTRY range{};
+	range.VirtualAddress = const_cast<uint8_t*>(m_view + (from - m_view_offset));
+	range.NumberOfBytes = static_cast<SIZE_T>(to - from);
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+void utils::MappedFileReader::DropBehind(uint64_t offset)
+{
+	const uint64_t to = offset - (offset - m_view_offset) % m_page_size;
+
+	if (to <= m_dropped_until)
+	{
+		return;
+	}
+
+	// VirtualUnlock trên vùng không bị khoá sẽ đưa các trang ra khỏi working set (về standby list)
+	VirtualUnlock(const_cast<uint8_t*>(m_view + (m_dropped_until - m_view_offset)), static_cast<SIZE_T>(to - m_dropped_until));
+	m_dropped_until = to;
+}
+
+void utils::MappedFileReader::Unmap()
+{
+	if (m_view != nullptr)
+	{
+		UnmapViewOfFile(m_view);
+		m_view = nullptr;
+		m_view_offset = 0;
+		m_view_size = 0;
+	}
+}
+
+void utils::MappedFileReader::Close()
+{
+	Unmap();
+
+	if (m_mapping != nullptr)
+	{
+		CloseHandle(m_mapping);
+		m_mapping = nullptr;
+	}
+
+	if (m_handle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_handle);
+		m_handle = INVALID_HANDLE_VALUE;
+	}
+}
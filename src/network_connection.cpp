@@ -4,7 +4,11 @@ NetworkConnection::NetworkConnection()
 	: m_socket(INVALID_SOCKET),
 	m_server_ip(""),
 	m_server_port(0),
-	m_is_connected(false)
+	m_is_connected(false),
+	m_send_arena(),
+	m_recv_arena(),
+	m_request_time(),
+	m_awaiting_response(false)
 {
 	WSADATA wsa_data;
 	if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
@@ -49,6 +53,11 @@ void NetworkConnection::Connect(const std::string& server_ip, uint16_t server_po
 }
 
 bool NetworkConnection::Send(const std::vector<uint8_t>& data) const
+{
+	return Send(data.data(), data.size());
+}
+
+bool NetworkConnection::Send(const uint8_t* data, size_t size) const
 {
 	if (!m_is_connected)
 	{
@@ -57,7 +66,7 @@ bool NetworkConnection::Send(const std::vector<uint8_t>& data) const
 	}
 
 	size_t totalSent = 0;
-	size_t dataSize = data.size();
+	size_t dataSize = size;
 
 	int retry_count = 0;
 
@@ -67,7 +76,7 @@ bool NetworkConnection::Send(const std::vector<uint8_t>& data) const
 		{
 			int bytesToSend = static_cast<int>(std::min<size_t>(dataSize - totalSent, INT32_MAX));
 			int bytesSent = send(m_socket,
-				reinterpret_cast<const char*>(data.data() + totalSent),
+				reinterpret_cast<const char*>(data + totalSent),
 				bytesToSend, 0);
 
 			if (bytesSent == SOCKET_ERROR)
@@ -91,6 +100,8 @@ bool NetworkConnection::Send(const std::vector<uint8_t>& data) const
 		}
 	}
 
+	utils::TransferStats::Shared().AddSent(totalSent);
+
 	return true;
 }
 
@@ -131,6 +142,8 @@ bool NetworkConnection::Receive(uint8_t* data, size_t size) const
 		}
 	}
 
+	utils::TransferStats::Shared().AddReceived(totalReceived);
+
 	return true;
 }
 
@@ -144,6 +157,10 @@ void NetworkConnection::Disconnect()
 	}
 
 	m_is_connected = false;
+
+	// Trả buffer gói tin về pool cho các kết nối khác
+	m_send_arena.Release();
+	m_recv_arena.Release();
 }
 
 bool NetworkConnection::Reconnect()
@@ -0,0 +1,483 @@
+#include <path_filter.h>
+
+#include <cwctype>
+#include <fstream>
+#include <iostream>
+
+utils::PathFilter::PathFilter()
+	: m_rules(),
+	m_names(),
+	m_extensions(),
+	m_trie(1),
+	m_name_globs(),
+	m_path_globs(),
+	m_classes()
+{
+}
+
+bool utils::PathFilter::AddRule(std::string_view line)
+{
+	// Bỏ xuống dòng và khoảng trắng cuối dòng, trừ dấu cách được escape ("\ ")
+	while (!line.empty() && (line.back() == '\r' || line.back() == '\n' || line.back() == ' ' || line.back() == '\t'))
+	{
+		if (line.back() == ' ' && line.size() >= 2 && line[line.size() - 2] == '\\')
+		{
+			break;
+		}
+		line.remove_suffix(1);
+	}
+
+	if (line.empty() || line.front() == '#')
+	{
+		return false;
+	}
+
+	std::wstring pattern;
+	try
+	{
+		pattern = FoldCase(fs::path(std::u8string(line.begin(), line.end())).wstring());
+	}
+	catch (const std::exception&)
+	{
+		std::cerr << "Ignoring invalid filter rule: " << line << std::endl;
+		return false;
+	}
+
+	Rule rule{ false, false };
+
+	if (pattern.front() == L'!')
+	{
+		rule.negate = true;
+		pattern.erase(0, 1);
+	}
+	else if (pattern.front() == L'\\' && pattern.size() > 1 && (pattern[1] == L'#' || pattern[1] == L'!'))
+	{
+		pattern.erase(0, 1);
+	}
+
+	while (!pattern.empty() && pattern.back() == L'/')
+	{
+		rule.directory_only = true;
+		pattern.pop_back();
+	}
+
+	// Có '/' ở đầu hoặc giữa: neo theo thư mục gốc; "**/name" tương đương "name"
+	bool anchored = pattern.find(L'/') != std::wstring::npos;
+
+	if (pattern.starts_with(L"**/") && pattern.find(L'/', 3) == std::wstring::npos)
+	{
+		pattern.erase(0, 3);
+		anchored = false;
+	}
+
+	while (!pattern.empty() && pattern.front() == L'/')
+	{
+		pattern.erase(0, 1);
+	}
+
+	if (pattern.empty())
+	{
+		return false;
+	}
+
+	const uint32_t index = static_cast<uint32_t>(m_rules.size());
+	m_rules.push_back(rule);
+
+	if (!anchored)
+	{
+		const std::wstring_view extension = std::wstring_view(pattern).substr(1);
+
+		if (!HasWildcard(pattern))
+		{
+			m_names[pattern].push_back(index);
+		}
+		else if (pattern.starts_with(L"*.") && !HasWildcard(extension) && extension.find(L'.', 1) == std::wstring_view::npos)
+		{
+			m_extensions[std::wstring(extension)].push_back(index);
+		}
+		else
+		{
+			m_name_globs.push_back(Glob{ index, CompileGlob(pattern) });
+		}
+	}
+	else if (!HasWildcard(pattern))
+	{
+		uint32_t node = 0;
+		size_t start = 0;
+
+		while (start <= pattern.size())
+		{
+			size_t end = pattern.find(L'/', start);
+			if (end == std::wstring::npos)
+			{
+				end = pattern.size();
+			}
+
+			const std::wstring component = pattern.substr(start, end - start);
+			start = end + 1;
+
+			if (component.empty() || component == L".")
+			{
+				continue;
+			}
+
+			auto it = m_trie[node].children.find(component);
+			if (it != m_trie[node].children.end())
+			{
+				node = it->second;
+				continue;
+			}
+
+			const uint32_t next = static_cast<uint32_t>(m_trie.size());
+			m_trie[node].children.emplace(component, next);
+			m_trie.emplace_back();
+			node = next;
+		}
+
+		m_trie[node].rules.push_back(index);
+	}
+	else
+	{
+		m_path_globs.push_back(Glob{ index, CompileGlob(pattern) });
+	}
+
+	return true;
+}
+
+bool utils::PathFilter::LoadIgnoreFile(const fs::path& path)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		return false;
+	}
+
+	std::string line;
+	bool first_line = true;
+
+	while (std::getline(file, line))
+	{
+		// BOM UTF-8 do Notepad thêm vào
+		if (first_line && line.starts_with("\xEF\xBB\xBF"))
+		{
+			line.erase(0, 3);
+		}
+		first_line = false;
+
+		AddRule(line);
+	}
+
+	return true;
+}
+
+bool utils::PathFilter::IsExcluded(const Context& parent, std::wstring_view name, bool is_directory, Context* child) const
+{
+	if (m_rules.empty())
+	{
+		if (child)
+		{
+			*child = Context{ NO_NODE, {} };
+		}
+		return false;
+	}
+
+	const std::wstring folded = FoldCase(name);
+	int64_t best = -1;
+
+	if (auto it = m_names.find(folded); it != m_names.end())
+	{
+		Consider(it->second, is_directory, best);
+	}
+
+	if (!m_extensions.empty())
+	{
+		const size_t dot = folded.rfind(L'.');
+		if (dot != std::wstring::npos)
+		{
+			if (auto it = m_extensions.find(folded.substr(dot)); it != m_extensions.end())
+			{
+				Consider(it->second, is_directory, best);
+			}
+		}
+	}
+
+	// Chỉ đi tiếp một bước từ nút trie của thư mục cha
+	uint32_t node = NO_NODE;
+	if (parent.trie_node != NO_NODE)
+	{
+		const auto& children = m_trie[parent.trie_node].children;
+		if (auto it = children.find(folded); it != children.end())
+		{
+			node = it->second;
+			Consider(m_trie[node].rules, is_directory, best);
+		}
+	}
+
+	// Glob được duyệt từ luật mới nhất, dừng khi không thể thắng luật đã khớp
+	for (auto it = m_name_globs.rbegin(); it != m_name_globs.rend() && static_cast<int64_t>(it->rule) > best; ++it)
+	{
+		if ((!m_rules[it->rule].directory_only || is_directory) && MatchGlob(it->tokens, 0, folded, 0))
+		{
+			best = it->rule;
+			break;
+		}
+	}
+
+	std::wstring path;
+	if (!m_path_globs.empty())
+	{
+		path = parent.path.empty() ? folded : parent.path + L'/' + folded;
+
+		for (auto it = m_path_globs.rbegin(); it != m_path_globs.rend() && static_cast<int64_t>(it->rule) > best; ++it)
+		{
+			if ((!m_rules[it->rule].directory_only || is_directory) && MatchGlob(it->tokens, 0, path, 0))
+			{
+				best = it->rule;
+				break;
+			}
+		}
+	}
+
+	const bool excluded = best >= 0 && !m_rules[static_cast<size_t>(best)].negate;
+
+	if (child && is_directory && !excluded)
+	{
+		child->trie_node = node;
+		child->path = std::move(path);
+	}
+
+	return excluded;
+}
+
+bool utils::PathFilter::IsExcludedPath(const fs::path& relative_path, bool is_directory) const
+{
+	if (m_rules.empty())
+	{
+		return false;
+	}
+
+	std::vector<std::wstring> components;
+	for (const auto& part : relative_path.relative_path())
+	{
+		std::wstring component = part.wstring();
+		if (!component.empty() && component != L".")
+		{
+			components.push_back(std::move(component));
+		}
+	}
+
+	Context context = Root();
+
+	for (size_t i = 0; i < components.size(); i++)
+	{
+		const bool last = i + 1 == components.size();
+
+		Context next;
+		if (IsExcluded(context, components[i], last ? is_directory : true, &next))
+		{
+			return true;
+		}
+		context = std::move(next);
+	}
+
+	return false;
+}
+
+std::wstring utils::PathFilter::FoldCase(std::wstring_view text)
+{
+	std::wstring folded(text);
+	for (auto& ch : folded)
+	{
+		ch = static_cast<wchar_t>(std::towlower(ch));
+	}
+	return folded;
+}
+
+bool utils::PathFilter::HasWildcard(std::wstring_view pattern)
+{
+	return pattern.find_first_of(L"*?[\\") != std::wstring_view::npos;
+}
+
+std::vector<utils::PathFilter::GlobToken> utils::PathFilter::CompileGlob(std::wstring_view pattern)
+{
+	std::vector<GlobToken> tokens;
+
+	for (size_t i = 0; i < pattern.size(); i++)
+	{
+		const wchar_t ch = pattern[i];
+
+		if (ch == L'*')
+		{
+			// "**" chỉ có nghĩa đặc biệt khi đứng riêng thành một thành phần đường dẫn
+			if (i + 1 < pattern.size() && pattern[i + 1] == L'*' && (i == 0 || pattern[i - 1] == L'/'))
+			{
+				if (i + 2 == pattern.size())
+				{
+					tokens.push_back({ TokenType::ANY_SUFFIX, 0, 0 });
+					break;
+				}
+
+				if (pattern[i + 2] == L'/')
+				{
+					tokens.push_back({ TokenType::ANY_DIRS, 0, 0 });
+					i += 2;
+					continue;
+				}
+			}
+
+			while (i + 1 < pattern.size() && pattern[i + 1] == L'*')
+			{
+				i++;
+			}
+
+			tokens.push_back({ TokenType::STAR, 0, 0 });
+		}
+		else if (ch == L'?')
+		{
+			tokens.push_back({ TokenType::ANY_CHAR, 0, 0 });
+		}
+		else if (ch == L'[')
+		{
+			CharClass char_class{ false, {} };
+			size_t j = i + 1;
+
+			if (j < pattern.size() && (pattern[j] == L'!' || pattern[j] == L'^'))
+			{
+				char_class.negate = true;
+				j++;
+			}
+
+			// ']' ngay sau '[' là ký tự thường
+			const size_t first = j;
+			while (j < pattern.size() && (pattern[j] != L']' || j == first))
+			{
+				if (j + 2 < pattern.size() && pattern[j + 1] == L'-' && pattern[j + 2] != L']')
+				{
+					char_class.ranges.emplace_back(pattern[j], pattern[j + 2]);
+					j += 3;
+				}
+				else
+				{
+					char_class.ranges.emplace_back(pattern[j], pattern[j]);
+					j++;
+				}
+			}
+
+			if (j >= pattern.size())
+			{
+				// Không có ']' đóng: '[' là ký tự thường
+				tokens.push_back({ TokenType::LITERAL, ch, 0 });
+				continue;
+			}
+
+			tokens.push_back({ TokenType::CHAR_CLASS, 0, static_cast<uint32_t>(m_classes.size()) });
+			m_classes.push_back(std::move(char_class));
+			i = j;
+		}
+		else if (ch == L'\\' && i + 1 < pattern.size())
+		{
+			tokens.push_back({ TokenType::LITERAL, pattern[++i], 0 });
+		}
+		else
+		{
+			tokens.push_back({ TokenType::LITERAL, ch, 0 });
+		}
+	}
+
+	return tokens;
+}
+
+bool utils::PathFilter::MatchClass(const CharClass& char_class, wchar_t ch) const
+{
+	for (const auto& [low, high] : char_class.ranges)
+	{
+		if (ch >= low && ch <= high)
+		{
+			return !char_class.negate;
+		}
+	}
+
+	return char_class.negate;
+}
+
+bool utils::PathFilter::MatchGlob(const std::vector<GlobToken>& tokens, size_t token, std::wstring_view text, size_t pos) const
+{
+	for (; token < tokens.size(); token++)
+	{
+		const GlobToken& current = tokens[token];
+
+		switch (current.type)
+		{
+		case TokenType::LITERAL:
+			if (pos >= text.size() || text[pos] != current.ch)
+			{
+				return false;
+			}
+			pos++;
+			break;
+
+		case TokenType::ANY_CHAR:
+			if (pos >= text.size() || text[pos] == L'/')
+			{
+				return false;
+			}
+			pos++;
+			break;
+
+		case TokenType::CHAR_CLASS:
+			if (pos >= text.size() || text[pos] == L'/' || !MatchClass(m_classes[current.value], text[pos]))
+			{
+				return false;
+			}
+			pos++;
+			break;
+
+		case TokenType::STAR:
+			// Thử đoạn ngắn nhất trước, '*' không vượt qua '/'
+			for (size_t end = pos;; end++)
+			{
+				if (MatchGlob(tokens, token + 1, text, end))
+				{
+					return true;
+				}
+
+				if (end >= text.size() || text[end] == L'/')
+				{
+					return false;
+				}
+			}
+
+		case TokenType::ANY_DIRS:
+			if (MatchGlob(tokens, token + 1, text, pos))
+			{
+				return true;
+			}
+
+			for (size_t end = pos; end < text.size(); end++)
+			{
+				if (text[end] == L'/' && MatchGlob(tokens, token + 1, text, end + 1))
+				{
+					return true;
+				}
+			}
+			return false;
+
+		case TokenType::ANY_SUFFIX:
+			return true;
+		}
+	}
+
+	return pos == text.size();
+}
+
+void utils::PathFilter::Consider(const std::vector<uint32_t>& rules, bool is_directory, int64_t& best) const
+{
+	for (auto it = rules.rbegin(); it != rules.rend() && static_cast<int64_t>(*it) > best; ++it)
+	{
+		if (!m_rules[*it].directory_only || is_directory)
+		{
+			best = *it;
+			return;
+		}
+	}
+}
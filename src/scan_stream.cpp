@@ -0,0 +1,95 @@
+#include <scan_stream.h>
+
+#include <stdexcept>
+
+namespace
+{
+	// Ném từ sink khi hàng đợi đã đóng để các worker quét dừng lại
+	struct ScanCancelled : std::runtime_error
+	{
+		ScanCancelled() : std::runtime_error("Directory scan cancelled.") {}
+	};
+}
+
+utils::ScanStream::ScanStream(const fs::path& root, PathFilter filter, size_t capacity)
+	: m_filter(std::move(filter)),
+	m_scanner(),
+	m_table(root),
+	m_queue(capacity),
+	m_discovered(0),
+	m_discovered_bytes(0),
+	m_complete(false),
+	m_cancelled(false),
+	m_error(),
+	m_producer()
+{
+	if (!m_filter.IsEmpty())
+	{
+		m_scanner.SetFilter(&m_filter);
+	}
+
+	m_producer = std::thread(
+		[this, root]()
+		{
+			try
+			{
+				m_scanner.Scan(root,
+					[this](size_t, const ScannedFile& file)
+					{
+						const uint32_t index = m_table.AddFile(file.directory, file.name, file.size, file.last_write_time);
+
+						// Đếm trước khi đẩy để ước lượng tổng không nhỏ hơn số file consumer đã nhận
+						m_discovered_bytes += file.size;
+						m_discovered++;
+
+						if (!m_queue.Push(index))
+						{
+							throw ScanCancelled();
+						}
+					},
+					nullptr,
+					[this](uint32_t parent, std::wstring_view name) { return m_table.AddDirectory(parent, name); });
+
+				m_complete = true;
+			}
+			catch (...)
+			{
+				if (!m_cancelled)
+				{
+					m_error = std::current_exception();
+				}
+			}
+
+			// Consumer thấy hàng đợi đóng sau khi m_error đã được ghi
+			m_queue.Close();
+		});
+}
+
+utils::ScanStream::~ScanStream()
+{
+	Cancel();
+
+	if (m_producer.joinable())
+	{
+		m_producer.join();
+	}
+}
+
+size_t utils::ScanStream::PopBatch(std::vector<uint32_t>& out, size_t max_items)
+{
+	return m_queue.PopBatch(out, max_items);
+}
+
+void utils::ScanStream::Cancel()
+{
+	m_cancelled = true;
+	m_queue.Close();
+}
+
+void utils::ScanStream::RethrowIfFailed() const
+{
+	if (m_error)
+	{
+		std::rethrow_exception(m_error);
+	}
+}
@@ -0,0 +1,98 @@
+#include <session_pool.h>
+#include <file_transfer_client.h>
+
+#include <iostream>
+#include <stdexcept>
+
+SessionPool::SessionPool(const std::pair<std::string, uint16_t>& server_info,
+	const std::pair<std::string, std::string>& credential)
+	: m_server_info(server_info),
+	m_credential(credential),
+	m_mutex(),
+	m_idle_sessions()
+{
+}
+
+SessionPool::~SessionPool()
+{
+	CloseAll();
+}
+
+std::unique_ptr<FileTransferClient> SessionPool::Acquire()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		while (!m_idle_sessions.empty())
+		{
+			std::unique_ptr<FileTransferClient> session = std::move(m_idle_sessions.back());
+			m_idle_sessions.pop_back();
+
+			if (session->GetConnection().IsConnected())
+			{
+				return session;
+			}
+		}
+	}
+
+	return OpenSession(m_server_info, m_credential);
+}
+
+void SessionPool::Release(std::unique_ptr<FileTransferClient> session)
+{
+	if (!session || !session->GetConnection().IsConnected())
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_idle_sessions.push_back(std::move(session));
+}
+
+void SessionPool::CloseAll()
+{
+	std::vector<std::unique_ptr<FileTransferClient>> sessions;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		sessions.swap(m_idle_sessions);
+	}
+
+	for (auto& session : sessions)
+	{
+		try
+		{
+			session->CloseSession();
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "Failed to close pooled session: " << e.what() << std::endl;
+		}
+	}
+}
+
+std::unique_ptr<FileTransferClient> SessionPool::OpenSession(
+	const std::pair<std::string, uint16_t>& server_info,
+	const std::pair<std::string, std::string>& credential)
+{
+	std::unique_ptr<FileTransferClient> session = std::make_unique<FileTransferClient>();
+
+	session->GetConnection().Connect(server_info.first, server_info.second);
+
+	if (!session->GetConnection().IsConnected())
+	{
+		throw std::runtime_error("Failed to connect to the server.");
+	}
+
+	if (!session->GetSessionManager().PerformHandshake())
+	{
+		throw std::runtime_error("Failed to perform handshake.");
+	}
+
+	if (!session->GetSessionManager().PerformAuthentication(credential.first, credential.second))
+	{
+		throw std::runtime_error("Failed to authenticate.");
+	}
+
+	return session;
+}
@@ -0,0 +1,185 @@
+#include <small_file_loader.h>
+
+#include <limits>
+#include <stdexcept>
+
+utils::SmallFileLoader::SmallFileLoader(size_t queue_depth)
+	: m_port(nullptr),
+	m_queue_depth((std::max)(queue_depth, size_t(1))),
+	m_arena(AlignedBufferPool::Shared(), ARENA_BLOCK_SIZE),
+	m_slots(),
+	m_free_slots()
+{
+	m_port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+	if (m_port == nullptr)
+	{
+		throw std::runtime_error("Failed to create I/O completion port (error " + std::to_string(GetLastError()) + ")");
+	}
+
+	m_slots.resize(m_queue_depth);
+	m_free_slots.reserve(m_queue_depth);
+
+	for (size_t i = 0; i < m_queue_depth; i++)
+	{
+		m_slots[i].handle = INVALID_HANDLE_VALUE;
+		m_free_slots.push_back(m_queue_depth - 1 - i);
+	}
+}
+
+utils::SmallFileLoader::~SmallFileLoader()
+{
+	if (m_port != nullptr)
+	{
+		CloseHandle(m_port);
+	}
+}
+
+std::vector<utils::SmallFileResult> utils::SmallFileLoader::LoadBatch(std::span<const SmallFileRequest> requests)
+{
+	m_arena.Reset();
+
+	std::vector<SmallFileResult> results(requests.size(), SmallFileResult{ {}, false });
+	std::vector<OVERLAPPED_ENTRY> entries(m_queue_depth);
+
+	size_t next = 0;
+	size_t in_flight = 0;
+
+	while (next < requests.size() || in_flight > 0)
+	{
+		// Giữ hàng đợi luôn đầy: mỗi slot trống nhận ngay file tiếp theo
+		while (next < requests.size() && !m_free_slots.empty())
+		{
+			const size_t slot_index = m_free_slots.back();
+			m_free_slots.pop_back();
+
+			m_slots[slot_index].request_index = next;
+			if (Submit(slot_index, requests[next], results))
+			{
+				in_flight++;
+			}
+			next++;
+		}
+
+		if (in_flight == 0)
+		{
+			continue;
+		}
+
+		ULONG removed = 0;
+		if (!GetQueuedCompletionStatusEx(m_port, entries.data(), static_cast<ULONG>(entries.size()), &removed, INFINITE, FALSE))
+		{
+			const DWORD error = GetLastError();
+
+			// Huỷ các lệnh đọc đang treo trước khi arena bị dùng lại
+			for (size_t i = 0; i < m_slots.size(); i++)
+			{
+				if (m_slots[i].handle != INVALID_HANDLE_VALUE)
+				{
+					DWORD bytes = 0;
+					CancelIoEx(m_slots[i].handle, &m_slots[i].overlapped);
+					GetOverlappedResult(m_slots[i].handle, &m_slots[i].overlapped, &bytes, TRUE);
+					Complete(i, 0, false, results);
+				}
+			}
+
+			throw std::runtime_error("Failed to wait for small file reads (error " + std::to_string(error) + ")");
+		}
+
+		for (ULONG i = 0; i < removed; i++)
+		{
+			const size_t slot_index = static_cast<size_t>(entries[i].lpCompletionKey);
+			Slot& slot = m_slots[slot_index];
+
+			// Trạng thái đã có sẵn trong OVERLAPPED, GetOverlappedResult không chờ
+			DWORD bytes = 0;
+			const bool success = GetOverlappedResult(slot.handle, &slot.overlapped, &bytes, FALSE) || GetLastError() == ERROR_HANDLE_EOF;
+
+			Complete(slot_index, bytes, success, results);
+			in_flight--;
+		}
+	}
+
+	return results;
+}
+
+bool utils::SmallFileLoader::Submit(size_t slot_index, const SmallFileRequest& request, std::vector<SmallFileResult>& results)
+{
+	Slot& slot = m_slots[slot_index];
+
+	// Đọc dư một byte để phát hiện file đã lớn hơn lúc quét
+	if (request.size_hint >= (std::numeric_limits<DWORD>::max)())
+	{
+		Complete(slot_index, 0, false, results);
+		return false;
+	}
+
+	slot.handle = CreateFileW(
+		request.path.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN,
+		nullptr);
+
+	if (slot.handle == INVALID_HANDLE_VALUE)
+	{
+		Complete(slot_index, 0, false, results);
+		return false;
+	}
+
+	if (CreateIoCompletionPort(slot.handle, m_port, static_cast<ULONG_PTR>(slot_index), 0) == nullptr)
+	{
+		Complete(slot_index, 0, false, results);
+		return false;
+	}
+
+	const bool skip_on_success = SetFileCompletionNotificationModes(slot.handle,
+		FILE_SKIP_COMPLETION_PORT_ON_SUCCESS | FILE_SKIP_SET_EVENT_ON_HANDLE) != FALSE;
+
+	slot.capacity = static_cast<size_t>(request.size_hint) + 1;
+	slot.buffer = m_arena.Allocate(slot.capacity);
+	slot.overlapped = OVERLAPPED{};
+
+	DWORD bytes = 0;
+	if (ReadFile(slot.handle, slot.buffer, static_cast<DWORD>(slot.capacity), &bytes, &slot.overlapped))
+	{
+		if (skip_on_success)
+		{
+			Complete(slot_index, bytes, true, results);
+			return false;
+		}
+
+		// Completion vẫn được đưa vào port
+		return true;
+	}
+
+	const DWORD error = GetLastError();
+	if (error == ERROR_IO_PENDING)
+	{
+		return true;
+	}
+
+	// File rỗng: đọc tại EOF thất bại ngay với ERROR_HANDLE_EOF
+	Complete(slot_index, 0, error == ERROR_HANDLE_EOF, results);
+	return false;
+}
+
+void utils::SmallFileLoader::Complete(size_t slot_index, DWORD bytes_read, bool success, std::vector<SmallFileResult>& results)
+{
+	Slot& slot = m_slots[slot_index];
+
+	if (slot.handle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(slot.handle);
+		slot.handle = INVALID_HANDLE_VALUE;
+	}
+
+	// Đọc được nhiều hơn size_hint nghĩa là file đã thay đổi sau khi quét, để đường upload thông thường xử lý
+	if (success && bytes_read < slot.capacity)
+	{
+		results[slot.request_index] = SmallFileResult{ std::span<const uint8_t>(slot.buffer, bytes_read), true };
+	}
+
+	m_free_slots.push_back(slot_index);
+}
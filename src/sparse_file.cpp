@@ -0,0 +1,126 @@
+#include <sparse_file.h>
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+utils::AllocatedRanges utils::AllocatedRanges::Query(const fs::path& path, uint64_t file_size)
+{
+	AllocatedRanges result;
+	result.m_file_size = file_size;
+
+	if (file_size == 0)
+	{
+		return result;
+	}
+
+	// File thường được coi là có dữ liệu trên toàn bộ, không cần truy vấn
+	const FileExtent whole_file{ 0, file_size };
+
+	DWORD attributes = GetFileAttributesW(path.c_str());
+	if (attributes == INVALID_FILE_ATTRIBUTES || (attributes & FILE_ATTRIBUTE_SPARSE_FILE) == 0)
+	{
+		result.m_ranges.push_back(whole_file);
+		return result;
+	}
+
+	HANDLE handle = CreateFileW(
+		path.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr);
+
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		result.m_ranges.push_back(whole_file);
+		return result;
+	}
+
+	FILE_ALLOCATED_RANGE_BUFFER query{};
+	query.FileOffset.QuadPart = 0;
+	query.Length.QuadPart = static_cast<LONGLONG>(file_size);
+
+	std::vector<FILE_ALLOCATED_RANGE_BUFFER> ranges(256);
+
+	while (true)
+	{
+		DWORD returned = 0;
+		BOOL ok = DeviceIoControl(handle, FSCTL_QUERY_ALLOCATED_RANGES,
+			&query, sizeof(query),
+			ranges.data(), static_cast<DWORD>(ranges.size() * sizeof(FILE_ALLOCATED_RANGE_BUFFER)),
+			&returned, nullptr);
+
+		const DWORD error = ok ? ERROR_SUCCESS : GetLastError();
+		if (!ok && error != ERROR_MORE_DATA)
+		{
+			std::cerr << "Failed to query allocated ranges of " << path.string() << " (error " << error << ")" << std::endl;
+			result.m_ranges.assign(1, whole_file);
+			break;
+		}
+
+		const size_t count = returned / sizeof(FILE_ALLOCATED_RANGE_BUFFER);
+		for (size_t i = 0; i < count; i++)
+		{
+			result.m_ranges.push_back({ static_cast<uint64_t>(ranges[i].FileOffset.QuadPart), static_cast<uint64_t>(ranges[i].Length.QuadPart) });
+		}
+
+		if (ok || count == 0)
+		{
+			break;
+		}
+
+		// ERROR_MORE_DATA: truy vấn tiếp từ cuối vùng cuối cùng đã nhận
+		const uint64_t next = result.m_ranges.back().End();
+		if (next >= file_size)
+		{
+			break;
+		}
+
+		query.FileOffset.QuadPart = static_cast<LONGLONG>(next);
+		query.Length.QuadPart = static_cast<LONGLONG>(file_size - next);
+	}
+
+	CloseHandle(handle);
+
+	return result;
+}
+
+bool utils::AllocatedRanges::Overlaps(uint64_t offset, uint64_t length) const
+{
+	if (length == 0)
+	{
+		return false;
+	}
+
+	// Vùng đầu tiên kết thúc sau offset
+	auto it = std::upper_bound(m_ranges.begin(), m_ranges.end(), offset,
+		[](uint64_t value, const FileExtent& range) { return value < range.End(); });
+
+	return it != m_ranges.end() && it->offset < offset + length;
+}
+
+uint64_t utils::AllocatedRanges::GetAllocatedBytes() const
+{
+	uint64_t total = 0;
+	for (const auto& range : m_ranges)
+	{
+		total += range.length;
+	}
+	return total;
+}
+
+bool utils::IsZeroBlock(std::span<const uint8_t> data)
+{
+	if (data.empty())
+	{
+		return true;
+	}
+
+	// Byte đầu bằng 0 và mỗi byte bằng byte liền trước: memcmp được vector hoá nên nhanh hơn vòng lặp từng byte
+	return data[0] == 0 && memcmp(data.data(), data.data() + 1, data.size() - 1) == 0;
+}
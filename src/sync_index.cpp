@@ -0,0 +1,257 @@
+#include <sync_index.h>
+#include <checkpoint_store.h>
+
+#include <Windows.h>
+
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+	constexpr uint32_t SYNC_INDEX_MAGIC = 0x31495953; // "SYI1"
+
+	// Bản ghi trên đĩa, theo sau là path_length byte đường dẫn tương đối và remote_length byte đường dẫn trên server
+#pragma pack(push, 1)
+	struct SyncRecord
+	{
+		uint64_t size;
+		uint64_t last_write_time;
+		uint64_t file_id;
+		uint8_t content_hash[16];
+		uint8_t has_hash;
+		uint16_t path_length;
+		uint16_t remote_length;
+	};
+#pragma pack(pop)
+
+	struct SyncIndexHeader
+	{
+		uint32_t magic;
+		uint32_t reserved;
+		uint64_t entry_count;
+	};
+}
+
+utils::SyncIndex::SyncIndex(const fs::path& path)
+	: m_path(path),
+	m_mutex(),
+	m_entries(),
+	m_dirty(false)
+{
+	Load();
+}
+
+fs::path utils::SyncIndex::PathFor(const fs::path& root)
+{
+	const std::string key = CheckpointStore::NormalizePath(root);
+
+	// Tên thư mục giúp dễ nhận ra file, hash của đường dẫn đầy đủ tránh trùng giữa các thư mục cùng tên
+	std::ostringstream name;
+	name << fs::path(key).filename().string() << '-' << std::hex << std::hash<std::string>{}(key) << ".index";
+
+	return fs::path(DEFAULT_SYNC_INDEX_DIR) / name.str();
+}
+
+uint64_t utils::SyncIndex::QueryFileId(const fs::path& path)
+{
+	HANDLE handle = CreateFileW(path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		return 0;
+	}
+
+	BY_HANDLE_FILE_INFORMATION info{};
+	const bool ok = GetFileInformationByHandle(handle, &info) != 0;
+	CloseHandle(handle);
+
+	if (!ok)
+	{
+		return 0;
+	}
+
+	// File index 64 bit của NTFS chỉ giữ 32 bit thấp, đủ để phân biệt trong cùng volume
+	return (static_cast<uint64_t>(info.dwVolumeSerialNumber) << 32) | info.nFileIndexLow;
+}
+
+bool utils::SyncIndex::Stat(const fs::path& path, SyncEntry& out_entry)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data{};
+	if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+	{
+		return false;
+	}
+
+	out_entry.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+	out_entry.last_write_time = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+	return true;
+}
+
+bool utils::SyncIndex::Find(const std::string& relative_path, SyncEntry& out_entry) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto it = m_entries.find(relative_path);
+	if (it == m_entries.end())
+	{
+		return false;
+	}
+
+	out_entry = it->second;
+	return true;
+}
+
+void utils::SyncIndex::Put(const std::string& relative_path, const SyncEntry& entry)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_entries[relative_path] = entry;
+	m_dirty = true;
+}
+
+size_t utils::SyncIndex::Retain(const std::unordered_set<std::string>& seen)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	const size_t removed = std::erase_if(m_entries, [&seen](const auto& entry) { return !seen.contains(entry.first); });
+	if (removed > 0)
+	{
+		m_dirty = true;
+	}
+
+	return removed;
+}
+
+size_t utils::SyncIndex::GetEntryCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_entries.size();
+}
+
+bool utils::SyncIndex::Save()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (!m_dirty)
+	{
+		return true;
+	}
+
+	std::vector<char> buffer(sizeof(SyncIndexHeader));
+
+	SyncIndexHeader header{ SYNC_INDEX_MAGIC, 0, m_entries.size() };
+	memcpy(buffer.data(), &header, sizeof(header));
+
+	for (const auto& [relative_path, entry] : m_entries)
+	{
+		SyncRecord record{};
+		record.size = entry.size;
+		record.last_write_time = entry.last_write_time;
+		record.file_id = entry.file_id;
+		memcpy(record.content_hash, entry.content_hash.data(), sizeof(record.content_hash));
+		record.has_hash = entry.has_hash ? 1 : 0;
+		record.path_length = static_cast<uint16_t>(relative_path.size());
+		record.remote_length = static_cast<uint16_t>(entry.remote_path.size());
+
+		const char* bytes = reinterpret_cast<const char*>(&record);
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(record));
+		buffer.insert(buffer.end(), relative_path.begin(), relative_path.begin() + record.path_length);
+		buffer.insert(buffer.end(), entry.remote_path.begin(), entry.remote_path.begin() + record.remote_length);
+	}
+
+	std::error_code ec;
+	fs::create_directories(m_path.parent_path(), ec);
+
+	fs::path temp_path = m_path;
+	temp_path += ".tmp";
+
+	{
+		std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+		if (!file.write(buffer.data(), buffer.size()) || !file.flush())
+		{
+			std::cerr << "Failed to write sync index: " << temp_path.string() << std::endl;
+			return false;
+		}
+	}
+
+	fs::rename(temp_path, m_path, ec);
+	if (ec)
+	{
+		std::cerr << "Failed to replace sync index: " << m_path.string() << " (" << ec.message() << ")" << std::endl;
+		return false;
+	}
+
+	m_dirty = false;
+	return true;
+}
+
+void utils::SyncIndex::Reload()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_entries.clear();
+	m_dirty = false;
+	Load();
+}
+
+void utils::SyncIndex::Load()
+{
+	std::ifstream file(m_path, std::ios::binary);
+	if (!file)
+	{
+		return; // Chưa sync lần nào
+	}
+
+	std::vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	SyncIndexHeader header{};
+	if (buffer.size() < sizeof(header) || (memcpy(&header, buffer.data(), sizeof(header)), header.magic != SYNC_INDEX_MAGIC))
+	{
+		std::cerr << "Ignoring invalid sync index: " << m_path.string() << std::endl;
+		return;
+	}
+
+	size_t offset = sizeof(header);
+
+	for (uint64_t i = 0; i < header.entry_count; i++)
+	{
+		SyncRecord record{};
+		if (buffer.size() - offset < sizeof(record))
+		{
+			break;
+		}
+
+		memcpy(&record, buffer.data() + offset, sizeof(record));
+		offset += sizeof(record);
+
+		if (buffer.size() - offset < static_cast<size_t>(record.path_length) + record.remote_length)
+		{
+			break;
+		}
+
+		SyncEntry entry;
+		entry.size = record.size;
+		entry.last_write_time = record.last_write_time;
+		entry.file_id = record.file_id;
+		memcpy(entry.content_hash.data(), record.content_hash, sizeof(record.content_hash));
+		entry.has_hash = record.has_hash != 0;
+
+		std::string relative_path(buffer.data() + offset, record.path_length);
+		offset += record.path_length;
+		entry.remote_path.assign(buffer.data() + offset, record.remote_length);
+		offset += record.remote_length;
+
+		m_entries.emplace(std::move(relative_path), std::move(entry));
+	}
+
+	if (m_entries.size() != header.entry_count)
+	{
+		// File bị cắt cụt: giữ phần đọc được, các file còn lại sẽ được upload lại
+		std::cerr << "Sync index is truncated: " << m_path.string() << std::endl;
+		m_dirty = true;
+	}
+}
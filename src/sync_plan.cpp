@@ -0,0 +1,226 @@
+#include <sync_plan.h>
+
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+size_t utils::SyncPlan::Count(SyncAction action) const
+{
+	return static_cast<size_t>(std::count_if(entries.begin(), entries.end(),
+		[action](const SyncPlanEntry& entry) { return entry.action == action; }));
+}
+
+uint64_t utils::SyncPlan::Bytes(SyncAction action) const
+{
+	uint64_t total = 0;
+	for (const auto& entry : entries)
+	{
+		if (entry.action == action)
+		{
+			total += action == SyncAction::DOWNLOAD ? entry.remote_size : entry.local_size;
+		}
+	}
+	return total;
+}
+
+utils::SyncPlanner::SyncPlanner(const FileTable& table, const SyncIndex* index, HashFunction hash_local)
+	: m_table(table),
+	m_index(index),
+	m_hash_local(std::move(hash_local))
+{
+}
+
+utils::SyncPlan utils::SyncPlanner::Build(std::span<const uint32_t> local_files, const std::vector<RemoteFile>& remote_files) const
+{
+	std::unordered_map<std::string, size_t> remote_by_path;
+	remote_by_path.reserve(remote_files.size());
+
+	for (size_t i = 0; i < remote_files.size(); i++)
+	{
+		remote_by_path.emplace(NormalizePath(remote_files[i].remote_path), i);
+	}
+
+	std::vector<bool> matched(remote_files.size(), false);
+	SyncPlan plan;
+	plan.entries.reserve((std::max)(local_files.size(), remote_files.size()));
+
+	for (uint32_t file : local_files)
+	{
+		const std::string relative_path = m_table.GetRelativePath(file);
+		std::string path = NormalizePath(relative_path);
+		const uint64_t local_size = m_table.GetFileSize(file);
+
+		auto it = remote_by_path.find(path);
+		if (it == remote_by_path.end())
+		{
+			plan.entries.push_back({ DecideLocalOnly(file, relative_path), std::move(path), file, NO_REMOTE_FILE, local_size, 0 });
+			continue;
+		}
+
+		const RemoteFile& remote = remote_files[it->second];
+		matched[it->second] = true;
+
+		plan.entries.push_back({ Decide(file, relative_path, remote), std::move(path), file, it->second, local_size, remote.size });
+	}
+
+	// File chỉ có trên server
+	for (size_t i = 0; i < remote_files.size(); i++)
+	{
+		if (!matched[i])
+		{
+			std::string path = NormalizePath(remote_files[i].remote_path);
+			const SyncAction action = DecideRemoteOnly(path, remote_files[i]);
+
+			plan.entries.push_back({ action, std::move(path), NO_LOCAL_FILE, i, 0, remote_files[i].size });
+		}
+	}
+
+	return plan;
+}
+
+std::string utils::SyncPlanner::NormalizePath(std::string path)
+{
+	std::replace(path.begin(), path.end(), '\\', '/');
+
+	size_t start = 0;
+	while (true)
+	{
+		if (path.compare(start, 2, "./") == 0)
+		{
+			start += 2;
+		}
+		else if (start < path.size() && path[start] == '/')
+		{
+			start++;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	return path.substr(start);
+}
+
+bool utils::SyncPlanner::IsSafeRelativePath(const std::string& path)
+{
+	if (path.empty() || path.front() == '/' || path.find(':') != std::string::npos)
+	{
+		return false;
+	}
+
+	size_t start = 0;
+	while (start <= path.size())
+	{
+		size_t end = path.find('/', start);
+		if (end == std::string::npos)
+		{
+			end = path.size();
+		}
+
+		const std::string_view component(path.data() + start, end - start);
+		if (component.empty() || component == "." || component == "..")
+		{
+			return false;
+		}
+
+		start = end + 1;
+	}
+
+	return true;
+}
+
+utils::SyncAction utils::SyncPlanner::Decide(uint32_t local_file, const std::string& relative_path, const RemoteFile& remote) const
+{
+	const uint64_t local_size = m_table.GetFileSize(local_file);
+
+	SyncEntry base;
+	const bool has_base = m_index != nullptr && m_index->Find(relative_path, base);
+
+	// File local không đổi kể từ lần sync trước thì dùng lại hash trong chỉ mục thay vì đọc file
+	const bool local_unchanged = has_base && base.size == local_size && base.last_write_time == m_table.GetLastWriteTime(local_file);
+
+	// Bản trên server vẫn là bản đã sync lần trước
+	const bool remote_unchanged = has_base && IsRemoteUnchanged(base, remote);
+
+	bool same = false;
+	if (local_size != remote.size)
+	{
+		same = false;
+	}
+	else if (local_size == 0)
+	{
+		same = true;
+	}
+	else if (!remote.has_checksum)
+	{
+		// Không so được nội dung: cùng kích thước chỉ coi là giống khi chưa từng sync,
+		// hoặc cả hai phía đều chưa đổi kể từ lần sync trước (sửa giữ nguyên kích thước vẫn phải được upload)
+		same = !has_base || (local_unchanged && remote_unchanged);
+	}
+	else
+	{
+		std::array<uint8_t, 16> local_hash{};
+		bool hashed = false;
+
+		if (local_unchanged && base.has_hash)
+		{
+			local_hash = base.content_hash;
+			hashed = true;
+		}
+		else if (m_hash_local)
+		{
+			hashed = m_hash_local(local_file, local_hash);
+		}
+
+		same = hashed && local_hash == remote.checksum;
+	}
+
+	if (same)
+	{
+		return SyncAction::SKIP;
+	}
+
+	if (local_unchanged && !remote_unchanged)
+	{
+		return SyncAction::DOWNLOAD;
+	}
+
+	if (remote_unchanged && !local_unchanged)
+	{
+		return SyncAction::UPLOAD;
+	}
+
+	return SyncAction::CONFLICT;
+}
+
+utils::SyncAction utils::SyncPlanner::DecideLocalOnly(uint32_t local_file, const std::string& relative_path) const
+{
+	SyncEntry base;
+	if (m_index == nullptr || !m_index->Find(relative_path, base))
+	{
+		return SyncAction::UPLOAD;
+	}
+
+	// Đã có trên server ở lần sync trước: file bị xoá trên server, chỉ xung đột khi local cũng đã sửa
+	const bool local_unchanged = base.size == m_table.GetFileSize(local_file) && base.last_write_time == m_table.GetLastWriteTime(local_file);
+	return local_unchanged ? SyncAction::DELETED : SyncAction::CONFLICT;
+}
+
+utils::SyncAction utils::SyncPlanner::DecideRemoteOnly(const std::string& path, const RemoteFile& remote) const
+{
+	// Chỉ mục dùng khoá như FileTable::GetRelativePath (dấu phân cách của hệ điều hành)
+	SyncEntry base;
+	if (m_index == nullptr || !m_index->Find(fs::path(path).make_preferred().string(), base))
+	{
+		return SyncAction::DOWNLOAD;
+	}
+
+	// Đã có ở local lần sync trước: file bị xoá ở local, chỉ xung đột khi bản trên server cũng đã đổi
+	return IsRemoteUnchanged(base, remote) ? SyncAction::DELETED : SyncAction::CONFLICT;
+}
+
+bool utils::SyncPlanner::IsRemoteUnchanged(const SyncEntry& base, const RemoteFile& remote)
+{
+	return base.size == remote.size && (!remote.has_checksum || !base.has_hash || base.content_hash == remote.checksum);
+}
@@ -0,0 +1,64 @@
+#include <transfer_arena.h>
+
+#include <algorithm>
+#include <utility>
+
+utils::TransferArena::TransferArena(AlignedBufferPool& pool, size_t block_size)
+	: m_pool(pool),
+	m_block_size(block_size),
+	m_blocks(),
+	m_used(0)
+{
+}
+
+uint8_t* utils::TransferArena::Allocate(size_t size, size_t alignment)
+{
+	if (!m_blocks.empty())
+	{
+		const size_t offset = static_cast<size_t>(AlignUp(m_used, alignment));
+		AlignedBufferPool::Buffer& block = m_blocks.back();
+
+		if (offset <= block.size() && size <= block.size() - offset)
+		{
+			m_used = offset + size;
+			return block.data() + offset;
+		}
+	}
+
+	// Khối mới bắt đầu tại biên trang nên thoả mọi alignment nhỏ hơn 4KB
+	m_blocks.push_back(m_pool.Acquire((std::max)(size, m_block_size)));
+	m_used = size;
+
+	return m_blocks.back().data();
+}
+
+void utils::TransferArena::Reset()
+{
+	if (m_blocks.size() > 1)
+	{
+		// Giữ lại khối lớn nhất để lần sau gói tin cùng kích thước nằm gọn trong một khối
+		auto largest = std::max_element(m_blocks.begin(), m_blocks.end(),
+			[](const AlignedBufferPool::Buffer& a, const AlignedBufferPool::Buffer& b) { return a.size() < b.size(); });
+
+		std::swap(*largest, m_blocks.front());
+		m_blocks.resize(1);
+	}
+
+	m_used = 0;
+}
+
+void utils::TransferArena::Release()
+{
+	m_blocks.clear();
+	m_used = 0;
+}
+
+size_t utils::TransferArena::GetCapacity() const
+{
+	size_t capacity = 0;
+	for (const auto& block : m_blocks)
+	{
+		capacity += block.size();
+	}
+	return capacity;
+}
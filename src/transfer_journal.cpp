@@ -0,0 +1,770 @@
+#include <transfer_journal.h>
+#include <crc32.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+	constexpr uint32_t JOURNAL_MAGIC = 0x314A5254; // "TRJ1"
+	constexpr size_t RECORD_SIZE = 64;
+
+	enum JournalRecordType : uint8_t
+	{
+		RECORD_BEGIN = 1,
+		RECORD_PROGRESS = 2,
+		RECORD_COMPLETE = 3,
+		RECORD_ABORT = 4,
+		RECORD_BITMAP = 5
+	};
+
+	// Bản ghi trên đĩa, BEGIN được theo sau bởi name_blocks khối 64 byte chứa "local_path\0remote_path\0"
+	// BITMAP (chỉ xuất hiện khi compact) được theo sau bởi ChunkBitmap đã nén, độ dài nằm trong position
+	struct JournalRecord
+	{
+		uint32_t magic;
+		uint32_t crc;
+		uint8_t type;
+		uint8_t direction;
+		uint16_t name_blocks;
+		uint32_t file_id;
+		uint64_t transfer_id;
+		uint64_t file_size;
+		uint32_t chunk_size;
+		uint32_t chunk_index;
+		uint64_t position;
+		uint8_t reserved[16];
+	};
+	static_assert(sizeof(JournalRecord) == RECORD_SIZE, "Journal records must be 64 bytes");
+
+	void AppendRecord(std::vector<uint8_t>& buffer, JournalRecord record, const std::string& names = std::string())
+	{
+		record.magic = JOURNAL_MAGIC;
+		record.crc = 0;
+		record.name_blocks = static_cast<uint16_t>((names.size() + RECORD_SIZE - 1) / RECORD_SIZE);
+
+		const size_t start = buffer.size();
+		buffer.resize(start + RECORD_SIZE * (1 + record.name_blocks), 0);
+
+		memcpy(buffer.data() + start, &record, RECORD_SIZE);
+		memcpy(buffer.data() + start + RECORD_SIZE, names.data(), names.size());
+
+		uint32_t crc = utils::Crc32(buffer.data() + start, buffer.size() - start);
+		memcpy(buffer.data() + start + offsetof(JournalRecord, crc), &crc, sizeof(crc));
+	}
+
+	uint32_t ChunkCountOf(uint64_t file_size, uint32_t chunk_size)
+	{
+		return chunk_size == 0 ? 0 : static_cast<uint32_t>((file_size + chunk_size - 1) / chunk_size);
+	}
+
+	void AppendState(std::vector<uint8_t>& buffer, const utils::TransferState& state)
+	{
+		JournalRecord begin{};
+		begin.type = RECORD_BEGIN;
+		begin.direction = static_cast<uint8_t>(state.direction);
+		begin.file_id = state.file_id;
+		begin.transfer_id = state.transfer_id;
+		begin.file_size = state.file_size;
+		begin.chunk_size = state.chunk_size;
+
+		std::string names = state.local_path + '\0' + state.remote_path + '\0';
+		AppendRecord(buffer, begin, names);
+
+		if (state.completed_chunks.GetCompletedCount() > 0)
+		{
+			std::vector<uint8_t> encoded = state.completed_chunks.Encode();
+
+			JournalRecord bitmap{};
+			bitmap.type = RECORD_BITMAP;
+			bitmap.transfer_id = state.transfer_id;
+			bitmap.position = encoded.size();
+			AppendRecord(buffer, bitmap, std::string(encoded.begin(), encoded.end()));
+		}
+
+		if (state.position > 0)
+		{
+			JournalRecord progress{};
+			progress.type = RECORD_PROGRESS;
+			progress.transfer_id = state.transfer_id;
+			progress.chunk_index = state.chunk_index;
+			progress.position = state.position;
+			AppendRecord(buffer, progress);
+		}
+	}
+}
+
+utils::TransferJournal::TransferJournal(const fs::path& path, const JournalCommitPolicy& policy)
+	: m_path(path),
+	m_policy(policy),
+	m_handle(INVALID_HANDLE_VALUE),
+	m_lock(INVALID_HANDLE_VALUE),
+	m_mutex(),
+	m_io_mutex(),
+	m_cv(),
+	m_states(),
+	m_pending(),
+	m_pending_records(0),
+	m_end_offset(0),
+	m_next_id(1),
+	m_stop(false)
+{
+	if (m_path.has_parent_path())
+	{
+		fs::create_directories(m_path.parent_path());
+	}
+
+	Lock();
+
+	try
+	{
+		Open();
+		Replay();
+	}
+	catch (...)
+	{
+		if (m_handle != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_handle);
+		}
+		CloseHandle(m_lock);
+		throw;
+	}
+
+	m_flusher = std::thread(&TransferJournal::FlusherLoop, this);
+}
+
+utils::TransferJournal::~TransferJournal()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_cv.notify_all();
+
+	if (m_flusher.joinable())
+	{
+		m_flusher.join();
+	}
+
+	try
+	{
+		// Không còn phiên dang dở: thu gọn journal một lần khi tắt thay vì sau mỗi lần kết thúc phiên
+		if (m_states.empty() && m_end_offset + m_pending.size() > 0)
+		{
+			Compact();
+		}
+		else
+		{
+			Commit();
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Failed to commit transfer journal: " << e.what() << std::endl;
+	}
+
+	if (m_handle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_handle);
+	}
+
+	CloseHandle(m_lock);
+}
+
+utils::TransferJournal& utils::TransferJournal::Shared()
+{
+	static std::unique_ptr<TransferJournal> journal = OpenShared();
+	return *journal;
+}
+
+fs::path utils::TransferJournal::SlotPath(size_t slot)
+{
+	if (slot == 0)
+	{
+		return DEFAULT_JOURNAL_PATH;
+	}
+
+	fs::path path(DEFAULT_JOURNAL_PATH);
+	return path.parent_path() / (path.stem().string() + "." + std::to_string(slot) + path.extension().string());
+}
+
+std::unique_ptr<utils::TransferJournal> utils::TransferJournal::OpenShared()
+{
+	std::unique_ptr<TransferJournal> journal;
+	size_t own_slot = 0;
+
+	for (size_t slot = 0; slot < MAX_JOURNAL_SLOTS && !journal; slot++)
+	{
+		try
+		{
+			journal = std::make_unique<TransferJournal>(SlotPath(slot));
+			own_slot = slot;
+		}
+		catch (const JournalInUseError&)
+		{
+			// Tiến trình khác đang giữ slot này
+		}
+	}
+
+	if (!journal)
+	{
+		throw std::runtime_error("All " + std::to_string(MAX_JOURNAL_SLOTS) +
+			" transfer journals are in use by other processes. Close another transfer and try again.");
+	}
+
+	// Journal không còn tiến trình nào giữ: chuyển phiên dang dở sang journal của tiến trình này để có thể resume
+	for (size_t slot = 0; slot < MAX_JOURNAL_SLOTS; slot++)
+	{
+		const fs::path path = SlotPath(slot);
+
+		if (slot == own_slot || !fs::exists(path))
+		{
+			continue;
+		}
+
+		try
+		{
+			TransferJournal orphan(path);
+
+			for (const auto& state : orphan.GetActiveTransfers())
+			{
+				journal->AdoptTransfer(state);
+				orphan.AbortTransfer(state.transfer_id);
+			}
+		}
+		catch (const JournalInUseError&)
+		{
+			continue;
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "Failed to recover transfer journal " << path.string() << ": " << e.what() << std::endl;
+			continue;
+		}
+
+		std::error_code ec;
+		fs::remove(path, ec);
+	}
+
+	return journal;
+}
+
+void utils::TransferJournal::Lock()
+{
+	fs::path lock_path = m_path;
+	lock_path += ".lock";
+
+	m_lock = CreateFileW(
+		lock_path.c_str(),
+		GENERIC_READ | GENERIC_WRITE,
+		0,
+		nullptr,
+		OPEN_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_DELETE_ON_CLOSE,
+		nullptr);
+
+	if (m_lock == INVALID_HANDLE_VALUE)
+	{
+		const DWORD error = GetLastError();
+
+		// File khoá đang mở hoặc đang chờ xoá bởi tiến trình khác
+		if (error == ERROR_SHARING_VIOLATION || error == ERROR_ACCESS_DENIED)
+		{
+			throw JournalInUseError("Transfer journal is in use by another process: " + m_path.string());
+		}
+
+		throw std::runtime_error("Failed to lock transfer journal (error " + std::to_string(error) + ")");
+	}
+}
+
+void utils::TransferJournal::Open()
+{
+	m_handle = CreateFileW(
+		m_path.c_str(),
+		GENERIC_READ | GENERIC_WRITE,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr);
+
+	if (m_handle == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Failed to open transfer journal (error " + std::to_string(GetLastError()) + ")");
+	}
+}
+
+void utils::TransferJournal::Replay()
+{
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(m_handle, &size))
+	{
+		throw std::runtime_error("Failed to get transfer journal size.");
+	}
+
+	std::vector<uint8_t> data(static_cast<size_t>(size.QuadPart));
+	size_t read_total = 0;
+
+	while (read_total < data.size())
+	{
+		OVERLAPPED overlapped{};
+		overlapped.Offset = static_cast<DWORD>(read_total & 0xFFFFFFFF);
+		overlapped.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(read_total) >> 32);
+
+		DWORD read = 0;
+		DWORD to_read = static_cast<DWORD>(std::min<size_t>(data.size() - read_total, 1ULL << 30));
+		if (!ReadFile(m_handle, data.data() + read_total, to_read, &read, &overlapped) || read == 0)
+		{
+			throw std::runtime_error("Failed to read transfer journal.");
+		}
+		read_total += read;
+	}
+
+	size_t offset = 0;
+
+	while (offset + RECORD_SIZE <= data.size())
+	{
+		JournalRecord record{};
+		memcpy(&record, data.data() + offset, RECORD_SIZE);
+
+		const size_t length = RECORD_SIZE * (1 + static_cast<size_t>(record.name_blocks));
+
+		if (record.magic != JOURNAL_MAGIC || offset + length > data.size())
+		{
+			break;
+		}
+
+		std::vector<uint8_t> copy(data.begin() + offset, data.begin() + offset + length);
+		memset(copy.data() + offsetof(JournalRecord, crc), 0, sizeof(record.crc));
+
+		if (Crc32(copy.data(), copy.size()) != record.crc)
+		{
+			break;
+		}
+
+		switch (record.type)
+		{
+		case RECORD_BEGIN:
+		{
+			const char* names = reinterpret_cast<const char*>(data.data() + offset + RECORD_SIZE);
+			const size_t names_size = length - RECORD_SIZE;
+
+			TransferState state;
+			state.transfer_id = record.transfer_id;
+			state.direction = static_cast<TransferDirection>(record.direction);
+			state.local_path.assign(names, strnlen(names, names_size));
+			if (state.local_path.size() + 1 < names_size)
+			{
+				const char* remote = names + state.local_path.size() + 1;
+				state.remote_path.assign(remote, strnlen(remote, names_size - state.local_path.size() - 1));
+			}
+			state.file_id = record.file_id;
+			state.file_size = record.file_size;
+			state.chunk_size = record.chunk_size;
+			state.completed_chunks = ChunkBitmap(ChunkCountOf(state.file_size, state.chunk_size));
+
+			m_states[state.transfer_id] = state;
+			m_next_id = (std::max)(m_next_id, record.transfer_id + 1);
+			break;
+		}
+		case RECORD_PROGRESS:
+		{
+			auto it = m_states.find(record.transfer_id);
+			if (it != m_states.end())
+			{
+				it->second.chunk_index = record.chunk_index;
+				it->second.position = record.position;
+				if (record.chunk_index < it->second.completed_chunks.GetChunkCount())
+				{
+					it->second.completed_chunks.Set(record.chunk_index);
+				}
+			}
+			break;
+		}
+		case RECORD_BITMAP:
+		{
+			auto it = m_states.find(record.transfer_id);
+			if (it != m_states.end() && record.position <= length - RECORD_SIZE)
+			{
+				try
+				{
+					it->second.completed_chunks = ChunkBitmap::Decode(data.data() + offset + RECORD_SIZE,
+						static_cast<size_t>(record.position), it->second.completed_chunks.GetChunkCount());
+				}
+				catch (const std::exception& e)
+				{
+					std::cerr << "Ignoring invalid chunk bitmap in transfer journal: " << e.what() << std::endl;
+				}
+			}
+			break;
+		}
+		case RECORD_COMPLETE:
+		case RECORD_ABORT:
+			m_states.erase(record.transfer_id);
+			break;
+		default:
+			break;
+		}
+
+		offset += length;
+	}
+
+	m_end_offset = offset;
+
+	// Cắt bỏ phần bản ghi ghi dở ở cuối journal
+	if (offset < data.size())
+	{
+		std::cerr << "Transfer journal has " << (data.size() - offset) << " trailing bytes, truncating." << std::endl;
+
+		LARGE_INTEGER position{};
+		position.QuadPart = static_cast<LONGLONG>(offset);
+		if (!SetFilePointerEx(m_handle, position, nullptr, FILE_BEGIN) || !SetEndOfFile(m_handle))
+		{
+			throw std::runtime_error("Failed to truncate transfer journal.");
+		}
+	}
+}
+
+uint64_t utils::TransferJournal::BeginTransfer(TransferDirection direction, const std::string& local_path,
+	const std::string& remote_path, uint32_t file_id, uint64_t file_size, uint32_t chunk_size)
+{
+	uint64_t transfer_id = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		TransferState state;
+		state.transfer_id = transfer_id = m_next_id++;
+		state.direction = direction;
+		state.local_path = local_path;
+		state.remote_path = remote_path;
+		state.file_id = file_id;
+		state.file_size = file_size;
+		state.chunk_size = chunk_size;
+		state.completed_chunks = ChunkBitmap(ChunkCountOf(file_size, chunk_size));
+
+		AppendState(m_pending, state);
+		m_pending_records++;
+		m_states[transfer_id] = state;
+	}
+
+	Commit();
+
+	return transfer_id;
+}
+
+uint64_t utils::TransferJournal::AdoptTransfer(const TransferState& state)
+{
+	uint64_t transfer_id = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		TransferState adopted = state;
+		adopted.transfer_id = transfer_id = m_next_id++;
+
+		AppendState(m_pending, adopted);
+		m_pending_records++;
+		m_states[transfer_id] = std::move(adopted);
+	}
+
+	Commit();
+
+	return transfer_id;
+}
+
+void utils::TransferJournal::RecordProgress(uint64_t transfer_id, uint32_t chunk_index, uint64_t position)
+{
+	bool wake_flusher = false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto it = m_states.find(transfer_id);
+		if (it == m_states.end())
+		{
+			return;
+		}
+
+		it->second.chunk_index = chunk_index;
+		it->second.position = position;
+		if (chunk_index < it->second.completed_chunks.GetChunkCount())
+		{
+			it->second.completed_chunks.Set(chunk_index);
+		}
+
+		JournalRecord record{};
+		record.type = RECORD_PROGRESS;
+		record.transfer_id = transfer_id;
+		record.chunk_index = chunk_index;
+		record.position = position;
+
+		AppendRecord(m_pending, record);
+		wake_flusher = (++m_pending_records >= m_policy.max_pending_records);
+	}
+
+	if (wake_flusher)
+	{
+		m_cv.notify_one();
+	}
+}
+
+void utils::TransferJournal::CompleteTransfer(uint64_t transfer_id)
+{
+	FinishTransfer(transfer_id, RECORD_COMPLETE);
+}
+
+void utils::TransferJournal::AbortTransfer(uint64_t transfer_id)
+{
+	FinishTransfer(transfer_id, RECORD_ABORT);
+}
+
+void utils::TransferJournal::FinishTransfer(uint64_t transfer_id, uint8_t record_type)
+{
+	bool compact = false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (m_states.erase(transfer_id) == 0)
+		{
+			return;
+		}
+
+		JournalRecord record{};
+		record.type = record_type;
+		record.transfer_id = transfer_id;
+
+		AppendRecord(m_pending, record);
+		m_pending_records++;
+
+		compact = m_end_offset + m_pending.size() >= m_policy.compact_threshold_bytes;
+	}
+
+	if (compact)
+	{
+		Compact();
+	}
+	else
+	{
+		Commit();
+	}
+}
+
+bool utils::TransferJournal::GetState(uint64_t transfer_id, TransferState& out_state) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto it = m_states.find(transfer_id);
+	if (it == m_states.end())
+	{
+		return false;
+	}
+
+	out_state = it->second;
+	return true;
+}
+
+std::vector<utils::TransferState> utils::TransferJournal::GetActiveTransfers() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::vector<TransferState> states;
+	states.reserve(m_states.size());
+
+	for (const auto& entry : m_states)
+	{
+		states.push_back(entry.second);
+	}
+
+	std::sort(states.begin(), states.end(),
+		[](const TransferState& a, const TransferState& b) { return a.transfer_id < b.transfer_id; });
+
+	return states;
+}
+
+void utils::TransferJournal::Commit()
+{
+	std::lock_guard<std::mutex> io_lock(m_io_mutex);
+
+	std::vector<uint8_t> batch;
+	size_t batch_records = 0;
+	uint64_t offset = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (m_pending.empty())
+		{
+			return;
+		}
+
+		batch.swap(m_pending);
+		batch_records = m_pending_records;
+		m_pending_records = 0;
+		offset = m_end_offset;
+	}
+
+	// Chỉ tiến m_end_offset khi đã ghi bền vững: ghi thất bại thì lần commit sau ghi đè lên đúng vị trí này,
+	// không để lại khoảng trống làm Replay bỏ mất các bản ghi phía sau
+	try
+	{
+		WriteAll(m_handle, offset, batch);
+
+		if (!FlushFileBuffers(m_handle))
+		{
+			throw std::runtime_error("Failed to flush transfer journal (error " + std::to_string(GetLastError()) + ")");
+		}
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pending.insert(m_pending.begin(), batch.begin(), batch.end());
+		m_pending_records += batch_records;
+		throw;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_end_offset += batch.size();
+}
+
+void utils::TransferJournal::Compact()
+{
+	std::lock_guard<std::mutex> io_lock(m_io_mutex);
+
+	// Trạng thái trong bộ nhớ đã bao gồm các bản ghi chưa commit, chỉ cần ghi lại trạng thái của các phiên còn dang dở
+	std::vector<uint8_t> snapshot;
+	std::vector<uint8_t> superseded; // Bản ghi chưa commit đã nằm trong snapshot
+	size_t superseded_records = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (const auto& entry : m_states)
+		{
+			AppendState(snapshot, entry.second);
+		}
+
+		superseded.swap(m_pending);
+		superseded_records = m_pending_records;
+		m_pending_records = 0;
+	}
+
+	// Compact thất bại thì journal cũ vẫn dùng được: trả lại các bản ghi chưa commit (trước các bản ghi mới hơn)
+	auto restore_pending = [&]()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pending.insert(m_pending.begin(), superseded.begin(), superseded.end());
+		m_pending_records += superseded_records;
+	};
+
+	const fs::path temp_path = m_path.string() + ".compact";
+
+	HANDLE temp = CreateFileW(
+		temp_path.c_str(),
+		GENERIC_READ | GENERIC_WRITE,
+		0,
+		nullptr,
+		CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr);
+
+	if (temp == INVALID_HANDLE_VALUE)
+	{
+		restore_pending();
+		throw std::runtime_error("Failed to create compacted journal (error " + std::to_string(GetLastError()) + ")");
+	}
+
+	try
+	{
+		WriteAll(temp, 0, snapshot);
+
+		if (!FlushFileBuffers(temp))
+		{
+			throw std::runtime_error("Failed to flush compacted journal.");
+		}
+	}
+	catch (...)
+	{
+		CloseHandle(temp);
+		fs::remove(temp_path);
+		restore_pending();
+		throw;
+	}
+
+	CloseHandle(temp);
+	CloseHandle(m_handle);
+	m_handle = INVALID_HANDLE_VALUE;
+
+	std::error_code ec;
+	fs::rename(temp_path, m_path, ec);
+
+	if (ec)
+	{
+		// Mở lại file cũ để m_handle luôn hợp lệ
+		fs::remove(temp_path, ec);
+		Open();
+		restore_pending();
+		throw std::runtime_error("Failed to replace transfer journal with compacted copy.");
+	}
+
+	Open();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_end_offset = snapshot.size();
+}
+
+void utils::TransferJournal::FlusherLoop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (!m_stop)
+	{
+		m_cv.wait_for(lock, m_policy.max_delay,
+			[this]() { return m_stop || m_pending_records >= m_policy.max_pending_records; });
+
+		if (m_pending.empty())
+		{
+			continue;
+		}
+
+		lock.unlock();
+
+		try
+		{
+			Commit();
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "Failed to commit transfer journal: " << e.what() << std::endl;
+		}
+
+		lock.lock();
+	}
+}
+
+void utils::TransferJournal::WriteAll(HANDLE handle, uint64_t offset, const std::vector<uint8_t>& data)
+{
+	size_t written_total = 0;
+
+	while (written_total < data.size())
+	{
+		const uint64_t position = offset + written_total;
+
+		OVERLAPPED overlapped{};
+		overlapped.Offset = static_cast<DWORD>(position & 0xFFFFFFFF);
+		overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+		DWORD written = 0;
+		DWORD to_write = static_cast<DWORD>(std::min<size_t>(data.size() - written_total, 1ULL << 30));
+		if (!WriteFile(handle, data.data() + written_total, to_write, &written, &overlapped) || written == 0)
+		{
+			throw std::runtime_error("Failed to write transfer journal (error " + std::to_string(GetLastError()) + ")");
+		}
+
+		written_total += written;
+	}
+}
@@ -0,0 +1,180 @@
+#include <transfer_scheduler.h>
+
+#include <algorithm>
+#include <iterator>
+
+utils::TransferScheduler::TransferScheduler(size_t worker_count, size_t capacity)
+	: m_mutex(),
+	m_work_available(),
+	m_space_available(),
+	m_queues((std::max)(worker_count, size_t(1))),
+	m_capacity((std::max)(capacity, size_t(1))),
+	m_queued(0),
+	m_outstanding(0),
+	m_closed(false),
+	m_cancelled(false)
+{
+}
+
+bool utils::TransferScheduler::Submit(WorkItem item)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_space_available.wait(lock, [this]() { return m_cancelled || m_queued < m_capacity; });
+
+	if (m_cancelled)
+	{
+		return false;
+	}
+
+	m_outstanding++;
+	Enqueue(std::move(item));
+
+	return true;
+}
+
+bool utils::TransferScheduler::Next(size_t worker, WorkItem& item)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_work_available.wait(lock, [this]() { return m_cancelled || m_queued > 0 || IsFinished(); });
+
+	if (m_cancelled || m_queued == 0)
+	{
+		return false;
+	}
+
+	// Ưu tiên deque của mình, hết thì lấy trộm từ deque đang nhiều byte nhất
+	WorkerQueue* source = &m_queues[worker % m_queues.size()];
+	bool stolen = false;
+
+	if (source->items.empty())
+	{
+		source = &*std::max_element(m_queues.begin(), m_queues.end(),
+			[](const WorkerQueue& a, const WorkerQueue& b) { return a.queued_bytes < b.queued_bytes || (a.queued_bytes == b.queued_bytes && a.items.size() < b.items.size()); });
+		stolen = true;
+	}
+
+	// Chủ lấy từ đầu, kẻ trộm lấy từ cuối để ít tranh với thứ tự của chủ
+	if (stolen)
+	{
+		item = std::move(source->items.back());
+		source->items.pop_back();
+	}
+	else
+	{
+		item = std::move(source->items.front());
+		source->items.pop_front();
+	}
+
+	source->queued_bytes -= item.bytes;
+	m_queued--;
+	lock.unlock();
+
+	m_space_available.notify_one();
+	return true;
+}
+
+void utils::TransferScheduler::Complete()
+{
+	bool finished = false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_outstanding > 0)
+		{
+			m_outstanding--;
+		}
+		finished = IsFinished();
+	}
+
+	if (finished)
+	{
+		m_work_available.notify_all();
+	}
+}
+
+bool utils::TransferScheduler::Requeue(WorkItem&& item)
+{
+	if (++item.attempts >= MAX_ATTEMPTS)
+	{
+		return false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_cancelled)
+		{
+			return false;
+		}
+
+		// Không tính vào sức chứa: item đã được đếm trong m_outstanding, chặn ở đây có thể làm mọi worker cùng chờ
+		Enqueue(std::move(item));
+	}
+
+	return true;
+}
+
+void utils::TransferScheduler::Close()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_closed = true;
+	}
+
+	m_work_available.notify_all();
+}
+
+void utils::TransferScheduler::Cancel()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_cancelled = true;
+	}
+
+	m_work_available.notify_all();
+	m_space_available.notify_all();
+}
+
+std::vector<utils::WorkItem> utils::TransferScheduler::TakeRemaining()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::vector<WorkItem> remaining;
+	for (auto& queue : m_queues)
+	{
+		std::move(queue.items.begin(), queue.items.end(), std::back_inserter(remaining));
+		queue.items.clear();
+		queue.queued_bytes = 0;
+	}
+
+	m_queued = 0;
+	return remaining;
+}
+
+bool utils::TransferScheduler::IsDone()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return IsFinished();
+}
+
+size_t utils::TransferScheduler::LeastLoadedQueue() const
+{
+	size_t best = 0;
+	for (size_t i = 1; i < m_queues.size(); i++)
+	{
+		if (m_queues[i].queued_bytes < m_queues[best].queued_bytes)
+		{
+			best = i;
+		}
+	}
+	return best;
+}
+
+void utils::TransferScheduler::Enqueue(WorkItem&& item)
+{
+	WorkerQueue& queue = m_queues[LeastLoadedQueue()];
+	queue.queued_bytes += item.bytes;
+	queue.items.push_back(std::move(item));
+	m_queued++;
+
+	m_work_available.notify_one();
+}
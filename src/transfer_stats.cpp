@@ -0,0 +1,7 @@
+#include <transfer_stats.h>
+
+utils::TransferStats& utils::TransferStats::Shared()
+{
+	static TransferStats stats;
+	return stats;
+}